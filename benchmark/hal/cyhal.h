@@ -0,0 +1,40 @@
+/***********************************************************************************************//**
+ * \file cyhal.h
+ *
+ * \brief
+ * Host stand-in for the part of the classic HAL used by the HAL NVM block storage device, so that
+ * the benchmark can run mtb_block_storage_nvm.c without any hardware. Only the NVM driver is
+ * available, its functions are implemented by the benchmark on top of a RAM device.
+ *
+ ***************************************************************************************************
+ * \copyright
+ * Copyright 2024 Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **************************************************************************************************/
+#pragma once
+
+#include "cy_result.h"
+#include "cy_utils.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define CYHAL_DRIVER_AVAILABLE_NVM      (1)
+#define CYHAL_DRIVER_AVAILABLE_FLASH    (0)
+#define CYHAL_DRIVER_AVAILABLE_DMA      (0)
+
+#include "cyhal_nvm.h"
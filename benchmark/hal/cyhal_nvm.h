@@ -0,0 +1,93 @@
+/***********************************************************************************************//**
+ * \file cyhal_nvm.h
+ *
+ * \brief
+ * Host stand-in for the classic HAL NVM driver, with the types and blocking functions of
+ * cyhal_nvm.h that the HAL NVM block storage device uses.
+ *
+ ***************************************************************************************************
+ * \copyright
+ * Copyright 2024 Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **************************************************************************************************/
+#pragma once
+
+#include "cy_result.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/** Type of memory of an NVM region */
+typedef enum
+{
+    CYHAL_NVM_TYPE_INVALID, /**< Invalid type */
+    CYHAL_NVM_TYPE_FLASH,   /**< Flash */
+    CYHAL_NVM_TYPE_RRAM,    /**< RRAM */
+    CYHAL_NVM_TYPE_OTP,     /**< OTP */
+} cyhal_nvm_type_t;
+
+/** NVM object */
+typedef struct
+{
+    uint32_t reserved;      /**< Unused */
+} cyhal_nvm_t;
+
+/** Description of one NVM region */
+typedef struct
+{
+    cyhal_nvm_type_t nvm_type;          /**< Type of memory */
+    uint32_t         start_address;     /**< Address of the first byte of the region */
+    uint32_t         offset;            /**< Offset of the region in the memory */
+    uint32_t         size;              /**< Size of the region in bytes */
+    uint32_t         sector_size;       /**< Size of an erase sector in bytes */
+    uint32_t         block_size;        /**< Size of a program block in bytes */
+    bool             is_erase_required; /**< Whether an erase is needed before programming */
+    uint8_t          erase_value;       /**< Value of every byte after an erase */
+} cyhal_nvm_region_info_t;
+
+/** Description of all the NVM regions */
+typedef struct
+{
+    uint8_t                        region_count;    /**< Number of regions */
+    const cyhal_nvm_region_info_t* regions;         /**< Table of the regions */
+} cyhal_nvm_info_t;
+
+/** Initializes the NVM object */
+cy_rslt_t cyhal_nvm_init(cyhal_nvm_t* obj);
+
+/** Releases the NVM object */
+void cyhal_nvm_free(cyhal_nvm_t* obj);
+
+/** Returns the description of the NVM regions */
+void cyhal_nvm_get_info(cyhal_nvm_t* obj, cyhal_nvm_info_t* info);
+
+/** Reads size bytes at address */
+cy_rslt_t cyhal_nvm_read(cyhal_nvm_t* obj, uint32_t address, uint8_t* data, size_t size);
+
+/** Programs the block at address */
+cy_rslt_t cyhal_nvm_program(cyhal_nvm_t* obj, uint32_t address, const uint32_t* data);
+
+/** Erases the sector at address */
+cy_rslt_t cyhal_nvm_erase(cyhal_nvm_t* obj, uint32_t address);
+
+#if defined(__cplusplus)
+}
+#endif
@@ -0,0 +1,619 @@
+/***********************************************************************************************//**
+ * \file mtb_block_storage_benchmark.c
+ *
+ * \brief
+ * Host benchmark for the block storage interface. Every backend is represented by a RAM device
+ * configured with the geometry and typical timing of the parts it drives, so the benchmark runs
+ * without any hardware. For each device and operation it reports the throughput of the software
+ * path, the throughput given by the timing model, p50/p99 latency and cycles per call.
+ *
+ * Build and run on host, with the core-lib include folder providing cy_result.h and cy_utils.h:
+ *
+ *     gcc -O2 -std=c99 -Iinclude -I<core-lib>/include benchmark/mtb_block_storage_benchmark.c \
+ *         source/mtb_block_storage.c source/mtb_block_storage_ram.c -o mtb_block_storage_benchmark
+ *     ./mtb_block_storage_benchmark
+ *
+ * Adding -DCY_USING_HAL -Ibenchmark/hal and source/mtb_block_storage_nvm.c also measures the
+ * region lookup of the HAL NVM device, created on the classic HAL stand-in of benchmark/hal whose
+ * NVM functions are implemented below on top of a RAM device.
+ *
+ ***************************************************************************************************
+ * \copyright
+ * Copyright 2024 Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **************************************************************************************************/
+#if !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "mtb_block_storage.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAS_CYCLE_COUNTER
+#endif
+
+#define BENCH_SAMPLES           (2000u)
+//Samples of each query, and number of calls timed together in each sample
+#define BENCH_QUERY_SAMPLES     (200u)
+#define BENCH_QUERY_BATCH       (1000u)
+#define BENCH_MAX_TRANSFER      (4096u)
+#define BENCH_MAX_REGIONS       (MTB_BLOCK_STORAGE_RAM_MAX_REGIONS)
+
+//Makes the compiler forget the value of a variable, so that the calls using it are all made
+#if defined(__GNUC__)
+#define BENCH_OPAQUE(value)     __asm__ volatile ("" : "+r" (value))
+#else
+#define BENCH_OPAQUE(value)     ((void)(value))
+#endif
+
+typedef enum
+{
+    BENCH_OP_READ,
+    BENCH_OP_PROGRAM,
+    BENCH_OP_ERASE,
+    BENCH_OP_PROGRAM_NB,
+    BENCH_OP_ERASE_NB,
+} bench_op_t;
+
+typedef enum
+{
+    BENCH_QUERY_PROGRAM_SIZE,
+    BENCH_QUERY_ERASE_SIZE,
+    BENCH_QUERY_GEOMETRY,
+} bench_query_t;
+
+/** Stand-in description of one backend */
+typedef struct
+{
+    const char*                           name;
+    const mtb_block_storage_ram_region_t* regions;
+    uint32_t                              region_count;
+} bench_profile_t;
+
+typedef struct
+{
+    uint64_t ns;
+    uint64_t cycles;
+} bench_sample_t;
+
+/* HAL NVM: PSoC 6 like main flash (512 B rows, 0x00 erased), work flash and supervisory flash */
+static const mtb_block_storage_ram_region_t bench_nvm_regions[] =
+{
+    { 0x10000000u, 1024u * 1024u, 512u, 512u, 0x00u, true, 1u, 16000u, 16000u, 0u },
+    { 0x14000000u, 32u * 1024u,   512u, 512u, 0x00u, true, 1u, 16000u, 16000u, 1u },
+    { 0x16000000u, 32u * 1024u,   512u, 512u, 0x00u, true, 1u, 16000u, 16000u, 2u },
+};
+
+/* HAL NVM with many regions, the address queried lives in the last one */
+static const mtb_block_storage_ram_region_t bench_nvm_many_regions[] =
+{
+    { 0x10000000u, 64u * 1024u, 512u, 512u, 0x00u, true, 1u, 16000u, 16000u, 0u },
+    { 0x10010000u, 64u * 1024u, 512u, 512u, 0x00u, true, 1u, 16000u, 16000u, 1u },
+    { 0x10020000u, 64u * 1024u, 512u, 512u, 0x00u, true, 1u, 16000u, 16000u, 2u },
+    { 0x10030000u, 64u * 1024u, 512u, 512u, 0x00u, true, 1u, 16000u, 16000u, 3u },
+    { 0x10040000u, 64u * 1024u, 512u, 512u, 0x00u, true, 1u, 16000u, 16000u, 4u },
+    { 0x10050000u, 64u * 1024u, 512u, 512u, 0x00u, true, 1u, 16000u, 16000u, 5u },
+    { 0x10060000u, 64u * 1024u, 512u, 512u, 0x00u, true, 1u, 16000u, 16000u, 6u },
+    { 0x10070000u, 64u * 1024u, 512u, 512u, 0x00u, true, 1u, 16000u, 16000u, 7u },
+};
+
+/* PDL: PSoC 4 flash, 128 B rows written with an implicit erase */
+static const mtb_block_storage_ram_region_t bench_pdl_regions[] =
+{
+    { 0x00000000u, 256u * 1024u, 128u, 128u, 0x00u, false, 1u, 2000u, 2000u, 0u },
+};
+
+/* Serial memory: QSPI NOR with hybrid 4 KB parameter sectors followed by 64 KB sectors */
+static const mtb_block_storage_ram_region_t bench_serial_memory_regions[] =
+{
+    { 0x00000000u, 128u * 1024u,       256u, 4096u,         0xFFu, true, 2u, 400u, 45000u,  0u },
+    { 0x00020000u, 8u * 1024u * 1024u, 256u, 64u * 1024u,   0xFFu, true, 2u, 400u, 150000u, 0u },
+};
+
+/* Serial flash: QSPI NOR with uniform 4 KB sectors */
+static const mtb_block_storage_ram_region_t bench_serial_flash_regions[] =
+{
+    { 0x00000000u, 8u * 1024u * 1024u, 256u, 4096u, 0xFFu, true, 2u, 400u, 45000u, 0u },
+};
+
+static const bench_profile_t bench_profiles[] =
+{
+    { "nvm",           bench_nvm_regions,           3u },
+    { "pdl",           bench_pdl_regions,           1u },
+    { "serial_memory", bench_serial_memory_regions, 2u },
+    { "serial_flash",  bench_serial_flash_regions,  1u },
+};
+
+static const uint32_t bench_transfer_sizes[] = { 4u, 16u, 64u, 128u, 256u, 512u, 1024u, 4096u };
+
+static bench_sample_t bench_samples[BENCH_SAMPLES];
+//Number of measurements that failed, the benchmark then exits with a non zero status
+static uint32_t bench_failures;
+//Sum of the query results, so that the queries are not optimized away
+static volatile uint32_t bench_sink;
+static uint8_t bench_buffer[BENCH_MAX_TRANSFER + 8u];
+
+#if defined(CY_USING_HAL)
+//RAM device and regions behind the HAL NVM functions of the stand-in
+static mtb_block_storage_t bench_hal_ram;
+static cyhal_nvm_region_info_t bench_hal_regions[BENCH_MAX_REGIONS];
+static uint8_t bench_hal_region_count;
+#endif
+
+
+//--------------------------------------------------------------------------------------------------
+// bench_now
+//--------------------------------------------------------------------------------------------------
+static bench_sample_t bench_now(void)
+{
+    bench_sample_t now;
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    now.ns = ((uint64_t)ts.tv_sec * 1000000000u) + (uint64_t)ts.tv_nsec;
+    #if defined(BENCH_HAS_CYCLE_COUNTER)
+    now.cycles = __rdtsc();
+    #else
+    now.cycles = 0;
+    #endif
+    return now;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// bench_compare
+//--------------------------------------------------------------------------------------------------
+static int bench_compare(const void* a, const void* b)
+{
+    uint64_t lhs = ((const bench_sample_t*)a)->ns;
+    uint64_t rhs = ((const bench_sample_t*)b)->ns;
+    return (lhs > rhs) - (lhs < rhs);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// bench_report
+//--------------------------------------------------------------------------------------------------
+static void bench_report(const char* device, const char* op, uint32_t size, uint32_t offset,
+                         uint32_t count, uint64_t model_us)
+{
+    uint64_t total_ns = 0;
+    uint64_t total_cycles = 0;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        total_ns += bench_samples[i].ns;
+        total_cycles += bench_samples[i].cycles;
+    }
+    qsort(bench_samples, count, sizeof(bench_samples[0]), bench_compare);
+
+    double bytes = (double)size * (double)count;
+    printf("%-14s %-11s %6u %4u %10.1f %10.3f %8llu %8llu %10llu\n", device, op, (unsigned)size,
+           (unsigned)offset,
+           (0u != total_ns) ? (bytes * 1000.0) / (double)total_ns : 0.0,
+           (0u != model_us) ? bytes / (double)model_us : 0.0,
+           (unsigned long long)bench_samples[count / 2u].ns,
+           (unsigned long long)bench_samples[(count * 99u) / 100u].ns,
+           (unsigned long long)(total_cycles / count));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// bench_transfer
+//--------------------------------------------------------------------------------------------------
+static void bench_transfer(const bench_profile_t* profile, mtb_block_storage_t* bsd,
+                           mtb_block_storage_ram_t* obj, bench_op_t op, uint32_t size,
+                           uint32_t offset)
+{
+    static const char* const names[] = { "read", "program", "erase", "program_nb", "erase_nb" };
+    const mtb_block_storage_ram_region_t* region = &profile->regions[0];
+    uint32_t unit = ((op == BENCH_OP_ERASE) || (op == BENCH_OP_ERASE_NB))
+        ? region->erase_size : region->program_size;
+    uint32_t count = 0;
+    uint64_t model_us = 0;
+    uint32_t addr = region->start_address + offset;
+
+    if (((op == BENCH_OP_PROGRAM_NB) && (NULL == bsd->program_nb)) ||
+        ((op == BENCH_OP_ERASE_NB) && (NULL == bsd->erase_nb)) ||
+        ((op != BENCH_OP_READ) && ((0u != (size % unit)) || (0u != (offset % unit)))))
+    {
+        //Not a valid request for this device, the backend would reject it
+        return;
+    }
+
+    for (uint32_t i = 0; i < BENCH_SAMPLES; i++)
+    {
+        cy_rslt_t result = CY_RSLT_SUCCESS;
+        if ((addr + size) > (region->start_address + region->size))
+        {
+            addr = region->start_address + offset;
+        }
+        if ((op == BENCH_OP_PROGRAM) || (op == BENCH_OP_PROGRAM_NB))
+        {
+            //Preparing the area is not part of the measurement
+            uint32_t erase_addr = addr - ((addr - region->start_address) % region->erase_size);
+            uint32_t erase_len = (((addr + size) - erase_addr + region->erase_size - 1u) /
+                                  region->erase_size) * region->erase_size;
+            (void)bsd->erase(bsd->context, erase_addr, erase_len);
+        }
+
+        uint64_t elapsed_before = obj->elapsed_us;
+        bench_sample_t start = bench_now();
+        switch (op)
+        {
+            case BENCH_OP_READ:
+                result = bsd->read(bsd->context, addr, size, bench_buffer);
+                break;
+
+            case BENCH_OP_PROGRAM:
+                result = bsd->program(bsd->context, addr, size, bench_buffer);
+                break;
+
+            case BENCH_OP_ERASE:
+                result = bsd->erase(bsd->context, addr, size);
+                break;
+
+            case BENCH_OP_PROGRAM_NB:
+                result = bsd->program_nb(bsd->context, addr, size, bench_buffer);
+                break;
+
+            default:
+                result = bsd->erase_nb(bsd->context, addr, size);
+                break;
+        }
+        //Non blocking operations are measured up to their completion
+        if ((result == CY_RSLT_SUCCESS) && ((op == BENCH_OP_PROGRAM_NB) ||
+                                            (op == BENCH_OP_ERASE_NB)))
+        {
+            do
+            {
+                result = bsd->poll(bsd->context);
+            } while (result == MTB_BLOCK_STORAGE_BUSY);
+        }
+        bench_sample_t end = bench_now();
+
+        if (result != CY_RSLT_SUCCESS)
+        {
+            printf("%-14s %-11s %6u %4u failed 0x%08lx\n", profile->name, names[op],
+                   (unsigned)size, (unsigned)offset, (unsigned long)result);
+            bench_failures++;
+            return;
+        }
+        bench_samples[count].ns = end.ns - start.ns;
+        bench_samples[count].cycles = end.cycles - start.cycles;
+        model_us += obj->elapsed_us - elapsed_before;
+        count++;
+        addr += ((size + unit - 1u) / unit) * unit;
+    }
+    bench_report(profile->name, names[op], size, offset, count, model_us);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// bench_query_batch
+//--------------------------------------------------------------------------------------------------
+static uint32_t bench_query_batch(bench_query_t query, mtb_block_storage_t* bsd,
+                                  const mtb_block_storage_region_t* regions,
+                                  uint32_t region_count, uint32_t addr)
+{
+    uint32_t sum = 0;
+
+    //The address is hidden from the compiler on every call, so none of them can be dropped or
+    //hoisted out of the loop, and the sum of the results is returned
+    switch (query)
+    {
+        case BENCH_QUERY_PROGRAM_SIZE:
+            for (uint32_t i = 0; i < BENCH_QUERY_BATCH; i++)
+            {
+                BENCH_OPAQUE(addr);
+                sum += bsd->get_program_size(bsd->context, addr);
+            }
+            break;
+
+        case BENCH_QUERY_ERASE_SIZE:
+            for (uint32_t i = 0; i < BENCH_QUERY_BATCH; i++)
+            {
+                BENCH_OPAQUE(addr);
+                sum += bsd->get_erase_size(bsd->context, addr);
+            }
+            break;
+
+        default:
+            for (uint32_t i = 0; i < BENCH_QUERY_BATCH; i++)
+            {
+                BENCH_OPAQUE(addr);
+                const mtb_block_storage_region_t* region =
+                    mtb_block_storage_find_region(regions, region_count, addr);
+                sum += region->program_size + region->erase_size;
+            }
+            break;
+    }
+    return sum;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// bench_queries
+//--------------------------------------------------------------------------------------------------
+static void bench_queries(const char* name, mtb_block_storage_t* bsd, uint32_t addr)
+{
+    static const char* const names[] = { "prog_size", "erase_size", "geometry" };
+    mtb_block_storage_region_t regions[BENCH_MAX_REGIONS];
+    uint32_t region_count = 0;
+    bench_query_t last = BENCH_QUERY_ERASE_SIZE;
+
+    //Lookup in a geometry table queried once, as done by code working on many addresses
+    if (mtb_block_storage_get_geometry(bsd, regions, BENCH_MAX_REGIONS, &region_count) ==
+        CY_RSLT_SUCCESS)
+    {
+        last = BENCH_QUERY_GEOMETRY;
+    }
+
+    //A query takes a few ns, less than reading the clock, so each sample times a batch of calls
+    //and records the time of one call
+    for (uint32_t query = BENCH_QUERY_PROGRAM_SIZE; query <= (uint32_t)last; query++)
+    {
+        for (uint32_t i = 0; i < BENCH_QUERY_SAMPLES; i++)
+        {
+            bench_sample_t start = bench_now();
+            bench_sink += bench_query_batch((bench_query_t)query, bsd, regions, region_count,
+                                            addr);
+            bench_sample_t end = bench_now();
+            bench_samples[i].ns = (end.ns - start.ns + (BENCH_QUERY_BATCH / 2u)) /
+                                  BENCH_QUERY_BATCH;
+            bench_samples[i].cycles = (end.cycles - start.cycles + (BENCH_QUERY_BATCH / 2u)) /
+                                      BENCH_QUERY_BATCH;
+        }
+        bench_report(name, names[query], 0u, 0u, BENCH_QUERY_SAMPLES, 0u);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// bench_create
+//--------------------------------------------------------------------------------------------------
+static uint8_t* bench_create(mtb_block_storage_t* bsd, mtb_block_storage_ram_t* obj,
+                             const mtb_block_storage_ram_region_t* regions, uint32_t region_count)
+{
+    uint32_t size = 0;
+    for (uint32_t region = 0; region < region_count; region++)
+    {
+        size += regions[region].size;
+    }
+
+    uint8_t* memory = (uint8_t*)malloc(size);
+    mtb_block_storage_ram_config_t config =
+    {
+        .regions      = regions,
+        .region_count = region_count,
+        .memory       = memory,
+        .program_map  = (uint32_t*)calloc(
+            mtb_block_storage_ram_get_program_map_size(regions, region_count), sizeof(uint32_t)),
+        .delay        = NULL,
+        .initialize   = true,
+    };
+    if ((NULL == memory) || (NULL == config.program_map) ||
+        (mtb_block_storage_create_ram(bsd, obj, &config) != CY_RSLT_SUCCESS))
+    {
+        free(memory);
+        free(config.program_map);
+        memory = NULL;
+    }
+    return memory;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// bench_free
+//--------------------------------------------------------------------------------------------------
+static void bench_free(mtb_block_storage_ram_t* obj)
+{
+    free(obj->config.memory);
+    free(obj->config.program_map);
+}
+
+
+#if defined(CY_USING_HAL)
+//--------------------------------------------------------------------------------------------------
+// cyhal_nvm_init
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t cyhal_nvm_init(cyhal_nvm_t* obj)
+{
+    CY_UNUSED_PARAMETER(obj);
+    return CY_RSLT_SUCCESS;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// cyhal_nvm_free
+//--------------------------------------------------------------------------------------------------
+void cyhal_nvm_free(cyhal_nvm_t* obj)
+{
+    CY_UNUSED_PARAMETER(obj);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// cyhal_nvm_get_info
+//--------------------------------------------------------------------------------------------------
+void cyhal_nvm_get_info(cyhal_nvm_t* obj, cyhal_nvm_info_t* info)
+{
+    CY_UNUSED_PARAMETER(obj);
+    info->region_count = bench_hal_region_count;
+    info->regions = bench_hal_regions;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// cyhal_nvm_read
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t cyhal_nvm_read(cyhal_nvm_t* obj, uint32_t address, uint8_t* data, size_t size)
+{
+    CY_UNUSED_PARAMETER(obj);
+    return bench_hal_ram.read(bench_hal_ram.context, address, (uint32_t)size, data);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// cyhal_nvm_program
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t cyhal_nvm_program(cyhal_nvm_t* obj, uint32_t address, const uint32_t* data)
+{
+    CY_UNUSED_PARAMETER(obj);
+    return bench_hal_ram.program(bench_hal_ram.context, address,
+                                 bench_hal_ram.get_program_size(bench_hal_ram.context, address),
+                                 (const uint8_t*)data);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// cyhal_nvm_erase
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t cyhal_nvm_erase(cyhal_nvm_t* obj, uint32_t address)
+{
+    CY_UNUSED_PARAMETER(obj);
+    return bench_hal_ram.erase(bench_hal_ram.context, address,
+                               bench_hal_ram.get_erase_size(bench_hal_ram.context, address));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// bench_hal_nvm
+//--------------------------------------------------------------------------------------------------
+static void bench_hal_nvm(const char* name, const mtb_block_storage_ram_region_t* regions,
+                          uint32_t region_count)
+{
+    mtb_block_storage_ram_t obj;
+    mtb_block_storage_t bsd;
+    cy_rslt_t result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+
+    if (NULL != bench_create(&bench_hal_ram, &obj, regions, region_count))
+    {
+        for (uint32_t region = 0; region < region_count; region++)
+        {
+            bench_hal_regions[region].nvm_type = CYHAL_NVM_TYPE_FLASH;
+            bench_hal_regions[region].start_address = regions[region].start_address;
+            bench_hal_regions[region].offset = 0u;
+            bench_hal_regions[region].size = regions[region].size;
+            bench_hal_regions[region].sector_size = regions[region].erase_size;
+            bench_hal_regions[region].block_size = regions[region].program_size;
+            bench_hal_regions[region].is_erase_required = regions[region].is_erase_required;
+            bench_hal_regions[region].erase_value = regions[region].erase_value;
+        }
+        bench_hal_region_count = (uint8_t)region_count;
+
+        //The device is released so that the next one reads the regions again
+        result = mtb_block_storage_create_hal_nvm(&bsd, NULL);
+        if (result == CY_RSLT_SUCCESS)
+        {
+            bench_queries(name, &bsd, regions[region_count - 1u].start_address);
+            (void)mtb_block_storage_nvm_deinit(&bsd);
+        }
+        bench_free(&obj);
+    }
+
+    if (result != CY_RSLT_SUCCESS)
+    {
+        printf("%-14s failed to create the device\n", name);
+        bench_failures++;
+    }
+}
+
+
+#endif // defined(CY_USING_HAL)
+
+
+//--------------------------------------------------------------------------------------------------
+// main
+//--------------------------------------------------------------------------------------------------
+int main(void)
+{
+    static const bench_op_t ops[] =
+    {
+        BENCH_OP_READ, BENCH_OP_PROGRAM, BENCH_OP_PROGRAM_NB, BENCH_OP_ERASE, BENCH_OP_ERASE_NB
+    };
+    mtb_block_storage_t bsd;
+    mtb_block_storage_ram_t obj;
+
+    for (uint32_t i = 0; i < sizeof(bench_buffer); i++)
+    {
+        bench_buffer[i] = (uint8_t)(i * 7u);
+    }
+
+    printf("%-14s %-11s %6s %4s %10s %10s %8s %8s %10s\n", "device", "op", "size", "off",
+           "host MB/s", "model MB/s", "p50 ns", "p99 ns", "cycles");
+
+    for (uint32_t p = 0; p < (sizeof(bench_profiles) / sizeof(bench_profiles[0])); p++)
+    {
+        const bench_profile_t* profile = &bench_profiles[p];
+        uint8_t* memory = bench_create(&bsd, &obj, profile->regions, profile->region_count);
+        if (NULL == memory)
+        {
+            printf("%-14s failed to create the device\n", profile->name);
+            return 1;
+        }
+
+        for (uint32_t o = 0; o < (sizeof(ops) / sizeof(ops[0])); o++)
+        {
+            uint32_t unit = ((ops[o] == BENCH_OP_ERASE) || (ops[o] == BENCH_OP_ERASE_NB))
+                ? profile->regions[0].erase_size : profile->regions[0].program_size;
+            if (unit > BENCH_MAX_TRANSFER)
+            {
+                bench_transfer(profile, &bsd, &obj, ops[o], unit, 0u);
+                continue;
+            }
+            for (uint32_t s = 0; s < (sizeof(bench_transfer_sizes) / sizeof(uint32_t)); s++)
+            {
+                bench_transfer(profile, &bsd, &obj, ops[o], bench_transfer_sizes[s], 0u);
+                //Misaligned start: by one byte for reads and by one unit for program and erase
+                bench_transfer(profile, &bsd, &obj, ops[o], bench_transfer_sizes[s],
+                               (ops[o] == BENCH_OP_READ) ? 1u : unit);
+            }
+        }
+        bench_queries(profile->name, &bsd,
+                      profile->regions[profile->region_count - 1u].start_address);
+        bench_free(&obj);
+    }
+
+    //Region lookup cost grows with the number of regions to scan
+    uint8_t* memory = bench_create(&bsd, &obj, bench_nvm_many_regions,
+                                   sizeof(bench_nvm_many_regions) /
+                                   sizeof(bench_nvm_many_regions[0]));
+    if (NULL != memory)
+    {
+        bench_queries("nvm_8_regions", &bsd, bench_nvm_many_regions[7].start_address);
+        bench_free(&obj);
+    }
+    else
+    {
+        printf("%-14s failed to create the device\n", "nvm_8_regions");
+        bench_failures++;
+    }
+
+    #if defined(CY_USING_HAL)
+    //Region lookup of the HAL NVM device itself, on the same region tables
+    bench_hal_nvm("hal_nvm", bench_nvm_regions,
+                  sizeof(bench_nvm_regions) / sizeof(bench_nvm_regions[0]));
+    bench_hal_nvm("hal_nvm_8", bench_nvm_many_regions,
+                  sizeof(bench_nvm_many_regions) / sizeof(bench_nvm_many_regions[0]));
+    #endif
+    return (0u == bench_failures) ? 0 : 1;
+}
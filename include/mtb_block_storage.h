@@ -51,12 +51,39 @@
     CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_ABSTRACTION_BLOCK_STORAGE, 2)
 #define MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR                  \
     CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_ABSTRACTION_BLOCK_STORAGE, 3)
+/** A program operation targets an area that has not been erased since it was last programmed. */
+#define MTB_BLOCK_STORAGE_NOT_ERASED_ERROR                     \
+    CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_ABSTRACTION_BLOCK_STORAGE, 4)
+/** A non blocking operation is still in progress. */
+#define MTB_BLOCK_STORAGE_BUSY                                 \
+    CY_RSLT_CREATE(CY_RSLT_TYPE_INFO, CY_RSLT_MODULE_ABSTRACTION_BLOCK_STORAGE, 5)
+/** The requested key is not stored. */
+#define MTB_BLOCK_STORAGE_NOT_FOUND_ERROR                      \
+    CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_ABSTRACTION_BLOCK_STORAGE, 6)
+/** There is not enough free space left to store the data. */
+#define MTB_BLOCK_STORAGE_NO_SPACE_ERROR                       \
+    CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_ABSTRACTION_BLOCK_STORAGE, 7)
+/** The request was dropped before it was issued to the device. */
+#define MTB_BLOCK_STORAGE_CANCELLED_ERROR                      \
+    CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_ABSTRACTION_BLOCK_STORAGE, 8)
 
-//Only limit support for non blocking functionality to PSoC6 for the moment
-#if (defined(COMPONENT_CAT1A) && !defined(CY_DEVICE_TVIIBE)) && \
+//Only limit support for non blocking functionality to PSoC6, and to XMC7000 and TRAVEO T2G
+//devices, whose work flash rows are started through the PDL, for the moment
+#if ((defined(COMPONENT_CAT1A) && !defined(CY_DEVICE_TVIIBE)) || defined(COMPONENT_CAT1C)) && \
     !(MTB_HAL_DRIVER_AVAILABLE_NVM)
 #define MTB_BLOCK_STORAGE_NON_BLOCKING_SUPPORTED
 #endif
+
+//The file backed device relies on POSIX memory mapping, so it is only available on host builds
+#if defined(__unix__) || defined(__APPLE__)
+#include <stddef.h>
+#define MTB_BLOCK_STORAGE_FILE_SUPPORTED
+#endif
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
 /**
  * \addtogroup group_block_storage Block Storage Library
  * \{
@@ -199,7 +226,134 @@ typedef bool (* mtb_block_storage_is_in_range_t)(void* context, uint32_t addr, u
 typedef bool (* mtb_block_storage_is_erase_required_t)(void* context, uint32_t addr,
                                                        uint32_t length);
 
-/** Block device interface */
+/** Function prototype for the callback invoked when a non blocking operation completes.
+ *
+ * @param[in]  callback_arg Argument that is passed into register_callback
+ * @param[in]  result       Result of the whole non blocking operation
+ */
+typedef void (* mtb_block_storage_async_callback_t)(void* callback_arg, cy_rslt_t result);
+
+/** Function prototype for registering the callback invoked when a non blocking operation
+ *  completes.
+ *
+ * @param[in]  context      Context object that is passed into mtb_block_storage_*_create
+ * @param[in]  callback     Function to call on completion, NULL to disable the notification
+ * @param[in]  callback_arg Argument passed to the callback
+ * @return Result of the register callback operation.
+ */
+typedef cy_rslt_t (* mtb_block_storage_register_callback_t)(
+    void* context, mtb_block_storage_async_callback_t callback, void* callback_arg);
+
+/** Function prototype for advancing and checking the non blocking operation of the block device.
+ *  Every call moves the operation on by at most one step without waiting, so it can be called
+ *  from the idle loop or from an interrupt, e.g. a periodic timer.
+ *
+ * @param[in]  context  Context object that is passed into mtb_block_storage_*_create
+ * @return MTB_BLOCK_STORAGE_BUSY while the operation is in progress, otherwise the result of the
+ *         last non blocking operation.
+ */
+typedef cy_rslt_t (* mtb_block_storage_poll_t)(void* context);
+
+/** Geometry of one region of a block device. Within a region all the addresses share the same
+ *  sizes, erase value and erase requirement. */
+typedef struct
+{
+    uint32_t start_address;        /**< Address of the first byte of the region */
+    uint32_t size;                 /**< Size of the region in bytes */
+    uint32_t read_size;            /**< Read size, as returned by get_read_size */
+    uint32_t program_size;         /**< Program size, as returned by get_program_size */
+    uint32_t erase_size;           /**< Erase size, as returned by get_erase_size */
+    uint8_t  erase_value;          /**< Erase value, as returned by get_erase_value */
+    bool     is_erase_required;    /**< Whether erase is required, as returned by
+                                      is_erase_required */
+    uint8_t  bank;                 /**< Bank of the region. A region can be read while a region
+                                      of another bank is being programmed or erased. */
+} mtb_block_storage_region_t;
+
+/** Function prototype for getting the full geometry of the block device in one call.
+ *
+ * @param[in]  context      Context object that is passed into mtb_block_storage_*_create
+ * @param[out] regions      Array filled with the regions of the device sorted by address.
+ *                          Can be NULL if max_regions is 0.
+ * @param[in]  max_regions  Number of entries available in regions
+ * @param[out] region_count Number of regions of the device. If it is bigger than max_regions,
+ *                          only the first max_regions entries are filled and
+ *                          MTB_BLOCK_STORAGE_INVALID_SIZE_ERROR is returned.
+ * @return Result of the get geometry operation.
+ */
+typedef cy_rslt_t (* mtb_block_storage_get_geometry_t)(void* context,
+                                                       mtb_block_storage_region_t* regions,
+                                                       uint32_t max_regions,
+                                                       uint32_t* region_count);
+
+/** Fragment of a vectored read */
+typedef struct
+{
+    uint32_t addr;      /**< Address to read the fragment from */
+    uint32_t length;    /**< Length of the fragment */
+    uint8_t* buf;       /**< Buffer receiving the fragment */
+} mtb_block_storage_read_vec_t;
+
+/** Fragment of a vectored program */
+typedef struct
+{
+    uint32_t       addr;    /**< Address to program the fragment to */
+    uint32_t       length;  /**< Length of the fragment, multiple of the program size */
+    const uint8_t* buf;     /**< Data of the fragment */
+} mtb_block_storage_program_vec_t;
+
+/** Function prototype for reading several fragments of the block device in one call.
+ *
+ * @param[in]  context  Context object that is passed into mtb_block_storage_*_create
+ * @param[in]  vecs     Fragments to read, in order
+ * @param[in]  count    Number of entries in vecs
+ * @return Result of the read operation, the fragments following a failed one are not read.
+ */
+typedef cy_rslt_t (* mtb_block_storage_readv_t)(void* context,
+                                                const mtb_block_storage_read_vec_t* vecs,
+                                                uint32_t count);
+
+/** Function prototype for programming several fragments of the block device in one call.
+ *
+ * @param[in]  context  Context object that is passed into mtb_block_storage_*_create
+ * @param[in]  vecs     Fragments to program, in order
+ * @param[in]  count    Number of entries in vecs
+ * @return Result of the program operation, the fragments following a failed one are not
+ *         programmed.
+ */
+typedef cy_rslt_t (* mtb_block_storage_programv_t)(void* context,
+                                                   const mtb_block_storage_program_vec_t* vecs,
+                                                   uint32_t count);
+
+/** Function prototype for getting a pointer to the data of an area of a memory mapped block
+ *  device, so that it can be read in place instead of being copied with read.
+ *
+ * @param[in]  context  Context object that is passed into mtb_block_storage_*_create
+ * @param[in]  addr     Address of the area
+ * @param[in]  length   Length of the area
+ * @param[out] ptr      Pointer to the data of the area, valid until unmap is called
+ * @return Result of the map operation.
+ */
+typedef cy_rslt_t (* mtb_block_storage_map_t)(void* context, uint32_t addr, uint32_t length,
+                                              const uint8_t** ptr);
+
+/** Function prototype for releasing a pointer returned by map.
+ *
+ * @param[in]  context  Context object that is passed into mtb_block_storage_*_create
+ * @param[in]  ptr      Pointer returned by map
+ * @param[in]  length   Length given to map
+ * @return Result of the unmap operation.
+ */
+typedef cy_rslt_t (* mtb_block_storage_unmap_t)(void* context, const uint8_t* ptr,
+                                                uint32_t length);
+
+/** Block device interface
+ *
+ *  The optional members are called only when they are not NULL. A custom device must zero
+ *  initialize the whole structure, e.g. with memset or an initializer, before setting its
+ *  functions: the members added in a later version of the library then read as not supported
+ *  instead of holding garbage that would be called.
+ */
 typedef struct
 {
     void*                               context;           /**< Context object that can be used in
@@ -234,11 +388,252 @@ typedef struct
                                                                            whether the memory
                                                                            type does require erase
                                                                               operation */
+    mtb_block_storage_get_geometry_t    get_geometry;       /**< Function to get the geometry of
+                                                               the whole device, can be NULL */
+    mtb_block_storage_register_callback_t register_callback; /**< Function to register the
+                                                                non blocking completion callback,
+                                                                can be NULL */
+    mtb_block_storage_poll_t            poll;               /**< Function to advance and check the
+                                                               non blocking operation, can be NULL
+                                                             */
+    mtb_block_storage_readv_t           readv;              /**< Function to read several
+                                                               fragments in one call, can be NULL.
+                                                               Use mtb_block_storage_readv. */
+    mtb_block_storage_programv_t        programv;           /**< Function to program several
+                                                               fragments in one call, can be NULL.
+                                                               Use mtb_block_storage_programv. */
+    mtb_block_storage_map_t             map;                /**< Function to get a pointer to
+                                                               the data of an area, can be NULL */
+    mtb_block_storage_unmap_t           unmap;              /**< Function to release a pointer
+                                                               returned by map, can be NULL */
 } mtb_block_storage_t;
 
+/** Function to get the full geometry of a block device in one call, so that callers can cache
+ *  it instead of querying the sizes of every address they touch.
+ *
+ * @param[in]  bsd          Block storage element
+ * @param[out] regions      Array filled with the regions of the device sorted by address
+ * @param[in]  max_regions  Number of entries available in regions
+ * @param[out] region_count Number of regions of the device
+ * @return Result of the operation, MTB_BLOCK_STORAGE_NOT_SUPPORTED_ERROR if the device does not
+ *         provide its geometry
+ */
+cy_rslt_t mtb_block_storage_get_geometry(const mtb_block_storage_t* bsd,
+                                         mtb_block_storage_region_t* regions,
+                                         uint32_t max_regions, uint32_t* region_count);
+
+/** Function to read several fragments of a block device, e.g. a record header and its payload
+ *  into separate buffers. Uses the readv function of the device when it provides one, which
+ *  handles the whole batch in one call. Otherwise each fragment is read with the read function,
+ *  a fragment that continues the previous one both on the device and in memory being merged
+ *  into the same call.
+ *
+ * @param[in]  bsd      Block storage element
+ * @param[in]  vecs     Fragments to read, in order. Can be NULL if count is 0.
+ * @param[in]  count    Number of entries in vecs
+ * @return Result of the operation, the fragments following a failed one are not read
+ */
+cy_rslt_t mtb_block_storage_readv(const mtb_block_storage_t* bsd,
+                                  const mtb_block_storage_read_vec_t* vecs, uint32_t count);
+
+/** Function to program several fragments of a block device, e.g. a record header and its
+ *  payload from separate buffers, without copying them into a single buffer first. Each fragment
+ *  must be aligned to the program size. Uses the programv function of the device when it provides
+ *  one, otherwise each fragment is programmed with the program function, merging the fragments
+ *  that continue the previous one both on the device and in memory.
+ *
+ * @param[in]  bsd      Block storage element
+ * @param[in]  vecs     Fragments to program, in order. Can be NULL if count is 0.
+ * @param[in]  count    Number of entries in vecs
+ * @return Result of the operation, the fragments following a failed one are not programmed
+ */
+cy_rslt_t mtb_block_storage_programv(const mtb_block_storage_t* bsd,
+                                     const mtb_block_storage_program_vec_t* vecs, uint32_t count);
+
+/** Function to get a pointer to the data of an area, for the memory mapped devices (HAL NVM,
+ *  PDL, RAM and file). Lookup tables and records can then be scanned in place, without copying
+ *  them into RAM first. A pending non blocking operation is completed first, like for a read.
+ *  The data must not be modified through the pointer, and the area must not be programmed or
+ *  erased until it is unmapped.
+ *
+ * @param[in]  bsd      Block storage element
+ * @param[in]  addr     Address of the area
+ * @param[in]  length   Length of the area
+ * @param[out] ptr      Pointer to the data of the area
+ * @return Result of the operation, MTB_BLOCK_STORAGE_NOT_SUPPORTED_ERROR if the memory of the
+ *         device is not mapped, in which case the area must be copied with read
+ */
+cy_rslt_t mtb_block_storage_map(const mtb_block_storage_t* bsd, uint32_t addr, uint32_t length,
+                                const uint8_t** ptr);
+
+/** Function to release a pointer returned by \ref mtb_block_storage_map.
+ *
+ * @param[in]  bsd      Block storage element
+ * @param[in]  ptr      Pointer returned by mtb_block_storage_map
+ * @param[in]  length   Length given to mtb_block_storage_map
+ * @return Result of the operation
+ */
+cy_rslt_t mtb_block_storage_unmap(const mtb_block_storage_t* bsd, const uint8_t* ptr,
+                                  uint32_t length);
+
+/** Function to find the region to which an address belongs in a geometry returned by
+ *  \ref mtb_block_storage_get_geometry.
+ *
+ * @param[in]  regions      Regions sorted by address
+ * @param[in]  region_count Number of entries in regions
+ * @param[in]  addr         Address to look up
+ * @return Region to which the address belongs, NULL if it is not in any region
+ */
+const mtb_block_storage_region_t* mtb_block_storage_find_region(
+    const mtb_block_storage_region_t* regions, uint32_t region_count, uint32_t addr);
+
+/** Function to erase an area, skipping the erase units that already read as the erase value.
+ *  Each erase unit is compared a word at a time in place when the device maps it, otherwise it is
+ *  read through scratch. The work flash of the XMC7000 and TRAVEO T2G devices is checked by the
+ *  flash controller with Cy_Flash_BlankCheck instead. Consecutive units that are not blank are
+ *  erased with a single erase call. The erase of a blank unit costs a read instead of the erase
+ *  time and an endurance cycle.
+ *
+ * @param[in]  bsd          Block storage element
+ * @param[in]  addr         Address of the area to erase, aligned to the erase size
+ * @param[in]  length       Length of the area to erase, multiple of the erase size
+ * @param[in]  scratch      Buffer used to read the content of the erase units
+ * @param[in]  scratch_size Size of scratch, multiple of the read size of the device
+ * @param[out] skipped      Number of erase units that were already blank, can be NULL
+ * @return Result of the operation
+ */
+cy_rslt_t mtb_block_storage_erase_blank_check(const mtb_block_storage_t* bsd, uint32_t addr,
+                                              uint32_t length, uint8_t* scratch,
+                                              uint32_t scratch_size, uint32_t* skipped);
+
+/** Function to check whether programming data over the current content of an area needs an
+ *  erase first. No erase is needed when the new data only moves bits away from the erase value,
+ *  e.g. only clears bits on a NOR flash whose erase value is 0xFF.
+ *
+ * @param[in]  current      Current content of the area
+ * @param[in]  data         Data to program
+ * @param[in]  length       Length of the area
+ * @param[in]  erase_value  Erase value of the area
+ * @return Whether some bit of data can only be reached through an erase
+ */
+bool mtb_block_storage_is_erase_needed(const uint8_t* current, const uint8_t* data,
+                                       uint32_t length, uint8_t erase_value);
+
+/** Step of an erase plan, a run of erase commands of the same size */
+typedef struct
+{
+    uint32_t addr;          /**< Address of the first byte erased by the step */
+    uint32_t length;        /**< Number of bytes erased by the step, multiple of erase_size */
+    uint32_t erase_size;    /**< Size of each erase command of the step, 0 for a chip erase */
+} mtb_block_storage_erase_step_t;
+
+/** Function prototype for issuing one erase command larger than the erase size of the device,
+ *  e.g. a 32 KB or 64 KB block erase of a serial NOR flash.
+ *
+ * @param[in]  arg      Argument that is passed into mtb_block_storage_execute_erase_plan
+ * @param[in]  addr     Address of the block, aligned to size
+ * @param[in]  size     Size of the block, 0 for a chip erase
+ * @return Result of the erase command
+ */
+typedef cy_rslt_t (* mtb_block_storage_block_erase_t)(void* arg, uint32_t addr, uint32_t size);
+
+/** Function to break an erase range into the largest erase commands the memory supports. A block
+ *  size is used where the block is aligned, fully inside the range and made only of sectors of
+ *  the same erase size, so hybrid sector layouts are handled. A range covering the whole device
+ *  becomes a single chip erase step.
+ *
+ * @param[in]  bsd              Block storage element
+ * @param[in]  block_sizes      Erase sizes supported on top of the erase size of the device, e.g.
+ *                              32 KB and 64 KB. Can be NULL if block_size_count is 0.
+ * @param[in]  block_size_count Number of entries in block_sizes
+ * @param[in]  device_size      Size of the device, 0 to never plan a chip erase
+ * @param[in]  addr             Address of the range, aligned to the erase size
+ * @param[in]  length           Length of the range, multiple of the erase size
+ * @param[out] steps            Array filled with the plan. Can be NULL if max_steps is 0.
+ * @param[in]  max_steps        Number of entries available in steps
+ * @param[out] step_count       Number of steps of the plan. If it is bigger than max_steps, only
+ *                              the first max_steps entries are filled and
+ *                              MTB_BLOCK_STORAGE_INVALID_SIZE_ERROR is returned.
+ * @return Result of the operation
+ */
+cy_rslt_t mtb_block_storage_plan_erase(const mtb_block_storage_t* bsd,
+                                       const uint32_t* block_sizes, uint32_t block_size_count,
+                                       uint32_t device_size, uint32_t addr, uint32_t length,
+                                       mtb_block_storage_erase_step_t* steps, uint32_t max_steps,
+                                       uint32_t* step_count);
+
+/** Function to execute an erase plan returned by \ref mtb_block_storage_plan_erase. The steps
+ *  using the erase size of the device are erased with the erase function of the device. Block
+ *  and chip erase steps are issued through block_erase, or through the erase function of the
+ *  device when block_erase is NULL, in which case the device decides which commands are used.
+ *
+ * @param[in]  bsd              Block storage element
+ * @param[in]  steps            Plan to execute
+ * @param[in]  step_count       Number of entries in steps
+ * @param[in]  block_erase      Function issuing the block and chip erase commands, can be NULL
+ * @param[in]  block_erase_arg  Argument passed to block_erase
+ * @return Result of the operation
+ */
+cy_rslt_t mtb_block_storage_execute_erase_plan(const mtb_block_storage_t* bsd,
+                                               const mtb_block_storage_erase_step_t* steps,
+                                               uint32_t step_count,
+                                               mtb_block_storage_block_erase_t block_erase,
+                                               void* block_erase_arg);
+
+/** Option of the HAL NVM and PDL devices and of the write-back cache: the data is compared with
+ *  the content of the memory first, and the program rows (or cache units) that already hold it
+ *  are not programmed. On the work flash of XMC7000 and TRAVEO T2G devices the HAL NVM device
+ *  blank checks each row with Cy_Flash_BlankCheck and only reads the programmed ones. */
+#define MTB_BLOCK_STORAGE_OPTION_COMPARE_BEFORE_PROGRAM     (1UL << 0)
+/** Option of the write-back cache, only used together with
+ *  MTB_BLOCK_STORAGE_OPTION_COMPARE_BEFORE_PROGRAM: a unit whose new content only moves bits away
+ *  from the erase value is programmed without an erase. Only for memories that accept
+ *  programming over programmed data, e.g. NOR flash without ECC. */
+#define MTB_BLOCK_STORAGE_OPTION_PROGRAM_WITHOUT_ERASE      (1UL << 1)
+/** Option of the HAL NVM device: a read of a bank other than the one of the non blocking program
+ *  or erase in progress is served right away instead of waiting for the operation to complete,
+ *  and the blocking program and erase start each row without waiting and poll for its
+ *  completion, so that interrupts and other threads keep running, and reading the other banks,
+ *  while the row is written. Meanwhile a read of the bank being written waits and program_nb and
+ *  erase_nb return MTB_BLOCK_STORAGE_BUSY, as for a non blocking operation, but the completion
+ *  callback is not invoked. The banks are set by MTB_BLOCK_STORAGE_NVM_BANKS and returned by
+ *  get_geometry. Only has an effect where the non blocking operations are supported. */
+#define MTB_BLOCK_STORAGE_OPTION_READ_WHILE_WRITE           (1UL << 2)
+
 #if !defined(COMPONENT_CAT2)
 #if (CYHAL_DRIVER_AVAILABLE_NVM) || (CYHAL_DRIVER_AVAILABLE_FLASH) || (MTB_HAL_DRIVER_AVAILABLE_NVM)
+/** Maximum number of NVM regions cached by each HAL NVM block storage device */
+#if !defined(MTB_BLOCK_STORAGE_NVM_MAX_REGIONS)
+#define MTB_BLOCK_STORAGE_NVM_MAX_REGIONS       (8u)
+#endif
+
+/** Maximum number of HAL NVM objects that HAL NVM block storage devices can be created for at the
+ *  same time, a slot is released by mtb_block_storage_nvm_deinit */
+#if !defined(MTB_BLOCK_STORAGE_NVM_MAX_INSTANCES)
+#define MTB_BLOCK_STORAGE_NVM_MAX_INSTANCES     (2u)
+#endif
+
+/** Address range of a flash bank made of several HAL NVM regions */
+typedef struct
+{
+    uint32_t start_address;        /**< Address of the first byte of the bank */
+    uint32_t size;                 /**< Size of the bank in bytes */
+} mtb_block_storage_nvm_bank_t;
+
+/** Banks of the HAL NVM device, as an initializer of a mtb_block_storage_nvm_bank_t array. The
+ *  regions starting in the n-th entry are bank n + 1 and all the other regions are bank 0. When
+ *  it is not defined, each region reported by the HAL is a bank. CAT1C devices report the large
+ *  and small sector regions of one flash as separate regions, so there only the work flash is a
+ *  bank of its own and the code flash regions share bank 0. */
+#if !defined(MTB_BLOCK_STORAGE_NVM_BANKS) && defined(COMPONENT_CAT1C)
+#define MTB_BLOCK_STORAGE_NVM_BANKS             { { CY_WFLASH_BASE, CY_WFLASH_SIZE } }
+#endif
+
 /** Function to create the block storage elements for devices that have HAL support.
+ *  The NVM regions are cached in a table owned by the device, so that no HAL query is needed
+ *  to find the region of an address. The context of bsd is this private table, not the HAL
+ *  object. The devices created again on the same HAL object, or with the classic HAL, share its
+ *  context: its options, callback and operation in progress are kept.
  *
  * @param[in]  bsd  Block storage element to be initialized
  * @param[in]  obj  Preinitialized HAL NVM object that is to used for block storage
@@ -252,6 +647,56 @@ cy_rslt_t mtb_block_storage_create_hal_nvm(mtb_block_storage_t* bsd, mtb_hal_nvm
 cy_rslt_t mtb_block_storage_create_hal_nvm(mtb_block_storage_t* bsd, void* obj);
 #endif
 
+/** Function to set the options of a HAL NVM block storage device.
+ *
+ * @param[in]  bsd      Block storage element created by mtb_block_storage_create_hal_nvm
+ * @param[in]  options  Combination of the MTB_BLOCK_STORAGE_OPTION_* values, 0 by default
+ * @return Result of the operation
+ */
+cy_rslt_t mtb_block_storage_nvm_set_options(mtb_block_storage_t* bsd, uint32_t options);
+
+/** Function to release a HAL NVM block storage device. The context shared by the devices created
+ *  on the same HAL object is released with the last of them, which first waits for the non
+ *  blocking operation in progress, making its slot available to another HAL object. With the
+ *  classic HAL, the HAL object is then freed. With HAL next, the HAL object belongs to the
+ *  application and is left initialized. The device must not be used afterwards.
+ *
+ * @param[in]  bsd  Block storage element created by mtb_block_storage_create_hal_nvm
+ * @return Result of the operation
+ */
+cy_rslt_t mtb_block_storage_nvm_deinit(mtb_block_storage_t* bsd);
+
+/** Function to read from a HAL NVM block storage device. It is the read function of the device,
+ *  exported so that it can be called directly, e.g. by mtb_block_storage::NvmBackend.
+ *
+ * @param[in]  context  Context of the device, the context member of its block storage element
+ * @param[in]  addr     Address to read from
+ * @param[in]  length   Length of the data to read
+ * @param[out] buf      Buffer receiving the data
+ * @return Result of the read
+ */
+cy_rslt_t mtb_block_storage_nvm_read(void* context, uint32_t addr, uint32_t length, uint8_t* buf);
+
+/** Function to program a HAL NVM block storage device, its program function.
+ *
+ * @param[in]  context  Context of the device, the context member of its block storage element
+ * @param[in]  addr     Address to program
+ * @param[in]  length   Length of the data to program
+ * @param[in]  buf      Data to program
+ * @return Result of the program
+ */
+cy_rslt_t mtb_block_storage_nvm_program(void* context, uint32_t addr, uint32_t length,
+                                        const uint8_t* buf);
+
+/** Function to erase a HAL NVM block storage device, its erase function.
+ *
+ * @param[in]  context  Context of the device, the context member of its block storage element
+ * @param[in]  addr     Address of the area to erase
+ * @param[in]  length   Length of the area to erase
+ * @return Result of the erase
+ */
+cy_rslt_t mtb_block_storage_nvm_erase(void* context, uint32_t addr, uint32_t length);
+
 /** Deprecated, for backwards compatibility */
 #define mtb_block_storage_nvm_create(bsd) mtb_block_storage_create_hal_nvm(bsd, NULL)
 #endif \
@@ -259,13 +704,54 @@ cy_rslt_t mtb_block_storage_create_hal_nvm(mtb_block_storage_t* bsd, void* obj);
     // (MTB_HAL_DRIVER_AVAILABLE_NVM)
 #else // if !defined(COMPONENT_CAT2)
 /** Function to create the block storage elements for CAT2 that does not have HAL NVM support.
- *  It is built directly on top of the PDL layer.
+ *  It is built directly on top of the PDL layer. The non blocking functions are provided when
+ *  the PDL supports non blocking flash writes (CY_FLASH_NON_BLOCKING_SUPPORTED), the application
+ *  then routes the SPCIF interrupt to Cy_Flash_ResumeWrite.
  *
  * @param[in]  bsd  Block storage element to be initialized
  * @return Result of the create function
  */
 cy_rslt_t mtb_block_storage_create_pdl(mtb_block_storage_t* bsd);
 
+/** Function to set the options of the PDL block storage device.
+ *
+ * @param[in]  bsd      Block storage element created by mtb_block_storage_create_pdl
+ * @param[in]  options  Combination of the MTB_BLOCK_STORAGE_OPTION_* values, 0 by default
+ * @return Result of the operation
+ */
+cy_rslt_t mtb_block_storage_pdl_set_options(mtb_block_storage_t* bsd, uint32_t options);
+
+/** Function to read from a PDL block storage device. It is the read function of the device,
+ *  exported so that it can be called directly, e.g. by mtb_block_storage::PdlBackend.
+ *
+ * @param[in]  context  Context of the device, the context member of its block storage element
+ * @param[in]  addr     Address to read from
+ * @param[in]  length   Length of the data to read
+ * @param[out] buf      Buffer receiving the data
+ * @return Result of the read
+ */
+cy_rslt_t mtb_block_storage_pdl_read(void* context, uint32_t addr, uint32_t length, uint8_t* buf);
+
+/** Function to program a PDL block storage device, its program function.
+ *
+ * @param[in]  context  Context of the device, the context member of its block storage element
+ * @param[in]  addr     Address to program
+ * @param[in]  length   Length of the data to program
+ * @param[in]  buf      Data to program
+ * @return Result of the program
+ */
+cy_rslt_t mtb_block_storage_pdl_program(void* context, uint32_t addr, uint32_t length,
+                                        const uint8_t* buf);
+
+/** Function to erase a PDL block storage device, its erase function.
+ *
+ * @param[in]  context  Context of the device, the context member of its block storage element
+ * @param[in]  addr     Address of the area to erase
+ * @param[in]  length   Length of the area to erase
+ * @return Result of the erase
+ */
+cy_rslt_t mtb_block_storage_pdl_erase(void* context, uint32_t addr, uint32_t length);
+
 /** Deprecated, for backwards compatibility */
 #define mtb_block_storage_cat2_create mtb_block_storage_create_pdl
 #endif // if !defined(COMPONENT_CAT2)
@@ -281,6 +767,62 @@ cy_rslt_t mtb_block_storage_create_pdl(mtb_block_storage_t* bsd);
  */
 cy_rslt_t mtb_block_storage_create_serial_memory(mtb_block_storage_t* bsd,
                                                  mtb_serial_memory_t* obj);
+
+/** Maximum number of lines that the read cache of a serial memory device can hold */
+#if !defined(MTB_BLOCK_STORAGE_SERIAL_MEMORY_CACHE_MAX_LINES)
+#define MTB_BLOCK_STORAGE_SERIAL_MEMORY_CACHE_MAX_LINES     (16u)
+#endif
+
+/** Configuration of the read cache of a serial memory device */
+typedef struct
+{
+    uint8_t*    buffer;         /**< Memory holding the cached lines, must stay valid while the
+                                   device is in use */
+    uint32_t    buffer_size;    /**< Size of buffer, it holds buffer_size / line_size lines, up to
+                                   MTB_BLOCK_STORAGE_SERIAL_MEMORY_CACHE_MAX_LINES */
+    uint32_t    line_size;      /**< Number of bytes fetched by one read command on a miss, the
+                                   size of the memory must be a multiple of it */
+    uint32_t    prefetch_lines; /**< Number of lines fetched ahead, in the same read command,
+                                   when the reads are sequential. 0 disables the prefetch. */
+} mtb_block_storage_serial_memory_cache_config_t;
+
+/** Line of the serial memory read cache. All members are private. */
+typedef struct
+{
+    uint32_t    addr;       /**< Address of the line */
+    uint32_t    last_use;   /**< Value of the use counter on the last access */
+    bool        valid;      /**< Whether the line holds data */
+} mtb_block_storage_serial_memory_cache_line_t;
+
+/** Serial memory device with a read cache. All members are private. */
+typedef struct
+{
+    mtb_serial_memory_t*                            memory;     /**< Serial memory object */
+    mtb_block_storage_serial_memory_cache_config_t  config;     /**< Copy of the configuration */
+    uint32_t                                        line_count; /**< Number of usable lines */
+    uint32_t                                        use_counter;    /**< Incremented on every
+                                                                       access */
+    uint32_t                                        next_addr;  /**< End of the last read, a read
+                                                                   starting there is sequential */
+    mtb_block_storage_serial_memory_cache_line_t
+        lines[MTB_BLOCK_STORAGE_SERIAL_MEMORY_CACHE_MAX_LINES];    /**< Cached lines */
+} mtb_block_storage_serial_memory_cached_t;
+
+/** Function to create the block storage elements for a serial memory with a read cache. Reads
+ * shorter than a line are served from the cache, which is refilled one line per read command, or
+ * several lines when the reads are sequential. program and erase on the created device
+ * invalidate the lines they overlap.
+ *
+ * @param[in]  bsd      Block storage element to be initialized
+ * @param[out] cached   Object holding the cache state, must stay valid while the device is in use
+ * @param[in]  obj      Preinitialized serial memory object that can be used for block storage
+ *                      operations
+ * @param[in]  config   Configuration of the cache
+ * @return Result of the create function
+ */
+cy_rslt_t mtb_block_storage_create_serial_memory_cached(
+    mtb_block_storage_t* bsd, mtb_block_storage_serial_memory_cached_t* cached,
+    mtb_serial_memory_t* obj, const mtb_block_storage_serial_memory_cache_config_t* config);
 #endif // defined(COMPONENT_MW_SERIAL_MEMORY)
 
 #if defined(COMPONENT_SERIAL_FLASH)
@@ -293,4 +835,177 @@ cy_rslt_t mtb_block_storage_create_serial_memory(mtb_block_storage_t* bsd,
 cy_rslt_t mtb_block_storage_create_serial_flash(mtb_block_storage_t* bsd);
 #endif // defined(COMPONENT_SERIAL_FLASH)
 
+/** Maximum number of regions that a RAM block storage device can be made of */
+#if !defined(MTB_BLOCK_STORAGE_RAM_MAX_REGIONS)
+#define MTB_BLOCK_STORAGE_RAM_MAX_REGIONS   (8u)
+#endif
+
+/** Function prototype used by the RAM block storage device to spend the modeled latency of an
+ *  operation in real time.
+ *
+ * @param[in]  delay_us Modeled latency of the operation in microseconds
+ */
+typedef void (* mtb_block_storage_ram_delay_t)(uint32_t delay_us);
+
+/** Geometry and timing model of one region of a RAM block storage device */
+typedef struct
+{
+    uint32_t start_address;        /**< Address of the first byte of the region */
+    uint32_t size;                 /**< Size of the region in bytes, multiple of erase_size */
+    uint32_t program_size;         /**< Minimum programmable unit in bytes */
+    uint32_t erase_size;           /**< Minimum erasable unit in bytes, multiple of program_size */
+    uint8_t  erase_value;          /**< Value of every byte after an erase */
+    bool     is_erase_required;    /**< Whether an erase is needed before reprogramming */
+    uint32_t read_latency_us;      /**< Modeled latency of one read call */
+    uint32_t program_latency_us;   /**< Modeled latency of programming one program unit */
+    uint32_t erase_latency_us;     /**< Modeled latency of erasing one erase unit */
+    uint8_t  bank;                 /**< Bank of the region. A read waits for the non blocking
+                                      operation in progress only if it is in the same bank. */
+} mtb_block_storage_ram_region_t;
+
+/** Configuration of a RAM block storage device */
+typedef struct
+{
+    const mtb_block_storage_ram_region_t* regions;  /**< Regions sorted by address, must not
+                                                       overlap. Must stay valid while the device
+                                                       is in use */
+    uint32_t                              region_count;  /**< Number of entries in regions */
+    uint8_t*                              memory;   /**< Backing memory, the regions are laid out
+                                                       back to back so its size must be the sum
+                                                       of all region sizes */
+    /** One bit per program unit used to reject reprogramming without an erase, see
+        \ref mtb_block_storage_ram_get_program_map_size for its size. Required if a region has
+        is_erase_required set, can be NULL otherwise. When memory is not initialized, the units
+        that do not read as erased start programmed. */
+    uint32_t*                             program_map;
+    mtb_block_storage_ram_delay_t         delay;    /**< Optional, called with the modeled
+                                                       latency of each operation. Can be NULL. */
+    bool                                  initialize;   /**< Fill memory with the erase value of
+                                                           each region on create */
+} mtb_block_storage_ram_config_t;
+
+/** RAM block storage object. All members are private except elapsed_us. */
+typedef struct
+{
+    mtb_block_storage_ram_config_t config;  /**< Copy of the configuration */
+    uint32_t memory_offset[MTB_BLOCK_STORAGE_RAM_MAX_REGIONS]; /**< Offset of each region in
+                                                                  memory */
+    uint32_t map_offset[MTB_BLOCK_STORAGE_RAM_MAX_REGIONS];    /**< First bit of each region in
+                                                                  program_map */
+    uint64_t elapsed_us;    /**< Sum of the modeled latency of all operations performed so far */
+    uint8_t  nb_operation;  /**< Non blocking operation in progress */
+    uint32_t nb_addr;       /**< Next address of the non blocking operation */
+    uint32_t nb_end;        /**< End address of the non blocking operation */
+    const uint8_t* nb_buf;  /**< Next data of the non blocking program operation */
+    cy_rslt_t nb_result;    /**< Result of the last non blocking operation */
+    mtb_block_storage_async_callback_t callback;    /**< Non blocking completion callback */
+    void*    callback_arg;  /**< Argument of the non blocking completion callback */
+} mtb_block_storage_ram_t;
+
+/** Function to get the number of 32-bit words needed for the program map of a RAM block storage
+ * device.
+ *
+ * @param[in]  regions      Regions of the device
+ * @param[in]  region_count Number of entries in regions
+ * @return Size of the program map in words
+ */
+uint32_t mtb_block_storage_ram_get_program_map_size(const mtb_block_storage_ram_region_t* regions,
+                                                    uint32_t region_count);
+
+/** Function to create the block storage elements for a simulated device backed by RAM.
+ *  This does not need any hardware, so it can be used to test and measure storage code on host.
+ *  Programming can only move bits away from the erase value, like on a real flash, and a program
+ *  unit of a region requiring an erase cannot be programmed again before it is erased.
+ *
+ * @param[in]  bsd      Block storage element to be initialized
+ * @param[in]  obj      RAM block storage object to be used for the device
+ * @param[in]  config   Configuration of the device
+ * @return Result of the create function, MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR if a region
+ *         requires an erase and there is no program map
+ */
+cy_rslt_t mtb_block_storage_create_ram(mtb_block_storage_t* bsd, mtb_block_storage_ram_t* obj,
+                                       const mtb_block_storage_ram_config_t* config);
+
+/** Function to read from a RAM block storage device. It is the read function of the device,
+ *  exported so that it can be called directly, e.g. by mtb_block_storage::RamBackend.
+ *
+ * @param[in]  context  Context of the device, the context member of its block storage element
+ * @param[in]  addr     Address to read from
+ * @param[in]  length   Length of the data to read
+ * @param[out] buf      Buffer receiving the data
+ * @return Result of the read
+ */
+cy_rslt_t mtb_block_storage_ram_read(void* context, uint32_t addr, uint32_t length, uint8_t* buf);
+
+/** Function to program a RAM block storage device, its program function.
+ *
+ * @param[in]  context  Context of the device, the context member of its block storage element
+ * @param[in]  addr     Address to program
+ * @param[in]  length   Length of the data to program
+ * @param[in]  buf      Data to program
+ * @return Result of the program
+ */
+cy_rslt_t mtb_block_storage_ram_program(void* context, uint32_t addr, uint32_t length,
+                                        const uint8_t* buf);
+
+/** Function to erase a RAM block storage device, its erase function.
+ *
+ * @param[in]  context  Context of the device, the context member of its block storage element
+ * @param[in]  addr     Address of the area to erase
+ * @param[in]  length   Length of the area to erase
+ * @return Result of the erase
+ */
+cy_rslt_t mtb_block_storage_ram_erase(void* context, uint32_t addr, uint32_t length);
+
+#if defined(MTB_BLOCK_STORAGE_FILE_SUPPORTED)
+/** File block storage object. All members are private except base. */
+typedef struct
+{
+    mtb_block_storage_ram_t ram;        /**< RAM device operating on the mapped image */
+    int                     fd;         /**< Descriptor of the image file */
+    uint8_t*                base;       /**< Start of the mapped image, the first region starts
+                                           at offset 0. Can be used for zero-copy access. */
+    size_t                  size;       /**< Size of the image in bytes */
+} mtb_block_storage_file_t;
+
+/** Function to create the block storage elements for a simulated device backed by a memory
+ *  mapped image file. The image is not copied into RAM and changes are written back to the file,
+ *  so the content persists across process runs. The device follows the same rules as the RAM
+ *  device, see \ref mtb_block_storage_create_ram. The program map is allocated by create, with
+ *  the units of the image that are not erased marked as programmed, and freed by close.
+ *  If the file does not exist or is empty it is created and filled with the erase value of each
+ *  region, otherwise its size must match the sum of the region sizes.
+ *
+ * @param[in]  bsd          Block storage element to be initialized
+ * @param[in]  obj          File block storage object to be used for the device
+ * @param[in]  path         Path of the image file
+ * @param[in]  regions      Regions of the device sorted by address. Must stay valid while the
+ *                          device is in use.
+ * @param[in]  region_count Number of entries in regions
+ * @return Result of the create function
+ */
+cy_rslt_t mtb_block_storage_create_file(mtb_block_storage_t* bsd, mtb_block_storage_file_t* obj,
+                                        const char* path,
+                                        const mtb_block_storage_ram_region_t* regions,
+                                        uint32_t region_count);
+
+/** Function to write back all changes to the image file.
+ *
+ * @param[in]  obj  File block storage object
+ * @return Result of the sync operation
+ */
+cy_rslt_t mtb_block_storage_file_sync(mtb_block_storage_file_t* obj);
+
+/** Function to write back all changes, unmap and close the image file.
+ *
+ * @param[in]  obj  File block storage object
+ * @return Result of the close operation
+ */
+cy_rslt_t mtb_block_storage_file_close(mtb_block_storage_file_t* obj);
+#endif // defined(MTB_BLOCK_STORAGE_FILE_SUPPORTED)
+
 /** \} group_block_storage */
+
+#if defined(__cplusplus)
+}
+#endif
@@ -0,0 +1,384 @@
+/***********************************************************************************************//**
+ * \file mtb_block_storage.hpp
+ *
+ * \brief
+ * C++ interface of the block storage library. Wraps a block storage backend in a class whose
+ * geometry can be fixed at compile time, so that the calls to a backend known at build time are
+ * direct and its alignment checks are folded by the compiler.
+ *
+ ***************************************************************************************************
+ * \copyright
+ * Copyright 2024 Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **************************************************************************************************/
+#pragma once
+
+#include "mtb_block_storage.h"
+
+/**
+ * \addtogroup group_block_storage_cpp Block Storage C++ Interface
+ * \{
+ * Every call made through a \ref mtb_block_storage_t goes through a function pointer, and the
+ * program and erase sizes are queried at runtime, so the alignment checks of the callers are
+ * divisions by a value unknown to the compiler. An application that links a single device knows
+ * both at build time.
+ *
+ * BlockDevice<Backend, Geometry> calls the read, program and erase functions of Backend and takes
+ * the sizes from Geometry:
+ * - \ref mtb_block_storage::FunctionBackend calls C functions given as template arguments, so the
+ *   calls are direct and can be inlined. RamBackend, NvmBackend and PdlBackend call the devices
+ *   of this library. Any class with the same read, program and erase members can also be used,
+ *   e.g. a driver written in C++.
+ * - \ref mtb_block_storage::StaticGeometry holds the sizes and the erase value of a device whose
+ *   regions all have the same geometry as constexpr values, so the alignment checks fold away.
+ * - \ref mtb_block_storage::DynamicBackend and \ref mtb_block_storage::DynamicGeometry, the
+ *   default arguments, fall back to a \ref mtb_block_storage_t for the devices only known at
+ *   runtime, e.g. the decorators of this library.
+ *
+ * The functions return the cy_rslt_t of the backend, the facade adds no exceptions. A
+ * StaticGeometry must match the real geometry of the backend, it is not checked against it.
+ */
+
+#if defined(__cplusplus)
+
+namespace mtb_block_storage
+{
+/** Backend calling the functions of a block storage element, for the devices only known at
+ *  runtime */
+class DynamicBackend
+{
+public:
+    /** Creates a backend calling the functions of bsd, which must stay valid while it is used
+     *
+     * @param[in]  bsd      Block storage element
+     */
+    explicit DynamicBackend(const mtb_block_storage_t* bsd) : _bsd(bsd) { }
+
+    /** Reads from the device, see \ref mtb_block_storage_read_t */
+    cy_rslt_t read(uint32_t addr, uint32_t length, uint8_t* buf) const
+    {
+        return _bsd->read(_bsd->context, addr, length, buf);
+    }
+
+    /** Programs the device, see \ref mtb_block_storage_program_t */
+    cy_rslt_t program(uint32_t addr, uint32_t length, const uint8_t* buf) const
+    {
+        return _bsd->program(_bsd->context, addr, length, buf);
+    }
+
+    /** Erases the device, see \ref mtb_block_storage_erase_t */
+    cy_rslt_t erase(uint32_t addr, uint32_t length) const
+    {
+        return _bsd->erase(_bsd->context, addr, length);
+    }
+
+    /** Returns the read size at addr, see \ref mtb_block_storage_read_size_t */
+    uint32_t read_size(uint32_t addr) const
+    {
+        return _bsd->get_read_size(_bsd->context, addr);
+    }
+
+    /** Returns the program size at addr, see \ref mtb_block_storage_program_size_t */
+    uint32_t program_size(uint32_t addr) const
+    {
+        return _bsd->get_program_size(_bsd->context, addr);
+    }
+
+    /** Returns the erase size at addr, see \ref mtb_block_storage_erase_size_t */
+    uint32_t erase_size(uint32_t addr) const
+    {
+        return _bsd->get_erase_size(_bsd->context, addr);
+    }
+
+    /** Returns the erase value at addr, see \ref mtb_block_storage_erase_value_t */
+    uint8_t erase_value(uint32_t addr) const
+    {
+        return _bsd->get_erase_value(_bsd->context, addr);
+    }
+
+    /** Returns the block storage element */
+    const mtb_block_storage_t* bsd() const
+    {
+        return _bsd;
+    }
+
+private:
+    const mtb_block_storage_t* _bsd;
+};
+
+/** Backend calling C functions known at compile time with their context
+ *
+ * @tparam Read     Read function of the device
+ * @tparam Program  Program function of the device
+ * @tparam Erase    Erase function of the device
+ */
+template <mtb_block_storage_read_t Read, mtb_block_storage_program_t Program,
+          mtb_block_storage_erase_t Erase>
+class FunctionBackend
+{
+public:
+    /** Creates a backend passing context to the functions
+     *
+     * @param[in]  context  Context of the device
+     */
+    explicit FunctionBackend(void* context) : _context(context) { }
+
+    /** Reads from the device, see \ref mtb_block_storage_read_t */
+    cy_rslt_t read(uint32_t addr, uint32_t length, uint8_t* buf) const
+    {
+        return Read(_context, addr, length, buf);
+    }
+
+    /** Programs the device, see \ref mtb_block_storage_program_t */
+    cy_rslt_t program(uint32_t addr, uint32_t length, const uint8_t* buf) const
+    {
+        return Program(_context, addr, length, buf);
+    }
+
+    /** Erases the device, see \ref mtb_block_storage_erase_t */
+    cy_rslt_t erase(uint32_t addr, uint32_t length) const
+    {
+        return Erase(_context, addr, length);
+    }
+
+private:
+    void* _context;
+};
+
+/** Backend calling the RAM device, created with the context member of the block storage element
+ *  initialized by \ref mtb_block_storage_create_ram */
+using RamBackend = FunctionBackend<mtb_block_storage_ram_read, mtb_block_storage_ram_program,
+                                   mtb_block_storage_ram_erase>;
+
+#if !defined(COMPONENT_CAT2)
+#if (CYHAL_DRIVER_AVAILABLE_NVM) || (CYHAL_DRIVER_AVAILABLE_FLASH) || (MTB_HAL_DRIVER_AVAILABLE_NVM)
+/** Backend calling the HAL NVM device, created with the context member of the block storage
+ *  element initialized by \ref mtb_block_storage_create_hal_nvm */
+using NvmBackend = FunctionBackend<mtb_block_storage_nvm_read, mtb_block_storage_nvm_program,
+                                   mtb_block_storage_nvm_erase>;
+#endif
+#else // if !defined(COMPONENT_CAT2)
+/** Backend calling the PDL device, created with the context member of the block storage element
+ *  initialized by \ref mtb_block_storage_create_pdl */
+using PdlBackend = FunctionBackend<mtb_block_storage_pdl_read, mtb_block_storage_pdl_program,
+                                   mtb_block_storage_pdl_erase>;
+#endif // if !defined(COMPONENT_CAT2)
+
+/** Geometry queried from the backend at runtime, for backends providing read_size,
+ *  program_size, erase_size and erase_value, such as \ref DynamicBackend */
+struct DynamicGeometry
+{
+    /** Returns the read size at addr */
+    template <typename Backend>
+    static uint32_t read_size(const Backend& backend, uint32_t addr)
+    {
+        return backend.read_size(addr);
+    }
+
+    /** Returns the program size at addr */
+    template <typename Backend>
+    static uint32_t program_size(const Backend& backend, uint32_t addr)
+    {
+        return backend.program_size(addr);
+    }
+
+    /** Returns the erase size at addr */
+    template <typename Backend>
+    static uint32_t erase_size(const Backend& backend, uint32_t addr)
+    {
+        return backend.erase_size(addr);
+    }
+
+    /** Returns the erase value at addr */
+    template <typename Backend>
+    static uint8_t erase_value(const Backend& backend, uint32_t addr)
+    {
+        return backend.erase_value(addr);
+    }
+};
+
+/** Geometry known at compile time, the same for the whole device
+ *
+ * @tparam ReadSize     Read size of the device
+ * @tparam ProgramSize  Program size of the device
+ * @tparam EraseSize    Erase size of the device
+ * @tparam EraseValue   Value of the erased bytes
+ */
+template <uint32_t ReadSize, uint32_t ProgramSize, uint32_t EraseSize, uint8_t EraseValue>
+struct StaticGeometry
+{
+    static_assert((0u != ReadSize) && (0u != ProgramSize) && (0u != EraseSize),
+                  "The sizes of a device cannot be 0");
+    static_assert(0u == (EraseSize % ProgramSize),
+                  "The erase size must be a multiple of the program size");
+
+    /** Read size of the device, for the constant expressions of the application */
+    static constexpr uint32_t READ_SIZE = ReadSize;
+    /** Program size of the device */
+    static constexpr uint32_t PROGRAM_SIZE = ProgramSize;
+    /** Erase size of the device */
+    static constexpr uint32_t ERASE_SIZE = EraseSize;
+    /** Value of the erased bytes */
+    static constexpr uint8_t ERASE_VALUE = EraseValue;
+
+    /** Returns the read size, the same at every address */
+    template <typename Backend>
+    static constexpr uint32_t read_size(const Backend&, uint32_t)
+    {
+        return ReadSize;
+    }
+
+    /** Returns the program size, the same at every address */
+    template <typename Backend>
+    static constexpr uint32_t program_size(const Backend&, uint32_t)
+    {
+        return ProgramSize;
+    }
+
+    /** Returns the erase size, the same at every address */
+    template <typename Backend>
+    static constexpr uint32_t erase_size(const Backend&, uint32_t)
+    {
+        return EraseSize;
+    }
+
+    /** Returns the erase value, the same at every address */
+    template <typename Backend>
+    static constexpr uint8_t erase_value(const Backend&, uint32_t)
+    {
+        return EraseValue;
+    }
+};
+
+/** Block storage device calling Backend, with the geometry of Geometry. The read, program and
+ *  erase functions check the buffer and the alignment of the area on the size of its first
+ *  address, then call the backend, which checks the range.
+ *
+ * @tparam Backend      Class with the read, program and erase members of \ref DynamicBackend
+ * @tparam Geometry     \ref StaticGeometry or \ref DynamicGeometry
+ */
+template <typename Backend = DynamicBackend, typename Geometry = DynamicGeometry>
+class BlockDevice
+{
+public:
+    /** Creates a device calling backend
+     *
+     * @param[in]  backend  Backend of the device
+     */
+    explicit BlockDevice(const Backend& backend) : _backend(backend) { }
+
+    /** Reads an area of the device
+     *
+     * @param[in]  addr     Address of the area
+     * @param[in]  length   Length of the area, a multiple of the read size
+     * @param[out] buf      Buffer receiving the data
+     * @return Result of the read
+     */
+    cy_rslt_t read(uint32_t addr, uint32_t length, uint8_t* buf) const
+    {
+        cy_rslt_t result = _check(buf, addr, length, read_size(addr));
+        if (result == CY_RSLT_SUCCESS)
+        {
+            result = _backend.read(addr, length, buf);
+        }
+        return result;
+    }
+
+    /** Programs an area of the device
+     *
+     * @param[in]  addr     Address of the area, aligned to the program size
+     * @param[in]  length   Length of the area, a multiple of the program size
+     * @param[in]  buf      Data to program
+     * @return Result of the program
+     */
+    cy_rslt_t program(uint32_t addr, uint32_t length, const uint8_t* buf) const
+    {
+        cy_rslt_t result = _check(buf, addr, length, program_size(addr));
+        if (result == CY_RSLT_SUCCESS)
+        {
+            result = _backend.program(addr, length, buf);
+        }
+        return result;
+    }
+
+    /** Erases an area of the device
+     *
+     * @param[in]  addr     Address of the area, aligned to the erase size
+     * @param[in]  length   Length of the area, a multiple of the erase size
+     * @return Result of the erase
+     */
+    cy_rslt_t erase(uint32_t addr, uint32_t length) const
+    {
+        cy_rslt_t result = _check_alignment(addr, length, erase_size(addr));
+        if (result == CY_RSLT_SUCCESS)
+        {
+            result = _backend.erase(addr, length);
+        }
+        return result;
+    }
+
+    /** Returns the read size at addr */
+    uint32_t read_size(uint32_t addr) const
+    {
+        return Geometry::read_size(_backend, addr);
+    }
+
+    /** Returns the program size at addr */
+    uint32_t program_size(uint32_t addr) const
+    {
+        return Geometry::program_size(_backend, addr);
+    }
+
+    /** Returns the erase size at addr */
+    uint32_t erase_size(uint32_t addr) const
+    {
+        return Geometry::erase_size(_backend, addr);
+    }
+
+    /** Returns the erase value at addr */
+    uint8_t erase_value(uint32_t addr) const
+    {
+        return Geometry::erase_value(_backend, addr);
+    }
+
+    /** Returns the backend of the device */
+    const Backend& backend() const
+    {
+        return _backend;
+    }
+
+private:
+    //With a StaticGeometry size is a constant, so the divisions become masks or disappear
+    static cy_rslt_t _check_alignment(uint32_t addr, uint32_t length, uint32_t size)
+    {
+        return ((0u == size) || (0u != (addr % size)) || (0u != (length % size)))
+            ? MTB_BLOCK_STORAGE_INVALID_SIZE_ERROR : CY_RSLT_SUCCESS;
+    }
+
+    static cy_rslt_t _check(const void* buf, uint32_t addr, uint32_t length, uint32_t size)
+    {
+        return (nullptr == buf) ? MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR :
+               _check_alignment(addr, length, size);
+    }
+
+    Backend _backend;
+};
+} // namespace mtb_block_storage
+
+#endif // defined(__cplusplus)
+
+/** \} group_block_storage_cpp */
@@ -0,0 +1,143 @@
+/***********************************************************************************************//**
+ * \file mtb_block_storage_cache.h
+ *
+ * \brief
+ * Write-back cache for block storage devices. Provides byte-granular writes on top of any block
+ * storage device by keeping the erase units being modified in RAM.
+ *
+ ***************************************************************************************************
+ * \copyright
+ * Copyright 2024 Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **************************************************************************************************/
+#pragma once
+
+#include "mtb_block_storage.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * \addtogroup group_block_storage_cache Block Storage Write-Back Cache
+ * \{
+ * The write-back cache accepts writes of any length at any address. The erase units touched by
+ * a write are read into RAM, modified there and written back (erased if required, then
+ * programmed) only when they are evicted to make room for another unit or when
+ * \ref mtb_block_storage_cache_flush is called. Repeated writes to the same erase unit are
+ * merged, so it is programmed once no matter how many times it was updated.
+ *
+ * Reads through \ref mtb_block_storage_cache_read return the cached data, so they always see the
+ * latest writes. The device must not be written directly while the cache holds dirty units.
+ * The erase units are expected to be aligned to the erase size, as on all flash devices.
+ * The cache functions are not thread safe.
+ */
+
+/** Maximum number of erase units that a cache can hold */
+#if !defined(MTB_BLOCK_STORAGE_CACHE_MAX_ENTRIES)
+#define MTB_BLOCK_STORAGE_CACHE_MAX_ENTRIES     (8u)
+#endif
+
+/** Erase unit held by the cache. All members are private. */
+typedef struct
+{
+    uint32_t    addr;       /**< Address of the erase unit */
+    uint32_t    size;       /**< Erase size of the unit, 0 if the entry is free */
+    uint32_t    last_use;   /**< Value of the use counter on the last access */
+    bool        dirty;      /**< Whether the unit has been modified since it was written back */
+    uint8_t*    data;       /**< Content of the unit */
+} mtb_block_storage_cache_entry_t;
+
+/** Write-back cache. All members are private. */
+typedef struct
+{
+    mtb_block_storage_t*            bsd;            /**< Device the cache writes back to */
+    uint32_t                        entry_size;     /**< Largest erase size that can be cached */
+    uint32_t                        entry_count;    /**< Number of usable entries */
+    uint32_t                        use_counter;    /**< Incremented on every access */
+    uint32_t                        options;        /**< MTB_BLOCK_STORAGE_OPTION_* values */
+    mtb_block_storage_cache_entry_t entries[MTB_BLOCK_STORAGE_CACHE_MAX_ENTRIES]; /**< Entries */
+} mtb_block_storage_cache_t;
+
+/** Function to initialize a write-back cache on top of a block storage device.
+ *
+ * @param[out] cache        Cache to initialize
+ * @param[in]  bsd          Block storage device the cache writes back to
+ * @param[in]  buffer       Memory holding the cached erase units
+ * @param[in]  buffer_size  Size of buffer, the number of units that can be cached is buffer_size
+ *                          divided by entry_size, up to MTB_BLOCK_STORAGE_CACHE_MAX_ENTRIES
+ * @param[in]  entry_size   Largest erase size of the areas that are written through the cache
+ * @return Result of the initialization
+ */
+cy_rslt_t mtb_block_storage_cache_init(mtb_block_storage_cache_t* cache, mtb_block_storage_t* bsd,
+                                       uint8_t* buffer, uint32_t buffer_size,
+                                       uint32_t entry_size);
+
+/** Function to set the options of a write-back cache.
+ *
+ * @param[in]  cache    Write-back cache
+ * @param[in]  options  Combination of MTB_BLOCK_STORAGE_OPTION_COMPARE_BEFORE_PROGRAM and
+ *                      MTB_BLOCK_STORAGE_OPTION_PROGRAM_WITHOUT_ERASE, 0 by default. With the
+ *                      compare option every write back first reads the unit from the device.
+ * @return Result of the operation
+ */
+cy_rslt_t mtb_block_storage_cache_set_options(mtb_block_storage_cache_t* cache, uint32_t options);
+
+/** Function to read through the cache. Data of the cached erase units is returned from RAM, the
+ *  rest is read from the device.
+ *
+ * @param[in]  cache    Write-back cache
+ * @param[in]  addr     Address to read from
+ * @param[in]  length   Number of bytes to read
+ * @param[out] buf      Buffer receiving the data
+ * @return Result of the read operation
+ */
+cy_rslt_t mtb_block_storage_cache_read(mtb_block_storage_cache_t* cache, uint32_t addr,
+                                       uint32_t length, uint8_t* buf);
+
+/** Function to write any number of bytes at any address through the cache. The data is written
+ *  to the device when the erase units are evicted or flushed.
+ *
+ * @param[in]  cache    Write-back cache
+ * @param[in]  addr     Address to write to
+ * @param[in]  length   Number of bytes to write
+ * @param[in]  buf      Data to write
+ * @return Result of the write operation, including the write back of the evicted units
+ */
+cy_rslt_t mtb_block_storage_cache_write(mtb_block_storage_cache_t* cache, uint32_t addr,
+                                        uint32_t length, const uint8_t* buf);
+
+/** Function to write back all the dirty erase units. The units stay cached.
+ *
+ * @param[in]  cache    Write-back cache
+ * @return Result of the flush operation
+ */
+cy_rslt_t mtb_block_storage_cache_flush(mtb_block_storage_cache_t* cache);
+
+/** Function to write back all the dirty erase units and release the units of the cache. If a
+ *  write back fails the cache keeps its units, so that the deinit can be called again.
+ *
+ * @param[in]  cache    Write-back cache
+ * @return Result of the write back
+ */
+cy_rslt_t mtb_block_storage_cache_deinit(mtb_block_storage_cache_t* cache);
+
+/** \} group_block_storage_cache */
+
+#if defined(__cplusplus)
+}
+#endif
@@ -0,0 +1,256 @@
+/***********************************************************************************************//**
+ * \file mtb_block_storage_dma.h
+ *
+ * \brief
+ * DMA read of a memory mapped block storage device. Moves the data from the memory to the buffer
+ * of the caller with a DMA engine, so the CPU is free while a large area is read.
+ *
+ ***************************************************************************************************
+ * \copyright
+ * Copyright 2024 Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **************************************************************************************************/
+#pragma once
+
+#include "mtb_block_storage.h"
+
+#if defined(CY_USING_HAL) && (CYHAL_DRIVER_AVAILABLE_DMA)
+#define MTB_BLOCK_STORAGE_DMA_HAL_ENGINE_SUPPORTED
+#endif
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * \addtogroup group_block_storage_dma Block Storage DMA Read
+ * \{
+ * The read functions of the HAL NVM, PDL and serial memory devices keep the CPU busy for the
+ * whole transfer. When the memory of a device is mapped in the address space of the CPU, i.e. the
+ * internal flash and a serial memory in memory mapped (XIP) mode, the DMA read copies it with a
+ * DMA engine instead and notifies the completion through a callback, like the non blocking
+ * program and erase.
+ *
+ * The part of a read that starts and ends on a cache line boundary of the buffer of the caller
+ * is transferred directly into it. The first and last bytes, up to a cache line each, are
+ * transferred into two line aligned bounce buffers and copied on completion, so the cache lines
+ * that the buffer shares with other data are never invalidated. Reads shorter than
+ * min_dma_length are copied by the CPU, as programming the DMA costs more than the copy.
+ *
+ * The DMA engine is a pair of functions starting a transfer and checking its completion, see
+ * \ref mtb_block_storage_dma_engine_t. \ref mtb_block_storage_dma_create_hal_engine builds one on
+ * a HAL DMA channel where the HAL provides it, and \ref mtb_block_storage_dma_create_sim_engine
+ * builds a simulated engine copying a few bytes per check, to exercise the code on a host. A read
+ * longer than the longest transfer of the engine is split into as few transfers as possible.
+ *
+ * An engine that registers a completion handler, like the HAL engine, advances the read from its
+ * interrupt: each transfer is started when the previous one completes and the callback is invoked
+ * from the interrupt, without any call from the application. Otherwise the read is advanced by
+ * \ref mtb_block_storage_dma_poll.
+ *
+ * The DMA reads the memory behind the device: the area must not be programmed or erased while a
+ * DMA read of it is in progress.
+ */
+
+/** Number of bounce buffers, each of the size of a cache line */
+#define MTB_BLOCK_STORAGE_DMA_BOUNCE_COUNT      (2u)
+
+/** Function prototype of a DMA engine starting a memory to memory transfer.
+ *
+ * @param[in]  arg      Argument of the engine
+ * @param[out] dst      Destination of the transfer
+ * @param[in]  src      Source of the transfer
+ * @param[in]  length   Length of the transfer in bytes
+ * @return Result of the start
+ */
+typedef cy_rslt_t (* mtb_block_storage_dma_start_t)(void* arg, uint8_t* dst, const uint8_t* src,
+                                                    uint32_t length);
+
+/** Function prototype of a DMA engine checking the completion of the transfer in progress.
+ *
+ * @param[in]  arg      Argument of the engine
+ * @return Whether the transfer is complete
+ */
+typedef bool (* mtb_block_storage_dma_is_complete_t)(void* arg);
+
+/** Function prototype of the handler that a DMA engine invokes from its interrupt when a transfer
+ *  completes.
+ *
+ * @param[in]  callback_arg Argument given on registration
+ */
+typedef void (* mtb_block_storage_dma_event_t)(void* callback_arg);
+
+/** Function prototype of a DMA engine registering the handler invoked when a transfer completes.
+ *
+ * @param[in]  arg          Argument of the engine
+ * @param[in]  callback     Handler invoked from the interrupt of the engine
+ * @param[in]  callback_arg Argument passed to callback
+ * @return Result of the registration
+ */
+typedef cy_rslt_t (* mtb_block_storage_dma_register_t)(void* arg,
+                                                       mtb_block_storage_dma_event_t callback,
+                                                       void* callback_arg);
+
+/** DMA engine */
+typedef struct
+{
+    mtb_block_storage_dma_start_t       start;          /**< Starts a transfer */
+    mtb_block_storage_dma_is_complete_t is_complete;    /**< Checks the transfer in progress */
+    void*                               arg;            /**< Argument of the functions */
+    uint32_t                            max_length;     /**< Longest transfer of the engine, 0 if
+                                                           unlimited */
+    uint32_t                            burst_length;   /**< A transfer longer than this must be a
+                                                           multiple of it, 0 for any length */
+    mtb_block_storage_dma_register_t    register_callback;  /**< Registers the completion
+                                                               handler, NULL if the engine has no
+                                                               interrupt */
+} mtb_block_storage_dma_engine_t;
+
+/** Configuration of a DMA read object */
+typedef struct
+{
+    mtb_block_storage_t*            bsd;        /**< Device whose memory is read, used to check the
+                                                   range of the reads */
+    uintptr_t                       map_base;   /**< CPU address of address 0 of the device: 0 for
+                                                   the internal flash, whose device addresses are
+                                                   CPU addresses, the XIP base for a serial
+                                                   memory */
+    mtb_block_storage_dma_engine_t  engine;     /**< DMA engine */
+    uint8_t*                        bounce;     /**< MTB_BLOCK_STORAGE_DMA_BOUNCE_COUNT * line_size
+                                                   bytes, aligned to line_size */
+    uint32_t                        line_size;  /**< Size of a cache line of the CPU, a power of 2,
+                                                   e.g. 32 on a Cortex-M7. 4 on the cores
+                                                   without a data cache. */
+    uint32_t                        min_dma_length; /**< Reads shorter than this are copied by the
+                                                       CPU */
+} mtb_block_storage_dma_config_t;
+
+/** DMA read object. All members are private. */
+typedef struct
+{
+    mtb_block_storage_dma_config_t      config;         /**< Configuration */
+    volatile uint8_t                    phase;          /**< Part of the read in progress, changed
+                                                           from the interrupt of the engine */
+    uint8_t*                            dst;            /**< Destination of the next transfer */
+    const uint8_t*                      src;            /**< Source of the next transfer */
+    uint32_t                            left;           /**< Bytes left in the part */
+    uint8_t*                            buf;            /**< Buffer of the caller */
+    uint32_t                            length;         /**< Length of the read */
+    uint32_t                            head;           /**< Bytes read through the first bounce
+                                                           buffer */
+    uint32_t                            tail;           /**< Bytes read through the last bounce
+                                                           buffer */
+    cy_rslt_t                           result;         /**< Result of the last read */
+    mtb_block_storage_async_callback_t  callback;       /**< Callback of the read in progress */
+    void*                               callback_arg;   /**< Argument of callback */
+} mtb_block_storage_dma_t;
+
+/** Simulated DMA engine. All members are private. */
+typedef struct
+{
+    uint8_t*        dst;            /**< Destination of the transfer in progress */
+    const uint8_t*  src;            /**< Source of the transfer in progress */
+    uint32_t        left;           /**< Bytes left to copy */
+    uint32_t        bytes_per_check;    /**< Bytes copied by each completion check */
+} mtb_block_storage_dma_sim_t;
+
+#if defined(MTB_BLOCK_STORAGE_DMA_HAL_ENGINE_SUPPORTED)
+/** HAL DMA engine. All members are private. */
+typedef struct
+{
+    cyhal_dma_t*                    dma;            /**< DMA channel */
+    uint8_t                         intr_priority;  /**< Priority of the completion interrupt */
+    mtb_block_storage_dma_event_t   callback;       /**< Completion handler */
+    void*                           callback_arg;   /**< Argument of callback */
+} mtb_block_storage_dma_hal_t;
+#endif
+
+/** Function to initialize a DMA read object. The completion handler is registered with the
+ *  engine if it has an interrupt.
+ *
+ * @param[out] obj      DMA read object
+ * @param[in]  config   Configuration
+ * @return Result of the initialization
+ */
+cy_rslt_t mtb_block_storage_dma_init(mtb_block_storage_dma_t* obj,
+                                     const mtb_block_storage_dma_config_t* config);
+
+/** Function to start reading an area with the DMA. The callback is invoked with the result once
+ *  the data is in buf, from the interrupt of the engine if it has one and from
+ *  \ref mtb_block_storage_dma_poll otherwise, or before this function returns if the read is
+ *  shorter than min_dma_length.
+ *
+ * @param[in]  obj          DMA read object
+ * @param[in]  addr         Address of the area on the device
+ * @param[in]  length       Length of the area
+ * @param[out] buf          Buffer receiving the data, must stay valid until the callback
+ * @param[in]  callback     Function called on completion, can be NULL
+ * @param[in]  callback_arg Argument passed to callback
+ * @return Result of the start, MTB_BLOCK_STORAGE_BUSY if a read is already in progress or if a
+ *         non blocking operation of the device is still in progress, in which case the device
+ *         was polled once and the read can be started again later
+ */
+cy_rslt_t mtb_block_storage_dma_read(mtb_block_storage_dma_t* obj, uint32_t addr,
+                                     uint32_t length, uint8_t* buf,
+                                     mtb_block_storage_async_callback_t callback,
+                                     void* callback_arg);
+
+/** Function to advance and check the read in progress. With an engine that has no interrupt,
+ *  every call checks the transfer in progress and starts the next one once it is complete,
+ *  without waiting, so it can be called from the idle loop. With an engine that has an interrupt
+ *  the read advances on its own and this function only reports its state.
+ *
+ * @param[in]  obj      DMA read object
+ * @return MTB_BLOCK_STORAGE_BUSY while the read is in progress, otherwise the result of the last
+ *         read
+ */
+cy_rslt_t mtb_block_storage_dma_poll(mtb_block_storage_dma_t* obj);
+
+/** Function to create a simulated DMA engine, which copies bytes_per_check bytes of the transfer
+ *  in progress each time its completion is checked. It has the limits of the HAL engine and
+ *  rejects the transfers that do not fit them, but no interrupt.
+ *
+ * @param[out] engine           Engine to initialize
+ * @param[out] sim              Simulated engine object, must stay valid while the engine is used
+ * @param[in]  bytes_per_check  Bytes copied by each completion check
+ */
+void mtb_block_storage_dma_create_sim_engine(mtb_block_storage_dma_engine_t* engine,
+                                             mtb_block_storage_dma_sim_t* sim,
+                                             uint32_t bytes_per_check);
+
+#if defined(MTB_BLOCK_STORAGE_DMA_HAL_ENGINE_SUPPORTED)
+/** Function to create a DMA engine on a HAL DMA channel. A transfer longer than 256 bytes is
+ *  made in 2D mode, as bursts of 256 bytes all moved on a single trigger, so a transfer moves up
+ *  to 64 KB and a longer read is split into 64 KB transfers. The completion interrupt of the
+ *  channel advances the reads, its callback is registered by \ref mtb_block_storage_dma_init.
+ *
+ * @param[out] engine           Engine to initialize
+ * @param[out] hal              HAL engine object, must stay valid while the engine is used
+ * @param[in]  dma              DMA channel, initialized by the application for memory to memory
+ *                              transfers with cyhal_dma_init
+ * @param[in]  intr_priority    Priority of the completion interrupt of the channel
+ */
+void mtb_block_storage_dma_create_hal_engine(mtb_block_storage_dma_engine_t* engine,
+                                             mtb_block_storage_dma_hal_t* hal, cyhal_dma_t* dma,
+                                             uint8_t intr_priority);
+#endif
+
+/** \} group_block_storage_dma */
+
+#if defined(__cplusplus)
+}
+#endif
@@ -0,0 +1,163 @@
+/***********************************************************************************************//**
+ * \file mtb_block_storage_ftl.h
+ *
+ * \brief
+ * Wear leveling flash translation layer. Exposes a block storage device whose pages are written
+ * out of place on top of an area of another block storage device.
+ *
+ ***************************************************************************************************
+ * \copyright
+ * Copyright 2024 Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **************************************************************************************************/
+#pragma once
+
+#include "mtb_block_storage.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * \addtogroup group_block_storage_ftl Block Storage Flash Translation Layer
+ * \{
+ * The flash translation layer (FTL) turns an area of a block storage device into a logical block
+ * storage device made of pages that can be programmed again without being erased. Every program
+ * of a page writes it to the next free slot of the open block and updates a page map held in RAM,
+ * so a logical program never waits for an erase of the page it replaces.
+ *
+ * The area is split into blocks, each made of one or more erase units of the device. A block
+ * starts with two headers holding its erase count and its sequence number, followed by slots
+ * holding one page and its header (logical page number and sequence number). The header of a slot
+ * is programmed after its data, so a slot interrupted by a power loss is ignored. On create the
+ * headers are scanned to rebuild the page map and the erase counts.
+ *
+ * Space is reclaimed by a garbage collector that moves the valid pages of a full block to the
+ * open block. Once the number of free blocks drops to reserved_blocks, every logical program moves
+ * up to gc_pages_per_write pages. The emptied blocks are erased by
+ * \ref mtb_block_storage_ftl_collect, which is meant to be called when the application is idle
+ * and also does the moves ahead of time, so the logical programs only wait for an erase when no
+ * erased block is left. Wear is spread by opening the free block with the lowest erase count, and
+ * by collecting the block with the lowest erase count once it is wear_threshold erases behind the
+ * most worn block, so that cold data moves too.
+ *
+ * Whether the blocks are erased before they are reused depends on is_erase_required of the
+ * device, so the FTL can be used on flash and on RRAM regions. An erase of the logical device
+ * writes a header marking the pages as erased, the reads then return the erase value.
+ *
+ * The created device provides read, program, erase, the size functions, is_in_range,
+ * is_erase_required (always false) and get_geometry. The non blocking functions are not
+ * supported. The FTL functions are not thread safe.
+ */
+
+/** State of a physical block of the FTL. All members are private. */
+typedef struct
+{
+    uint32_t    erase_count;    /**< Number of times the block was erased */
+    uint32_t    valid_count;    /**< Number of slots of the block holding the current version of
+                                   a page */
+    uint32_t    sequence;       /**< Sequence number the block was opened with */
+    uint8_t     state;          /**< Free, needing an erase, open or full */
+} mtb_block_storage_ftl_block_t;
+
+/** Configuration of an FTL */
+typedef struct
+{
+    mtb_block_storage_t*            bsd;            /**< Device the FTL is built on */
+    uint32_t                        start_address;  /**< Start of the area used by the FTL,
+                                                       aligned to block_size */
+    uint32_t                        size;           /**< Size of the area, multiple of
+                                                       block_size */
+    uint32_t                        block_size;     /**< Size of a block, multiple of the erase
+                                                       size of the area */
+    uint32_t                        page_size;      /**< Program and erase size of the logical
+                                                       device, multiple of the program size of the
+                                                       area */
+    uint32_t                        reserved_blocks;    /**< Blocks kept out of the logical
+                                                           capacity for the garbage collector,
+                                                           at least 2 */
+    uint32_t                        gc_pages_per_write; /**< Pages moved by each logical program
+                                                           once the collector is active, 0 to
+                                                           only collect when a block is needed */
+    uint32_t                        wear_threshold; /**< Erase count difference after which the
+                                                       least worn block is collected, 0 disables
+                                                       it */
+    uint32_t*                       map;            /**< Page map, see
+                                                       \ref mtb_block_storage_ftl_get_page_count
+                                                       for its number of entries */
+    mtb_block_storage_ftl_block_t*  blocks;         /**< One entry per block of the area */
+    uint8_t*                        scratch;        /**< Buffer used to program the headers and
+                                                       move the pages */
+    uint32_t                        scratch_size;   /**< Size of scratch, at least the program
+                                                       size of the area and 16 bytes */
+} mtb_block_storage_ftl_config_t;
+
+/** FTL object. All members are private. */
+typedef struct
+{
+    mtb_block_storage_ftl_config_t  config;         /**< Copy of the configuration */
+    uint32_t                        block_count;    /**< Number of blocks of the area */
+    uint32_t                        header_size;    /**< Size of a header in the area */
+    uint32_t                        slot_size;      /**< Size of a page and its header */
+    uint32_t                        slots_per_block;    /**< Number of slots of a block */
+    uint32_t                        page_count;     /**< Number of pages of the logical device */
+    uint32_t                        free_blocks;    /**< Number of blocks that can be opened */
+    uint32_t                        open_block;     /**< Block the pages are written to */
+    uint32_t                        next_slot;      /**< Next free slot of the open block */
+    uint32_t                        gc_block;       /**< Block being collected */
+    uint32_t                        gc_slot;        /**< Next slot of gc_block to check */
+    uint32_t                        sequence;       /**< Last sequence number used */
+    uint8_t                         erase_value;    /**< Erase value of the area */
+    bool                            erase_required; /**< Whether the area needs erases */
+} mtb_block_storage_ftl_t;
+
+/** Function to get the number of pages of the logical device of an FTL, which is the number of
+ *  entries that the map of the configuration must have.
+ *
+ * @param[in]  config   Configuration of the FTL, bsd, start_address, size, block_size, page_size
+ *                      and reserved_blocks are used
+ * @return Number of pages, 0 if the configuration is not valid
+ */
+uint32_t mtb_block_storage_ftl_get_page_count(const mtb_block_storage_ftl_config_t* config);
+
+/** Function to create a block storage device on top of an FTL. The area is scanned to restore
+ *  the pages written by a previous instance. An area that does not hold any FTL data is formatted
+ *  on the fly, as its blocks are opened.
+ *
+ * @param[out] bsd      Block storage element to be initialized
+ * @param[out] obj      FTL object, must stay valid while the device is in use
+ * @param[in]  config   Configuration of the FTL
+ * @return Result of the create function
+ */
+cy_rslt_t mtb_block_storage_create_ftl(mtb_block_storage_t* bsd, mtb_block_storage_ftl_t* obj,
+                                       const mtb_block_storage_ftl_config_t* config);
+
+/** Function to run the garbage collector ahead of time, e.g. when the application is idle, so
+ *  that the logical programs do not have to.
+ *
+ * @param[in]  obj          FTL object
+ * @param[in]  max_pages    Maximum number of pages to move
+ * @return MTB_BLOCK_STORAGE_BUSY if there is more to collect, CY_RSLT_SUCCESS once more than
+ *         reserved_blocks blocks are free, or an error
+ */
+cy_rslt_t mtb_block_storage_ftl_collect(mtb_block_storage_ftl_t* obj, uint32_t max_pages);
+
+/** \} group_block_storage_ftl */
+
+#if defined(__cplusplus)
+}
+#endif
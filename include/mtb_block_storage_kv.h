@@ -0,0 +1,178 @@
+/***********************************************************************************************//**
+ * \file mtb_block_storage_kv.h
+ *
+ * \brief
+ * Log-structured key-value store. Appends the records to an area of a block storage device and
+ * looks them up through a hash index held in RAM.
+ *
+ ***************************************************************************************************
+ * \copyright
+ * Copyright 2024 Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **************************************************************************************************/
+#pragma once
+
+#include "mtb_block_storage.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * \addtogroup group_block_storage_kv Block Storage Key-Value Store
+ * \{
+ * The key-value store keeps values of any length under string keys in an area of a block storage
+ * device. The area is split into sectors of one or more erase units used as a circular log: every
+ * put or delete appends a record (header with a CRC, key and value, padded to the program size)
+ * to the newest sector, so a value is never programmed in place.
+ *
+ * The location of the latest record of every key is kept in a hash index in RAM, a get costs a
+ * probe of the index and the read of the record. When the newest sector is full the next one is
+ * opened, and the oldest sector is compacted so that one sector always stays free: its live
+ * records are appended to the newest sector and it is erased.
+ *
+ * Each opened sector can start with a checkpoint, a copy of the hash index. On init the most
+ * recent valid checkpoint is loaded and only the records written after it are read, so the mount
+ * time depends on the size of a couple of sectors rather than of the area. Without a valid
+ * checkpoint all the records are read. A record interrupted by a power loss fails its CRC and is
+ * ignored, the previous value of the key is kept.
+ *
+ * The key-value store functions are not thread safe.
+ */
+
+/** Maximum length of a key, without the terminating null character */
+#if !defined(MTB_BLOCK_STORAGE_KV_MAX_KEY_LENGTH)
+#define MTB_BLOCK_STORAGE_KV_MAX_KEY_LENGTH     (64u)
+#endif
+
+/** Entry of the hash index. All members are private. */
+typedef struct
+{
+    uint32_t    hash;       /**< Hash of the key */
+    uint32_t    offset;     /**< Offset of the latest record of the key in the area */
+} mtb_block_storage_kv_entry_t;
+
+/** Configuration of a key-value store */
+typedef struct
+{
+    mtb_block_storage_t*            bsd;            /**< Device holding the store */
+    uint32_t                        start_address;  /**< Start of the area, aligned to
+                                                       sector_size */
+    uint32_t                        size;           /**< Size of the area, at least 2 sectors */
+    uint32_t                        sector_size;    /**< Size of a sector, multiple of the erase
+                                                       size of the area */
+    mtb_block_storage_kv_entry_t*   index;          /**< Hash index, it holds up to index_size - 1
+                                                       keys */
+    uint32_t                        index_size;     /**< Number of entries of index, power of 2 */
+    uint8_t*                        scratch;        /**< Buffer used to program and read back the
+                                                       records */
+    uint32_t                        scratch_size;   /**< Size of scratch, at least 16 bytes and the
+                                                       program size of the area */
+    bool                            checkpoint;     /**< Whether a checkpoint of the index is
+                                                       written to every opened sector. It is only
+                                                       written if it takes at most half a sector.
+                                                     */
+} mtb_block_storage_kv_config_t;
+
+/** Key-value store. All members are private. */
+typedef struct
+{
+    mtb_block_storage_kv_config_t   config;         /**< Copy of the configuration */
+    uint32_t                        sector_count;   /**< Number of sectors of the area */
+    uint32_t                        program_size;   /**< Program size of the area */
+    uint32_t                        header_size;    /**< Size of the header of a sector */
+    uint32_t                        head;           /**< Sector the records are appended to */
+    uint32_t                        head_offset;    /**< Offset of the next record in head */
+    uint32_t                        tail;           /**< Oldest sector in use */
+    uint32_t                        free_sectors;   /**< Number of sectors not in use */
+    uint32_t                        sequence;       /**< Sequence number of the head sector */
+    uint32_t                        count;          /**< Number of keys stored */
+    uint8_t                         erase_value;    /**< Erase value of the area */
+} mtb_block_storage_kv_t;
+
+/** Function prototype for the callback of \ref mtb_block_storage_kv_iterate.
+ *
+ * @param[in]  arg          Argument passed to mtb_block_storage_kv_iterate
+ * @param[in]  key          Key, only valid during the call
+ * @param[in]  value_length Length of the value stored under key
+ * @return true to continue the iteration, false to stop it
+ */
+typedef bool (* mtb_block_storage_kv_iterate_t)(void* arg, const char* key, uint32_t value_length);
+
+/** Function to initialize a key-value store. The index is rebuilt from the content of the area,
+ *  an area that does not hold any record is used as an empty store.
+ *
+ * @param[out] kv       Key-value store to initialize
+ * @param[in]  config   Configuration of the store
+ * @return Result of the initialization
+ */
+cy_rslt_t mtb_block_storage_kv_init(mtb_block_storage_kv_t* kv,
+                                    const mtb_block_storage_kv_config_t* config);
+
+/** Function to store a value under a key, replacing the previous value of the key.
+ *
+ * @param[in]  kv           Key-value store
+ * @param[in]  key          Null terminated key of at most MTB_BLOCK_STORAGE_KV_MAX_KEY_LENGTH
+ *                          characters
+ * @param[in]  value        Value to store, can be NULL if value_length is 0
+ * @param[in]  value_length Length of the value. A record, made of a 12 bytes header, the key and
+ *                          the value, takes at most half a sector.
+ * @return Result of the operation, MTB_BLOCK_STORAGE_NO_SPACE_ERROR if the index is full or the
+ *         compaction cannot free enough space
+ */
+cy_rslt_t mtb_block_storage_kv_put(mtb_block_storage_kv_t* kv, const char* key,
+                                   const uint8_t* value, uint32_t value_length);
+
+/** Function to read the value stored under a key.
+ *
+ * @param[in]  kv           Key-value store
+ * @param[in]  key          Null terminated key
+ * @param[out] value        Buffer receiving the value, can be NULL if value_size is 0
+ * @param[in]  value_size   Size of value. If it is smaller than the length of the value, only
+ *                          value_size bytes are read and MTB_BLOCK_STORAGE_INVALID_SIZE_ERROR is
+ *                          returned.
+ * @param[out] value_length Length of the value, can be NULL
+ * @return Result of the operation, MTB_BLOCK_STORAGE_NOT_FOUND_ERROR if the key is not stored
+ */
+cy_rslt_t mtb_block_storage_kv_get(mtb_block_storage_kv_t* kv, const char* key, uint8_t* value,
+                                   uint32_t value_size, uint32_t* value_length);
+
+/** Function to delete a key.
+ *
+ * @param[in]  kv   Key-value store
+ * @param[in]  key  Null terminated key
+ * @return Result of the operation, MTB_BLOCK_STORAGE_NOT_FOUND_ERROR if the key is not stored,
+ *         MTB_BLOCK_STORAGE_NO_SPACE_ERROR if the store is too full to append the deletion record
+ */
+cy_rslt_t mtb_block_storage_kv_delete(mtb_block_storage_kv_t* kv, const char* key);
+
+/** Function to call a function for every key stored, in no particular order. The callback can
+ *  read the values with \ref mtb_block_storage_kv_get but must not modify the store.
+ *
+ * @param[in]  kv       Key-value store
+ * @param[in]  callback Function called for every key
+ * @param[in]  arg      Argument passed to callback
+ * @return Result of the operation
+ */
+cy_rslt_t mtb_block_storage_kv_iterate(mtb_block_storage_kv_t* kv,
+                                       mtb_block_storage_kv_iterate_t callback, void* arg);
+
+/** \} group_block_storage_kv */
+
+#if defined(__cplusplus)
+}
+#endif
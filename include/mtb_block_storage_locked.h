@@ -0,0 +1,154 @@
+/***********************************************************************************************//**
+ * \file mtb_block_storage_locked.h
+ *
+ * \brief
+ * Thread safe block storage device. Wraps a block storage device and serializes the calls made to
+ * it from several threads, with one lock per region so that the regions are accessed in parallel.
+ *
+ ***************************************************************************************************
+ * \copyright
+ * Copyright 2024 Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **************************************************************************************************/
+#pragma once
+
+#include "mtb_block_storage.h"
+
+//The locks come from the RTOS abstraction, or from POSIX threads on host builds
+#if defined(CY_RTOS_AWARE) || defined(COMPONENT_RTOS_AWARE)
+#include "cyabs_rtos.h"
+#define MTB_BLOCK_STORAGE_LOCKED_SUPPORTED
+#elif defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+#define MTB_BLOCK_STORAGE_LOCKED_SUPPORTED
+#endif
+
+#if defined(MTB_BLOCK_STORAGE_LOCKED_SUPPORTED)
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * \addtogroup group_block_storage_locked Block Storage Thread Safe Device
+ * \{
+ * The devices of this library are not thread safe: two threads calling the same device at the
+ * same time corrupt its state, and the HAL NVM device created by
+ * \ref mtb_block_storage_create_hal_nvm shares a single HAL object. The locked device wraps a
+ * device so that it can be shared by several threads, it is available when CY_RTOS_AWARE or
+ * COMPONENT_RTOS_AWARE is defined and on host builds.
+ *
+ * The address space is split into lock regions, each protected by its own mutex. A read,
+ * program or erase takes the locks of the regions it touches, in ascending order, so a read of a
+ * region does not wait for a long erase in another region, e.g. a work flash read while the code
+ * flash is being erased. By default the lock regions are the regions of the geometry of the
+ * inner device, the regions of a same bank (see \ref mtb_block_storage_region_t) sharing one
+ * lock, so a read of a bank only waits for the operations of that bank. The lock regions can also
+ * be given in the configuration, each with its own lock. With several locks, program, erase,
+ * program_nb, erase_nb, programv and poll also take a write lock shared by the whole device,
+ * before the locks of their regions: a device has a single flash controller, so only reads run
+ * in parallel with a write, and a write waiting for another one does not hold the locks of its
+ * regions meanwhile, so their reads do not wait for the other write. Splitting the locks is only
+ * useful if the inner device can read a region while another one is written, e.g. the HAL NVM
+ * device with \ref MTB_BLOCK_STORAGE_OPTION_READ_WHILE_WRITE; set per_region to false to protect
+ * the whole device with a single lock otherwise.
+ *
+ * program_nb and erase_nb hold the locks while the operation is started, readv and programv hold
+ * the locks of all the fragments for the whole batch, poll, register_callback and get_geometry
+ * take all the locks. map holds the locks of the area while it is mapped, but not while it is
+ * read through the pointer: the application must not program or erase a mapped area. The
+ * functions that only query the layout (sizes, erase value, is_in_range, is_erase_required) are
+ * forwarded without locking. The mutexes are recursive, so the completion callback of a non
+ * blocking operation invoked by poll can call the device again. A callback invoked while a read
+ * completes the operation in progress holds region locks without the write lock, so it must not
+ * program or erase the device.
+ */
+
+/** Maximum number of lock regions of a device, at most 32 */
+#if !defined(MTB_BLOCK_STORAGE_LOCKED_MAX_REGIONS)
+#define MTB_BLOCK_STORAGE_LOCKED_MAX_REGIONS    (4u)
+#endif
+
+/** Configuration of a locked device */
+typedef struct
+{
+    mtb_block_storage_t*    bsd;            /**< Inner device */
+    bool                    per_region;     /**< Whether each region has its own lock, false to use
+                                               a single lock for the whole device */
+    const uint32_t*         region_starts;  /**< Start addresses of the lock regions, NULL to use
+                                               the regions of the inner device geometry. Only
+                                               used when per_region is true. */
+    uint32_t                region_count;   /**< Number of entries of region_starts */
+} mtb_block_storage_locked_config_t;
+
+/** Locked device. All members are private. */
+typedef struct
+{
+    mtb_block_storage_t*    bsd;            /**< Inner device */
+    uint32_t                region_count;   /**< Number of lock regions */
+    uint32_t                mutex_count;    /**< Number of mutexes */
+    uint32_t                starts[MTB_BLOCK_STORAGE_LOCKED_MAX_REGIONS];   /**< Start address of
+                                                                               each lock region,
+                                                                               ascending */
+    uint8_t                 mutex_of[MTB_BLOCK_STORAGE_LOCKED_MAX_REGIONS]; /**< Mutex of each
+                                                                               lock region */
+    #if defined(CY_RTOS_AWARE) || defined(COMPONENT_RTOS_AWARE)
+    cy_mutex_t              mutexes[MTB_BLOCK_STORAGE_LOCKED_MAX_REGIONS];  /**< Mutexes of the
+                                                                               lock regions */
+    #else
+    pthread_mutex_t         mutexes[MTB_BLOCK_STORAGE_LOCKED_MAX_REGIONS];  /**< Mutexes of the
+                                                                               lock regions */
+    #endif
+    #if defined(CY_RTOS_AWARE) || defined(COMPONENT_RTOS_AWARE)
+    cy_mutex_t              write_mutex;    /**< Taken by program and erase when there are several
+                                               mutexes */
+    #else
+    pthread_mutex_t         write_mutex;    /**< Taken by program and erase when there are several
+                                               mutexes */
+    #endif
+} mtb_block_storage_locked_t;
+
+/** Function to create a block storage device that serializes the calls made to an inner device.
+ *  The optional functions are provided if the inner device provides them. The inner device must
+ *  not be called directly while the locked device is in use.
+ *
+ *  The first lock region also covers the addresses below its start and each region extends up to
+ *  the start of the next one. If the inner geometry has more regions than
+ *  MTB_BLOCK_STORAGE_LOCKED_MAX_REGIONS, the last lock covers the remaining ones.
+ *
+ * @param[out] bsd      Block storage element to be initialized
+ * @param[out] obj      Locked device object, must stay valid while the device is in use
+ * @param[in]  config   Configuration of the locked device
+ * @return Result of the create function
+ */
+cy_rslt_t mtb_block_storage_create_locked(mtb_block_storage_t* bsd,
+                                          mtb_block_storage_locked_t* obj,
+                                          const mtb_block_storage_locked_config_t* config);
+
+/** Function to release the locks of a locked device. The device must not be in use.
+ *
+ * @param[in]  obj      Locked device object
+ */
+void mtb_block_storage_locked_deinit(mtb_block_storage_locked_t* obj);
+
+/** \} group_block_storage_locked */
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // defined(MTB_BLOCK_STORAGE_LOCKED_SUPPORTED)
@@ -0,0 +1,81 @@
+/***********************************************************************************************//**
+ * \file mtb_block_storage_partition.h
+ *
+ * \brief
+ * Partitions of a block storage device. Exposes a contiguous area of a device as a block storage
+ * device of its own, starting at address 0.
+ *
+ ***************************************************************************************************
+ * \copyright
+ * Copyright 2024 Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **************************************************************************************************/
+#pragma once
+
+#include "mtb_block_storage.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * \addtogroup group_block_storage_partition Block Storage Partition
+ * \{
+ * A partition is a view of a contiguous area of a parent device, e.g. the OTA, log and key-value
+ * areas of one QSPI memory. Address 0 of the partition is the start of the area. Every access is
+ * checked against the size of the partition, which is computed once on create, then forwarded to
+ * the parent with the start of the area added, so the layers built on a partition do not have to
+ * know where it lives.
+ *
+ * The area is validated on create: it must be aligned to the erase size of the parent at both
+ * ends and, if the parent provides is_in_range, be in range of the parent.
+ *
+ * The non blocking functions of the partition are the ones of the parent, or NULL if the parent
+ * does not provide them. The completion callback and the poll state belong to the parent, so
+ * only one non blocking operation can be in progress across all the partitions of a device.
+ * A partition is as thread safe as its parent.
+ */
+
+/** Partition object. All members are private. */
+typedef struct
+{
+    mtb_block_storage_t*    parent;     /**< Device holding the partition */
+    uint32_t                offset;     /**< Address of the partition in parent */
+    uint32_t                size;       /**< Size of the partition */
+} mtb_block_storage_partition_t;
+
+/** Function to create the block storage elements for a partition of a device.
+ *
+ * @param[out] child    Block storage element to be initialized
+ * @param[out] obj      Partition object, must stay valid while the partition is in use
+ * @param[in]  parent   Device holding the partition, must stay valid while the partition is in
+ *                      use
+ * @param[in]  offset   Address of the partition in parent, aligned to the erase size of parent
+ * @param[in]  size     Size of the partition, its end must be aligned to the erase size of parent
+ * @return Result of the create function, MTB_BLOCK_STORAGE_NOT_IN_RANGE_ERROR if the area is not
+ *         in range of the parent
+ */
+cy_rslt_t mtb_block_storage_create_partition(mtb_block_storage_t* child,
+                                             mtb_block_storage_partition_t* obj,
+                                             mtb_block_storage_t* parent, uint32_t offset,
+                                             uint32_t size);
+
+/** \} group_block_storage_partition */
+
+#if defined(__cplusplus)
+}
+#endif
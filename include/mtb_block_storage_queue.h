@@ -0,0 +1,177 @@
+/***********************************************************************************************//**
+ * \file mtb_block_storage_queue.h
+ *
+ * \brief
+ * Request queue for block storage devices. Read, program and erase requests from several clients
+ * are collected, merged and ordered before being issued to the device.
+ *
+ ***************************************************************************************************
+ * \copyright
+ * Copyright 2024 Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **************************************************************************************************/
+#pragma once
+
+#include "mtb_block_storage.h"
+
+//The worker mode needs the RTOS abstraction, the poll mode is always available
+#if defined(CY_RTOS_AWARE) || defined(COMPONENT_RTOS_AWARE)
+#include "cyabs_rtos.h"
+#define MTB_BLOCK_STORAGE_QUEUE_WORKER_SUPPORTED
+#endif
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * \addtogroup group_block_storage_queue Block Storage Request Queue
+ * \{
+ * The request queue sits between the clients of a block storage device and the device itself.
+ * Clients submit read, program and erase requests that complete through a callback. Before
+ * they are issued to the device the requests are:
+ *
+ * * merged: adjacent programs, adjacent or overlapping reads and adjacent or overlapping erases
+ *   are issued as a single operation, up to the size of the staging buffer for reads and
+ *   programs
+ * * dropped: an erase that is already covered by a pending erase completes together with it
+ * * ordered: requests are issued in ascending address order starting from the end of the last
+ *   operation (elevator), except that a request never overtakes an earlier pending request
+ *   whose range it overlaps
+ *
+ * If the device supports program_nb and erase_nb, programs and erases are started without
+ * waiting and completed through the poll function of the device.
+ *
+ * The queue can be driven in two ways:
+ * * poll mode: the application calls \ref mtb_block_storage_queue_process until it returns
+ *   CY_RSLT_SUCCESS. Submit and process must be called from the same thread.
+ * * worker mode: available when CY_RTOS_AWARE or COMPONENT_RTOS_AWARE is defined,
+ *   \ref mtb_block_storage_queue_start_worker creates a thread that processes the requests and
+ *   submit can be called from any thread.
+ */
+
+/** Type of a block storage request */
+typedef enum
+{
+    MTB_BLOCK_STORAGE_REQUEST_READ,     /**< Read length bytes at addr into buf */
+    MTB_BLOCK_STORAGE_REQUEST_PROGRAM,  /**< Program length bytes from buf at addr */
+    MTB_BLOCK_STORAGE_REQUEST_ERASE,    /**< Erase length bytes at addr, buf is not used */
+} mtb_block_storage_request_type_t;
+
+/** Block storage request. The request is owned by the queue from submit until its callback is
+ *  invoked, so it must not be modified or submitted again in between. */
+typedef struct mtb_block_storage_request
+{
+    mtb_block_storage_request_type_t    type;       /**< Type of the request */
+    uint32_t                            addr;       /**< Address of the request */
+    uint32_t                            length;     /**< Length of the request in bytes */
+    uint8_t*                            buf;        /**< Destination of a read or source of a
+                                                       program, must stay valid until the
+                                                       callback is invoked */
+    mtb_block_storage_async_callback_t  callback;   /**< Called with the result once the request
+                                                       completes, can be NULL */
+    void*                               callback_arg;   /**< Argument passed to callback */
+
+    struct mtb_block_storage_request*   next;       /**< Private, next pending request */
+    struct mtb_block_storage_request*   merged;     /**< Private, requests merged into this one */
+    uint32_t                            range_addr; /**< Private, start of the merged range */
+    uint32_t                            range_end;  /**< Private, end of the merged range */
+} mtb_block_storage_request_t;
+
+/** Block storage request queue. All members are private. */
+typedef struct
+{
+    mtb_block_storage_t*            bsd;            /**< Device the requests are issued to */
+    uint8_t*                        staging_buf;    /**< Buffer used for merged reads and
+                                                       programs */
+    uint32_t                        staging_size;   /**< Size of staging_buf */
+    mtb_block_storage_request_t*    head;           /**< Pending requests in submission order */
+    mtb_block_storage_request_t*    tail;           /**< Last pending request */
+    mtb_block_storage_request_t*    active;         /**< Request started without waiting */
+    uint32_t                        position;       /**< End of the last issued operation */
+    bool                            use_nb;         /**< Whether program_nb and erase_nb are
+                                                       used */
+    #if defined(MTB_BLOCK_STORAGE_QUEUE_WORKER_SUPPORTED)
+    cy_mutex_t                      mutex;          /**< Protects the pending requests */
+    cy_semaphore_t                  semaphore;      /**< Wakes the worker up */
+    cy_thread_t                     thread;         /**< Worker thread */
+    volatile bool                   stop;           /**< Asks the worker to exit */
+    bool                            worker_started; /**< Whether the worker thread exists */
+    #endif // defined(MTB_BLOCK_STORAGE_QUEUE_WORKER_SUPPORTED)
+} mtb_block_storage_queue_t;
+
+/** Function to initialize a request queue on top of a block storage device.
+ *
+ * @param[out] queue        Queue to initialize
+ * @param[in]  bsd          Block storage device the requests are issued to. It must not be used
+ *                          directly while the queue has pending requests.
+ * @param[in]  staging_buf  Buffer used to issue merged reads and programs as one operation, can be
+ *                          NULL, in which case reads and programs are not merged
+ * @param[in]  staging_size Size of staging_buf, a few erase sizes of the device is a good choice
+ * @return Result of the initialization
+ */
+cy_rslt_t mtb_block_storage_queue_init(mtb_block_storage_queue_t* queue, mtb_block_storage_t* bsd,
+                                       uint8_t* staging_buf, uint32_t staging_size);
+
+/** Function to submit a request to the queue. The request is completed through its callback.
+ *
+ * @param[in]  queue    Request queue
+ * @param[in]  request  Request to submit, with type, addr, length, buf, callback and
+ *                      callback_arg set
+ * @return Result of the submission
+ */
+cy_rslt_t mtb_block_storage_queue_submit(mtb_block_storage_queue_t* queue,
+                                         mtb_block_storage_request_t* request);
+
+/** Function to make progress on the pending requests in poll mode. Every call issues at most one
+ *  operation to the device, or checks the one in progress, and invokes the callbacks of the
+ *  requests it completes.
+ *
+ * @param[in]  queue    Request queue
+ * @return MTB_BLOCK_STORAGE_BUSY while there is work left, CY_RSLT_SUCCESS once the queue is
+ *         empty, MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR if queue is NULL
+ */
+cy_rslt_t mtb_block_storage_queue_process(mtb_block_storage_queue_t* queue);
+
+#if defined(MTB_BLOCK_STORAGE_QUEUE_WORKER_SUPPORTED)
+/** Function to start the worker thread that processes the requests of the queue.
+ *
+ * @param[in]  queue        Request queue
+ * @param[in]  stack        Stack of the worker thread, can be NULL to let the RTOS allocate it
+ * @param[in]  stack_size   Size of the stack in bytes
+ * @param[in]  priority     Priority of the worker thread
+ * @return Result of the operation
+ */
+cy_rslt_t mtb_block_storage_queue_start_worker(mtb_block_storage_queue_t* queue, void* stack,
+                                               uint32_t stack_size,
+                                               cy_thread_priority_t priority);
+#endif // defined(MTB_BLOCK_STORAGE_QUEUE_WORKER_SUPPORTED)
+
+/** Function to release the resources of the queue. In worker mode the worker thread is stopped.
+ *  The operation in progress on the device, if any, is waited for and its requests complete with
+ *  its result. The requests still pending complete with MTB_BLOCK_STORAGE_CANCELLED_ERROR, their
+ *  callbacks are invoked from this function.
+ *
+ * @param[in]  queue    Request queue
+ */
+void mtb_block_storage_queue_deinit(mtb_block_storage_queue_t* queue);
+
+/** \} group_block_storage_queue */
+
+#if defined(__cplusplus)
+}
+#endif
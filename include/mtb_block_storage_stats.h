@@ -0,0 +1,168 @@
+/***********************************************************************************************//**
+ * \file mtb_block_storage_stats.h
+ *
+ * \brief
+ * Statistics for block storage devices. Wraps a block storage device and records the count, size,
+ * latency and errors of its operations, and how many times each erase unit was erased.
+ *
+ ***************************************************************************************************
+ * \copyright
+ * Copyright 2024 Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **************************************************************************************************/
+#pragma once
+
+#include "mtb_block_storage.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * \addtogroup group_block_storage_stats Block Storage Statistics
+ * \{
+ * The statistics device forwards every function to an inner device and records, for read,
+ * program, erase, program_nb and erase_nb, the number of calls, the calls that failed, the number
+ * of bytes and the latency: total, maximum and a histogram with one bucket per power of 2 of clock
+ * ticks. The latency of program_nb and erase_nb runs from the start of the operation to the poll
+ * or the completion callback that reports its completion, whichever comes first. The erases can
+ * also be counted per erase unit of an area, to see the wear of the device.
+ *
+ * The latency is measured with the monotonic clock (in nanoseconds) on host builds and with the
+ * DWT cycle counter on the Cortex-M cores that have one. Another clock can be given in the
+ * configuration, e.g. a hardware timer on the cores without a cycle counter. The clock is 32 bits
+ * wide, so an operation that lasts longer than its wrap period is not measured correctly.
+ *
+ * Defining MTB_BLOCK_STORAGE_STATS_ENABLED to 0 compiles the statistics out: the created device is
+ * then a copy of the inner device, so the calls do not go through any wrapper, and the statistics
+ * read as zero.
+ *
+ * The statistics functions are not thread safe, a snapshot taken while an operation is in progress
+ * may not include it.
+ */
+
+/** Whether the statistics are recorded */
+#if !defined(MTB_BLOCK_STORAGE_STATS_ENABLED)
+#define MTB_BLOCK_STORAGE_STATS_ENABLED         (1)
+#endif
+
+/** Number of buckets of the latency histograms. Bucket 0 counts the latencies of 0 ticks and
+ *  bucket i the latencies from 2^(i-1) to 2^i - 1 ticks, the last bucket also counts the longer
+ *  ones. */
+#if !defined(MTB_BLOCK_STORAGE_STATS_BUCKETS)
+#define MTB_BLOCK_STORAGE_STATS_BUCKETS         (32u)
+#endif
+
+/** Operations for which statistics are recorded */
+typedef enum
+{
+    MTB_BLOCK_STORAGE_STATS_READ,           /**< read */
+    MTB_BLOCK_STORAGE_STATS_PROGRAM,        /**< program */
+    MTB_BLOCK_STORAGE_STATS_ERASE,          /**< erase */
+    MTB_BLOCK_STORAGE_STATS_PROGRAM_NB,     /**< program_nb, until its completion */
+    MTB_BLOCK_STORAGE_STATS_ERASE_NB,       /**< erase_nb, until its completion */
+    MTB_BLOCK_STORAGE_STATS_OP_COUNT        /**< Number of operations */
+} mtb_block_storage_stats_op_id_t;
+
+/** Statistics of one operation */
+typedef struct
+{
+    uint32_t    count;          /**< Number of calls */
+    uint32_t    errors;         /**< Number of calls that failed */
+    uint64_t    bytes;          /**< Number of bytes of all the calls */
+    uint64_t    total_ticks;    /**< Sum of the latencies in clock ticks */
+    uint32_t    max_ticks;      /**< Longest latency in clock ticks */
+    uint32_t    histogram[MTB_BLOCK_STORAGE_STATS_BUCKETS];  /**< Latency histogram */
+} mtb_block_storage_stats_op_t;
+
+/** Statistics of a device */
+typedef struct
+{
+    mtb_block_storage_stats_op_t    ops[MTB_BLOCK_STORAGE_STATS_OP_COUNT];  /**< Statistics of
+                                                                               each operation */
+    uint32_t                        clock_hz;   /**< Frequency of the clock ticks, 0 if the
+                                                   latency is not measured */
+} mtb_block_storage_stats_t;
+
+/** Function prototype of a clock used to measure the latency.
+ *
+ * @return Current value of a free running 32 bits counter
+ */
+typedef uint32_t (* mtb_block_storage_stats_clock_t)(void);
+
+/** Configuration of a statistics device */
+typedef struct
+{
+    mtb_block_storage_t*            bsd;            /**< Inner device */
+    mtb_block_storage_stats_clock_t clock;          /**< Clock measuring the latency, NULL for the
+                                                       built-in clock */
+    uint32_t                        clock_hz;       /**< Frequency of clock, not used with the
+                                                       built-in clock */
+    uint32_t*                       erase_counts;   /**< One counter per erase unit of the area,
+                                                       NULL to not count the erases per unit */
+    uint32_t                        erase_count_size;   /**< Number of entries of erase_counts */
+    uint32_t                        erase_start;    /**< Start of the area whose erases are
+                                                       counted */
+    uint32_t                        erase_unit;     /**< Size of the units whose erases are
+                                                       counted, e.g. the erase size of the area */
+} mtb_block_storage_stats_config_t;
+
+/** Statistics device. All members are private. */
+typedef struct
+{
+    mtb_block_storage_stats_config_t    config;     /**< Copy of the configuration */
+    #if (MTB_BLOCK_STORAGE_STATS_ENABLED)
+    mtb_block_storage_stats_t           stats;      /**< Statistics recorded so far */
+    uint32_t                            nb_start;   /**< Start of the non blocking operation */
+    uint8_t                             nb_op;      /**< Non blocking operation in progress */
+    mtb_block_storage_async_callback_t  callback;   /**< Completion callback of the application */
+    void*                               callback_arg;   /**< Argument of callback */
+    #endif
+} mtb_block_storage_stats_device_t;
+
+/** Function to create a block storage device that records the statistics of an inner device.
+ *  The optional functions are provided if the inner device provides them.
+ *
+ * @param[out] bsd      Block storage element to be initialized
+ * @param[out] obj      Statistics object, must stay valid while the device is in use
+ * @param[in]  config   Configuration of the statistics
+ * @return Result of the create function
+ */
+cy_rslt_t mtb_block_storage_create_stats(mtb_block_storage_t* bsd,
+                                         mtb_block_storage_stats_device_t* obj,
+                                         const mtb_block_storage_stats_config_t* config);
+
+/** Function to take a snapshot of the statistics of a device. The erase counts per unit are read
+ *  directly from the erase_counts array of the configuration.
+ *
+ * @param[in]  obj      Statistics object
+ * @param[out] stats    Statistics recorded since the create or the last reset
+ */
+void mtb_block_storage_stats_get(const mtb_block_storage_stats_device_t* obj,
+                                 mtb_block_storage_stats_t* stats);
+
+/** Function to reset the statistics of a device, including the erase counts per unit.
+ *
+ * @param[in]  obj      Statistics object
+ */
+void mtb_block_storage_stats_reset(mtb_block_storage_stats_device_t* obj);
+
+/** \} group_block_storage_stats */
+
+#if defined(__cplusplus)
+}
+#endif
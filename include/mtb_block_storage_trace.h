@@ -0,0 +1,169 @@
+/***********************************************************************************************//**
+ * \file mtb_block_storage_trace.h
+ *
+ * \brief
+ * Trace of the operations of the block storage devices. Records the read, program and erase calls
+ * of the devices in a ring buffer that can be dumped after a crash or a watchdog reset.
+ *
+ ***************************************************************************************************
+ * \copyright
+ * Copyright 2024 Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **************************************************************************************************/
+#pragma once
+
+#include "mtb_block_storage.h"
+#include "cy_utils.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * \addtogroup group_block_storage_trace Block Storage Trace
+ * \{
+ * When MTB_BLOCK_STORAGE_TRACE_ENABLED is defined to 1, the read, program and erase functions of
+ * the devices provided by this library (HAL NVM, PDL, serial memory, serial flash, RAM and file)
+ * record every call in a trace buffer given to \ref mtb_block_storage_trace_start. A record is
+ * written when the call starts, with the operation, the device context, the address, the length
+ * and the start time, and completed with the end time and the result when the call returns. The
+ * record of a call that never returned, e.g. because a watchdog fired while a flash row was being
+ * programmed, stays marked as in progress.
+ *
+ * The buffer is a header followed by fixed-size records used as a ring, the newest records
+ * overwrite the oldest ones. Slots are reserved with an atomic increment, so records can be
+ * written from several threads and from interrupts without a lock (on the cores without atomic
+ * instructions, interrupts are masked for the increment). Placing the buffer in a memory that is
+ * not cleared on reset lets the application dump it on the next boot, before restarting the
+ * trace. tools/block_storage_trace.py turns a dump into a timeline.
+ *
+ * When MTB_BLOCK_STORAGE_TRACE_ENABLED is 0, the default, the trace hooks compile to nothing.
+ */
+
+/** Whether the devices record their operations */
+#if !defined(MTB_BLOCK_STORAGE_TRACE_ENABLED)
+#define MTB_BLOCK_STORAGE_TRACE_ENABLED         (0)
+#endif
+
+/** Value of the magic field of the trace header, "BSTR" */
+#define MTB_BLOCK_STORAGE_TRACE_MAGIC           (0x52545342u)
+/** Version of the trace layout */
+#define MTB_BLOCK_STORAGE_TRACE_VERSION         (1u)
+/** Result of a record whose call has not returned */
+#define MTB_BLOCK_STORAGE_TRACE_IN_PROGRESS     (0xFFFFFFFFu)
+/** Number returned by \ref mtb_block_storage_trace_begin when no record is written. It is never
+ *  the number of a record, the numbering skips it when it wraps. */
+#define MTB_BLOCK_STORAGE_TRACE_NO_RECORD       (0xFFFFFFFFu)
+
+/** Operations recorded in the trace */
+typedef enum
+{
+    MTB_BLOCK_STORAGE_TRACE_READ    = 1,    /**< read */
+    MTB_BLOCK_STORAGE_TRACE_PROGRAM = 2,    /**< program */
+    MTB_BLOCK_STORAGE_TRACE_ERASE   = 3,    /**< erase */
+} mtb_block_storage_trace_op_t;
+
+/** Record of one call, 32 bytes in the native byte order */
+typedef struct
+{
+    volatile uint32_t   sequence;   /**< Number of the record plus 1, 0 while it is written or
+                                       when a later call reused it while this one returned */
+    uint32_t            op;         /**< Operation, see \ref mtb_block_storage_trace_op_t */
+    uint32_t            context;    /**< Low 32 bits of the context of the device */
+    uint32_t            addr;       /**< Address of the call */
+    uint32_t            length;     /**< Length of the call */
+    uint32_t            start;      /**< Clock value when the call started */
+    uint32_t            end;        /**< Clock value when the call returned */
+    volatile uint32_t   result;     /**< Result of the call, MTB_BLOCK_STORAGE_TRACE_IN_PROGRESS
+                                       until it returns */
+} mtb_block_storage_trace_record_t;
+
+/** Header of a trace buffer, 32 bytes in the native byte order */
+typedef struct
+{
+    uint32_t            magic;          /**< MTB_BLOCK_STORAGE_TRACE_MAGIC */
+    uint32_t            version;        /**< MTB_BLOCK_STORAGE_TRACE_VERSION */
+    uint32_t            record_size;    /**< Size of a record */
+    uint32_t            record_count;   /**< Number of records following the header */
+    uint32_t            clock_hz;       /**< Frequency of the clock, 0 if unknown */
+    volatile uint32_t   next;           /**< Number of records reserved so far */
+    uint32_t            reserved[2];    /**< Reserved, 0 */
+} mtb_block_storage_trace_header_t;
+
+/** Function prototype of the clock giving the timestamps of the records.
+ *
+ * @return Current value of a free running 32 bits counter
+ */
+typedef uint32_t (* mtb_block_storage_trace_clock_t)(void);
+
+/** Function to start recording the operations of the devices in a buffer. The buffer is
+ *  cleared, an earlier content must be dumped before.
+ *
+ * @param[in]  buffer   Trace buffer, aligned to 4 bytes. Must stay valid until the trace is
+ *                      stopped.
+ * @param[in]  size     Size of buffer, room for the header and at least one record
+ * @param[in]  clock    Clock giving the timestamps, NULL to record 0
+ * @param[in]  clock_hz Frequency of clock, stored in the header for the decoder
+ * @return Result of the operation
+ */
+cy_rslt_t mtb_block_storage_trace_start(void* buffer, uint32_t size,
+                                        mtb_block_storage_trace_clock_t clock, uint32_t clock_hz);
+
+/** Function to stop recording the operations. The buffer keeps the records. */
+void mtb_block_storage_trace_stop(void);
+
+/** Function to record the start of a call. Used by the devices through
+ *  MTB_BLOCK_STORAGE_TRACE_BEGIN.
+ *
+ * @param[in]  op       Operation
+ * @param[in]  context  Context of the device
+ * @param[in]  addr     Address of the call
+ * @param[in]  length   Length of the call
+ * @return Number of the record, to give to \ref mtb_block_storage_trace_end.
+ *         MTB_BLOCK_STORAGE_TRACE_NO_RECORD if the trace is stopped.
+ */
+uint32_t mtb_block_storage_trace_begin(mtb_block_storage_trace_op_t op, const void* context,
+                                       uint32_t addr, uint32_t length);
+
+/** Function to record the end of a call. Does nothing if the record was overwritten meanwhile,
+ *  and drops it if it is overwritten while the end is written, so that it never mixes two calls.
+ *  Used by the devices through MTB_BLOCK_STORAGE_TRACE_END.
+ *
+ * @param[in]  record   Number of the record returned by \ref mtb_block_storage_trace_begin
+ * @param[in]  result   Result of the call
+ */
+void mtb_block_storage_trace_end(uint32_t record, cy_rslt_t result);
+
+#if (MTB_BLOCK_STORAGE_TRACE_ENABLED)
+/** Records the start of a call, evaluates to the number of its record */
+#define MTB_BLOCK_STORAGE_TRACE_BEGIN(op, context, addr, length) \
+    mtb_block_storage_trace_begin((op), (context), (addr), (length))
+/** Records the end of a call */
+#define MTB_BLOCK_STORAGE_TRACE_END(record, result) \
+    mtb_block_storage_trace_end((record), (result))
+#else
+/** Records the start of a call, evaluates to the number of its record */
+#define MTB_BLOCK_STORAGE_TRACE_BEGIN(op, context, addr, length)    (0u)
+/** Records the end of a call */
+#define MTB_BLOCK_STORAGE_TRACE_END(record, result)                 CY_UNUSED_PARAMETER(record)
+#endif // if (MTB_BLOCK_STORAGE_TRACE_ENABLED)
+
+/** \} group_block_storage_trace */
+
+#if defined(__cplusplus)
+}
+#endif
@@ -0,0 +1,580 @@
+/***********************************************************************************************//**
+ * \file mtb_block_storage.c
+ *
+ * \brief
+ * Utility library for defining storage to NVM. Contains the helpers that work on top of any block
+ * storage device.
+ *
+ ***************************************************************************************************
+ * \copyright
+ * Copyright 2024 Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **************************************************************************************************/
+#include "mtb_block_storage.h"
+
+#include <string.h>
+
+/*******************************************************************************
+*                       Private Function Definitions
+*******************************************************************************/
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_is_blank
+//--------------------------------------------------------------------------------------------------
+static bool _mtb_block_storage_is_blank(const uint8_t* data, uint32_t length, uint8_t value)
+{
+    const uint32_t pattern = 0x01010101UL * value;
+    uint32_t i = 0;
+
+    //Byte compare up to the first aligned word, then compare a word at a time
+    while ((i < length) && (0u != (((uintptr_t)&data[i]) & (sizeof(uint32_t) - 1u))))
+    {
+        if (data[i] != value)
+        {
+            return false;
+        }
+        i++;
+    }
+    for (; (i + sizeof(uint32_t)) <= length; i += sizeof(uint32_t))
+    {
+        //Copied rather than read through a uint32_t pointer, which would alias the bytes. The
+        //compilers turn the copy into a single load.
+        uint32_t word;
+        (void)memcpy(&word, &data[i], sizeof(word));
+        if (word != pattern)
+        {
+            return false;
+        }
+    }
+    for (; i < length; i++)
+    {
+        if (data[i] != value)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+#if (CPUSS_FLASHC_ECT == 1)
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_is_work_flash
+//--------------------------------------------------------------------------------------------------
+static inline bool _mtb_block_storage_is_work_flash(const uint8_t* ptr, uint32_t size)
+{
+    uintptr_t start = (uintptr_t)ptr;
+    return (start >= CY_WFLASH_BASE) && ((start - CY_WFLASH_BASE) < CY_WFLASH_SIZE) &&
+           (size <= (CY_WFLASH_SIZE - (start - CY_WFLASH_BASE)));
+}
+
+
+#endif // if (CPUSS_FLASHC_ECT == 1)
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_is_mapped_unit_blank
+//--------------------------------------------------------------------------------------------------
+static bool _mtb_block_storage_is_mapped_unit_blank(const uint8_t* ptr, uint32_t size,
+                                                    uint8_t value)
+{
+    bool blank;
+    #if (CPUSS_FLASHC_ECT == 1)
+    //Erased work flash reads with ECC errors, the flash controller checks it without reading it.
+    //Any result other than a success, e.g. not erased, leads to the erase of the unit.
+    if (_mtb_block_storage_is_work_flash(ptr, size))
+    {
+        cy_stc_flash_blankcheck_config_t config;
+        config.addrToBeChecked = (uint32_t*)(uintptr_t)ptr;
+        config.numOfWordsToBeChecked = size / sizeof(uint32_t);
+        blank = (Cy_Flash_BlankCheck(&config, CY_FLASH_DRIVER_BLOCKING) == CY_FLASH_DRV_SUCCESS);
+    }
+    else
+    #endif // if (CPUSS_FLASHC_ECT == 1)
+    {
+        blank = _mtb_block_storage_is_blank(ptr, size, value);
+    }
+    return blank;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_is_unit_blank
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_is_unit_blank(const mtb_block_storage_t* bsd, uint32_t addr,
+                                                  uint32_t size, uint8_t* scratch,
+                                                  uint32_t scratch_size, bool* blank)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint8_t value = bsd->get_erase_value(bsd->context, addr);
+    uint32_t offset = 0;
+    const uint8_t* ptr = NULL;
+
+    //A memory mapped unit is compared in place, without copying it through scratch
+    if ((NULL != bsd->map) && (bsd->map(bsd->context, addr, size, &ptr) == CY_RSLT_SUCCESS))
+    {
+        *blank = _mtb_block_storage_is_mapped_unit_blank(ptr, size, value);
+        if (NULL != bsd->unmap)
+        {
+            result = bsd->unmap(bsd->context, ptr, size);
+        }
+        offset = size;
+    }
+    else
+    {
+        *blank = true;
+    }
+
+    //Stop reading at the first chunk that is not blank
+    while ((result == CY_RSLT_SUCCESS) && *blank && (offset < size))
+    {
+        uint32_t chunk = ((size - offset) < scratch_size) ? (size - offset) : scratch_size;
+        result = bsd->read(bsd->context, addr + offset, chunk, scratch);
+        if (result == CY_RSLT_SUCCESS)
+        {
+            *blank = _mtb_block_storage_is_blank(scratch, chunk, value);
+        }
+        offset += chunk;
+    }
+    return result;
+}
+
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_is_uniform
+//--------------------------------------------------------------------------------------------------
+static bool _mtb_block_storage_is_uniform(const mtb_block_storage_t* bsd, uint32_t addr,
+                                          uint32_t size, uint32_t sector_size)
+{
+    for (uint32_t offset = sector_size; offset < size; offset += sector_size)
+    {
+        if (bsd->get_erase_size(bsd->context, addr + offset) != sector_size)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_add_step
+//--------------------------------------------------------------------------------------------------
+static void _mtb_block_storage_add_step(mtb_block_storage_erase_step_t* steps, uint32_t max_steps,
+                                        uint32_t* count, mtb_block_storage_erase_step_t* last,
+                                        uint32_t addr, uint32_t length, uint32_t erase_size)
+{
+    //A step continuing the previous one with the same command size extends it
+    if ((*count > 0u) && (last->erase_size == erase_size) &&
+        ((last->addr + last->length) == addr))
+    {
+        last->length += length;
+    }
+    else
+    {
+        last->addr = addr;
+        last->length = length;
+        last->erase_size = erase_size;
+        (*count)++;
+    }
+    if (*count <= max_steps)
+    {
+        steps[*count - 1u] = *last;
+    }
+}
+
+
+/*******************************************************************************
+*                        Public Function Definitions
+*******************************************************************************/
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_get_geometry
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t mtb_block_storage_get_geometry(const mtb_block_storage_t* bsd,
+                                         mtb_block_storage_region_t* regions,
+                                         uint32_t max_regions, uint32_t* region_count)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    if ((NULL == bsd) || (NULL == region_count) || ((NULL == regions) && (0u != max_regions)))
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+    }
+    else if (NULL == bsd->get_geometry)
+    {
+        result = MTB_BLOCK_STORAGE_NOT_SUPPORTED_ERROR;
+    }
+    else
+    {
+        result = bsd->get_geometry(bsd->context, regions, max_regions, region_count);
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_readv
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t mtb_block_storage_readv(const mtb_block_storage_t* bsd,
+                                  const mtb_block_storage_read_vec_t* vecs, uint32_t count)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    if ((NULL == bsd) || ((NULL == vecs) && (0u != count)))
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+    }
+    else if (NULL != bsd->readv)
+    {
+        result = bsd->readv(bsd->context, vecs, count);
+    }
+    else
+    {
+        uint32_t addr = 0;
+        uint32_t length = 0;
+        uint8_t* buf = NULL;
+        for (uint32_t i = 0; (result == CY_RSLT_SUCCESS) && (i <= count); i++)
+        {
+            //A fragment continuing the pending one on the device and in memory joins its call
+            if ((i < count) && (0u != length) && (vecs[i].addr == (addr + length)) &&
+                (vecs[i].buf == &buf[length]) && (vecs[i].length <= (UINT32_MAX - length)))
+            {
+                length += vecs[i].length;
+                continue;
+            }
+            if (0u != length)
+            {
+                result = bsd->read(bsd->context, addr, length, buf);
+            }
+            if (i < count)
+            {
+                addr = vecs[i].addr;
+                length = vecs[i].length;
+                buf = vecs[i].buf;
+            }
+        }
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_programv
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t mtb_block_storage_programv(const mtb_block_storage_t* bsd,
+                                     const mtb_block_storage_program_vec_t* vecs, uint32_t count)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    if ((NULL == bsd) || ((NULL == vecs) && (0u != count)))
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+    }
+    else if (NULL != bsd->programv)
+    {
+        result = bsd->programv(bsd->context, vecs, count);
+    }
+    else
+    {
+        uint32_t addr = 0;
+        uint32_t length = 0;
+        const uint8_t* buf = NULL;
+        for (uint32_t i = 0; (result == CY_RSLT_SUCCESS) && (i <= count); i++)
+        {
+            if ((i < count) && (0u != length) && (vecs[i].addr == (addr + length)) &&
+                (vecs[i].buf == &buf[length]) && (vecs[i].length <= (UINT32_MAX - length)))
+            {
+                length += vecs[i].length;
+                continue;
+            }
+            if (0u != length)
+            {
+                result = bsd->program(bsd->context, addr, length, buf);
+            }
+            if (i < count)
+            {
+                addr = vecs[i].addr;
+                length = vecs[i].length;
+                buf = vecs[i].buf;
+            }
+        }
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_map
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t mtb_block_storage_map(const mtb_block_storage_t* bsd, uint32_t addr, uint32_t length,
+                                const uint8_t** ptr)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    if ((NULL == bsd) || (NULL == ptr))
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+    }
+    else if (NULL == bsd->map)
+    {
+        result = MTB_BLOCK_STORAGE_NOT_SUPPORTED_ERROR;
+    }
+    else
+    {
+        result = bsd->map(bsd->context, addr, length, ptr);
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_unmap
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t mtb_block_storage_unmap(const mtb_block_storage_t* bsd, const uint8_t* ptr,
+                                  uint32_t length)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    if ((NULL == bsd) || (NULL == ptr))
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+    }
+    else if (NULL == bsd->unmap)
+    {
+        result = MTB_BLOCK_STORAGE_NOT_SUPPORTED_ERROR;
+    }
+    else
+    {
+        result = bsd->unmap(bsd->context, ptr, length);
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_find_region
+//--------------------------------------------------------------------------------------------------
+const mtb_block_storage_region_t* mtb_block_storage_find_region(
+    const mtb_block_storage_region_t* regions, uint32_t region_count, uint32_t addr)
+{
+    const mtb_block_storage_region_t* region = NULL;
+    uint32_t low = 0;
+    uint32_t high = region_count;
+
+    //Find the last region starting at or before the address
+    while (low < high)
+    {
+        uint32_t mid = low + ((high - low) / 2u);
+        if (regions[mid].start_address <= addr)
+        {
+            low = mid + 1u;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    if ((low > 0u) && ((addr - regions[low - 1u].start_address) < regions[low - 1u].size))
+    {
+        region = &regions[low - 1u];
+    }
+    return region;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_is_erase_needed
+//--------------------------------------------------------------------------------------------------
+bool mtb_block_storage_is_erase_needed(const uint8_t* current, const uint8_t* data,
+                                       uint32_t length, uint8_t erase_value)
+{
+    //A program can only move bits away from the erase value. An erase is needed if some bit
+    //changes and its new value is the erase value.
+    for (uint32_t i = 0; i < length; i++)
+    {
+        if (0u != ((uint8_t)(current[i] ^ data[i]) & (uint8_t)~(data[i] ^ erase_value)))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_erase_blank_check
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t mtb_block_storage_erase_blank_check(const mtb_block_storage_t* bsd, uint32_t addr,
+                                              uint32_t length, uint8_t* scratch,
+                                              uint32_t scratch_size, uint32_t* skipped)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint32_t end = addr + length;
+    uint32_t current = addr;
+    uint32_t pending_addr = addr;
+    uint32_t skip_count = 0;
+
+    if ((NULL == bsd) || (NULL == scratch) || (0u == scratch_size) || (end < addr))
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+    }
+
+    //Units that are not blank are accumulated from pending_addr and erased in one call when a
+    //blank unit or the end of the area is reached
+    while ((result == CY_RSLT_SUCCESS) && (current < end))
+    {
+        uint32_t size = bsd->get_erase_size(bsd->context, current);
+        bool blank = false;
+
+        if ((0u == size) || (0u != (current % size)) || (size > (end - current)))
+        {
+            result = MTB_BLOCK_STORAGE_INVALID_SIZE_ERROR;
+        }
+        else
+        {
+            result = _mtb_block_storage_is_unit_blank(bsd, current, size, scratch, scratch_size,
+                                                      &blank);
+        }
+        if ((result == CY_RSLT_SUCCESS) && blank)
+        {
+            if (current > pending_addr)
+            {
+                result = bsd->erase(bsd->context, pending_addr, current - pending_addr);
+            }
+            pending_addr = current + size;
+            skip_count++;
+        }
+        current += size;
+    }
+
+    if ((result == CY_RSLT_SUCCESS) && (end > pending_addr))
+    {
+        result = bsd->erase(bsd->context, pending_addr, end - pending_addr);
+    }
+    if (NULL != skipped)
+    {
+        *skipped = skip_count;
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_plan_erase
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t mtb_block_storage_plan_erase(const mtb_block_storage_t* bsd,
+                                       const uint32_t* block_sizes, uint32_t block_size_count,
+                                       uint32_t device_size, uint32_t addr, uint32_t length,
+                                       mtb_block_storage_erase_step_t* steps, uint32_t max_steps,
+                                       uint32_t* step_count)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint32_t end = addr + length;
+    uint32_t current = addr;
+    uint32_t count = 0;
+    mtb_block_storage_erase_step_t last = { 0u, 0u, 0u };
+
+    if ((NULL == bsd) || (NULL == step_count) || ((NULL == steps) && (0u != max_steps)) ||
+        ((NULL == block_sizes) && (0u != block_size_count)) || (end < addr))
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+    }
+    else if ((0u != device_size) && (0u == addr) && (length == device_size))
+    {
+        _mtb_block_storage_add_step(steps, max_steps, &count, &last, addr, length, 0u);
+        current = end;
+    }
+
+    while ((result == CY_RSLT_SUCCESS) && (current < end))
+    {
+        uint32_t sector_size = bsd->get_erase_size(bsd->context, current);
+        uint32_t unit = sector_size;
+
+        if ((0u == sector_size) || (0u != (current % sector_size)) ||
+            (sector_size > (end - current)))
+        {
+            result = MTB_BLOCK_STORAGE_INVALID_SIZE_ERROR;
+        }
+        else
+        {
+            //Largest block that is aligned, fits in the range and has a single sector size
+            for (uint32_t i = 0; i < block_size_count; i++)
+            {
+                uint32_t size = block_sizes[i];
+                if ((size > unit) && (0u == (size % sector_size)) && (0u == (current % size)) &&
+                    (size <= (end - current)) &&
+                    _mtb_block_storage_is_uniform(bsd, current, size, sector_size))
+                {
+                    unit = size;
+                }
+            }
+            _mtb_block_storage_add_step(steps, max_steps, &count, &last, current, unit, unit);
+            current += unit;
+        }
+    }
+
+    if (NULL != step_count)
+    {
+        *step_count = count;
+    }
+    if ((result == CY_RSLT_SUCCESS) && (count > max_steps))
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_SIZE_ERROR;
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_execute_erase_plan
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t mtb_block_storage_execute_erase_plan(const mtb_block_storage_t* bsd,
+                                               const mtb_block_storage_erase_step_t* steps,
+                                               uint32_t step_count,
+                                               mtb_block_storage_block_erase_t block_erase,
+                                               void* block_erase_arg)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    if ((NULL == bsd) || ((NULL == steps) && (0u != step_count)))
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+    }
+
+    for (uint32_t i = 0; (result == CY_RSLT_SUCCESS) && (i < step_count); i++)
+    {
+        const mtb_block_storage_erase_step_t* step = &steps[i];
+        if ((NULL == block_erase) ||
+            ((0u != step->erase_size) &&
+             (step->erase_size == bsd->get_erase_size(bsd->context, step->addr))))
+        {
+            result = bsd->erase(bsd->context, step->addr, step->length);
+        }
+        else if (0u == step->erase_size)
+        {
+            result = block_erase(block_erase_arg, step->addr, 0u);
+        }
+        else
+        {
+            for (uint32_t offset = 0; (result == CY_RSLT_SUCCESS) && (offset < step->length);
+                 offset += step->erase_size)
+            {
+                result = block_erase(block_erase_arg, step->addr + offset, step->erase_size);
+            }
+        }
+    }
+    return result;
+}
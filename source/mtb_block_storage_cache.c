@@ -0,0 +1,392 @@
+/***********************************************************************************************//**
+ * \file mtb_block_storage_cache.c
+ *
+ * \brief
+ * Write-back cache for block storage devices. Provides byte-granular writes on top of any block
+ * storage device by keeping the erase units being modified in RAM.
+ *
+ ***************************************************************************************************
+ * \copyright
+ * Copyright 2024 Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **************************************************************************************************/
+#include "mtb_block_storage_cache.h"
+
+#include <string.h>
+
+//Size of the stack buffer through which a unit is read to compare it before the write back
+#define _MTB_BLOCK_STORAGE_CACHE_COMPARE_CHUNK  (64u)
+
+/*******************************************************************************
+*                       Private Function Definitions
+*******************************************************************************/
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_cache_lookup
+//--------------------------------------------------------------------------------------------------
+static mtb_block_storage_cache_entry_t* _mtb_block_storage_cache_lookup(
+    mtb_block_storage_cache_t* cache, uint32_t addr)
+{
+    for (uint32_t i = 0; i < cache->entry_count; i++)
+    {
+        mtb_block_storage_cache_entry_t* entry = &cache->entries[i];
+        if ((0u != entry->size) && (addr >= entry->addr) && ((addr - entry->addr) < entry->size))
+        {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_cache_next
+//--------------------------------------------------------------------------------------------------
+static uint32_t _mtb_block_storage_cache_next(const mtb_block_storage_cache_t* cache,
+                                              uint32_t addr, uint32_t end)
+{
+    //Start of the first cached unit after addr, or end if there is none before it
+    uint32_t next = end;
+    for (uint32_t i = 0; i < cache->entry_count; i++)
+    {
+        const mtb_block_storage_cache_entry_t* entry = &cache->entries[i];
+        if ((0u != entry->size) && (entry->addr > addr) && (entry->addr < next))
+        {
+            next = entry->addr;
+        }
+    }
+    return next;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_cache_write_back
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_cache_write_back(mtb_block_storage_cache_t* cache,
+                                                     mtb_block_storage_cache_entry_t* entry)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    mtb_block_storage_t* bsd = cache->bsd;
+
+    if (entry->dirty)
+    {
+        uint8_t current[_MTB_BLOCK_STORAGE_CACHE_COMPARE_CHUNK];
+        uint8_t erase_value = bsd->get_erase_value(bsd->context, entry->addr);
+        //A device that does not tell is assumed to need an erase before a program
+        bool erase_required = (NULL == bsd->is_erase_required) ||
+                              bsd->is_erase_required(bsd->context, entry->addr, entry->size);
+        bool compare = (0u != (cache->options & MTB_BLOCK_STORAGE_OPTION_COMPARE_BEFORE_PROGRAM));
+        bool changed = !compare;
+        bool erase = erase_required &&
+                     (!compare ||
+                      (0u == (cache->options & MTB_BLOCK_STORAGE_OPTION_PROGRAM_WITHOUT_ERASE)));
+
+        //Compare with the device content: an unchanged unit is not written back, and a unit whose
+        //bits only move away from the erase value can be programmed without an erase
+        for (uint32_t offset = 0; compare && (result == CY_RSLT_SUCCESS) && (offset < entry->size);
+             offset += sizeof(current))
+        {
+            uint32_t chunk = ((entry->size - offset) < sizeof(current)) ?
+                             (entry->size - offset) : sizeof(current);
+            result = bsd->read(bsd->context, entry->addr + offset, chunk, current);
+            if ((result == CY_RSLT_SUCCESS) && (0 != memcmp(current, &entry->data[offset], chunk)))
+            {
+                changed = true;
+                if (!erase && erase_required)
+                {
+                    erase = mtb_block_storage_is_erase_needed(current, &entry->data[offset], chunk,
+                                                              erase_value);
+                }
+                //Once an erase is needed the rest of the content does not matter
+                compare = !erase;
+            }
+        }
+        erase = erase && changed;
+
+        if ((result == CY_RSLT_SUCCESS) && erase)
+        {
+            result = bsd->erase(bsd->context, entry->addr, entry->size);
+        }
+        //The erase size is a multiple of the program size, so the unit is programmed in one call
+        if ((result == CY_RSLT_SUCCESS) && changed)
+        {
+            result = bsd->program(bsd->context, entry->addr, entry->size, entry->data);
+        }
+        if (result == CY_RSLT_SUCCESS)
+        {
+            entry->dirty = false;
+        }
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_cache_load
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_cache_load(mtb_block_storage_cache_t* cache, uint32_t addr,
+                                               uint32_t end,
+                                               mtb_block_storage_cache_entry_t** loaded)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    mtb_block_storage_t* bsd = cache->bsd;
+    mtb_block_storage_cache_entry_t* entry = NULL;
+    uint32_t size = bsd->get_erase_size(bsd->context, addr);
+    uint32_t unit_addr = 0;
+
+    if (0u == size)
+    {
+        result = MTB_BLOCK_STORAGE_NOT_IN_RANGE_ERROR;
+    }
+    else if (size > cache->entry_size)
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_SIZE_ERROR;
+    }
+    else
+    {
+        unit_addr = addr - (addr % size);
+
+        //Use a free entry, otherwise evict the least recently used one
+        entry = &cache->entries[0];
+        for (uint32_t i = 0; (i < cache->entry_count) && (0u != entry->size); i++)
+        {
+            if ((0u == cache->entries[i].size) ||
+                (cache->entries[i].last_use < entry->last_use))
+            {
+                entry = &cache->entries[i];
+            }
+        }
+        result = _mtb_block_storage_cache_write_back(cache, entry);
+    }
+
+    if (result == CY_RSLT_SUCCESS)
+    {
+        entry->size = 0;
+        //A unit that is entirely overwritten does not need to be read
+        if ((addr != unit_addr) || ((end - addr) < size))
+        {
+            result = bsd->read(bsd->context, unit_addr, size, entry->data);
+        }
+    }
+
+    if (result == CY_RSLT_SUCCESS)
+    {
+        entry->addr = unit_addr;
+        entry->size = size;
+        entry->dirty = false;
+        *loaded = entry;
+    }
+    return result;
+}
+
+
+/*******************************************************************************
+*                        Public Function Definitions
+*******************************************************************************/
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_cache_init
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t mtb_block_storage_cache_init(mtb_block_storage_cache_t* cache, mtb_block_storage_t* bsd,
+                                       uint8_t* buffer, uint32_t buffer_size,
+                                       uint32_t entry_size)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    if ((NULL == cache) || (NULL == bsd) || (NULL == buffer) || (0u == entry_size) ||
+        (buffer_size < entry_size))
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+    }
+    else
+    {
+        memset(cache, 0, sizeof(*cache));
+        cache->bsd = bsd;
+        cache->entry_size = entry_size;
+        cache->entry_count = buffer_size / entry_size;
+        if (cache->entry_count > MTB_BLOCK_STORAGE_CACHE_MAX_ENTRIES)
+        {
+            cache->entry_count = MTB_BLOCK_STORAGE_CACHE_MAX_ENTRIES;
+        }
+        for (uint32_t i = 0; i < cache->entry_count; i++)
+        {
+            cache->entries[i].data = &buffer[i * entry_size];
+        }
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_cache_set_options
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t mtb_block_storage_cache_set_options(mtb_block_storage_cache_t* cache, uint32_t options)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    if (NULL == cache)
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+    }
+    else
+    {
+        cache->options = options;
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_cache_read
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t mtb_block_storage_cache_read(mtb_block_storage_cache_t* cache, uint32_t addr,
+                                       uint32_t length, uint8_t* buf)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint32_t end = addr + length;
+    uint32_t run_addr = addr;
+    uint32_t current = addr;
+
+    if ((NULL == cache) || ((NULL == buf) && (0u != length)) || (end < addr))
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+    }
+
+    //The parts that are not cached are read from the device in as few calls as possible
+    while ((result == CY_RSLT_SUCCESS) && (current < end))
+    {
+        mtb_block_storage_cache_entry_t* entry = _mtb_block_storage_cache_lookup(cache, current);
+        if (NULL == entry)
+        {
+            current = _mtb_block_storage_cache_next(cache, current, end);
+        }
+        else
+        {
+            if (current > run_addr)
+            {
+                result = cache->bsd->read(cache->bsd->context, run_addr, current - run_addr,
+                                          &buf[run_addr - addr]);
+            }
+            if (result == CY_RSLT_SUCCESS)
+            {
+                uint32_t entry_end = entry->addr + entry->size;
+                uint32_t chunk = ((entry_end < end) ? entry_end : end) - current;
+                memcpy(&buf[current - addr], &entry->data[current - entry->addr], chunk);
+                entry->last_use = ++cache->use_counter;
+                current += chunk;
+                run_addr = current;
+            }
+        }
+    }
+
+    if ((result == CY_RSLT_SUCCESS) && (end > run_addr))
+    {
+        result = cache->bsd->read(cache->bsd->context, run_addr, end - run_addr,
+                                  &buf[run_addr - addr]);
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_cache_write
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t mtb_block_storage_cache_write(mtb_block_storage_cache_t* cache, uint32_t addr,
+                                        uint32_t length, const uint8_t* buf)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint32_t end = addr + length;
+    uint32_t current = addr;
+
+    if ((NULL == cache) || ((NULL == buf) && (0u != length)) || (end < addr))
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+    }
+
+    while ((result == CY_RSLT_SUCCESS) && (current < end))
+    {
+        mtb_block_storage_cache_entry_t* entry = _mtb_block_storage_cache_lookup(cache, current);
+        if (NULL == entry)
+        {
+            result = _mtb_block_storage_cache_load(cache, current, end, &entry);
+        }
+        if (result == CY_RSLT_SUCCESS)
+        {
+            uint32_t entry_end = entry->addr + entry->size;
+            uint32_t chunk = ((entry_end < end) ? entry_end : end) - current;
+            memcpy(&entry->data[current - entry->addr], &buf[current - addr], chunk);
+            entry->dirty = true;
+            entry->last_use = ++cache->use_counter;
+            current += chunk;
+        }
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_cache_flush
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t mtb_block_storage_cache_flush(mtb_block_storage_cache_t* cache)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    if (NULL == cache)
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+    }
+
+    //Units are written back in address order, which is the fastest order for most devices
+    uint32_t addr = 0;
+    while (result == CY_RSLT_SUCCESS)
+    {
+        mtb_block_storage_cache_entry_t* next = NULL;
+        for (uint32_t i = 0; i < cache->entry_count; i++)
+        {
+            mtb_block_storage_cache_entry_t* entry = &cache->entries[i];
+            if (entry->dirty && (entry->addr >= addr) &&
+                ((NULL == next) || (entry->addr < next->addr)))
+            {
+                next = entry;
+            }
+        }
+        if (NULL == next)
+        {
+            break;
+        }
+        result = _mtb_block_storage_cache_write_back(cache, next);
+        addr = next->addr + next->size;
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_cache_deinit
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t mtb_block_storage_cache_deinit(mtb_block_storage_cache_t* cache)
+{
+    cy_rslt_t result = mtb_block_storage_cache_flush(cache);
+
+    if (result == CY_RSLT_SUCCESS)
+    {
+        for (uint32_t i = 0; i < cache->entry_count; i++)
+        {
+            cache->entries[i].size = 0;
+        }
+    }
+    return result;
+}
@@ -0,0 +1,473 @@
+/***********************************************************************************************//**
+ * \file mtb_block_storage_dma.c
+ *
+ * \brief
+ * DMA read of a memory mapped block storage device.
+ *
+ ***************************************************************************************************
+ * \copyright
+ * Copyright 2024 Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **************************************************************************************************/
+#include "mtb_block_storage_dma.h"
+#include "cy_utils.h"
+
+#include <string.h>
+
+//The DMA bypasses the data cache, the lines of the destination are invalidated around transfers
+#if defined(COMPONENT_CAT1) || defined(COMPONENT_CAT2)
+#include "cy_device_headers.h"
+#if defined(__DCACHE_PRESENT) && (__DCACHE_PRESENT == 1U)
+#define _MTB_BLOCK_STORAGE_DMA_DCACHE
+#endif
+#endif
+
+//Parts of a read, transferred in this order
+#define _MTB_BLOCK_STORAGE_DMA_IDLE     (0u)
+#define _MTB_BLOCK_STORAGE_DMA_HEAD     (1u)
+#define _MTB_BLOCK_STORAGE_DMA_BODY     (2u)
+#define _MTB_BLOCK_STORAGE_DMA_TAIL     (3u)
+#define _MTB_BLOCK_STORAGE_DMA_DONE     (4u)
+
+//A transfer longer than a burst is made in 2D mode, as up to 256 bursts moved on a single
+//trigger. A burst is 256 bytes, the longest 1D transfer when the elements are bytes, and 64 words
+//otherwise. The simulated engine has the same limits.
+#define _MTB_BLOCK_STORAGE_DMA_BURST_LENGTH     (256u)
+#define _MTB_BLOCK_STORAGE_DMA_MAX_LENGTH       (256u * _MTB_BLOCK_STORAGE_DMA_BURST_LENGTH)
+
+/*******************************************************************************
+*                       Private Function Definitions
+*******************************************************************************/
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_dma_invalidate
+//--------------------------------------------------------------------------------------------------
+static void _mtb_block_storage_dma_invalidate(mtb_block_storage_dma_t* obj)
+{
+    #if defined(_MTB_BLOCK_STORAGE_DMA_DCACHE)
+    //Only whole lines written by the DMA: the body of the buffer and the bounce buffers
+    uint32_t body = obj->length - obj->head - obj->tail;
+    if (0u != body)
+    {
+        SCB_InvalidateDCache_by_Addr(&obj->buf[obj->head], (int32_t)body);
+    }
+    SCB_InvalidateDCache_by_Addr(obj->config.bounce,
+                                 (int32_t)(MTB_BLOCK_STORAGE_DMA_BOUNCE_COUNT *
+                                           obj->config.line_size));
+    #else
+    CY_UNUSED_PARAMETER(obj);
+    #endif
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_dma_start_next
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_dma_start_next(mtb_block_storage_dma_t* obj)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint32_t chunk;
+
+    //The parts are contiguous in the memory, only the destination changes from a part to the next
+    while ((0u == obj->left) && (obj->phase < _MTB_BLOCK_STORAGE_DMA_DONE))
+    {
+        obj->phase++;
+        if (_MTB_BLOCK_STORAGE_DMA_HEAD == obj->phase)
+        {
+            obj->dst = obj->config.bounce;
+            obj->left = obj->head;
+        }
+        else if (_MTB_BLOCK_STORAGE_DMA_BODY == obj->phase)
+        {
+            obj->dst = &obj->buf[obj->head];
+            obj->left = obj->length - obj->head - obj->tail;
+        }
+        else if (_MTB_BLOCK_STORAGE_DMA_TAIL == obj->phase)
+        {
+            obj->dst = &obj->config.bounce[obj->config.line_size];
+            obj->left = obj->tail;
+        }
+    }
+
+    if (0u != obj->left)
+    {
+        uint8_t* dst = obj->dst;
+        const uint8_t* src = obj->src;
+        chunk = ((0u != obj->config.engine.max_length) &&
+                 (obj->left > obj->config.engine.max_length)) ?
+                obj->config.engine.max_length : obj->left;
+        if ((0u != obj->config.engine.burst_length) && (chunk > obj->config.engine.burst_length))
+        {
+            chunk -= chunk % obj->config.engine.burst_length;
+        }
+        //Moved on before the start, the completion interrupt may start the next transfer
+        obj->dst += chunk;
+        obj->src += chunk;
+        obj->left -= chunk;
+        result = obj->config.engine.start(obj->config.engine.arg, dst, src, chunk);
+        if (result == CY_RSLT_SUCCESS)
+        {
+            result = MTB_BLOCK_STORAGE_BUSY;
+        }
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_dma_finish
+//--------------------------------------------------------------------------------------------------
+static void _mtb_block_storage_dma_finish(mtb_block_storage_dma_t* obj, cy_rslt_t result)
+{
+    _mtb_block_storage_dma_invalidate(obj);
+    if (result == CY_RSLT_SUCCESS)
+    {
+        (void)memcpy(obj->buf, obj->config.bounce, obj->head);
+        (void)memcpy(&obj->buf[obj->length - obj->tail],
+                     &obj->config.bounce[obj->config.line_size], obj->tail);
+    }
+    obj->result = result;
+    obj->phase = _MTB_BLOCK_STORAGE_DMA_IDLE;
+    if (NULL != obj->callback)
+    {
+        obj->callback(obj->callback_arg, result);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_dma_advance
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_dma_advance(mtb_block_storage_dma_t* obj)
+{
+    cy_rslt_t result = MTB_BLOCK_STORAGE_BUSY;
+
+    if (obj->config.engine.is_complete(obj->config.engine.arg))
+    {
+        result = _mtb_block_storage_dma_start_next(obj);
+        if (result != MTB_BLOCK_STORAGE_BUSY)
+        {
+            _mtb_block_storage_dma_finish(obj, result);
+        }
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_dma_event
+//--------------------------------------------------------------------------------------------------
+static void _mtb_block_storage_dma_event(void* callback_arg)
+{
+    mtb_block_storage_dma_t* obj = (mtb_block_storage_dma_t*)callback_arg;
+    if (_MTB_BLOCK_STORAGE_DMA_IDLE != obj->phase)
+    {
+        (void)_mtb_block_storage_dma_advance(obj);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_dma_sim_start
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_dma_sim_start(void* arg, uint8_t* dst, const uint8_t* src,
+                                                  uint32_t length)
+{
+    mtb_block_storage_dma_sim_t* sim = (mtb_block_storage_dma_sim_t*)arg;
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    //Rejected like the HAL rejects a transfer that does not fit a 2D transfer of whole bursts
+    if ((length > _MTB_BLOCK_STORAGE_DMA_MAX_LENGTH) ||
+        ((length > _MTB_BLOCK_STORAGE_DMA_BURST_LENGTH) &&
+         (0u != (length % _MTB_BLOCK_STORAGE_DMA_BURST_LENGTH))))
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_SIZE_ERROR;
+    }
+    else
+    {
+        sim->dst = dst;
+        sim->src = src;
+        sim->left = length;
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_dma_sim_is_complete
+//--------------------------------------------------------------------------------------------------
+static bool _mtb_block_storage_dma_sim_is_complete(void* arg)
+{
+    mtb_block_storage_dma_sim_t* sim = (mtb_block_storage_dma_sim_t*)arg;
+    //Every check moves the transfer on, like a DMA engine running between two checks
+    uint32_t chunk = ((0u != sim->bytes_per_check) && (sim->left > sim->bytes_per_check)) ?
+                     sim->bytes_per_check : sim->left;
+    (void)memcpy(sim->dst, sim->src, chunk);
+    sim->dst += chunk;
+    sim->src += chunk;
+    sim->left -= chunk;
+    return (0u == sim->left);
+}
+
+
+#if defined(MTB_BLOCK_STORAGE_DMA_HAL_ENGINE_SUPPORTED)
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_dma_hal_start
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_dma_hal_start(void* arg, uint8_t* dst, const uint8_t* src,
+                                                  uint32_t length)
+{
+    mtb_block_storage_dma_hal_t* hal = (mtb_block_storage_dma_hal_t*)arg;
+    cyhal_dma_cfg_t cfg;
+    cy_rslt_t result;
+    //Word transfers when the source, the destination and the length allow it
+    bool words = (0u == (((uint32_t)(uintptr_t)dst | (uint32_t)(uintptr_t)src | length) & 3u));
+    uint32_t width = words ? 4u : 1u;
+
+    (void)memset(&cfg, 0, sizeof(cfg));
+    cfg.src_addr = (uint32_t)(uintptr_t)src;
+    cfg.src_increment = 1;
+    cfg.dst_addr = (uint32_t)(uintptr_t)dst;
+    cfg.dst_increment = 1;
+    cfg.transfer_width = words ? 32u : 8u;
+    cfg.length = length / width;
+    //A longer transfer is a multiple of the burst, all its bursts are moved on the one trigger
+    cfg.burst_size = (length > _MTB_BLOCK_STORAGE_DMA_BURST_LENGTH) ?
+                     (_MTB_BLOCK_STORAGE_DMA_BURST_LENGTH / width) : 0u;
+    cfg.action = CYHAL_DMA_TRANSFER_FULL;
+    result = cyhal_dma_configure(hal->dma, &cfg);
+    if (result == CY_RSLT_SUCCESS)
+    {
+        result = cyhal_dma_start_transfer(hal->dma);
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_dma_hal_is_complete
+//--------------------------------------------------------------------------------------------------
+static bool _mtb_block_storage_dma_hal_is_complete(void* arg)
+{
+    return !cyhal_dma_is_busy(((mtb_block_storage_dma_hal_t*)arg)->dma);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_dma_hal_event
+//--------------------------------------------------------------------------------------------------
+static void _mtb_block_storage_dma_hal_event(void* callback_arg, cyhal_dma_event_t event)
+{
+    mtb_block_storage_dma_hal_t* hal = (mtb_block_storage_dma_hal_t*)callback_arg;
+    if (0u != ((uint32_t)event & (uint32_t)CYHAL_DMA_TRANSFER_COMPLETE))
+    {
+        hal->callback(hal->callback_arg);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_dma_hal_register
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_dma_hal_register(void* arg,
+                                                     mtb_block_storage_dma_event_t callback,
+                                                     void* callback_arg)
+{
+    mtb_block_storage_dma_hal_t* hal = (mtb_block_storage_dma_hal_t*)arg;
+    hal->callback = callback;
+    hal->callback_arg = callback_arg;
+    cyhal_dma_register_callback(hal->dma, _mtb_block_storage_dma_hal_event, hal);
+    cyhal_dma_enable_event(hal->dma, CYHAL_DMA_TRANSFER_COMPLETE, hal->intr_priority, true);
+    return CY_RSLT_SUCCESS;
+}
+
+
+#endif // defined(MTB_BLOCK_STORAGE_DMA_HAL_ENGINE_SUPPORTED)
+
+/*******************************************************************************
+*                        Public Function Definitions
+*******************************************************************************/
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_dma_init
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t mtb_block_storage_dma_init(mtb_block_storage_dma_t* obj,
+                                     const mtb_block_storage_dma_config_t* config)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    if ((NULL == obj) || (NULL == config) || (NULL == config->bsd) ||
+        (NULL == config->engine.start) || (NULL == config->engine.is_complete) ||
+        (NULL == config->bounce) || (0u == config->line_size) ||
+        (0u != (config->line_size & (config->line_size - 1u))) ||
+        (0u != ((uintptr_t)config->bounce & (config->line_size - 1u))))
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+    }
+
+    if (result == CY_RSLT_SUCCESS)
+    {
+        (void)memset(obj, 0, sizeof(*obj));
+        obj->config = *config;
+        obj->phase = _MTB_BLOCK_STORAGE_DMA_IDLE;
+        obj->result = CY_RSLT_SUCCESS;
+        if (NULL != config->engine.register_callback)
+        {
+            result = config->engine.register_callback(config->engine.arg,
+                                                      _mtb_block_storage_dma_event, obj);
+        }
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_dma_read
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t mtb_block_storage_dma_read(mtb_block_storage_dma_t* obj, uint32_t addr,
+                                     uint32_t length, uint8_t* buf,
+                                     mtb_block_storage_async_callback_t callback,
+                                     void* callback_arg)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    mtb_block_storage_t* bsd;
+
+    if ((NULL == obj) || ((NULL == buf) && (0u != length)))
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+    }
+    else if (_MTB_BLOCK_STORAGE_DMA_IDLE != obj->phase)
+    {
+        result = MTB_BLOCK_STORAGE_BUSY;
+    }
+    else
+    {
+        bsd = obj->config.bsd;
+        if ((NULL != bsd->is_in_range) && !bsd->is_in_range(bsd->context, addr, length))
+        {
+            result = MTB_BLOCK_STORAGE_NOT_IN_RANGE_ERROR;
+        }
+        //The memory cannot be read while a program_nb or an erase_nb of the device is in
+        //progress, poll moves it on and the read is retried by the caller until it completes
+        else if ((NULL != bsd->poll) && (bsd->poll(bsd->context) == MTB_BLOCK_STORAGE_BUSY))
+        {
+            result = MTB_BLOCK_STORAGE_BUSY;
+        }
+    }
+
+    if (result == CY_RSLT_SUCCESS)
+    {
+        uint32_t line_mask = obj->config.line_size - 1u;
+        obj->buf = buf;
+        obj->length = length;
+        obj->src = (const uint8_t*)(obj->config.map_base + addr);
+        obj->left = 0;
+        obj->callback = callback;
+        obj->callback_arg = callback_arg;
+        if (length < obj->config.min_dma_length)
+        {
+            obj->head = 0;
+            obj->tail = 0;
+            (void)memcpy(buf, obj->src, length);
+            _mtb_block_storage_dma_finish(obj, CY_RSLT_SUCCESS);
+        }
+        else
+        {
+            //The head and the tail are the parts of the buffer sharing a cache line with other data
+            obj->head = (obj->config.line_size - ((uint32_t)(uintptr_t)buf & line_mask)) &
+                        line_mask;
+            obj->head = (obj->head < length) ? obj->head : length;
+            obj->tail = (length - obj->head) & line_mask;
+            _mtb_block_storage_dma_invalidate(obj);
+            result = _mtb_block_storage_dma_start_next(obj);
+            if (result == MTB_BLOCK_STORAGE_BUSY)
+            {
+                result = CY_RSLT_SUCCESS;
+            }
+            else if (result == CY_RSLT_SUCCESS)
+            {
+                _mtb_block_storage_dma_finish(obj, CY_RSLT_SUCCESS);
+            }
+            else
+            {
+                obj->phase = _MTB_BLOCK_STORAGE_DMA_IDLE;
+                obj->result = result;
+            }
+        }
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_dma_poll
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t mtb_block_storage_dma_poll(mtb_block_storage_dma_t* obj)
+{
+    cy_rslt_t result;
+
+    if (_MTB_BLOCK_STORAGE_DMA_IDLE != obj->phase)
+    {
+        //With an interrupt the read advances on its own, it is not raced from here
+        result = (NULL != obj->config.engine.register_callback) ?
+                 MTB_BLOCK_STORAGE_BUSY : _mtb_block_storage_dma_advance(obj);
+    }
+    else
+    {
+        result = obj->result;
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_dma_create_sim_engine
+//--------------------------------------------------------------------------------------------------
+void mtb_block_storage_dma_create_sim_engine(mtb_block_storage_dma_engine_t* engine,
+                                             mtb_block_storage_dma_sim_t* sim,
+                                             uint32_t bytes_per_check)
+{
+    (void)memset(sim, 0, sizeof(*sim));
+    sim->bytes_per_check = bytes_per_check;
+    engine->start = _mtb_block_storage_dma_sim_start;
+    engine->is_complete = _mtb_block_storage_dma_sim_is_complete;
+    engine->arg = sim;
+    engine->max_length = _MTB_BLOCK_STORAGE_DMA_MAX_LENGTH;
+    engine->burst_length = _MTB_BLOCK_STORAGE_DMA_BURST_LENGTH;
+    engine->register_callback = NULL;
+}
+
+
+#if defined(MTB_BLOCK_STORAGE_DMA_HAL_ENGINE_SUPPORTED)
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_dma_create_hal_engine
+//--------------------------------------------------------------------------------------------------
+void mtb_block_storage_dma_create_hal_engine(mtb_block_storage_dma_engine_t* engine,
+                                             mtb_block_storage_dma_hal_t* hal, cyhal_dma_t* dma,
+                                             uint8_t intr_priority)
+{
+    (void)memset(hal, 0, sizeof(*hal));
+    hal->dma = dma;
+    hal->intr_priority = intr_priority;
+    engine->start = _mtb_block_storage_dma_hal_start;
+    engine->is_complete = _mtb_block_storage_dma_hal_is_complete;
+    engine->arg = hal;
+    engine->max_length = _MTB_BLOCK_STORAGE_DMA_MAX_LENGTH;
+    engine->burst_length = _MTB_BLOCK_STORAGE_DMA_BURST_LENGTH;
+    engine->register_callback = _mtb_block_storage_dma_hal_register;
+}
+
+
+#endif // defined(MTB_BLOCK_STORAGE_DMA_HAL_ENGINE_SUPPORTED)
@@ -0,0 +1,231 @@
+/***********************************************************************************************//**
+ * \file mtb_block_storage_file.c
+ *
+ * \brief
+ * Utility library for defining a simulated storage backed by a memory mapped image file. It is
+ * meant for host builds, to replay workloads against an image of a real part.
+ *
+ ***************************************************************************************************
+ * \copyright
+ * Copyright 2024 Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **************************************************************************************************/
+#if defined(__unix__) || defined(__APPLE__)
+#if !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+#if !defined(_FILE_OFFSET_BITS)
+#define _FILE_OFFSET_BITS 64
+#endif
+#endif // if defined(__unix__) || defined(__APPLE__)
+
+#include "mtb_block_storage.h"
+
+#if defined(MTB_BLOCK_STORAGE_FILE_SUPPORTED)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*******************************************************************************
+*                        Public Function Definitions
+*******************************************************************************/
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_create_file
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t mtb_block_storage_create_file(mtb_block_storage_t* bsd, mtb_block_storage_file_t* obj,
+                                        const char* path,
+                                        const mtb_block_storage_ram_region_t* regions,
+                                        uint32_t region_count)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    struct stat file_stat;
+    bool created = false;
+    bool is_new = false;
+    size_t size = 0;
+
+    if (NULL != obj)
+    {
+        obj->fd = -1;
+        obj->base = NULL;
+    }
+
+    if ((NULL == bsd) || (NULL == obj) || (NULL == path) || (NULL == regions))
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+    }
+
+    if (result == CY_RSLT_SUCCESS)
+    {
+        for (uint32_t region = 0; region < region_count; region++)
+        {
+            size += regions[region].size;
+        }
+
+        //The file is only removed on error if this call created it
+        obj->size = size;
+        obj->fd = open(path, O_RDWR | O_CREAT | O_EXCL, 0644);
+        created = (obj->fd >= 0);
+        if (!created && (EEXIST == errno))
+        {
+            obj->fd = open(path, O_RDWR);
+        }
+        if ((obj->fd < 0) || (0 != fstat(obj->fd, &file_stat)))
+        {
+            result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+        }
+    }
+
+    if (result == CY_RSLT_SUCCESS)
+    {
+        if (0 == file_stat.st_size)
+        {
+            is_new = true;
+            if (0 != ftruncate(obj->fd, (off_t)size))
+            {
+                result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+            }
+        }
+        else if ((size_t)file_stat.st_size != size)
+        {
+            result = MTB_BLOCK_STORAGE_INVALID_SIZE_ERROR;
+        }
+    }
+
+    if ((result == CY_RSLT_SUCCESS) && (0u != size))
+    {
+        void* map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, obj->fd, 0);
+        if (MAP_FAILED == map)
+        {
+            result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+        }
+        else
+        {
+            obj->base = (uint8_t*)map;
+        }
+    }
+
+    //A new image reads back as zero, so it only needs to be filled where the erase value differs.
+    //Existing images are used as they are.
+    if ((result == CY_RSLT_SUCCESS) && is_new)
+    {
+        size_t offset = 0;
+        for (uint32_t region = 0; region < region_count; region++)
+        {
+            if (0u != regions[region].erase_value)
+            {
+                (void)memset(&obj->base[offset], regions[region].erase_value,
+                             regions[region].size);
+            }
+            offset += regions[region].size;
+        }
+    }
+
+    if (result == CY_RSLT_SUCCESS)
+    {
+        //The RAM device marks the units of the image that are not erased in the program map
+        mtb_block_storage_ram_config_t config =
+        {
+            .regions      = regions,
+            .region_count = region_count,
+            .memory       = obj->base,
+            .program_map  = (uint32_t*)calloc(
+                mtb_block_storage_ram_get_program_map_size(regions, region_count),
+                sizeof(uint32_t)),
+            .delay        = NULL,
+            .initialize   = false,
+        };
+        result = (NULL == config.program_map) ? MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR :
+                 mtb_block_storage_create_ram(bsd, &obj->ram, &config);
+        if (result != CY_RSLT_SUCCESS)
+        {
+            free(config.program_map);
+        }
+    }
+
+    //On error the file is left as it was found, so that the next run does not open an image of
+    //the wrong size or left partly filled
+    if ((result != CY_RSLT_SUCCESS) && (NULL != obj) && (obj->fd >= 0))
+    {
+        if (NULL != obj->base)
+        {
+            (void)munmap(obj->base, obj->size);
+            obj->base = NULL;
+        }
+        if (created)
+        {
+            (void)unlink(path);
+        }
+        else if (is_new)
+        {
+            (void)ftruncate(obj->fd, 0);
+        }
+        (void)close(obj->fd);
+        obj->fd = -1;
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_file_sync
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t mtb_block_storage_file_sync(mtb_block_storage_file_t* obj)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    if ((NULL == obj) || (obj->fd < 0))
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+    }
+    else if ((NULL != obj->base) && (0 != msync(obj->base, obj->size, MS_SYNC)))
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_file_close
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t mtb_block_storage_file_close(mtb_block_storage_file_t* obj)
+{
+    cy_rslt_t result = mtb_block_storage_file_sync(obj);
+
+    if ((NULL != obj) && (obj->fd >= 0))
+    {
+        free(obj->ram.config.program_map);
+        obj->ram.config.program_map = NULL;
+        if (NULL != obj->base)
+        {
+            (void)munmap(obj->base, obj->size);
+            obj->base = NULL;
+        }
+        (void)close(obj->fd);
+        obj->fd = -1;
+    }
+    return result;
+}
+
+
+#endif // defined(MTB_BLOCK_STORAGE_FILE_SUPPORTED)
@@ -0,0 +1,1086 @@
+/***********************************************************************************************//**
+ * \file mtb_block_storage_ftl.c
+ *
+ * \brief
+ * Wear leveling flash translation layer. Exposes a block storage device whose pages are written
+ * out of place on top of an area of another block storage device.
+ *
+ ***************************************************************************************************
+ * \copyright
+ * Copyright 2024 Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **************************************************************************************************/
+#include "mtb_block_storage_ftl.h"
+#include "cy_utils.h"
+
+#include <string.h>
+
+//Headers hold 4 words and are padded to the program size with the erase value
+#define _MTB_BLOCK_STORAGE_FTL_HEADER_WORDS     (4u)
+#define _MTB_BLOCK_STORAGE_FTL_HEADER_BYTES     (_MTB_BLOCK_STORAGE_FTL_HEADER_WORDS * 4u)
+
+//First word of the header written after an erase, the one written when a block is opened and
+//the one following every page
+#define _MTB_BLOCK_STORAGE_FTL_ERASE_MAGIC      (0x45465431u)
+#define _MTB_BLOCK_STORAGE_FTL_OPEN_MAGIC       (0x4F465431u)
+#define _MTB_BLOCK_STORAGE_FTL_PAGE_MAGIC       (0x50465431u)
+
+//Set in the logical page number of a page header, and in the map, for an erased page
+#define _MTB_BLOCK_STORAGE_FTL_TRIM             (0x80000000u)
+#define _MTB_BLOCK_STORAGE_FTL_UNMAPPED         (0xFFFFFFFFu)
+#define _MTB_BLOCK_STORAGE_FTL_NONE             (0xFFFFFFFFu)
+
+#define _MTB_BLOCK_STORAGE_FTL_BLOCK_FREE       (0u)
+#define _MTB_BLOCK_STORAGE_FTL_BLOCK_DIRTY      (1u)
+#define _MTB_BLOCK_STORAGE_FTL_BLOCK_OPEN       (2u)
+#define _MTB_BLOCK_STORAGE_FTL_BLOCK_FULL       (3u)
+
+/*******************************************************************************
+*                       Private Function Definitions
+*******************************************************************************/
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ftl_header_size
+//--------------------------------------------------------------------------------------------------
+static inline uint32_t _mtb_block_storage_ftl_header_size(uint32_t program_size)
+{
+    return ((_MTB_BLOCK_STORAGE_FTL_HEADER_BYTES + program_size - 1u) / program_size) *
+           program_size;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ftl_block_addr
+//--------------------------------------------------------------------------------------------------
+static inline uint32_t _mtb_block_storage_ftl_block_addr(const mtb_block_storage_ftl_t* obj,
+                                                         uint32_t block)
+{
+    return obj->config.start_address + (block * obj->config.block_size);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ftl_slot_addr
+//--------------------------------------------------------------------------------------------------
+static inline uint32_t _mtb_block_storage_ftl_slot_addr(const mtb_block_storage_ftl_t* obj,
+                                                        uint32_t index)
+{
+    return _mtb_block_storage_ftl_block_addr(obj, index / obj->slots_per_block) +
+           (2u * obj->header_size) + ((index % obj->slots_per_block) * obj->slot_size);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ftl_page_check
+//--------------------------------------------------------------------------------------------------
+static inline uint32_t _mtb_block_storage_ftl_page_check(uint32_t tag, uint32_t sequence,
+                                                         uint32_t block_sequence)
+{
+    //Including the sequence of the block rejects the pages left from a previous use of the block
+    //on memories that are reused without an erase
+    return ~(tag ^ sequence ^ block_sequence);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ftl_read_header
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_ftl_read_header(const mtb_block_storage_ftl_t* obj,
+                                                    uint32_t addr, uint32_t* header)
+{
+    mtb_block_storage_t* bsd = obj->config.bsd;
+    return bsd->read(bsd->context, addr, _MTB_BLOCK_STORAGE_FTL_HEADER_BYTES, (uint8_t*)header);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ftl_write_header
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_ftl_write_header(mtb_block_storage_ftl_t* obj, uint32_t addr,
+                                                     const uint32_t* header)
+{
+    mtb_block_storage_t* bsd = obj->config.bsd;
+    (void)memset(obj->config.scratch, obj->erase_value, obj->header_size);
+    (void)memcpy(obj->config.scratch, header, _MTB_BLOCK_STORAGE_FTL_HEADER_BYTES);
+    return bsd->program(bsd->context, addr, obj->header_size, obj->config.scratch);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ftl_is_blank
+//--------------------------------------------------------------------------------------------------
+static bool _mtb_block_storage_ftl_is_blank(const mtb_block_storage_ftl_t* obj,
+                                            const uint32_t* header)
+{
+    uint32_t erase_word = 0x01010101u * obj->erase_value;
+    bool blank = true;
+    for (uint32_t i = 0; i < _MTB_BLOCK_STORAGE_FTL_HEADER_WORDS; i++)
+    {
+        blank = blank && (header[i] == erase_word);
+    }
+    return blank;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ftl_read_page_header
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_ftl_read_page_header(const mtb_block_storage_ftl_t* obj,
+                                                         uint32_t index, uint32_t* header,
+                                                         bool* valid)
+{
+    uint32_t block_sequence = obj->config.blocks[index / obj->slots_per_block].sequence;
+    uint32_t addr = _mtb_block_storage_ftl_slot_addr(obj, index) + obj->config.page_size;
+    cy_rslt_t result = _mtb_block_storage_ftl_read_header(obj, addr, header);
+    *valid = (result == CY_RSLT_SUCCESS) && (header[0] == _MTB_BLOCK_STORAGE_FTL_PAGE_MAGIC) &&
+             (header[3] == _mtb_block_storage_ftl_page_check(header[1], header[2],
+                                                             block_sequence)) &&
+             ((header[1] & ~_MTB_BLOCK_STORAGE_FTL_TRIM) < obj->page_count);
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ftl_is_slot_blank
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_ftl_is_slot_blank(const mtb_block_storage_ftl_t* obj,
+                                                      uint32_t index, bool* blank)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    mtb_block_storage_t* bsd = obj->config.bsd;
+    uint32_t addr = _mtb_block_storage_ftl_slot_addr(obj, index);
+    uint32_t chunk = obj->config.scratch_size - (obj->config.scratch_size %
+                                                 bsd->get_program_size(bsd->context, addr));
+
+    //Page and header, read through scratch in multiples of the program size of the area
+    *blank = true;
+    for (uint32_t offset = 0; (result == CY_RSLT_SUCCESS) && *blank && (offset < obj->slot_size);
+         offset += chunk)
+    {
+        uint32_t length = ((obj->slot_size - offset) < chunk) ? (obj->slot_size - offset) : chunk;
+        result = bsd->read(bsd->context, addr + offset, length, obj->config.scratch);
+        for (uint32_t i = 0; (result == CY_RSLT_SUCCESS) && *blank && (i < length); i++)
+        {
+            *blank = (obj->config.scratch[i] == obj->erase_value);
+        }
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ftl_erase_block
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_ftl_erase_block(mtb_block_storage_ftl_t* obj, uint32_t block)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    mtb_block_storage_t* bsd = obj->config.bsd;
+    mtb_block_storage_ftl_block_t* info = &obj->config.blocks[block];
+    uint32_t addr = _mtb_block_storage_ftl_block_addr(obj, block);
+
+    if (obj->erase_required)
+    {
+        result = bsd->erase(bsd->context, addr, obj->config.block_size);
+    }
+    else
+    {
+        //Clearing the open header is enough, the pages left in the block no longer match the
+        //sequence of the block once it is opened again
+        (void)memset(obj->config.scratch, obj->erase_value, obj->header_size);
+        result = bsd->program(bsd->context, addr + obj->header_size, obj->header_size,
+                              obj->config.scratch);
+    }
+    if (result == CY_RSLT_SUCCESS)
+    {
+        uint32_t header[_MTB_BLOCK_STORAGE_FTL_HEADER_WORDS] =
+        {
+            _MTB_BLOCK_STORAGE_FTL_ERASE_MAGIC, info->erase_count + 1u, ~(info->erase_count + 1u),
+            0u
+        };
+        info->erase_count++;
+        result = _mtb_block_storage_ftl_write_header(obj, addr, header);
+    }
+    if (result == CY_RSLT_SUCCESS)
+    {
+        info->state = _MTB_BLOCK_STORAGE_FTL_BLOCK_FREE;
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ftl_open_block
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_ftl_open_block(mtb_block_storage_ftl_t* obj)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint32_t block = _MTB_BLOCK_STORAGE_FTL_NONE;
+
+    //Least worn block, preferring the ones that are already erased
+    for (uint32_t i = 0; i < obj->block_count; i++)
+    {
+        const mtb_block_storage_ftl_block_t* info = &obj->config.blocks[i];
+        if ((info->state == _MTB_BLOCK_STORAGE_FTL_BLOCK_FREE) ||
+            (info->state == _MTB_BLOCK_STORAGE_FTL_BLOCK_DIRTY))
+        {
+            if ((block == _MTB_BLOCK_STORAGE_FTL_NONE) ||
+                (info->state < obj->config.blocks[block].state) ||
+                ((info->state == obj->config.blocks[block].state) &&
+                 (info->erase_count < obj->config.blocks[block].erase_count)))
+            {
+                block = i;
+            }
+        }
+    }
+
+    if (block == _MTB_BLOCK_STORAGE_FTL_NONE)
+    {
+        result = MTB_BLOCK_STORAGE_NOT_ERASED_ERROR;
+    }
+    else if (obj->config.blocks[block].state == _MTB_BLOCK_STORAGE_FTL_BLOCK_DIRTY)
+    {
+        result = _mtb_block_storage_ftl_erase_block(obj, block);
+    }
+
+    if (result == CY_RSLT_SUCCESS)
+    {
+        uint32_t sequence = obj->sequence + 1u;
+        uint32_t header[_MTB_BLOCK_STORAGE_FTL_HEADER_WORDS] =
+        {
+            _MTB_BLOCK_STORAGE_FTL_OPEN_MAGIC, sequence, ~sequence, 0u
+        };
+        obj->sequence = sequence;
+        obj->config.blocks[block].sequence = sequence;
+        obj->config.blocks[block].valid_count = 0;
+        obj->config.blocks[block].state = _MTB_BLOCK_STORAGE_FTL_BLOCK_OPEN;
+        obj->free_blocks--;
+        obj->open_block = block;
+        obj->next_slot = 0;
+        result = _mtb_block_storage_ftl_write_header(obj,
+                                                     _mtb_block_storage_ftl_block_addr(obj, block) +
+                                                     obj->header_size, header);
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ftl_get_slot
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_ftl_get_slot(mtb_block_storage_ftl_t* obj, uint32_t keep,
+                                                 uint32_t* index)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    if ((obj->open_block != _MTB_BLOCK_STORAGE_FTL_NONE) &&
+        (obj->next_slot == obj->slots_per_block))
+    {
+        obj->config.blocks[obj->open_block].state = _MTB_BLOCK_STORAGE_FTL_BLOCK_FULL;
+        obj->open_block = _MTB_BLOCK_STORAGE_FTL_NONE;
+    }
+    if (obj->open_block == _MTB_BLOCK_STORAGE_FTL_NONE)
+    {
+        //keep free blocks are left for the garbage collector
+        result = (obj->free_blocks > keep) ?
+                 _mtb_block_storage_ftl_open_block(obj) : MTB_BLOCK_STORAGE_NOT_ERASED_ERROR;
+    }
+    if (result == CY_RSLT_SUCCESS)
+    {
+        //The slot is consumed even if programming it fails, as it may be partially programmed
+        *index = (obj->open_block * obj->slots_per_block) + obj->next_slot;
+        obj->next_slot++;
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ftl_write_page
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_ftl_write_page(mtb_block_storage_ftl_t* obj, uint32_t tag,
+                                                   const uint8_t* data, uint32_t source,
+                                                   uint32_t keep)
+{
+    mtb_block_storage_t* bsd = obj->config.bsd;
+    uint32_t lpn = tag & ~_MTB_BLOCK_STORAGE_FTL_TRIM;
+    uint32_t index = 0;
+    cy_rslt_t result = _mtb_block_storage_ftl_get_slot(obj, keep, &index);
+    uint32_t addr = _mtb_block_storage_ftl_slot_addr(obj, index);
+
+    if ((result == CY_RSLT_SUCCESS) && (NULL != data))
+    {
+        result = bsd->program(bsd->context, addr, obj->config.page_size, data);
+    }
+    else if ((result == CY_RSLT_SUCCESS) && (0u == (tag & _MTB_BLOCK_STORAGE_FTL_TRIM)))
+    {
+        //Page moved by the garbage collector, copied through scratch in multiples of the program
+        //size of the area
+        uint32_t source_addr = _mtb_block_storage_ftl_slot_addr(obj, source);
+        uint32_t chunk = obj->config.scratch_size - (obj->config.scratch_size %
+                                                     bsd->get_program_size(bsd->context, addr));
+        for (uint32_t offset = 0; (result == CY_RSLT_SUCCESS) && (offset < obj->config.page_size);
+             offset += chunk)
+        {
+            uint32_t length = ((obj->config.page_size - offset) < chunk) ?
+                              (obj->config.page_size - offset) : chunk;
+            result = bsd->read(bsd->context, source_addr + offset, length, obj->config.scratch);
+            if (result == CY_RSLT_SUCCESS)
+            {
+                result = bsd->program(bsd->context, addr + offset, length, obj->config.scratch);
+            }
+        }
+    }
+
+    //The header is programmed last, a page interrupted by a power loss is never found on mount
+    if (result == CY_RSLT_SUCCESS)
+    {
+        uint32_t sequence = ++obj->sequence;
+        uint32_t block_sequence = obj->config.blocks[obj->open_block].sequence;
+        uint32_t header[_MTB_BLOCK_STORAGE_FTL_HEADER_WORDS] =
+        {
+            _MTB_BLOCK_STORAGE_FTL_PAGE_MAGIC, tag, sequence,
+            _mtb_block_storage_ftl_page_check(tag, sequence, block_sequence)
+        };
+        result = _mtb_block_storage_ftl_write_header(obj, addr + obj->config.page_size, header);
+    }
+
+    if (result == CY_RSLT_SUCCESS)
+    {
+        uint32_t previous = obj->config.map[lpn];
+        if (previous != _MTB_BLOCK_STORAGE_FTL_UNMAPPED)
+        {
+            previous &= ~_MTB_BLOCK_STORAGE_FTL_TRIM;
+            obj->config.blocks[previous / obj->slots_per_block].valid_count--;
+        }
+        obj->config.map[lpn] = index | (tag & _MTB_BLOCK_STORAGE_FTL_TRIM);
+        obj->config.blocks[obj->open_block].valid_count++;
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ftl_pick_victim
+//--------------------------------------------------------------------------------------------------
+static uint32_t _mtb_block_storage_ftl_pick_victim(const mtb_block_storage_ftl_t* obj, bool space,
+                                                   bool wear)
+{
+    const mtb_block_storage_ftl_block_t* blocks = obj->config.blocks;
+    uint32_t victim = _MTB_BLOCK_STORAGE_FTL_NONE;
+    uint32_t coldest = _MTB_BLOCK_STORAGE_FTL_NONE;
+    uint32_t max_erase_count = 0;
+
+    for (uint32_t i = 0; i < obj->block_count; i++)
+    {
+        if (blocks[i].erase_count > max_erase_count)
+        {
+            max_erase_count = blocks[i].erase_count;
+        }
+        if (blocks[i].state == _MTB_BLOCK_STORAGE_FTL_BLOCK_FULL)
+        {
+            if ((victim == _MTB_BLOCK_STORAGE_FTL_NONE) ||
+                (blocks[i].valid_count < blocks[victim].valid_count))
+            {
+                victim = i;
+            }
+            if ((coldest == _MTB_BLOCK_STORAGE_FTL_NONE) ||
+                (blocks[i].erase_count < blocks[coldest].erase_count))
+            {
+                coldest = i;
+            }
+        }
+    }
+
+    //Collecting a block full of valid pages does not free anything
+    if (!space || ((victim != _MTB_BLOCK_STORAGE_FTL_NONE) &&
+                   (blocks[victim].valid_count == obj->slots_per_block)))
+    {
+        victim = _MTB_BLOCK_STORAGE_FTL_NONE;
+    }
+    //Static wear leveling: the data of the least worn block is moved so that the block gets used
+    if (wear && (0u != obj->config.wear_threshold) && (coldest != _MTB_BLOCK_STORAGE_FTL_NONE) &&
+        ((max_erase_count - blocks[coldest].erase_count) > obj->config.wear_threshold))
+    {
+        victim = coldest;
+    }
+    return victim;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ftl_move_next
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_ftl_move_next(mtb_block_storage_ftl_t* obj, uint32_t keep)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    mtb_block_storage_ftl_block_t* victim = &obj->config.blocks[obj->gc_block];
+    bool moved = false;
+
+    //Moves the next valid page of the block being collected
+    while ((result == CY_RSLT_SUCCESS) && !moved && (0u != victim->valid_count) &&
+           (obj->gc_slot < obj->slots_per_block))
+    {
+        uint32_t header[_MTB_BLOCK_STORAGE_FTL_HEADER_WORDS];
+        uint32_t index = (obj->gc_block * obj->slots_per_block) + obj->gc_slot;
+        bool valid = false;
+        result = _mtb_block_storage_ftl_read_page_header(obj, index, header, &valid);
+        if ((result == CY_RSLT_SUCCESS) && valid &&
+            ((obj->config.map[header[1] & ~_MTB_BLOCK_STORAGE_FTL_TRIM] &
+              ~_MTB_BLOCK_STORAGE_FTL_TRIM) == index))
+        {
+            result = _mtb_block_storage_ftl_write_page(obj, header[1], NULL, index, keep);
+            moved = true;
+        }
+        if (result == CY_RSLT_SUCCESS)
+        {
+            obj->gc_slot++;
+        }
+    }
+
+    if ((result == CY_RSLT_SUCCESS) &&
+        ((0u == victim->valid_count) || (obj->gc_slot == obj->slots_per_block)))
+    {
+        //The block is erased when it is opened again or by mtb_block_storage_ftl_collect, so the
+        //logical programs never wait for an erase
+        if (0u == victim->valid_count)
+        {
+            victim->state = _MTB_BLOCK_STORAGE_FTL_BLOCK_DIRTY;
+            obj->free_blocks++;
+        }
+        obj->gc_block = _MTB_BLOCK_STORAGE_FTL_NONE;
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ftl_collect_block
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_ftl_collect_block(mtb_block_storage_ftl_t* obj)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint32_t victim = _mtb_block_storage_ftl_pick_victim(obj, true, false);
+
+    //The block with the fewest valid pages is collected entirely and may use the last free block,
+    //it always has fewer valid pages than a block has slots
+    if (victim == _MTB_BLOCK_STORAGE_FTL_NONE)
+    {
+        result = MTB_BLOCK_STORAGE_NOT_ERASED_ERROR;
+    }
+    else if (victim != obj->gc_block)
+    {
+        obj->gc_block = victim;
+        obj->gc_slot = 0;
+    }
+    while ((result == CY_RSLT_SUCCESS) && (obj->gc_block != _MTB_BLOCK_STORAGE_FTL_NONE))
+    {
+        result = _mtb_block_storage_ftl_move_next(obj, 0u);
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ftl_collect
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_ftl_collect(mtb_block_storage_ftl_t* obj, uint32_t max_pages,
+                                                bool erase)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint32_t work = 0;
+    bool done = false;
+
+    while ((result == CY_RSLT_SUCCESS) && !done && (work < max_pages))
+    {
+        uint32_t dirty = _MTB_BLOCK_STORAGE_FTL_NONE;
+        for (uint32_t i = 0; erase && (i < obj->block_count); i++)
+        {
+            if (obj->config.blocks[i].state == _MTB_BLOCK_STORAGE_FTL_BLOCK_DIRTY)
+            {
+                dirty = i;
+                break;
+            }
+        }
+
+        if (dirty != _MTB_BLOCK_STORAGE_FTL_NONE)
+        {
+            result = _mtb_block_storage_ftl_erase_block(obj, dirty);
+            work++;
+        }
+        else
+        {
+            if (obj->gc_block == _MTB_BLOCK_STORAGE_FTL_NONE)
+            {
+                bool space = (obj->free_blocks <= obj->config.reserved_blocks);
+                obj->gc_block = _mtb_block_storage_ftl_pick_victim(obj, space, true);
+                obj->gc_slot = 0;
+            }
+
+            if (obj->gc_block == _MTB_BLOCK_STORAGE_FTL_NONE)
+            {
+                done = true;
+            }
+            else if (((obj->open_block == _MTB_BLOCK_STORAGE_FTL_NONE) ||
+                      (obj->next_slot == obj->slots_per_block)) && (obj->free_blocks < 2u))
+            {
+                //Moving to the last free block is only safe if a block is finished right away
+                if (_mtb_block_storage_ftl_pick_victim(obj, true, false) !=
+                    _MTB_BLOCK_STORAGE_FTL_NONE)
+                {
+                    result = _mtb_block_storage_ftl_collect_block(obj);
+                    work++;
+                }
+                else
+                {
+                    obj->gc_block = _MTB_BLOCK_STORAGE_FTL_NONE;
+                    done = true;
+                }
+            }
+            else
+            {
+                result = _mtb_block_storage_ftl_move_next(obj, 1u);
+                work++;
+            }
+        }
+    }
+    return ((result == CY_RSLT_SUCCESS) && !done) ? MTB_BLOCK_STORAGE_BUSY : result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ftl_write
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_ftl_write(mtb_block_storage_ftl_t* obj, uint32_t tag,
+                                              const uint8_t* data)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    if ((obj->open_block == _MTB_BLOCK_STORAGE_FTL_NONE) ||
+        (obj->next_slot == obj->slots_per_block))
+    {
+        if (obj->open_block != _MTB_BLOCK_STORAGE_FTL_NONE)
+        {
+            obj->config.blocks[obj->open_block].state = _MTB_BLOCK_STORAGE_FTL_BLOCK_FULL;
+            obj->open_block = _MTB_BLOCK_STORAGE_FTL_NONE;
+        }
+        //The last free block is only used by the garbage collector
+        for (uint32_t i = 0; (result == CY_RSLT_SUCCESS) && (i < obj->block_count) &&
+             (obj->open_block == _MTB_BLOCK_STORAGE_FTL_NONE) && (obj->free_blocks < 2u); i++)
+        {
+            result = _mtb_block_storage_ftl_collect_block(obj);
+        }
+    }
+    if (result == CY_RSLT_SUCCESS)
+    {
+        result = _mtb_block_storage_ftl_write_page(obj, tag, data, _MTB_BLOCK_STORAGE_FTL_NONE,
+                                                   1u);
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ftl_after_write
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_ftl_after_write(mtb_block_storage_ftl_t* obj)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    if ((obj->free_blocks <= obj->config.reserved_blocks) &&
+        (0u != obj->config.gc_pages_per_write))
+    {
+        result = _mtb_block_storage_ftl_collect(obj, obj->config.gc_pages_per_write, false);
+        if (result == MTB_BLOCK_STORAGE_BUSY)
+        {
+            result = CY_RSLT_SUCCESS;
+        }
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ftl_mount
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_ftl_mount(mtb_block_storage_ftl_t* obj)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    mtb_block_storage_ftl_block_t* blocks = obj->config.blocks;
+    uint32_t header[_MTB_BLOCK_STORAGE_FTL_HEADER_WORDS];
+    uint32_t max_erase_count = 0;
+    uint32_t last_block = _MTB_BLOCK_STORAGE_FTL_NONE;
+    uint32_t last_slot = 0;
+
+    for (uint32_t lpn = 0; lpn < obj->page_count; lpn++)
+    {
+        obj->config.map[lpn] = _MTB_BLOCK_STORAGE_FTL_UNMAPPED;
+    }
+
+    //Erase count and state of every block
+    for (uint32_t block = 0; (result == CY_RSLT_SUCCESS) && (block < obj->block_count); block++)
+    {
+        uint32_t addr = _mtb_block_storage_ftl_block_addr(obj, block);
+        bool erased = false;
+        blocks[block].valid_count = 0;
+        blocks[block].sequence = 0;
+        result = _mtb_block_storage_ftl_read_header(obj, addr, header);
+        if (result == CY_RSLT_SUCCESS)
+        {
+            erased = (header[0] == _MTB_BLOCK_STORAGE_FTL_ERASE_MAGIC) &&
+                     (header[2] == ~header[1]);
+            //Unknown erase counts are set to the highest one found once all blocks are read
+            blocks[block].erase_count = erased ? header[1] : _MTB_BLOCK_STORAGE_FTL_NONE;
+            if (erased && (header[1] > max_erase_count))
+            {
+                max_erase_count = header[1];
+            }
+            result = _mtb_block_storage_ftl_read_header(obj, addr + obj->header_size, header);
+        }
+        if (result == CY_RSLT_SUCCESS)
+        {
+            if ((header[0] == _MTB_BLOCK_STORAGE_FTL_OPEN_MAGIC) && (header[2] == ~header[1]))
+            {
+                blocks[block].state = _MTB_BLOCK_STORAGE_FTL_BLOCK_FULL;
+                blocks[block].sequence = header[1];
+                if (header[1] > obj->sequence)
+                {
+                    obj->sequence = header[1];
+                }
+                if ((last_block == _MTB_BLOCK_STORAGE_FTL_NONE) ||
+                    (header[1] > blocks[last_block].sequence))
+                {
+                    last_block = block;
+                }
+            }
+            else if (erased && _mtb_block_storage_ftl_is_blank(obj, header))
+            {
+                blocks[block].state = _MTB_BLOCK_STORAGE_FTL_BLOCK_FREE;
+            }
+            else
+            {
+                blocks[block].state = _MTB_BLOCK_STORAGE_FTL_BLOCK_DIRTY;
+            }
+        }
+    }
+
+    //Latest version of every page. A block may have slots without a valid header in the middle,
+    //when the writes resumed after the slot interrupted by a power loss.
+    for (uint32_t block = 0; (result == CY_RSLT_SUCCESS) && (block < obj->block_count); block++)
+    {
+        if (blocks[block].erase_count == _MTB_BLOCK_STORAGE_FTL_NONE)
+        {
+            blocks[block].erase_count = max_erase_count;
+        }
+        if (blocks[block].state != _MTB_BLOCK_STORAGE_FTL_BLOCK_FULL)
+        {
+            obj->free_blocks++;
+        }
+        else
+        {
+            for (uint32_t slot = 0; (result == CY_RSLT_SUCCESS) && (slot < obj->slots_per_block);
+                 slot++)
+            {
+                bool valid = false;
+                uint32_t index = (block * obj->slots_per_block) + slot;
+                result = _mtb_block_storage_ftl_read_page_header(obj, index, header, &valid);
+                if ((result == CY_RSLT_SUCCESS) && valid)
+                {
+                    uint32_t tag = header[1];
+                    uint32_t sequence = header[2];
+                    uint32_t current = obj->config.map[tag & ~_MTB_BLOCK_STORAGE_FTL_TRIM];
+                    bool newer = true;
+                    if (sequence > obj->sequence)
+                    {
+                        obj->sequence = sequence;
+                    }
+                    if (current != _MTB_BLOCK_STORAGE_FTL_UNMAPPED)
+                    {
+                        bool current_valid = false;
+                        result = _mtb_block_storage_ftl_read_page_header(
+                            obj, current & ~_MTB_BLOCK_STORAGE_FTL_TRIM, header, &current_valid);
+                        newer = (header[2] < sequence);
+                    }
+                    if (block == last_block)
+                    {
+                        last_slot = slot + 1u;
+                    }
+                    if (newer)
+                    {
+                        obj->config.map[tag & ~_MTB_BLOCK_STORAGE_FTL_TRIM] =
+                            index | (tag & _MTB_BLOCK_STORAGE_FTL_TRIM);
+                    }
+                }
+            }
+        }
+    }
+
+    for (uint32_t lpn = 0; (result == CY_RSLT_SUCCESS) && (lpn < obj->page_count); lpn++)
+    {
+        if (obj->config.map[lpn] != _MTB_BLOCK_STORAGE_FTL_UNMAPPED)
+        {
+            uint32_t index = obj->config.map[lpn] & ~_MTB_BLOCK_STORAGE_FTL_TRIM;
+            blocks[index / obj->slots_per_block].valid_count++;
+        }
+    }
+
+    //The last opened block is written again after its last page. On memories that need an erase
+    //the writes resume at the first blank slot: the slots after the last page may have been
+    //partially programmed by interrupted writes, several of them if the writes were interrupted
+    //again after a mount. When no slot is blank the block is full.
+    if ((result == CY_RSLT_SUCCESS) && (last_block != _MTB_BLOCK_STORAGE_FTL_NONE))
+    {
+        uint32_t next_slot = last_slot;
+        bool blank = !obj->erase_required;
+        while ((result == CY_RSLT_SUCCESS) && !blank && (next_slot < obj->slots_per_block))
+        {
+            result = _mtb_block_storage_ftl_is_slot_blank(
+                obj, (last_block * obj->slots_per_block) + next_slot, &blank);
+            if (!blank)
+            {
+                next_slot++;
+            }
+        }
+        if ((result == CY_RSLT_SUCCESS) && (next_slot < obj->slots_per_block))
+        {
+            blocks[last_block].state = _MTB_BLOCK_STORAGE_FTL_BLOCK_OPEN;
+            obj->open_block = last_block;
+            obj->next_slot = next_slot;
+        }
+    }
+    //A power loss while the garbage collector used the last free block leaves none, the
+    //collection is completed before the device is used
+    if ((result == CY_RSLT_SUCCESS) && (0u == obj->free_blocks))
+    {
+        result = _mtb_block_storage_ftl_collect_block(obj);
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ftl_read_size
+//--------------------------------------------------------------------------------------------------
+static uint32_t _mtb_block_storage_ftl_read_size(void* context, uint32_t addr)
+{
+    CY_UNUSED_PARAMETER(context);
+    CY_UNUSED_PARAMETER(addr);
+    return 1;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ftl_page_size
+//--------------------------------------------------------------------------------------------------
+static uint32_t _mtb_block_storage_ftl_page_size(void* context, uint32_t addr)
+{
+    CY_UNUSED_PARAMETER(addr);
+    return ((const mtb_block_storage_ftl_t*)context)->config.page_size;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ftl_erase_value
+//--------------------------------------------------------------------------------------------------
+static uint8_t _mtb_block_storage_ftl_erase_value(void* context, uint32_t addr)
+{
+    CY_UNUSED_PARAMETER(addr);
+    return ((const mtb_block_storage_ftl_t*)context)->erase_value;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ftl_is_in_range
+//--------------------------------------------------------------------------------------------------
+static bool _mtb_block_storage_ftl_is_in_range(void* context, uint32_t addr, uint32_t length)
+{
+    const mtb_block_storage_ftl_t* obj = (const mtb_block_storage_ftl_t*)context;
+    uint32_t size = obj->page_count * obj->config.page_size;
+    return (addr < size) && (length <= (size - addr));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ftl_is_erase_required
+//--------------------------------------------------------------------------------------------------
+static bool _mtb_block_storage_ftl_is_erase_required(void* context, uint32_t addr,
+                                                     uint32_t length)
+{
+    CY_UNUSED_PARAMETER(context);
+    CY_UNUSED_PARAMETER(addr);
+    CY_UNUSED_PARAMETER(length);
+    //Pages are never programmed in place
+    return false;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ftl_get_geometry
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_ftl_get_geometry(void* context,
+                                                     mtb_block_storage_region_t* regions,
+                                                     uint32_t max_regions, uint32_t* region_count)
+{
+    const mtb_block_storage_ftl_t* obj = (const mtb_block_storage_ftl_t*)context;
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    if (max_regions > 0u)
+    {
+        regions[0].start_address = 0;
+        regions[0].size = obj->page_count * obj->config.page_size;
+        regions[0].read_size = 1;
+        regions[0].program_size = obj->config.page_size;
+        regions[0].erase_size = obj->config.page_size;
+        regions[0].erase_value = obj->erase_value;
+        regions[0].is_erase_required = false;
+        regions[0].bank = 0;
+    }
+    else
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_SIZE_ERROR;
+    }
+    *region_count = 1;
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ftl_read
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_ftl_read(void* context, uint32_t addr, uint32_t length,
+                                             uint8_t* buf)
+{
+    mtb_block_storage_ftl_t* obj = (mtb_block_storage_ftl_t*)context;
+    mtb_block_storage_t* bsd = obj->config.bsd;
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    if (!_mtb_block_storage_ftl_is_in_range(context, addr, length))
+    {
+        result = MTB_BLOCK_STORAGE_NOT_IN_RANGE_ERROR;
+    }
+
+    while ((result == CY_RSLT_SUCCESS) && (length > 0u))
+    {
+        uint32_t offset = addr % obj->config.page_size;
+        uint32_t chunk = ((obj->config.page_size - offset) < length) ?
+                         (obj->config.page_size - offset) : length;
+        uint32_t index = obj->config.map[addr / obj->config.page_size];
+
+        if ((index == _MTB_BLOCK_STORAGE_FTL_UNMAPPED) ||
+            (0u != (index & _MTB_BLOCK_STORAGE_FTL_TRIM)))
+        {
+            (void)memset(buf, obj->erase_value, chunk);
+        }
+        else
+        {
+            result = bsd->read(bsd->context, _mtb_block_storage_ftl_slot_addr(obj, index) + offset,
+                               chunk, buf);
+        }
+        addr += chunk;
+        buf += chunk;
+        length -= chunk;
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ftl_check
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_ftl_check(mtb_block_storage_ftl_t* obj, uint32_t addr,
+                                              uint32_t length)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    if (!_mtb_block_storage_ftl_is_in_range(obj, addr, length))
+    {
+        result = MTB_BLOCK_STORAGE_NOT_IN_RANGE_ERROR;
+    }
+    else if ((0u != (addr % obj->config.page_size)) || (0u != (length % obj->config.page_size)))
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_SIZE_ERROR;
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ftl_program
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_ftl_program(void* context, uint32_t addr, uint32_t length,
+                                                const uint8_t* data)
+{
+    mtb_block_storage_ftl_t* obj = (mtb_block_storage_ftl_t*)context;
+    cy_rslt_t result = _mtb_block_storage_ftl_check(obj, addr, length);
+
+    for (uint32_t offset = 0; (result == CY_RSLT_SUCCESS) && (offset < length);
+         offset += obj->config.page_size)
+    {
+        result = _mtb_block_storage_ftl_write(obj, (addr + offset) / obj->config.page_size,
+                                              &data[offset]);
+    }
+    if (result == CY_RSLT_SUCCESS)
+    {
+        result = _mtb_block_storage_ftl_after_write(obj);
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ftl_erase
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_ftl_erase(void* context, uint32_t addr, uint32_t length)
+{
+    mtb_block_storage_ftl_t* obj = (mtb_block_storage_ftl_t*)context;
+    cy_rslt_t result = _mtb_block_storage_ftl_check(obj, addr, length);
+
+    for (uint32_t offset = 0; (result == CY_RSLT_SUCCESS) && (offset < length);
+         offset += obj->config.page_size)
+    {
+        uint32_t lpn = (addr + offset) / obj->config.page_size;
+        //Pages that were never written or are already erased do not need a record
+        if ((obj->config.map[lpn] != _MTB_BLOCK_STORAGE_FTL_UNMAPPED) &&
+            (0u == (obj->config.map[lpn] & _MTB_BLOCK_STORAGE_FTL_TRIM)))
+        {
+            result = _mtb_block_storage_ftl_write(obj, lpn | _MTB_BLOCK_STORAGE_FTL_TRIM, NULL);
+        }
+    }
+    if (result == CY_RSLT_SUCCESS)
+    {
+        result = _mtb_block_storage_ftl_after_write(obj);
+    }
+    return result;
+}
+
+
+/*******************************************************************************
+*                        Public Function Definitions
+*******************************************************************************/
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_ftl_get_page_count
+//--------------------------------------------------------------------------------------------------
+uint32_t mtb_block_storage_ftl_get_page_count(const mtb_block_storage_ftl_config_t* config)
+{
+    uint32_t pages = 0;
+
+    if ((NULL != config) && (NULL != config->bsd) && (0u != config->block_size) &&
+        (0u != config->page_size) && (0u == (config->start_address % config->block_size)) &&
+        (0u == (config->size % config->block_size)) && (config->reserved_blocks >= 2u) &&
+        ((config->size / config->block_size) > config->reserved_blocks))
+    {
+        mtb_block_storage_t* bsd = config->bsd;
+        uint32_t program_size = bsd->get_program_size(bsd->context, config->start_address);
+        uint32_t erase_size = bsd->get_erase_size(bsd->context, config->start_address);
+
+        if ((0u != program_size) && (0u != erase_size) &&
+            (0u == (config->block_size % erase_size)) &&
+            (0u == (config->page_size % program_size)) &&
+            ((NULL == bsd->is_in_range) ||
+             bsd->is_in_range(bsd->context, config->start_address, config->size)))
+        {
+            uint32_t header_size = _mtb_block_storage_ftl_header_size(program_size);
+            uint32_t slots = (config->block_size > (2u * header_size)) ?
+                             ((config->block_size - (2u * header_size)) /
+                              (config->page_size + header_size)) : 0u;
+            pages = ((config->size / config->block_size) - config->reserved_blocks) * slots;
+        }
+    }
+    return pages;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_create_ftl
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t mtb_block_storage_create_ftl(mtb_block_storage_t* bsd, mtb_block_storage_ftl_t* obj,
+                                       const mtb_block_storage_ftl_config_t* config)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint32_t page_count = mtb_block_storage_ftl_get_page_count(config);
+
+    if ((NULL == bsd) || (NULL == obj) || (0u == page_count) || (NULL == config->map) ||
+        (NULL == config->blocks) || (NULL == config->scratch))
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+    }
+
+    if (result == CY_RSLT_SUCCESS)
+    {
+        mtb_block_storage_t* device = config->bsd;
+        obj->config = *config;
+        obj->block_count = config->size / config->block_size;
+        obj->header_size = _mtb_block_storage_ftl_header_size(
+            device->get_program_size(device->context, config->start_address));
+        obj->slot_size = config->page_size + obj->header_size;
+        obj->slots_per_block = (config->block_size - (2u * obj->header_size)) / obj->slot_size;
+        obj->page_count = page_count;
+        obj->free_blocks = 0;
+        obj->open_block = _MTB_BLOCK_STORAGE_FTL_NONE;
+        obj->next_slot = 0;
+        obj->gc_block = _MTB_BLOCK_STORAGE_FTL_NONE;
+        obj->gc_slot = 0;
+        obj->sequence = 0;
+        obj->erase_value = device->get_erase_value(device->context, config->start_address);
+        obj->erase_required = (NULL == device->is_erase_required) ||
+                              device->is_erase_required(device->context, config->start_address,
+                                                        config->size);
+        if (config->scratch_size < obj->header_size)
+        {
+            result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+        }
+    }
+
+    if (result == CY_RSLT_SUCCESS)
+    {
+        result = _mtb_block_storage_ftl_mount(obj);
+    }
+
+    if (result == CY_RSLT_SUCCESS)
+    {
+        bsd->read = _mtb_block_storage_ftl_read;
+        bsd->program = _mtb_block_storage_ftl_program;
+        bsd->erase = _mtb_block_storage_ftl_erase;
+        //Setting NULL, as the FTL does not support non blocking operations
+        bsd->program_nb = NULL;
+        bsd->erase_nb = NULL;
+        bsd->register_callback = NULL;
+        bsd->poll = NULL;
+        //Setting NULL, the vectored calls are split by mtb_block_storage_readv and programv
+        bsd->readv = NULL;
+        bsd->programv = NULL;
+        //Setting NULL, the pages of a logical area are not contiguous in the memory
+        bsd->map = NULL;
+        bsd->unmap = NULL;
+        bsd->get_read_size = _mtb_block_storage_ftl_read_size;
+        bsd->get_program_size = _mtb_block_storage_ftl_page_size;
+        bsd->get_erase_size = _mtb_block_storage_ftl_page_size;
+        bsd->get_erase_value = _mtb_block_storage_ftl_erase_value;
+        bsd->is_in_range = _mtb_block_storage_ftl_is_in_range;
+        bsd->is_erase_required = _mtb_block_storage_ftl_is_erase_required;
+        bsd->get_geometry = _mtb_block_storage_ftl_get_geometry;
+        bsd->context = obj;
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_ftl_collect
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t mtb_block_storage_ftl_collect(mtb_block_storage_ftl_t* obj, uint32_t max_pages)
+{
+    return (NULL == obj) ? MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR :
+           _mtb_block_storage_ftl_collect(obj, max_pages, true);
+}
@@ -0,0 +1,973 @@
+/***********************************************************************************************//**
+ * \file mtb_block_storage_kv.c
+ *
+ * \brief
+ * Log-structured key-value store. Appends the records to an area of a block storage device and
+ * looks them up through a hash index held in RAM.
+ *
+ ***************************************************************************************************
+ * \copyright
+ * Copyright 2024 Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **************************************************************************************************/
+#include "mtb_block_storage_kv.h"
+
+#include <string.h>
+
+//Sector header: magic, sequence and inverted sequence, padded to the program size
+#define _MTB_BLOCK_STORAGE_KV_SECTOR_MAGIC      (0x4B565331u)
+//Record header: magic, flags and key length in the first word, value length, CRC
+#define _MTB_BLOCK_STORAGE_KV_RECORD_MAGIC      (0x4B56u)
+#define _MTB_BLOCK_STORAGE_KV_RECORD_HEADER     (12u)
+#define _MTB_BLOCK_STORAGE_KV_FLAG_TOMBSTONE    (0x01u)
+#define _MTB_BLOCK_STORAGE_KV_FLAG_CHECKPOINT   (0x02u)
+
+#define _MTB_BLOCK_STORAGE_KV_NONE              (0xFFFFFFFFu)
+#define _MTB_BLOCK_STORAGE_KV_EMPTY             (0xFFFFFFFFu)
+
+/*******************************************************************************
+*                       Private Function Definitions
+*******************************************************************************/
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_kv_crc
+//--------------------------------------------------------------------------------------------------
+static uint32_t _mtb_block_storage_kv_crc(uint32_t crc, const uint8_t* data, uint32_t length)
+{
+    //CRC-32 (IEEE 802.3) computed a nibble at a time, a compromise between code size and speed
+    static const uint32_t table[16] =
+    {
+        0x00000000u, 0x1DB71064u, 0x3B6E20C8u, 0x26D930ACu, 0x76DC4190u, 0x6B6B51F4u,
+        0x4DB26158u, 0x5005713Cu, 0xEDB88320u, 0xF00F9344u, 0xD6D6A3E8u, 0xCB61B38Cu,
+        0x9B64C2B0u, 0x86D3D2D4u, 0xA00AE278u, 0xBDBDF21Cu
+    };
+    for (uint32_t i = 0; i < length; i++)
+    {
+        crc ^= data[i];
+        crc = (crc >> 4) ^ table[crc & 0x0Fu];
+        crc = (crc >> 4) ^ table[crc & 0x0Fu];
+    }
+    return crc;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_kv_hash
+//--------------------------------------------------------------------------------------------------
+static uint32_t _mtb_block_storage_kv_hash(const char* key, uint32_t key_length)
+{
+    //FNV-1a
+    uint32_t hash = 2166136261u;
+    for (uint32_t i = 0; i < key_length; i++)
+    {
+        hash = (hash ^ (uint8_t)key[i]) * 16777619u;
+    }
+    return hash;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_kv_key_length
+//--------------------------------------------------------------------------------------------------
+static uint32_t _mtb_block_storage_kv_key_length(const char* key)
+{
+    //0 for a NULL, empty or too long key
+    uint32_t length = 0;
+    while ((NULL != key) && (length <= MTB_BLOCK_STORAGE_KV_MAX_KEY_LENGTH) &&
+           ('\0' != key[length]))
+    {
+        length++;
+    }
+    return (length > MTB_BLOCK_STORAGE_KV_MAX_KEY_LENGTH) ? 0u : length;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_kv_align
+//--------------------------------------------------------------------------------------------------
+static inline uint32_t _mtb_block_storage_kv_align(const mtb_block_storage_kv_t* kv, uint32_t size)
+{
+    return ((size + kv->program_size - 1u) / kv->program_size) * kv->program_size;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_kv_sector_addr
+//--------------------------------------------------------------------------------------------------
+static inline uint32_t _mtb_block_storage_kv_sector_addr(const mtb_block_storage_kv_t* kv,
+                                                         uint32_t sector)
+{
+    return kv->config.start_address + (sector * kv->config.sector_size);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_kv_read
+//--------------------------------------------------------------------------------------------------
+static inline cy_rslt_t _mtb_block_storage_kv_read(const mtb_block_storage_kv_t* kv,
+                                                   uint32_t offset, uint32_t length, void* buf)
+{
+    mtb_block_storage_t* bsd = kv->config.bsd;
+    return bsd->read(bsd->context, kv->config.start_address + offset, length, (uint8_t*)buf);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_kv_record_size
+//--------------------------------------------------------------------------------------------------
+static uint32_t _mtb_block_storage_kv_record_size(const mtb_block_storage_kv_t* kv,
+                                                  const uint32_t* header, uint32_t offset)
+{
+    //Size of a valid record header starting at offset in its sector, 0 otherwise
+    uint32_t key_length = header[0] & 0xFFu;
+    uint32_t room = kv->config.sector_size - (offset % kv->config.sector_size);
+    uint32_t size = 0;
+    if (((header[0] >> 16) == _MTB_BLOCK_STORAGE_KV_RECORD_MAGIC) &&
+        (key_length <= MTB_BLOCK_STORAGE_KV_MAX_KEY_LENGTH) &&
+        (room >= (_MTB_BLOCK_STORAGE_KV_RECORD_HEADER + key_length)) &&
+        (header[1] <= (room - _MTB_BLOCK_STORAGE_KV_RECORD_HEADER - key_length)))
+    {
+        size = _mtb_block_storage_kv_align(kv, _MTB_BLOCK_STORAGE_KV_RECORD_HEADER + key_length +
+                                           header[1]);
+    }
+    return (size <= room) ? size : 0u;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_kv_find
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_kv_find(const mtb_block_storage_kv_t* kv, const char* key,
+                                            uint32_t key_length, uint32_t hash, uint32_t* slot,
+                                            bool* found)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    const mtb_block_storage_kv_entry_t* index = kv->config.index;
+    uint32_t mask = kv->config.index_size - 1u;
+    uint32_t i = hash & mask;
+
+    //Linear probing, the index always has an empty entry so the probe ends. The key of the
+    //entries with the same hash is read back to tell the keys apart.
+    *found = false;
+    while ((result == CY_RSLT_SUCCESS) && !*found &&
+           (index[i].offset != _MTB_BLOCK_STORAGE_KV_EMPTY))
+    {
+        if (index[i].hash == hash)
+        {
+            char stored[MTB_BLOCK_STORAGE_KV_MAX_KEY_LENGTH];
+            uint32_t header[3];
+            result = _mtb_block_storage_kv_read(kv, index[i].offset, sizeof(header), header);
+            if ((result == CY_RSLT_SUCCESS) && ((header[0] & 0xFFu) == key_length))
+            {
+                result = _mtb_block_storage_kv_read(kv, index[i].offset +
+                                                    _MTB_BLOCK_STORAGE_KV_RECORD_HEADER,
+                                                    key_length, stored);
+                *found = (result == CY_RSLT_SUCCESS) && (0 == memcmp(stored, key, key_length));
+            }
+        }
+        if (!*found)
+        {
+            i = (i + 1u) & mask;
+        }
+    }
+    *slot = i;
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_kv_remove_slot
+//--------------------------------------------------------------------------------------------------
+static void _mtb_block_storage_kv_remove_slot(mtb_block_storage_kv_t* kv, uint32_t slot)
+{
+    mtb_block_storage_kv_entry_t* index = kv->config.index;
+    uint32_t mask = kv->config.index_size - 1u;
+    uint32_t hole = slot;
+    uint32_t i = slot;
+
+    //Backward shift deletion: the following entries of the probe sequence that would no longer be
+    //found past the hole are moved into it
+    for (;;)
+    {
+        i = (i + 1u) & mask;
+        if (index[i].offset == _MTB_BLOCK_STORAGE_KV_EMPTY)
+        {
+            break;
+        }
+        uint32_t home = index[i].hash & mask;
+        if (((i - home) & mask) >= ((i - hole) & mask))
+        {
+            index[hole] = index[i];
+            hole = i;
+        }
+    }
+    index[hole].offset = _MTB_BLOCK_STORAGE_KV_EMPTY;
+    kv->count--;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_kv_apply
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_kv_apply(mtb_block_storage_kv_t* kv, const char* key,
+                                             uint32_t key_length, bool tombstone, uint32_t offset)
+{
+    uint32_t hash = _mtb_block_storage_kv_hash(key, key_length);
+    uint32_t slot = 0;
+    bool found = false;
+    cy_rslt_t result = _mtb_block_storage_kv_find(kv, key, key_length, hash, &slot, &found);
+
+    if ((result == CY_RSLT_SUCCESS) && tombstone && found)
+    {
+        _mtb_block_storage_kv_remove_slot(kv, slot);
+    }
+    else if ((result == CY_RSLT_SUCCESS) && found)
+    {
+        kv->config.index[slot].offset = offset;
+    }
+    else if ((result == CY_RSLT_SUCCESS) && !tombstone)
+    {
+        if ((kv->count + 1u) >= kv->config.index_size)
+        {
+            result = MTB_BLOCK_STORAGE_NO_SPACE_ERROR;
+        }
+        else
+        {
+            kv->config.index[slot].hash = hash;
+            kv->config.index[slot].offset = offset;
+            kv->count++;
+        }
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_kv_append
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_kv_append(mtb_block_storage_kv_t* kv, uint32_t flags,
+                                              const char* key, uint32_t key_length,
+                                              const uint8_t* value, uint32_t value_length,
+                                              uint32_t* offset)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    mtb_block_storage_t* bsd = kv->config.bsd;
+    uint32_t header[3] =
+    {
+        (_MTB_BLOCK_STORAGE_KV_RECORD_MAGIC << 16) | (flags << 8) | key_length, value_length, 0u
+    };
+    const uint8_t* parts[3] = { (const uint8_t*)header, (const uint8_t*)key, value };
+    uint32_t lengths[3] = { _MTB_BLOCK_STORAGE_KV_RECORD_HEADER, key_length, value_length };
+    uint32_t size = _mtb_block_storage_kv_align(kv, _MTB_BLOCK_STORAGE_KV_RECORD_HEADER +
+                                                key_length + value_length);
+    uint32_t chunk = kv->config.scratch_size - (kv->config.scratch_size % kv->program_size);
+    uint32_t addr = _mtb_block_storage_kv_sector_addr(kv, kv->head) + kv->head_offset;
+    uint32_t part = 0;
+    uint32_t part_offset = 0;
+
+    uint32_t crc = _mtb_block_storage_kv_crc(0xFFFFFFFFu, (const uint8_t*)header,
+                                             2u * sizeof(uint32_t));
+    crc = _mtb_block_storage_kv_crc(crc, (const uint8_t*)key, key_length);
+    header[2] = ~_mtb_block_storage_kv_crc(crc, value, value_length);
+
+    //The space is consumed even if programming fails, as the record may be partially programmed
+    *offset = (kv->head * kv->config.sector_size) + kv->head_offset;
+    kv->head_offset += size;
+
+    //Header, key and value are gathered in scratch and programmed a chunk at a time, the end of
+    //the last program unit is padded with the erase value
+    for (uint32_t done = 0; (result == CY_RSLT_SUCCESS) && (done < size); done += chunk)
+    {
+        uint32_t length = ((size - done) < chunk) ? (size - done) : chunk;
+        uint32_t filled = 0;
+        while (filled < length)
+        {
+            if (part < 3u)
+            {
+                uint32_t copy = lengths[part] - part_offset;
+                copy = (copy < (length - filled)) ? copy : (length - filled);
+                if (0u != copy)
+                {
+                    (void)memcpy(&kv->config.scratch[filled], &parts[part][part_offset], copy);
+                }
+                filled += copy;
+                part_offset += copy;
+                if (part_offset == lengths[part])
+                {
+                    part++;
+                    part_offset = 0;
+                }
+            }
+            else
+            {
+                (void)memset(&kv->config.scratch[filled], kv->erase_value, length - filled);
+                filled = length;
+            }
+        }
+        result = bsd->program(bsd->context, addr + done, length, kv->config.scratch);
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_kv_open
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_kv_open(mtb_block_storage_kv_t* kv, bool checkpoint)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    mtb_block_storage_t* bsd = kv->config.bsd;
+    uint32_t sector = (kv->head == _MTB_BLOCK_STORAGE_KV_NONE) ? 0u :
+                      ((kv->head + 1u) % kv->sector_count);
+    uint32_t addr = _mtb_block_storage_kv_sector_addr(kv, sector);
+
+    if (0u == kv->free_sectors)
+    {
+        result = MTB_BLOCK_STORAGE_NO_SPACE_ERROR;
+    }
+    //The sector was erased when it was compacted, it is only erased again if that was interrupted
+    if (result == CY_RSLT_SUCCESS)
+    {
+        result = mtb_block_storage_erase_blank_check(bsd, addr, kv->config.sector_size,
+                                                     kv->config.scratch,
+                                                     kv->config.scratch_size, NULL);
+    }
+    if (result == CY_RSLT_SUCCESS)
+    {
+        uint32_t sequence = kv->sequence + 1u;
+        uint32_t header[3] = { _MTB_BLOCK_STORAGE_KV_SECTOR_MAGIC, sequence, ~sequence };
+        (void)memset(kv->config.scratch, kv->erase_value, kv->header_size);
+        (void)memcpy(kv->config.scratch, header, sizeof(header));
+        result = bsd->program(bsd->context, addr, kv->header_size, kv->config.scratch);
+        if (result == CY_RSLT_SUCCESS)
+        {
+            kv->sequence = sequence;
+            kv->head = sector;
+            kv->head_offset = kv->header_size;
+            kv->free_sectors--;
+            if (kv->tail == _MTB_BLOCK_STORAGE_KV_NONE)
+            {
+                kv->tail = sector;
+            }
+        }
+    }
+    if ((result == CY_RSLT_SUCCESS) && checkpoint && kv->config.checkpoint &&
+        (_mtb_block_storage_kv_align(kv, _MTB_BLOCK_STORAGE_KV_RECORD_HEADER +
+                                     (kv->config.index_size *
+                                      (uint32_t)sizeof(mtb_block_storage_kv_entry_t))) <=
+         ((kv->config.sector_size - kv->header_size) / 2u)))
+    {
+        uint32_t offset = 0;
+        result = _mtb_block_storage_kv_append(kv, _MTB_BLOCK_STORAGE_KV_FLAG_CHECKPOINT, NULL, 0,
+                                              (const uint8_t*)kv->config.index,
+                                              kv->config.index_size *
+                                              sizeof(mtb_block_storage_kv_entry_t), &offset);
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_kv_copy
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_kv_copy(mtb_block_storage_kv_t* kv, uint32_t from,
+                                            uint32_t size, uint32_t* offset)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    mtb_block_storage_t* bsd = kv->config.bsd;
+    uint32_t chunk = kv->config.scratch_size - (kv->config.scratch_size % kv->program_size);
+
+    //The compaction may use the last free sector, the sector being compacted is freed right after
+    if ((kv->config.sector_size - kv->head_offset) < size)
+    {
+        result = _mtb_block_storage_kv_open(kv, false);
+    }
+    if (result == CY_RSLT_SUCCESS)
+    {
+        uint32_t addr = _mtb_block_storage_kv_sector_addr(kv, kv->head) + kv->head_offset;
+        *offset = (kv->head * kv->config.sector_size) + kv->head_offset;
+        kv->head_offset += size;
+        for (uint32_t done = 0; (result == CY_RSLT_SUCCESS) && (done < size); done += chunk)
+        {
+            uint32_t length = ((size - done) < chunk) ? (size - done) : chunk;
+            result = _mtb_block_storage_kv_read(kv, from + done, length, kv->config.scratch);
+            if (result == CY_RSLT_SUCCESS)
+            {
+                result = bsd->program(bsd->context, addr + done, length, kv->config.scratch);
+            }
+        }
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_kv_compact
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_kv_compact(mtb_block_storage_kv_t* kv)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    mtb_block_storage_t* bsd = kv->config.bsd;
+    uint32_t sector = kv->tail;
+    uint32_t offset = kv->header_size;
+
+    if (sector == kv->head)
+    {
+        result = _mtb_block_storage_kv_open(kv, false);
+    }
+
+    //Only the records the index points to are live, older values, tombstones and checkpoints
+    //are dropped
+    while ((result == CY_RSLT_SUCCESS) &&
+           ((kv->config.sector_size - offset) >= _MTB_BLOCK_STORAGE_KV_RECORD_HEADER))
+    {
+        uint32_t record = (sector * kv->config.sector_size) + offset;
+        uint32_t header[3];
+        uint32_t size = 0;
+        result = _mtb_block_storage_kv_read(kv, record, sizeof(header), header);
+        if (result == CY_RSLT_SUCCESS)
+        {
+            size = _mtb_block_storage_kv_record_size(kv, header, record);
+        }
+        if (0u == size)
+        {
+            break;
+        }
+        if ((result == CY_RSLT_SUCCESS) && (0u == ((header[0] >> 8) & 0xFFu)))
+        {
+            char key[MTB_BLOCK_STORAGE_KV_MAX_KEY_LENGTH];
+            uint32_t key_length = header[0] & 0xFFu;
+            uint32_t slot = 0;
+            bool found = false;
+            result = _mtb_block_storage_kv_read(kv, record + _MTB_BLOCK_STORAGE_KV_RECORD_HEADER,
+                                                key_length, key);
+            if (result == CY_RSLT_SUCCESS)
+            {
+                result = _mtb_block_storage_kv_find(kv, key, key_length,
+                                                    _mtb_block_storage_kv_hash(key, key_length),
+                                                    &slot, &found);
+            }
+            if ((result == CY_RSLT_SUCCESS) && found &&
+                (kv->config.index[slot].offset == record))
+            {
+                result = _mtb_block_storage_kv_copy(kv, record, size,
+                                                    &kv->config.index[slot].offset);
+            }
+        }
+        offset += size;
+    }
+
+    if (result == CY_RSLT_SUCCESS)
+    {
+        result = bsd->erase(bsd->context, _mtb_block_storage_kv_sector_addr(kv, sector),
+                            kv->config.sector_size);
+    }
+    if (result == CY_RSLT_SUCCESS)
+    {
+        kv->tail = (sector + 1u) % kv->sector_count;
+        kv->free_sectors++;
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_kv_reserve
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_kv_reserve(mtb_block_storage_kv_t* kv, uint32_t size)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    for (uint32_t i = 0; (result == CY_RSLT_SUCCESS) &&
+         ((kv->head == _MTB_BLOCK_STORAGE_KV_NONE) ||
+          ((kv->config.sector_size - kv->head_offset) < size)); i++)
+    {
+        bool progress = true;
+        if (i > kv->sector_count)
+        {
+            result = MTB_BLOCK_STORAGE_NO_SPACE_ERROR;
+        }
+        else if ((kv->head == _MTB_BLOCK_STORAGE_KV_NONE) || (kv->free_sectors >= 2u))
+        {
+            result = _mtb_block_storage_kv_open(kv, true);
+        }
+        //One sector is kept free for the next compaction. The compaction is done as soon as a
+        //sector is opened, so the next one is also opened with a checkpoint.
+        while ((result == CY_RSLT_SUCCESS) && progress && (kv->free_sectors < 2u))
+        {
+            uint32_t free_sectors = kv->free_sectors;
+            result = _mtb_block_storage_kv_compact(kv);
+            progress = (kv->free_sectors > free_sectors);
+        }
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_kv_replay
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_kv_replay(mtb_block_storage_kv_t* kv, uint32_t sector,
+                                              uint32_t offset, uint32_t* end)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint32_t blank = 0x01010101u * kv->erase_value;
+    uint32_t chunk = kv->config.scratch_size;
+
+    while ((result == CY_RSLT_SUCCESS) &&
+           ((kv->config.sector_size - offset) >= _MTB_BLOCK_STORAGE_KV_RECORD_HEADER))
+    {
+        uint32_t record = (sector * kv->config.sector_size) + offset;
+        uint32_t header[3];
+        uint32_t size = 0;
+        result = _mtb_block_storage_kv_read(kv, record, sizeof(header), header);
+        if ((result != CY_RSLT_SUCCESS) ||
+            ((header[0] == blank) && (header[1] == blank) && (header[2] == blank)))
+        {
+            break;
+        }
+        size = _mtb_block_storage_kv_record_size(kv, header, record);
+        if (0u == size)
+        {
+            //Not a record header, nothing more can be appended to this sector
+            offset = kv->config.sector_size;
+        }
+        else
+        {
+            char key[MTB_BLOCK_STORAGE_KV_MAX_KEY_LENGTH];
+            uint32_t key_length = header[0] & 0xFFu;
+            uint32_t flags = (header[0] >> 8) & 0xFFu;
+            uint32_t value = record + _MTB_BLOCK_STORAGE_KV_RECORD_HEADER + key_length;
+            uint32_t crc = _mtb_block_storage_kv_crc(0xFFFFFFFFu, (const uint8_t*)header,
+                                                     2u * sizeof(uint32_t));
+            result = _mtb_block_storage_kv_read(kv, record + _MTB_BLOCK_STORAGE_KV_RECORD_HEADER,
+                                                key_length, key);
+            crc = _mtb_block_storage_kv_crc(crc, (const uint8_t*)key, key_length);
+            for (uint32_t done = 0; (result == CY_RSLT_SUCCESS) && (done < header[1]);
+                 done += chunk)
+            {
+                uint32_t length = ((header[1] - done) < chunk) ? (header[1] - done) : chunk;
+                result = _mtb_block_storage_kv_read(kv, value + done, length, kv->config.scratch);
+                crc = _mtb_block_storage_kv_crc(crc, kv->config.scratch, length);
+            }
+            //A record that fails its CRC was interrupted, its space is skipped
+            if ((result == CY_RSLT_SUCCESS) && (~crc == header[2]) && (0u != key_length) &&
+                (0u == (flags & _MTB_BLOCK_STORAGE_KV_FLAG_CHECKPOINT)))
+            {
+                result = _mtb_block_storage_kv_apply(kv, key, key_length,
+                                                     (0u != (flags &
+                                                             _MTB_BLOCK_STORAGE_KV_FLAG_TOMBSTONE)),
+                                                     record);
+            }
+            offset += size;
+        }
+    }
+    *end = offset;
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_kv_load_checkpoint
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_kv_load_checkpoint(mtb_block_storage_kv_t* kv,
+                                                       uint32_t sector, uint32_t* end)
+{
+    uint32_t record = (sector * kv->config.sector_size) + kv->header_size;
+    uint32_t length = kv->config.index_size * sizeof(mtb_block_storage_kv_entry_t);
+    uint32_t header[3];
+    cy_rslt_t result = _mtb_block_storage_kv_read(kv, record, sizeof(header), header);
+
+    *end = 0;
+    if ((result == CY_RSLT_SUCCESS) && (0u != _mtb_block_storage_kv_record_size(kv, header,
+                                                                                record)) &&
+        (header[0] == ((_MTB_BLOCK_STORAGE_KV_RECORD_MAGIC << 16) |
+                       (_MTB_BLOCK_STORAGE_KV_FLAG_CHECKPOINT << 8))) && (header[1] == length))
+    {
+        //The index is read in place and kept only if its CRC matches
+        result = _mtb_block_storage_kv_read(kv, record + _MTB_BLOCK_STORAGE_KV_RECORD_HEADER,
+                                            length, kv->config.index);
+        if ((result == CY_RSLT_SUCCESS) &&
+            (~_mtb_block_storage_kv_crc(_mtb_block_storage_kv_crc(0xFFFFFFFFu,
+                                                                  (const uint8_t*)header,
+                                                                  2u * sizeof(uint32_t)),
+                                        (const uint8_t*)kv->config.index, length) == header[2]))
+        {
+            *end = kv->header_size + _mtb_block_storage_kv_record_size(kv, header, record);
+        }
+    }
+
+    kv->count = 0;
+    for (uint32_t i = 0; i < kv->config.index_size; i++)
+    {
+        if (0u == *end)
+        {
+            kv->config.index[i].offset = _MTB_BLOCK_STORAGE_KV_EMPTY;
+        }
+        else if (kv->config.index[i].offset != _MTB_BLOCK_STORAGE_KV_EMPTY)
+        {
+            kv->count++;
+        }
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_kv_mount
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_kv_mount(mtb_block_storage_kv_t* kv)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint32_t used = 0;
+    uint32_t sector = 0;
+    uint32_t offset = 0;
+
+    //The sectors in use follow each other in the ring, from the lowest sequence to the highest
+    for (uint32_t i = 0; (result == CY_RSLT_SUCCESS) && (i < kv->sector_count); i++)
+    {
+        uint32_t header[3];
+        result = _mtb_block_storage_kv_read(kv, i * kv->config.sector_size, sizeof(header),
+                                            header);
+        if ((result == CY_RSLT_SUCCESS) && (header[0] == _MTB_BLOCK_STORAGE_KV_SECTOR_MAGIC) &&
+            (header[2] == ~header[1]))
+        {
+            if ((0u == used) || (header[1] > kv->sequence))
+            {
+                kv->head = i;
+                kv->sequence = header[1];
+            }
+            used++;
+        }
+    }
+
+    if ((result == CY_RSLT_SUCCESS) && (0u != used))
+    {
+        kv->free_sectors = kv->sector_count - used;
+        kv->tail = (kv->head + kv->sector_count + 1u - used) % kv->sector_count;
+
+        //Most recent checkpoint, without one every sector is read
+        sector = kv->head;
+        for (uint32_t i = 0; (result == CY_RSLT_SUCCESS) && (0u == offset) && (i < used); i++)
+        {
+            result = _mtb_block_storage_kv_load_checkpoint(kv, sector, &offset);
+            if (0u == offset)
+            {
+                sector = (sector + kv->sector_count - 1u) % kv->sector_count;
+            }
+        }
+        if (0u == offset)
+        {
+            sector = kv->tail;
+            offset = kv->header_size;
+        }
+        else
+        {
+            //The entries pointing to sectors compacted after the checkpoint are dropped, the
+            //records they pointed to were copied after it and are found again by the replay
+            uint32_t age = (sector + kv->sector_count - kv->tail) % kv->sector_count;
+            for (uint32_t i = 0; i < kv->config.index_size; i++)
+            {
+                while ((kv->config.index[i].offset != _MTB_BLOCK_STORAGE_KV_EMPTY) &&
+                       ((((kv->config.index[i].offset / kv->config.sector_size) +
+                          kv->sector_count - kv->tail) % kv->sector_count) >= age))
+                {
+                    _mtb_block_storage_kv_remove_slot(kv, i);
+                }
+            }
+        }
+
+        while (result == CY_RSLT_SUCCESS)
+        {
+            uint32_t end = 0;
+            result = _mtb_block_storage_kv_replay(kv, sector, offset, &end);
+            if (sector == kv->head)
+            {
+                kv->head_offset = end;
+                break;
+            }
+            sector = (sector + 1u) % kv->sector_count;
+            offset = kv->header_size;
+        }
+    }
+
+    //A sector is always kept free outside of a compaction, none is free if the power was lost
+    //after the compaction of the tail opened the last free sector and before the tail was
+    //erased. The compaction is finished now: the records already copied are no longer pointed to
+    //by the index, the others fit in the sector it opened, then the tail is erased. Otherwise the
+    //next compaction would need a free sector and every put and delete would fail.
+    if ((result == CY_RSLT_SUCCESS) && (0u != used) && (0u == kv->free_sectors))
+    {
+        result = _mtb_block_storage_kv_compact(kv);
+    }
+    return result;
+}
+
+
+/*******************************************************************************
+*                        Public Function Definitions
+*******************************************************************************/
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_kv_init
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t mtb_block_storage_kv_init(mtb_block_storage_kv_t* kv,
+                                    const mtb_block_storage_kv_config_t* config)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint32_t program_size = 0;
+    uint32_t erase_size = 0;
+
+    if ((NULL == kv) || (NULL == config) || (NULL == config->bsd) || (NULL == config->index) ||
+        (NULL == config->scratch) || (0u == config->sector_size) || (config->index_size < 2u) ||
+        (0u != (config->index_size & (config->index_size - 1u))))
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+    }
+    if (result == CY_RSLT_SUCCESS)
+    {
+        program_size = config->bsd->get_program_size(config->bsd->context, config->start_address);
+        erase_size = config->bsd->get_erase_size(config->bsd->context, config->start_address);
+        if ((0u == program_size) || (0u == erase_size) ||
+            (0u != (config->sector_size % erase_size)) ||
+            (0u != (config->start_address % config->sector_size)) ||
+            (0u != (config->size % config->sector_size)) ||
+            ((config->size / config->sector_size) < 2u) ||
+            (config->scratch_size < program_size) || (config->scratch_size < 16u) ||
+            ((NULL != config->bsd->is_in_range) &&
+             !config->bsd->is_in_range(config->bsd->context, config->start_address, config->size)))
+        {
+            result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+        }
+    }
+
+    if (result == CY_RSLT_SUCCESS)
+    {
+        kv->config = *config;
+        kv->sector_count = config->size / config->sector_size;
+        kv->program_size = program_size;
+        kv->header_size = _mtb_block_storage_kv_align(kv, 3u * sizeof(uint32_t));
+        kv->head = _MTB_BLOCK_STORAGE_KV_NONE;
+        kv->head_offset = 0;
+        kv->tail = _MTB_BLOCK_STORAGE_KV_NONE;
+        kv->free_sectors = kv->sector_count;
+        kv->sequence = 0;
+        kv->count = 0;
+        kv->erase_value = config->bsd->get_erase_value(config->bsd->context,
+                                                       config->start_address);
+        for (uint32_t i = 0; i < config->index_size; i++)
+        {
+            config->index[i].offset = _MTB_BLOCK_STORAGE_KV_EMPTY;
+        }
+        result = _mtb_block_storage_kv_mount(kv);
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_kv_put
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t mtb_block_storage_kv_put(mtb_block_storage_kv_t* kv, const char* key,
+                                   const uint8_t* value, uint32_t value_length)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint32_t key_length = _mtb_block_storage_kv_key_length(key);
+    uint32_t hash = _mtb_block_storage_kv_hash(key, key_length);
+    uint32_t size = 0;
+    uint32_t slot = 0;
+    uint32_t offset = 0;
+    bool found = false;
+
+    if ((NULL == kv) || (0u == key_length) || ((NULL == value) && (0u != value_length)))
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+    }
+    else if (value_length > (kv->config.sector_size / 2u))
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_SIZE_ERROR;
+    }
+    if (result == CY_RSLT_SUCCESS)
+    {
+        size = _mtb_block_storage_kv_align(kv, _MTB_BLOCK_STORAGE_KV_RECORD_HEADER + key_length +
+                                           value_length);
+        if (size > ((kv->config.sector_size - kv->header_size) / 2u))
+        {
+            result = MTB_BLOCK_STORAGE_INVALID_SIZE_ERROR;
+        }
+    }
+    if (result == CY_RSLT_SUCCESS)
+    {
+        result = _mtb_block_storage_kv_find(kv, key, key_length, hash, &slot, &found);
+    }
+    if ((result == CY_RSLT_SUCCESS) && !found && ((kv->count + 1u) >= kv->config.index_size))
+    {
+        result = MTB_BLOCK_STORAGE_NO_SPACE_ERROR;
+    }
+    //The compaction only updates the offsets of the index, slot stays valid
+    if (result == CY_RSLT_SUCCESS)
+    {
+        result = _mtb_block_storage_kv_reserve(kv, size);
+    }
+    if (result == CY_RSLT_SUCCESS)
+    {
+        result = _mtb_block_storage_kv_append(kv, 0u, key, key_length, value, value_length,
+                                              &offset);
+    }
+    if (result == CY_RSLT_SUCCESS)
+    {
+        if (!found)
+        {
+            kv->config.index[slot].hash = hash;
+            kv->count++;
+        }
+        kv->config.index[slot].offset = offset;
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_kv_get
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t mtb_block_storage_kv_get(mtb_block_storage_kv_t* kv, const char* key, uint8_t* value,
+                                   uint32_t value_size, uint32_t* value_length)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint32_t key_length = _mtb_block_storage_kv_key_length(key);
+    uint32_t header[3] = { 0u, 0u, 0u };
+    uint32_t slot = 0;
+    bool found = false;
+
+    if ((NULL == kv) || (0u == key_length) || ((NULL == value) && (0u != value_size)))
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+    }
+    if (result == CY_RSLT_SUCCESS)
+    {
+        result = _mtb_block_storage_kv_find(kv, key, key_length,
+                                            _mtb_block_storage_kv_hash(key, key_length), &slot,
+                                            &found);
+    }
+    if ((result == CY_RSLT_SUCCESS) && !found)
+    {
+        result = MTB_BLOCK_STORAGE_NOT_FOUND_ERROR;
+    }
+    if (result == CY_RSLT_SUCCESS)
+    {
+        result = _mtb_block_storage_kv_read(kv, kv->config.index[slot].offset, sizeof(header),
+                                            header);
+    }
+    //A value of length 0 can end at the end of the area, so nothing is read after it
+    if ((result == CY_RSLT_SUCCESS) && (0u != value_size) && (0u != header[1]))
+    {
+        result = _mtb_block_storage_kv_read(kv, kv->config.index[slot].offset +
+                                            _MTB_BLOCK_STORAGE_KV_RECORD_HEADER + key_length,
+                                            (header[1] < value_size) ? header[1] : value_size,
+                                            value);
+    }
+    if ((result == CY_RSLT_SUCCESS) && (header[1] > value_size))
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_SIZE_ERROR;
+    }
+    if (NULL != value_length)
+    {
+        *value_length = header[1];
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_kv_delete
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t mtb_block_storage_kv_delete(mtb_block_storage_kv_t* kv, const char* key)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint32_t key_length = _mtb_block_storage_kv_key_length(key);
+    uint32_t slot = 0;
+    uint32_t offset = 0;
+    bool found = false;
+
+    if ((NULL == kv) || (0u == key_length))
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+    }
+    if (result == CY_RSLT_SUCCESS)
+    {
+        result = _mtb_block_storage_kv_find(kv, key, key_length,
+                                            _mtb_block_storage_kv_hash(key, key_length), &slot,
+                                            &found);
+    }
+    if ((result == CY_RSLT_SUCCESS) && !found)
+    {
+        result = MTB_BLOCK_STORAGE_NOT_FOUND_ERROR;
+    }
+    if (result == CY_RSLT_SUCCESS)
+    {
+        result = _mtb_block_storage_kv_reserve(kv, _mtb_block_storage_kv_align(
+                                                   kv, _MTB_BLOCK_STORAGE_KV_RECORD_HEADER +
+                                                   key_length));
+    }
+    if (result == CY_RSLT_SUCCESS)
+    {
+        result = _mtb_block_storage_kv_append(kv, _MTB_BLOCK_STORAGE_KV_FLAG_TOMBSTONE, key,
+                                              key_length, NULL, 0, &offset);
+    }
+    if (result == CY_RSLT_SUCCESS)
+    {
+        _mtb_block_storage_kv_remove_slot(kv, slot);
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_kv_iterate
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t mtb_block_storage_kv_iterate(mtb_block_storage_kv_t* kv,
+                                       mtb_block_storage_kv_iterate_t callback, void* arg)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    bool next = true;
+
+    if ((NULL == kv) || (NULL == callback))
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+    }
+    for (uint32_t i = 0; (result == CY_RSLT_SUCCESS) && next && (i < kv->config.index_size); i++)
+    {
+        uint32_t offset = kv->config.index[i].offset;
+        if (offset != _MTB_BLOCK_STORAGE_KV_EMPTY)
+        {
+            char key[MTB_BLOCK_STORAGE_KV_MAX_KEY_LENGTH + 1u];
+            uint32_t header[3];
+            result = _mtb_block_storage_kv_read(kv, offset, sizeof(header), header);
+            if (result == CY_RSLT_SUCCESS)
+            {
+                result = _mtb_block_storage_kv_read(kv, offset +
+                                                    _MTB_BLOCK_STORAGE_KV_RECORD_HEADER,
+                                                    header[0] & 0xFFu, key);
+            }
+            if (result == CY_RSLT_SUCCESS)
+            {
+                key[header[0] & 0xFFu] = '\0';
+                next = callback(arg, key, header[1]);
+            }
+        }
+    }
+    return result;
+}
@@ -0,0 +1,675 @@
+/***********************************************************************************************//**
+ * \file mtb_block_storage_locked.c
+ *
+ * \brief
+ * Thread safe block storage device. Wraps a block storage device and serializes the calls made to
+ * it from several threads, with one lock per region so that the regions are accessed in parallel.
+ *
+ ***************************************************************************************************
+ * \copyright
+ * Copyright 2024 Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **************************************************************************************************/
+#if defined(__unix__) || defined(__APPLE__)
+#if !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+#endif // if defined(__unix__) || defined(__APPLE__)
+
+#include "mtb_block_storage_locked.h"
+
+#if defined(MTB_BLOCK_STORAGE_LOCKED_SUPPORTED)
+
+#if defined(CY_RTOS_AWARE) || defined(COMPONENT_RTOS_AWARE)
+#define _MTB_BLOCK_STORAGE_LOCKED_RTOS
+typedef cy_mutex_t _mtb_block_storage_locked_mutex_t;
+#else
+typedef pthread_mutex_t _mtb_block_storage_locked_mutex_t;
+#endif
+
+/*******************************************************************************
+*                       Private Function Definitions
+*******************************************************************************/
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_locked_init_mutex
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_locked_init_mutex(_mtb_block_storage_locked_mutex_t* mutex)
+{
+    #if defined(_MTB_BLOCK_STORAGE_LOCKED_RTOS)
+    //The mutexes of the RTOS abstraction are recursive
+    return cy_rtos_init_mutex(mutex);
+    #else
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    pthread_mutexattr_t attr;
+    if ((0 != pthread_mutexattr_init(&attr)) ||
+        (0 != pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE)) ||
+        (0 != pthread_mutex_init(mutex, &attr)))
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+    }
+    (void)pthread_mutexattr_destroy(&attr);
+    return result;
+    #endif // if defined(_MTB_BLOCK_STORAGE_LOCKED_RTOS)
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_locked_deinit_mutex
+//--------------------------------------------------------------------------------------------------
+static void _mtb_block_storage_locked_deinit_mutex(_mtb_block_storage_locked_mutex_t* mutex)
+{
+    #if defined(_MTB_BLOCK_STORAGE_LOCKED_RTOS)
+    (void)cy_rtos_deinit_mutex(mutex);
+    #else
+    (void)pthread_mutex_destroy(mutex);
+    #endif
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_locked_get_mutex
+//--------------------------------------------------------------------------------------------------
+static inline void _mtb_block_storage_locked_get_mutex(_mtb_block_storage_locked_mutex_t* mutex)
+{
+    #if defined(_MTB_BLOCK_STORAGE_LOCKED_RTOS)
+    (void)cy_rtos_get_mutex(mutex, CY_RTOS_NEVER_TIMEOUT);
+    #else
+    (void)pthread_mutex_lock(mutex);
+    #endif
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_locked_set_mutex
+//--------------------------------------------------------------------------------------------------
+static inline void _mtb_block_storage_locked_set_mutex(_mtb_block_storage_locked_mutex_t* mutex)
+{
+    #if defined(_MTB_BLOCK_STORAGE_LOCKED_RTOS)
+    (void)cy_rtos_set_mutex(mutex);
+    #else
+    (void)pthread_mutex_unlock(mutex);
+    #endif
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_locked_lock
+//--------------------------------------------------------------------------------------------------
+static void _mtb_block_storage_locked_lock(mtb_block_storage_locked_t* obj, uint32_t mutexes)
+{
+    //Always in ascending order, so two calls spanning several regions cannot deadlock
+    for (uint32_t mutex = 0; mutex < obj->mutex_count; mutex++)
+    {
+        if (0u != (mutexes & (1UL << mutex)))
+        {
+            _mtb_block_storage_locked_get_mutex(&obj->mutexes[mutex]);
+        }
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_locked_unlock
+//--------------------------------------------------------------------------------------------------
+static void _mtb_block_storage_locked_unlock(mtb_block_storage_locked_t* obj, uint32_t mutexes)
+{
+    for (uint32_t mutex = obj->mutex_count; mutex > 0u; mutex--)
+    {
+        if (0u != (mutexes & (1UL << (mutex - 1u))))
+        {
+            _mtb_block_storage_locked_set_mutex(&obj->mutexes[mutex - 1u]);
+        }
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_locked_lock_write
+//--------------------------------------------------------------------------------------------------
+static void _mtb_block_storage_locked_lock_write(mtb_block_storage_locked_t* obj, uint32_t mutexes)
+{
+    //The write lock is taken first, then the regions in ascending order. A writer waiting for
+    //another write to finish holds no region lock, so the reads of its regions do not wait for
+    //that write. Reads never take the write lock, so the order is the same for every call.
+    if (obj->mutex_count > 1u)
+    {
+        _mtb_block_storage_locked_get_mutex(&obj->write_mutex);
+    }
+    _mtb_block_storage_locked_lock(obj, mutexes);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_locked_unlock_write
+//--------------------------------------------------------------------------------------------------
+static void _mtb_block_storage_locked_unlock_write(mtb_block_storage_locked_t* obj,
+                                                   uint32_t mutexes)
+{
+    _mtb_block_storage_locked_unlock(obj, mutexes);
+    if (obj->mutex_count > 1u)
+    {
+        _mtb_block_storage_locked_set_mutex(&obj->write_mutex);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_locked_all
+//--------------------------------------------------------------------------------------------------
+static inline uint32_t _mtb_block_storage_locked_all(const mtb_block_storage_locked_t* obj)
+{
+    return UINT32_MAX >> (32u - obj->mutex_count);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_locked_region
+//--------------------------------------------------------------------------------------------------
+static uint32_t _mtb_block_storage_locked_region(const mtb_block_storage_locked_t* obj,
+                                                 uint32_t addr)
+{
+    uint32_t region = 0;
+    while (((region + 1u) < obj->region_count) && (addr >= obj->starts[region + 1u]))
+    {
+        region++;
+    }
+    return region;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_locked_range
+//--------------------------------------------------------------------------------------------------
+static uint32_t _mtb_block_storage_locked_range(const mtb_block_storage_locked_t* obj,
+                                                uint32_t addr, uint32_t length)
+{
+    uint32_t mutexes = 0;
+    uint32_t first = _mtb_block_storage_locked_region(obj, addr);
+    uint32_t last = first;
+
+    if ((0u != length) && ((length - 1u) > (UINT32_MAX - addr)))
+    {
+        //Wraps around the address space, the inner device rejects it, under all the locks
+        first = 0;
+        last = obj->region_count - 1u;
+    }
+    else if (0u != length)
+    {
+        last = _mtb_block_storage_locked_region(obj, addr + (length - 1u));
+    }
+    for (uint32_t region = first; region <= last; region++)
+    {
+        mutexes |= 1UL << obj->mutex_of[region];
+    }
+    return mutexes;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_locked_read_size
+//--------------------------------------------------------------------------------------------------
+static uint32_t _mtb_block_storage_locked_read_size(void* context, uint32_t addr)
+{
+    mtb_block_storage_t* bsd = ((mtb_block_storage_locked_t*)context)->bsd;
+    return bsd->get_read_size(bsd->context, addr);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_locked_program_size
+//--------------------------------------------------------------------------------------------------
+static uint32_t _mtb_block_storage_locked_program_size(void* context, uint32_t addr)
+{
+    mtb_block_storage_t* bsd = ((mtb_block_storage_locked_t*)context)->bsd;
+    return bsd->get_program_size(bsd->context, addr);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_locked_erase_size
+//--------------------------------------------------------------------------------------------------
+static uint32_t _mtb_block_storage_locked_erase_size(void* context, uint32_t addr)
+{
+    mtb_block_storage_t* bsd = ((mtb_block_storage_locked_t*)context)->bsd;
+    return bsd->get_erase_size(bsd->context, addr);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_locked_erase_value
+//--------------------------------------------------------------------------------------------------
+static uint8_t _mtb_block_storage_locked_erase_value(void* context, uint32_t addr)
+{
+    mtb_block_storage_t* bsd = ((mtb_block_storage_locked_t*)context)->bsd;
+    return bsd->get_erase_value(bsd->context, addr);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_locked_read
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_locked_read(void* context, uint32_t addr, uint32_t length,
+                                                uint8_t* buf)
+{
+    mtb_block_storage_locked_t* obj = (mtb_block_storage_locked_t*)context;
+    uint32_t mutexes = _mtb_block_storage_locked_range(obj, addr, length);
+    cy_rslt_t result;
+
+    _mtb_block_storage_locked_lock(obj, mutexes);
+    result = obj->bsd->read(obj->bsd->context, addr, length, buf);
+    _mtb_block_storage_locked_unlock(obj, mutexes);
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_locked_program
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_locked_program(void* context, uint32_t addr, uint32_t length,
+                                                   const uint8_t* buf)
+{
+    mtb_block_storage_locked_t* obj = (mtb_block_storage_locked_t*)context;
+    uint32_t mutexes = _mtb_block_storage_locked_range(obj, addr, length);
+    cy_rslt_t result;
+
+    _mtb_block_storage_locked_lock_write(obj, mutexes);
+    result = obj->bsd->program(obj->bsd->context, addr, length, buf);
+    _mtb_block_storage_locked_unlock_write(obj, mutexes);
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_locked_readv
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_locked_readv(void* context,
+                                                 const mtb_block_storage_read_vec_t* vecs,
+                                                 uint32_t count)
+{
+    mtb_block_storage_locked_t* obj = (mtb_block_storage_locked_t*)context;
+    uint32_t mutexes = 0;
+    cy_rslt_t result;
+
+    //The whole batch runs under the locks of all the regions it touches
+    for (uint32_t i = 0; i < count; i++)
+    {
+        mutexes |= _mtb_block_storage_locked_range(obj, vecs[i].addr, vecs[i].length);
+    }
+    _mtb_block_storage_locked_lock(obj, mutexes);
+    result = obj->bsd->readv(obj->bsd->context, vecs, count);
+    _mtb_block_storage_locked_unlock(obj, mutexes);
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_locked_programv
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_locked_programv(void* context,
+                                                    const mtb_block_storage_program_vec_t* vecs,
+                                                    uint32_t count)
+{
+    mtb_block_storage_locked_t* obj = (mtb_block_storage_locked_t*)context;
+    uint32_t mutexes = 0;
+    cy_rslt_t result;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        mutexes |= _mtb_block_storage_locked_range(obj, vecs[i].addr, vecs[i].length);
+    }
+    _mtb_block_storage_locked_lock_write(obj, mutexes);
+    result = obj->bsd->programv(obj->bsd->context, vecs, count);
+    _mtb_block_storage_locked_unlock_write(obj, mutexes);
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_locked_map
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_locked_map(void* context, uint32_t addr, uint32_t length,
+                                               const uint8_t** ptr)
+{
+    mtb_block_storage_locked_t* obj = (mtb_block_storage_locked_t*)context;
+    uint32_t mutexes = _mtb_block_storage_locked_range(obj, addr, length);
+    cy_rslt_t result;
+
+    //The locks are only held while the area is mapped, not while it is read through the pointer
+    _mtb_block_storage_locked_lock(obj, mutexes);
+    result = obj->bsd->map(obj->bsd->context, addr, length, ptr);
+    _mtb_block_storage_locked_unlock(obj, mutexes);
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_locked_unmap
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_locked_unmap(void* context, const uint8_t* ptr,
+                                                 uint32_t length)
+{
+    mtb_block_storage_locked_t* obj = (mtb_block_storage_locked_t*)context;
+    return obj->bsd->unmap(obj->bsd->context, ptr, length);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_locked_erase
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_locked_erase(void* context, uint32_t addr, uint32_t length)
+{
+    mtb_block_storage_locked_t* obj = (mtb_block_storage_locked_t*)context;
+    uint32_t mutexes = _mtb_block_storage_locked_range(obj, addr, length);
+    cy_rslt_t result;
+
+    _mtb_block_storage_locked_lock_write(obj, mutexes);
+    result = obj->bsd->erase(obj->bsd->context, addr, length);
+    _mtb_block_storage_locked_unlock_write(obj, mutexes);
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_locked_program_nb
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_locked_program_nb(void* context, uint32_t addr,
+                                                      uint32_t length, const uint8_t* buf)
+{
+    mtb_block_storage_locked_t* obj = (mtb_block_storage_locked_t*)context;
+    uint32_t mutexes = _mtb_block_storage_locked_range(obj, addr, length);
+    cy_rslt_t result;
+
+    _mtb_block_storage_locked_lock_write(obj, mutexes);
+    result = obj->bsd->program_nb(obj->bsd->context, addr, length, buf);
+    _mtb_block_storage_locked_unlock_write(obj, mutexes);
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_locked_erase_nb
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_locked_erase_nb(void* context, uint32_t addr, uint32_t length)
+{
+    mtb_block_storage_locked_t* obj = (mtb_block_storage_locked_t*)context;
+    uint32_t mutexes = _mtb_block_storage_locked_range(obj, addr, length);
+    cy_rslt_t result;
+
+    _mtb_block_storage_locked_lock_write(obj, mutexes);
+    result = obj->bsd->erase_nb(obj->bsd->context, addr, length);
+    _mtb_block_storage_locked_unlock_write(obj, mutexes);
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_locked_is_in_range
+//--------------------------------------------------------------------------------------------------
+static bool _mtb_block_storage_locked_is_in_range(void* context, uint32_t addr, uint32_t length)
+{
+    mtb_block_storage_t* bsd = ((mtb_block_storage_locked_t*)context)->bsd;
+    return bsd->is_in_range(bsd->context, addr, length);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_locked_is_erase_required
+//--------------------------------------------------------------------------------------------------
+static bool _mtb_block_storage_locked_is_erase_required(void* context, uint32_t addr,
+                                                        uint32_t length)
+{
+    mtb_block_storage_t* bsd = ((mtb_block_storage_locked_t*)context)->bsd;
+    //An inner device that does not tell is assumed to need an erase before a program
+    return (NULL == bsd->is_erase_required) ||
+           bsd->is_erase_required(bsd->context, addr, length);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_locked_get_geometry
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_locked_get_geometry(void* context,
+                                                        mtb_block_storage_region_t* regions,
+                                                        uint32_t max_regions,
+                                                        uint32_t* region_count)
+{
+    mtb_block_storage_locked_t* obj = (mtb_block_storage_locked_t*)context;
+    cy_rslt_t result;
+
+    _mtb_block_storage_locked_lock(obj, _mtb_block_storage_locked_all(obj));
+    result = obj->bsd->get_geometry(obj->bsd->context, regions, max_regions, region_count);
+    _mtb_block_storage_locked_unlock(obj, _mtb_block_storage_locked_all(obj));
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_locked_register_callback
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_locked_register_callback(
+    void* context, mtb_block_storage_async_callback_t callback, void* callback_arg)
+{
+    mtb_block_storage_locked_t* obj = (mtb_block_storage_locked_t*)context;
+    cy_rslt_t result;
+
+    _mtb_block_storage_locked_lock(obj, _mtb_block_storage_locked_all(obj));
+    result = obj->bsd->register_callback(obj->bsd->context, callback, callback_arg);
+    _mtb_block_storage_locked_unlock(obj, _mtb_block_storage_locked_all(obj));
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_locked_poll
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_locked_poll(void* context)
+{
+    mtb_block_storage_locked_t* obj = (mtb_block_storage_locked_t*)context;
+    cy_rslt_t result;
+
+    //The non blocking operation in progress is not tied to an address, so all regions are locked.
+    //The write lock is taken as well, as the completion callback can program or erase.
+    _mtb_block_storage_locked_lock_write(obj, _mtb_block_storage_locked_all(obj));
+    result = obj->bsd->poll(obj->bsd->context);
+    _mtb_block_storage_locked_unlock_write(obj, _mtb_block_storage_locked_all(obj));
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_locked_set_regions
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_locked_set_regions(
+    mtb_block_storage_locked_t* obj, const mtb_block_storage_locked_config_t* config)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    obj->region_count = 1;
+    obj->mutex_count = 1;
+    obj->starts[0] = 0;
+    obj->mutex_of[0] = 0;
+    if (!config->per_region)
+    {
+        //One lock for the whole device
+    }
+    else if (NULL != config->region_starts)
+    {
+        if (0u == config->region_count)
+        {
+            result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+        }
+        for (uint32_t i = 1; (result == CY_RSLT_SUCCESS) && (i < config->region_count); i++)
+        {
+            if (config->region_starts[i] <= config->region_starts[i - 1u])
+            {
+                result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+            }
+        }
+        if (result == CY_RSLT_SUCCESS)
+        {
+            obj->region_count = (config->region_count < MTB_BLOCK_STORAGE_LOCKED_MAX_REGIONS) ?
+                                config->region_count : MTB_BLOCK_STORAGE_LOCKED_MAX_REGIONS;
+            obj->mutex_count = obj->region_count;
+            for (uint32_t i = 0; i < obj->region_count; i++)
+            {
+                obj->starts[i] = config->region_starts[i];
+                obj->mutex_of[i] = (uint8_t)i;
+            }
+        }
+    }
+    else if (NULL != config->bsd->get_geometry)
+    {
+        mtb_block_storage_region_t regions[MTB_BLOCK_STORAGE_LOCKED_MAX_REGIONS];
+        uint32_t count = 0;
+        result = config->bsd->get_geometry(config->bsd->context, regions,
+                                           MTB_BLOCK_STORAGE_LOCKED_MAX_REGIONS, &count);
+        //Only the first regions fit, the last lock covers the others
+        if (result == MTB_BLOCK_STORAGE_INVALID_SIZE_ERROR)
+        {
+            result = CY_RSLT_SUCCESS;
+            count = MTB_BLOCK_STORAGE_LOCKED_MAX_REGIONS;
+        }
+        if ((result == CY_RSLT_SUCCESS) && (0u != count))
+        {
+            obj->region_count = count;
+            obj->mutex_count = 0;
+            for (uint32_t i = 0; i < count; i++)
+            {
+                //The regions of a bank cannot be accessed in parallel, they share one lock
+                uint32_t same = 0;
+                while ((same < i) && (regions[same].bank != regions[i].bank))
+                {
+                    same++;
+                }
+                obj->starts[i] = regions[i].start_address;
+                if (same < i)
+                {
+                    obj->mutex_of[i] = obj->mutex_of[same];
+                }
+                else
+                {
+                    obj->mutex_of[i] = (uint8_t)obj->mutex_count;
+                    obj->mutex_count++;
+                }
+            }
+        }
+    }
+    return result;
+}
+
+
+/*******************************************************************************
+*                        Public Function Definitions
+*******************************************************************************/
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_create_locked
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t mtb_block_storage_create_locked(mtb_block_storage_t* bsd,
+                                          mtb_block_storage_locked_t* obj,
+                                          const mtb_block_storage_locked_config_t* config)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    if ((NULL == bsd) || (NULL == obj) || (NULL == config) || (NULL == config->bsd))
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+    }
+
+    if (result == CY_RSLT_SUCCESS)
+    {
+        obj->bsd = config->bsd;
+        result = _mtb_block_storage_locked_set_regions(obj, config);
+    }
+
+    //With several locks, the write lock serializes the program and erase calls of all regions
+    if ((result == CY_RSLT_SUCCESS) && (obj->mutex_count > 1u))
+    {
+        result = _mtb_block_storage_locked_init_mutex(&obj->write_mutex);
+    }
+    for (uint32_t mutex = 0; (result == CY_RSLT_SUCCESS) && (mutex < obj->mutex_count); mutex++)
+    {
+        result = _mtb_block_storage_locked_init_mutex(&obj->mutexes[mutex]);
+        if (result != CY_RSLT_SUCCESS)
+        {
+            while (mutex > 0u)
+            {
+                mutex--;
+                _mtb_block_storage_locked_deinit_mutex(&obj->mutexes[mutex]);
+            }
+            if (obj->mutex_count > 1u)
+            {
+                _mtb_block_storage_locked_deinit_mutex(&obj->write_mutex);
+            }
+        }
+    }
+
+    if (result == CY_RSLT_SUCCESS)
+    {
+        bsd->get_read_size = _mtb_block_storage_locked_read_size;
+        bsd->get_program_size = _mtb_block_storage_locked_program_size;
+        bsd->get_erase_size = _mtb_block_storage_locked_erase_size;
+        bsd->get_erase_value = _mtb_block_storage_locked_erase_value;
+        bsd->read = _mtb_block_storage_locked_read;
+        bsd->program = _mtb_block_storage_locked_program;
+        bsd->erase = _mtb_block_storage_locked_erase;
+        bsd->is_erase_required = _mtb_block_storage_locked_is_erase_required;
+        //The optional functions are only provided if the inner device provides them
+        bsd->program_nb = (NULL != config->bsd->program_nb) ?
+                          _mtb_block_storage_locked_program_nb : NULL;
+        bsd->erase_nb = (NULL != config->bsd->erase_nb) ? _mtb_block_storage_locked_erase_nb :
+                        NULL;
+        bsd->is_in_range = (NULL != config->bsd->is_in_range) ?
+                           _mtb_block_storage_locked_is_in_range : NULL;
+        bsd->get_geometry = (NULL != config->bsd->get_geometry) ?
+                            _mtb_block_storage_locked_get_geometry : NULL;
+        bsd->register_callback = (NULL != config->bsd->register_callback) ?
+                                 _mtb_block_storage_locked_register_callback : NULL;
+        bsd->poll = (NULL != config->bsd->poll) ? _mtb_block_storage_locked_poll : NULL;
+        bsd->readv = (NULL != config->bsd->readv) ? _mtb_block_storage_locked_readv : NULL;
+        bsd->programv = (NULL != config->bsd->programv) ? _mtb_block_storage_locked_programv :
+                        NULL;
+        bsd->map = (NULL != config->bsd->map) ? _mtb_block_storage_locked_map : NULL;
+        bsd->unmap = (NULL != config->bsd->unmap) ? _mtb_block_storage_locked_unmap : NULL;
+        bsd->context = obj;
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_locked_deinit
+//--------------------------------------------------------------------------------------------------
+void mtb_block_storage_locked_deinit(mtb_block_storage_locked_t* obj)
+{
+    if (NULL != obj)
+    {
+        for (uint32_t mutex = 0; mutex < obj->mutex_count; mutex++)
+        {
+            _mtb_block_storage_locked_deinit_mutex(&obj->mutexes[mutex]);
+        }
+        if (obj->mutex_count > 1u)
+        {
+            _mtb_block_storage_locked_deinit_mutex(&obj->write_mutex);
+        }
+        obj->region_count = 0;
+        obj->mutex_count = 0;
+    }
+}
+
+
+#endif // defined(MTB_BLOCK_STORAGE_LOCKED_SUPPORTED)
@@ -26,6 +26,8 @@
  **************************************************************************************************/
 #if !defined(COMPONENT_CAT2)
 #include "mtb_block_storage.h"
+#include "mtb_block_storage_trace.h"
+#include <string.h>
 #if (CYHAL_DRIVER_AVAILABLE_NVM) || (CYHAL_DRIVER_AVAILABLE_FLASH) || (MTB_HAL_DRIVER_AVAILABLE_NVM)
 #if defined(CY_USING_HAL) || defined(CY_USING_HAL_LITE)
 #if (CYHAL_DRIVER_AVAILABLE_NVM)
@@ -50,328 +52,1091 @@ typedef cyhal_flash_info_t       mtb_block_storage_nvm_info_t;
 #endif // (CYHAL_DRIVER_AVAILABLE_NVM)
 
 
-/* The following API is implemented in block storage as a fallback for older HAL
-   versions that use the now deprecated cyhal_flash.h or do not have access to the
-   cyhal_nvm.h API cyhal_nvm_get_region_for_address. */
+#else // if defined(CY_USING_HAL) || defined(CY_USING_HAL_LITE)
+
+
+#include "mtb_hal.h"
+
+typedef mtb_hal_nvm_region_info_t mtb_block_storage_nvm_region_info_t;
+typedef mtb_hal_nvm_t             mtb_block_storage_nvm_t;
+typedef mtb_hal_nvm_info_t        mtb_block_storage_nvm_info_t;
+
+#define MTB_BLOCK_STORAGE_NVM_SUPPORT
+
+#endif // if defined(CY_USING_HAL) || defined(CY_USING_HAL_LITE)
+
+/* Region information resolved for the memory type, with the shifts of the program and erase
+   sizes precomputed so that the hot paths do not need any division. */
+typedef struct
+{
+    uint32_t start_address;
+    uint32_t size;
+    uint32_t program_size;
+    uint32_t erase_size;
+    uint8_t  program_shift;
+    uint8_t  erase_shift;
+    uint8_t  erase_value;
+    bool     is_erase_required;
+    uint8_t  bank;              //See MTB_BLOCK_STORAGE_NVM_BANKS
+} _mtb_block_storage_nvm_region_t;
+
+//Size of the stack buffer through which a row is read to compare it before programming
+#define _MTB_BLOCK_STORAGE_NVM_COMPARE_CHUNK    (64u)
+
+/* Context of a block storage instance, its address is passed to all the callbacks */
+typedef struct
+{
+    mtb_block_storage_nvm_t*        hal_obj;
+    uint32_t                        region_count;
+    uint32_t                        last_region;
+    uint32_t                        options;        //MTB_BLOCK_STORAGE_OPTION_* values
+    uint32_t                        users;          //Devices created and not deinitialized
+    _mtb_block_storage_nvm_region_t regions[MTB_BLOCK_STORAGE_NVM_MAX_REGIONS];
+    #if defined(MTB_BLOCK_STORAGE_NON_BLOCKING_SUPPORTED)
+    volatile uint8_t                nb_operation;   //Non blocking operation in progress
+    uint32_t                        nb_addr;        //Address of the row being processed
+    uint32_t                        nb_end;
+    uint32_t                        nb_step;        //Program or erase size of the region
+    uint32_t                        nb_row;         //Length of the row being processed
+    const uint8_t*                  nb_buf;         //Data of the row being programmed
+    uint8_t                         nb_bank;        //Bank of the operation
+    bool                            nb_blocking;    //Run by program or erase, not reported
+    cy_rslt_t                       nb_result;
+    mtb_block_storage_async_callback_t callback;
+    void*                           callback_arg;
+    #endif // defined(MTB_BLOCK_STORAGE_NON_BLOCKING_SUPPORTED)
+} _mtb_block_storage_nvm_context_t;
+
+#if defined(MTB_BLOCK_STORAGE_NON_BLOCKING_SUPPORTED)
+#define _MTB_BLOCK_STORAGE_NVM_NB_IDLE      (0u)
+#define _MTB_BLOCK_STORAGE_NVM_NB_PROGRAM   (1u)
+#define _MTB_BLOCK_STORAGE_NVM_NB_ERASE     (2u)
+#endif
+
+static _mtb_block_storage_nvm_context_t
+    _mtb_block_storage_nvm_contexts[MTB_BLOCK_STORAGE_NVM_MAX_INSTANCES];
+
+#if defined(MTB_BLOCK_STORAGE_NVM_BANKS)
+static const mtb_block_storage_nvm_bank_t _mtb_block_storage_nvm_banks[] =
+    MTB_BLOCK_STORAGE_NVM_BANKS;
+#endif
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_nvm_shift
+//--------------------------------------------------------------------------------------------------
+static uint8_t _mtb_block_storage_nvm_shift(uint32_t size)
+{
+    uint8_t shift = 0;
+    while ((shift < 31u) && ((1UL << shift) < size))
+    {
+        shift++;
+    }
+    return shift;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_nvm_is_multiple
+//--------------------------------------------------------------------------------------------------
+static inline bool _mtb_block_storage_nvm_is_multiple(uint32_t value, uint32_t size, uint8_t shift)
+{
+    //All known NVM geometries are powers of two, the modulo is only kept as a safe fallback
+    return ((1UL << shift) == size) ? (0u == (value & (size - 1u))) : (0u == (value % size));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_nvm_fill_region
+//--------------------------------------------------------------------------------------------------
+static void _mtb_block_storage_nvm_fill_region(_mtb_block_storage_nvm_region_t* region,
+                                               const mtb_block_storage_nvm_region_info_t* info)
+{
+    region->start_address = info->start_address;
+    region->size = info->size;
+    region->erase_value = info->erase_value;
+
+    //For Flash NVM block size represents the minimum programmable size and sector size
+    //represents the minimum erasable size. As they do not always match, it is necessary to
+    // use the bigger
+    //metric so that program and erase are performed on the same area.
+    //However for RRAM NVM where we don't have an erase operation, block size represents the
+    // actual
+    //minimum programmable size and sector size represents the overall physical
+    // sectorization of the memory.
+    //For this reason we need to select different measures for this function based on the
+    // memory type.
+    #if defined(MTB_BLOCK_STORAGE_NVM_SUPPORT)
+    if (info->nvm_type == MTB_HAL_NVM_TYPE_RRAM)
+    {
+        region->program_size = info->block_size;
+        region->erase_size = info->block_size;
+    }
+    else
+    #endif // defined(MTB_BLOCK_STORAGE_NVM_SUPPORT)
+    {
+        #if (CYHAL_DRIVER_AVAILABLE_NVM) || (MTB_HAL_DRIVER_AVAILABLE_NVM)
+        region->program_size = info->block_size;
+        #elif (CYHAL_DRIVER_AVAILABLE_FLASH)
+        region->program_size = info->sector_size;
+        #endif /* (CYHAL_DRIVER_AVAILABLE_NVM) || (MTB_HAL_DRIVER_AVAILABLE_NVM)*/
+        region->erase_size = info->sector_size;
+    }
+
+    #if !defined(MTB_BLOCK_STORAGE_FLASH_SUPPORT)
+    region->is_erase_required = info->is_erase_required;
+    #else
+    region->is_erase_required = true;
+    #endif
+    region->program_shift = _mtb_block_storage_nvm_shift(region->program_size);
+    region->erase_shift = _mtb_block_storage_nvm_shift(region->erase_size);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_nvm_get_bank
+//--------------------------------------------------------------------------------------------------
+static uint8_t _mtb_block_storage_nvm_get_bank(const mtb_block_storage_nvm_region_info_t* info,
+                                               uint32_t index)
+{
+    #if defined(MTB_BLOCK_STORAGE_NVM_BANKS)
+    uint8_t bank = 0;
+    CY_UNUSED_PARAMETER(index);
+    for (uint32_t i = 0; i < (sizeof(_mtb_block_storage_nvm_banks) /
+                              sizeof(_mtb_block_storage_nvm_banks[0])); i++)
+    {
+        if ((info->start_address >= _mtb_block_storage_nvm_banks[i].start_address) &&
+            ((info->start_address - _mtb_block_storage_nvm_banks[i].start_address) <
+             _mtb_block_storage_nvm_banks[i].size))
+        {
+            bank = (uint8_t)(i + 1u);
+        }
+    }
+    return bank;
+    #else
+    //The HAL regions are different memories, e.g. main and work flash, so each one is treated as
+    //a bank
+    CY_UNUSED_PARAMETER(info);
+    return (uint8_t)index;
+    #endif // if defined(MTB_BLOCK_STORAGE_NVM_BANKS)
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_nvm_add_region
+//--------------------------------------------------------------------------------------------------
+static const _mtb_block_storage_nvm_region_t* _mtb_block_storage_nvm_add_region(
+    _mtb_block_storage_nvm_context_t* ctx, const mtb_block_storage_nvm_region_info_t* info,
+    uint8_t bank)
+{
+    const _mtb_block_storage_nvm_region_t* region = NULL;
+
+    if (ctx->region_count < MTB_BLOCK_STORAGE_NVM_MAX_REGIONS)
+    {
+        //Keep the table sorted by address for the binary search
+        uint32_t index = ctx->region_count;
+        while ((index > 0u) && (ctx->regions[index - 1u].start_address > info->start_address))
+        {
+            ctx->regions[index] = ctx->regions[index - 1u];
+            index--;
+        }
+        _mtb_block_storage_nvm_fill_region(&ctx->regions[index], info);
+        ctx->regions[index].bank = bank;
+        ctx->region_count++;
+        ctx->last_region = index;
+        region = &ctx->regions[index];
+    }
+    return region;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_nvm_region_contains
+//--------------------------------------------------------------------------------------------------
+static inline bool _mtb_block_storage_nvm_region_contains(
+    const _mtb_block_storage_nvm_region_t* region, uint32_t addr, uint32_t length)
+{
+    return (addr >= region->start_address) && ((addr - region->start_address) < region->size) &&
+           (length <= (region->size - (addr - region->start_address)));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_nvm_find_region
+//--------------------------------------------------------------------------------------------------
+static const _mtb_block_storage_nvm_region_t* _mtb_block_storage_nvm_find_region(
+    _mtb_block_storage_nvm_context_t* ctx, uint32_t addr, uint32_t length)
+{
+    const _mtb_block_storage_nvm_region_t* region = NULL;
+    //Read once, another thread can update it when the device is read while it is written
+    uint32_t last_region = ctx->last_region;
+
+    //Consecutive operations usually target the same region
+    if ((last_region < ctx->region_count) &&
+        _mtb_block_storage_nvm_region_contains(&ctx->regions[last_region], addr, length))
+    {
+        region = &ctx->regions[last_region];
+    }
+    else
+    {
+        //Find the last region starting at or before the address
+        uint32_t low = 0;
+        uint32_t high = ctx->region_count;
+        while (low < high)
+        {
+            uint32_t mid = low + ((high - low) / 2u);
+            if (ctx->regions[mid].start_address <= addr)
+            {
+                low = mid + 1u;
+            }
+            else
+            {
+                high = mid;
+            }
+        }
+        if ((low > 0u) &&
+            _mtb_block_storage_nvm_region_contains(&ctx->regions[low - 1u], addr, length))
+        {
+            ctx->last_region = low - 1u;
+            region = &ctx->regions[low - 1u];
+        }
+    }
+    return region;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_nvm_init_context
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_nvm_init_context(_mtb_block_storage_nvm_context_t* ctx,
+                                                     mtb_block_storage_nvm_t* hal_obj)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    ctx->hal_obj = hal_obj;
+    ctx->region_count = 0;
+    ctx->last_region = 0;
+    ctx->options = 0;
+    ctx->users = 0;
+    #if defined(MTB_BLOCK_STORAGE_NON_BLOCKING_SUPPORTED)
+    ctx->nb_operation = _MTB_BLOCK_STORAGE_NVM_NB_IDLE;
+    ctx->nb_blocking = false;
+    ctx->nb_result = CY_RSLT_SUCCESS;
+    ctx->callback = NULL;
+    ctx->callback_arg = NULL;
+    #endif
+
+    mtb_block_storage_nvm_info_t nvm_info;
+    #if defined(MTB_BLOCK_STORAGE_FLASH_SUPPORT)
+    cyhal_flash_get_info(hal_obj, &nvm_info);
+    uint32_t count = nvm_info.block_count;
+    const mtb_block_storage_nvm_region_info_t* infos = nvm_info.blocks;
+    #else
+    #if defined(CY_USING_HAL) || defined(CY_USING_HAL_LITE)
+    cyhal_nvm_get_info(hal_obj, &nvm_info);
+    #else
+    mtb_hal_nvm_get_info(hal_obj, &nvm_info);
+    #endif
+    uint32_t count = nvm_info.region_count;
+    const mtb_block_storage_nvm_region_info_t* infos = nvm_info.regions;
+    #endif // defined(MTB_BLOCK_STORAGE_FLASH_SUPPORT)
+
+    if (count > MTB_BLOCK_STORAGE_NVM_MAX_REGIONS)
+    {
+        //MTB_BLOCK_STORAGE_NVM_MAX_REGIONS needs to be increased for this device
+        result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+    }
+    else
+    {
+        for (uint32_t region = 0; region < count; region++)
+        {
+            (void)_mtb_block_storage_nvm_add_region(ctx, &infos[region],
+                                                    _mtb_block_storage_nvm_get_bank(
+                                                        &infos[region], region));
+        }
+    }
+
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_nvm_get_context
+//--------------------------------------------------------------------------------------------------
+static _mtb_block_storage_nvm_context_t* _mtb_block_storage_nvm_get_context(
+    mtb_block_storage_nvm_t* hal_obj, bool* in_use)
+{
+    _mtb_block_storage_nvm_context_t* ctx = NULL;
+
+    //Creating a device again on the same HAL object reuses its context, which is left as is, so
+    //that the options, the callback and the operation in progress of the devices already created
+    //on it are kept
+    *in_use = false;
+    for (uint32_t i = 0; i < MTB_BLOCK_STORAGE_NVM_MAX_INSTANCES; i++)
+    {
+        if (_mtb_block_storage_nvm_contexts[i].hal_obj == hal_obj)
+        {
+            ctx = &_mtb_block_storage_nvm_contexts[i];
+            *in_use = true;
+            break;
+        }
+        if ((NULL == ctx) && (NULL == _mtb_block_storage_nvm_contexts[i].hal_obj))
+        {
+            ctx = &_mtb_block_storage_nvm_contexts[i];
+        }
+    }
+    return ctx;
+}
+
+#if (CPUSS_FLASHC_ECT == 1)
+/* Row sizes of the work flash ProgramRow, widest first. Each row costs one SROM call whatever its
+   size, so a program is split into the widest rows its alignment and length allow. */
+static const struct
+{
+    uint32_t                            bytes;
+    cy_en_flash_programrow_datasize_t   data_size;
+} _mtb_block_storage_nvm_ect_rows[] =
+{
+    { 512u, CY_FLASH_PROGRAMROW_DATA_SIZE_4096BIT },
+    { 128u, CY_FLASH_PROGRAMROW_DATA_SIZE_1024BIT },
+    { 4u,   CY_FLASH_PROGRAMROW_DATA_SIZE_32BIT   }
+};
+
+#define _MTB_BLOCK_STORAGE_NVM_ECT_ROW_COUNT \
+    (sizeof(_mtb_block_storage_nvm_ect_rows) / sizeof(_mtb_block_storage_nvm_ect_rows[0]))
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_nvm_ect_min_row
+//--------------------------------------------------------------------------------------------------
+static uint32_t _mtb_block_storage_nvm_ect_min_row(uint32_t prog_size)
+{
+    //Narrowest row of a region: its program size, programmed as 4096-bit rows when it is wider
+    uint32_t min_row = (prog_size > _mtb_block_storage_nvm_ect_rows[0].bytes)
+        ? _mtb_block_storage_nvm_ect_rows[0].bytes : prog_size;
+    uint32_t result = 0;
+
+    for (uint32_t i = 0; i < _MTB_BLOCK_STORAGE_NVM_ECT_ROW_COUNT; i++)
+    {
+        if ((_mtb_block_storage_nvm_ect_rows[i].bytes == min_row) &&
+            (0u == (prog_size & (min_row - 1u))))
+        {
+            result = min_row;
+        }
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_nvm_ect_start_row
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_nvm_ect_start_row(uint32_t addr, uint32_t left,
+                                                      const uint8_t* buf, uint32_t prog_size,
+                                                      bool blocking, uint32_t* row)
+{
+    cy_rslt_t result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+    cy_stc_flash_programrow_config_t config;
+    cy_en_flashdrv_status_t status;
+    uint32_t min_row = _mtb_block_storage_nvm_ect_min_row(prog_size);
+    uint32_t i = 0;
+
+    //A program size that is not one of the row sizes cannot be programmed
+    if (0u != min_row)
+    {
+        //The address and the length are multiples of min_row, so the search stops at min_row at
+        //the latest
+        while ((_mtb_block_storage_nvm_ect_rows[i].bytes > min_row) &&
+               ((0u != (addr & (_mtb_block_storage_nvm_ect_rows[i].bytes - 1u))) ||
+                (left < _mtb_block_storage_nvm_ect_rows[i].bytes)))
+        {
+            i++;
+        }
+        config.blocking = blocking ? CY_FLASH_PROGRAMROW_BLOCKING :
+                          CY_FLASH_PROGRAMROW_NON_BLOCKING;
+        config.skipBC = CY_FLASH_PROGRAMROW_SKIP_BLANK_CHECK;
+        config.dataSize = _mtb_block_storage_nvm_ect_rows[i].data_size;
+        config.dataLoc = CY_FLASH_PROGRAMROW_DATA_LOCATION_SRAM;
+        //The completion of a non blocking row is polled, no interrupt is needed
+        config.intrMask = blocking ? CY_FLASH_PROGRAMROW_SET_INTR_MASK :
+                          CY_FLASH_PROGRAMROW_NOT_SET_INTR_MASK;
+        config.destAddr = (const uint32_t*)(uintptr_t)addr;
+        config.dataAddr = (const uint32_t*)buf;
+        status = Cy_Flash_Program_WorkFlash(&config);
+        result = ((status == CY_FLASH_DRV_SUCCESS) || (status == CY_FLASH_DRV_OPERATION_STARTED))
+            ? CY_RSLT_SUCCESS : (cy_rslt_t)status;
+        *row = _mtb_block_storage_nvm_ect_rows[i].bytes;
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_nvm_ect_row_status
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_nvm_ect_row_status(void)
+{
+    cy_en_flashdrv_status_t status = Cy_Flash_IsOperationComplete();
+    cy_rslt_t result = (cy_rslt_t)status;
+    if (status == CY_FLASH_DRV_SUCCESS)
+    {
+        result = CY_RSLT_SUCCESS;
+    }
+    else if ((status == CY_FLASH_DRV_OPCODE_BUSY) || (status == CY_FLASH_DRV_PROGRESS_NO_ERROR))
+    {
+        result = MTB_BLOCK_STORAGE_BUSY;
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_nvm_ect_program
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_nvm_ect_program(uint32_t addr, uint32_t length,
+                                                    const uint8_t* buf, uint32_t prog_size)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint32_t row = 0;
+
+    for (uint32_t done = 0; (result == CY_RSLT_SUCCESS) && (done < length); done += row)
+    {
+        result = _mtb_block_storage_nvm_ect_start_row(addr + done, length - done, &buf[done],
+                                                      prog_size, true, &row);
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_nvm_is_work_flash
+//--------------------------------------------------------------------------------------------------
+static inline bool _mtb_block_storage_nvm_is_work_flash(uint32_t addr, uint32_t length)
+{
+    return (addr >= CY_WFLASH_BASE) && ((addr - CY_WFLASH_BASE) < CY_WFLASH_SIZE) &&
+           (length <= (CY_WFLASH_SIZE - (addr - CY_WFLASH_BASE)));
+}
+
+
+#endif // if (CPUSS_FLASHC_ECT == 1)
+#if defined(MTB_BLOCK_STORAGE_NON_BLOCKING_SUPPORTED)
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_nvm_start_row
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_nvm_start_row(_mtb_block_storage_nvm_context_t* ctx,
+                                                  uint8_t operation, uint32_t addr,
+                                                  const uint8_t* buf)
+{
+    cy_rslt_t result;
+    ctx->nb_row = ctx->nb_step;
+    if (_MTB_BLOCK_STORAGE_NVM_NB_PROGRAM == operation)
+    {
+        #if (CPUSS_FLASHC_ECT == 1)
+        //Only the non blocking operations start work flash rows here, the widest row that fits
+        result = _mtb_block_storage_nvm_ect_start_row(addr, ctx->nb_end - addr, buf, ctx->nb_step,
+                                                      false, &ctx->nb_row);
+        #elif (CYHAL_DRIVER_AVAILABLE_NVM)
+        result = cyhal_nvm_start_program(ctx->hal_obj, addr, (const uint32_t*)buf);
+        #else
+        result = cyhal_flash_start_program(ctx->hal_obj, addr, (const uint32_t*)buf);
+        #endif
+    }
+    else
+    {
+        #if (CYHAL_DRIVER_AVAILABLE_NVM)
+        result = cyhal_nvm_start_erase(ctx->hal_obj, addr);
+        #else
+        result = cyhal_flash_start_erase(ctx->hal_obj, addr);
+        #endif
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_nvm_row_status
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_nvm_row_status(_mtb_block_storage_nvm_context_t* ctx,
+                                                   uint8_t operation)
+{
+    cy_rslt_t result;
+    #if (CPUSS_FLASHC_ECT == 1)
+    if (_MTB_BLOCK_STORAGE_NVM_NB_PROGRAM == operation)
+    {
+        result = _mtb_block_storage_nvm_ect_row_status();
+    }
+    else
+    #else
+    CY_UNUSED_PARAMETER(operation);
+    #endif
+    {
+        #if (CYHAL_DRIVER_AVAILABLE_NVM)
+        result = cyhal_nvm_is_operation_complete(ctx->hal_obj) ? CY_RSLT_SUCCESS :
+                 MTB_BLOCK_STORAGE_BUSY;
+        #else
+        result = cyhal_flash_is_operation_complete(ctx->hal_obj) ? CY_RSLT_SUCCESS :
+                 MTB_BLOCK_STORAGE_BUSY;
+        #endif
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_nvm_start
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_nvm_start(_mtb_block_storage_nvm_context_t* ctx,
+                                              uint8_t operation, uint32_t addr, uint32_t length,
+                                              const uint8_t* buf, bool blocking)
+{
+    const _mtb_block_storage_nvm_region_t* region =
+        _mtb_block_storage_nvm_find_region(ctx, addr, length);
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint32_t step = 0;
+
+    if (NULL == region)
+    {
+        result = MTB_BLOCK_STORAGE_NOT_IN_RANGE_ERROR;
+    }
+    else
+    {
+        uint8_t shift = (_MTB_BLOCK_STORAGE_NVM_NB_PROGRAM == operation)
+            ? region->program_shift : region->erase_shift;
+        step = (_MTB_BLOCK_STORAGE_NVM_NB_PROGRAM == operation)
+            ? region->program_size : region->erase_size;
+        if ((0u == length) || !_mtb_block_storage_nvm_is_multiple(length, step, shift))
+        {
+            result = MTB_BLOCK_STORAGE_INVALID_SIZE_ERROR;
+        }
+    }
+
+    if (result == CY_RSLT_SUCCESS)
+    {
+        //The operation is claimed, described and its first row started in one critical section,
+        //as poll, which can be called from an interrupt, uses all of it once it is claimed. The
+        //following rows are started by poll.
+        uint32_t state = cyhal_system_critical_section_enter();
+        if (_MTB_BLOCK_STORAGE_NVM_NB_IDLE != ctx->nb_operation)
+        {
+            result = MTB_BLOCK_STORAGE_BUSY;
+        }
+        else
+        {
+            ctx->nb_addr = addr;
+            ctx->nb_end = addr + length;
+            ctx->nb_step = step;
+            ctx->nb_buf = buf;
+            ctx->nb_bank = region->bank;
+            ctx->nb_blocking = blocking;
+            result = _mtb_block_storage_nvm_start_row(ctx, operation, addr, buf);
+            ctx->nb_result = (result == CY_RSLT_SUCCESS) ? MTB_BLOCK_STORAGE_BUSY : result;
+            if (result == CY_RSLT_SUCCESS)
+            {
+                ctx->nb_operation = operation;
+            }
+        }
+        cyhal_system_critical_section_exit(state);
+    }
+    return result;
+}
+
+
+#endif // defined(MTB_BLOCK_STORAGE_NON_BLOCKING_SUPPORTED)
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_nvm_poll
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t mtb_block_storage_nvm_poll(void* context)
+{
+    #if !defined(MTB_BLOCK_STORAGE_NON_BLOCKING_SUPPORTED)
+    CY_UNUSED_PARAMETER(context);
+    return CY_RSLT_SUCCESS;
+    #else // if !defined(MTB_BLOCK_STORAGE_NON_BLOCKING_SUPPORTED)
+    _mtb_block_storage_nvm_context_t* ctx = (_mtb_block_storage_nvm_context_t*)context;
+    cy_rslt_t result = MTB_BLOCK_STORAGE_BUSY;
+    bool finished = false;
+    bool notify = false;
+
+    //The step is claimed in a critical section so that poll can be called both from the
+    //application and from an interrupt
+    uint32_t state = cyhal_system_critical_section_enter();
+    if (_MTB_BLOCK_STORAGE_NVM_NB_IDLE == ctx->nb_operation)
+    {
+        result = ctx->nb_result;
+    }
+    else
+    {
+        cy_rslt_t row_result = _mtb_block_storage_nvm_row_status(ctx, ctx->nb_operation);
+        if (row_result == CY_RSLT_SUCCESS)
+        {
+            ctx->nb_addr += ctx->nb_row;
+            if (_MTB_BLOCK_STORAGE_NVM_NB_PROGRAM == ctx->nb_operation)
+            {
+                ctx->nb_buf += ctx->nb_row;
+            }
+            if (ctx->nb_addr < ctx->nb_end)
+            {
+                row_result = _mtb_block_storage_nvm_start_row(ctx, ctx->nb_operation,
+                                                              ctx->nb_addr, ctx->nb_buf);
+                finished = (row_result != CY_RSLT_SUCCESS);
+            }
+            else
+            {
+                finished = true;
+            }
+        }
+        else if (row_result != MTB_BLOCK_STORAGE_BUSY)
+        {
+            //The row failed
+            finished = true;
+        }
+        if (finished)
+        {
+            result = row_result;
+            //Mark the device as idle before leaving the critical section, the callback is
+            //invoked outside of it
+            ctx->nb_result = result;
+            ctx->nb_operation = _MTB_BLOCK_STORAGE_NVM_NB_IDLE;
+            //Only the operations started by program_nb and erase_nb are reported
+            notify = !ctx->nb_blocking;
+        }
+    }
+    cyhal_system_critical_section_exit(state);
+
+    if (notify && (NULL != ctx->callback))
+    {
+        ctx->callback(ctx->callback_arg, result);
+    }
+    return result;
+    #endif // if !defined(MTB_BLOCK_STORAGE_NON_BLOCKING_SUPPORTED)
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_nvm_complete
+//--------------------------------------------------------------------------------------------------
+static inline void _mtb_block_storage_nvm_complete(_mtb_block_storage_nvm_context_t* ctx)
+{
+    #if defined(MTB_BLOCK_STORAGE_NON_BLOCKING_SUPPORTED)
+    //Blocking operations finish the non blocking one first, as the NVM can only do one operation
+    //at a time and cannot be read while it is busy
+    while (mtb_block_storage_nvm_poll(ctx) == MTB_BLOCK_STORAGE_BUSY)
+    {
+    }
+    #else
+    CY_UNUSED_PARAMETER(ctx);
+    #endif
+}
+
+
+#if defined(MTB_BLOCK_STORAGE_NON_BLOCKING_SUPPORTED)
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_nvm_run
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_nvm_run(_mtb_block_storage_nvm_context_t* ctx,
+                                            uint8_t operation, uint32_t addr, uint32_t length,
+                                            const uint8_t* buf)
+{
+    //The rows are started and polled rather than written by the blocking HAL function, so that
+    //interrupts and other threads keep running, and can read the other banks, meanwhile. The
+    //operation is claimed like a non blocking one, so that a read of its bank waits for it and no
+    //other operation is started until it completes.
+    cy_rslt_t result = _mtb_block_storage_nvm_start(ctx, operation, addr, length, buf, true);
+    while (result == MTB_BLOCK_STORAGE_BUSY)
+    {
+        //A non blocking operation was started by another thread in the meantime
+        _mtb_block_storage_nvm_complete(ctx);
+        result = _mtb_block_storage_nvm_start(ctx, operation, addr, length, buf, true);
+    }
+    if (result == CY_RSLT_SUCCESS)
+    {
+        result = MTB_BLOCK_STORAGE_BUSY;
+        while (result == MTB_BLOCK_STORAGE_BUSY)
+        {
+            result = mtb_block_storage_nvm_poll(ctx);
+        }
+    }
+    return result;
+}
+
+
+#endif // defined(MTB_BLOCK_STORAGE_NON_BLOCKING_SUPPORTED)
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_nvm_complete_for_read
+//--------------------------------------------------------------------------------------------------
+static inline void _mtb_block_storage_nvm_complete_for_read(_mtb_block_storage_nvm_context_t* ctx,
+                                                            uint32_t addr, uint32_t length)
+{
+    #if defined(MTB_BLOCK_STORAGE_NON_BLOCKING_SUPPORTED)
+    //In read while write mode, only a read of the bank being written waits for the operation
+    const _mtb_block_storage_nvm_region_t* region =
+        (0u != (ctx->options & MTB_BLOCK_STORAGE_OPTION_READ_WHILE_WRITE))
+        ? _mtb_block_storage_nvm_find_region(ctx, addr, length) : NULL;
+    if ((NULL == region) || (region->bank == ctx->nb_bank))
+    {
+        _mtb_block_storage_nvm_complete(ctx);
+    }
+    #else
+    CY_UNUSED_PARAMETER(addr);
+    CY_UNUSED_PARAMETER(length);
+    _mtb_block_storage_nvm_complete(ctx);
+    #endif
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_nvm_read_size
+//--------------------------------------------------------------------------------------------------
+static uint32_t mtb_block_storage_nvm_read_size(void* context, uint32_t addr)
+{
+    CY_UNUSED_PARAMETER(context);
+    CY_UNUSED_PARAMETER(addr);
+    //Read operation is based on direct memory access so read size is always one 32-bit word.
+    return 1;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_nvm_program_size
+//--------------------------------------------------------------------------------------------------
+static uint32_t mtb_block_storage_nvm_program_size(void* context, uint32_t addr)
+{
+    const _mtb_block_storage_nvm_region_t* region =
+        _mtb_block_storage_nvm_find_region((_mtb_block_storage_nvm_context_t*)context, addr, 0);
+    return (NULL != region) ? region->program_size : 0u;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_nvm_erase_size
+//--------------------------------------------------------------------------------------------------
+static uint32_t mtb_block_storage_nvm_erase_size(void* context, uint32_t addr)
+{
+    const _mtb_block_storage_nvm_region_t* region =
+        _mtb_block_storage_nvm_find_region((_mtb_block_storage_nvm_context_t*)context, addr, 0);
+    return (NULL != region) ? region->erase_size : 0u;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_nvm_erase_value
+//--------------------------------------------------------------------------------------------------
+static uint8_t mtb_block_storage_nvm_erase_value(void* context, uint32_t addr)
+{
+    const _mtb_block_storage_nvm_region_t* region =
+        _mtb_block_storage_nvm_find_region((_mtb_block_storage_nvm_context_t*)context, addr, 0);
+    return (NULL != region) ? region->erase_value : 0u;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_nvm_hal_read
+//--------------------------------------------------------------------------------------------------
+static inline cy_rslt_t _mtb_block_storage_nvm_hal_read(mtb_block_storage_nvm_t* hal_obj,
+                                                        uint32_t addr, uint32_t length,
+                                                        uint8_t* buf)
+{
+    #if (MTB_HAL_DRIVER_AVAILABLE_NVM)
+    return mtb_hal_nvm_read(hal_obj, addr, buf, length);
+    #elif (CYHAL_DRIVER_AVAILABLE_NVM)
+    return cyhal_nvm_read(hal_obj, addr, buf, length);
+    #else // if (CYHAL_DRIVER_AVAILABLE_NVM)
+    return cyhal_flash_read(hal_obj, addr, buf, length);
+    #endif // if (CYHAL_DRIVER_AVAILABLE_NVM)
+}
 
-/** Find the nvm region based on given address and length.
- * If "length is zero and address is not in any nvm region" or
- * if "length is not zero and address is not in any nvm region" or
- * if "length is not zero and address is one nvm region but address + length goes into another
- * nvm region", the function will return Null.
- *
- * @param[in] obj The nvm object
- * @param[in] addr The start address of the region to check
- * @param[in] length The length to check
- * @return pointer, mtb_block_storage_nvm_region_info_t, to region info
- */
-const mtb_block_storage_nvm_region_info_t* mtb_block_storage_nvm_get_region_for_address(
-    mtb_block_storage_nvm_t* obj, uint32_t addr,
-    uint32_t length)
-{
-    #if !defined(CYHAL_API_AVAILABLE_NVM_GET_REGION_FOR_ADDRESS)
-    mtb_block_storage_nvm_info_t nvm_info;
-    #if defined(MTB_BLOCK_STORAGE_FLASH_SUPPORT)
-    cyhal_flash_get_info(obj, &nvm_info);
 
-    for (uint32_t block = 0; block < nvm_info.block_count; block++)
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_nvm_row_matches
+//--------------------------------------------------------------------------------------------------
+static bool _mtb_block_storage_nvm_row_matches(_mtb_block_storage_nvm_context_t* ctx,
+                                               const _mtb_block_storage_nvm_region_t* region,
+                                               uint32_t addr, const uint8_t* buf,
+                                               uint32_t length)
+{
+    uint8_t current[_MTB_BLOCK_STORAGE_NVM_COMPARE_CHUNK];
+    bool matches = true;
+    uint32_t read_length = length;
+
+    #if (CPUSS_FLASHC_ECT == 1)
+    //Erased work flash reads with ECC errors, so the flash controller checks the row first and it
+    //is only read once found programmed. An erased row holds the data if it is the erase value.
+    //The rows are programmed whole, so a row is either erased or programmed. The code flash is
+    //read and compared as is.
+    cy_stc_flash_blankcheck_config_t config;
+    config.addrToBeChecked = (uint32_t*)(uintptr_t)addr;
+    config.numOfWordsToBeChecked = length / sizeof(uint32_t);
+    if (_mtb_block_storage_nvm_is_work_flash(addr, length) &&
+        (Cy_Flash_BlankCheck(&config, CY_FLASH_DRIVER_BLOCKING) == CY_FLASH_DRV_SUCCESS))
     {
-        if (((addr >= nvm_info.blocks[block].start_address) &&
-             (addr < (nvm_info.blocks[block].start_address + nvm_info.blocks[block].size)) &&
-             (addr + length <=
-              (nvm_info.blocks[block].start_address + nvm_info.blocks[block].size)))
-            )
+        for (uint32_t offset = 0; matches && (offset < length); offset++)
         {
-            return (mtb_block_storage_nvm_region_info_t*)&nvm_info.blocks[block];
+            matches = (buf[offset] == region->erase_value);
         }
+        read_length = 0;
     }
+    #else
+    CY_UNUSED_PARAMETER(region);
+    #endif // if (CPUSS_FLASHC_ECT == 1)
 
-    #else // if defined(MTB_BLOCK_STORAGE_FLASH_SUPPORT)
-    cyhal_nvm_get_info(obj, &nvm_info);
-
-    for (uint32_t region = 0; region < nvm_info.region_count; region++)
+    for (uint32_t offset = 0; matches && (offset < read_length); offset += sizeof(current))
     {
-        if (((addr >= nvm_info.regions[region].start_address) &&
-             (addr < (nvm_info.regions[region].start_address + nvm_info.regions[region].size)) &&
-             (addr + length <=
-              (nvm_info.regions[region].start_address + nvm_info.regions[region].size)))
-            )
-        {
-            return (mtb_block_storage_nvm_region_info_t*)&nvm_info.regions[region];
-        }
+        uint32_t chunk = ((length - offset) < sizeof(current)) ? (length - offset) :
+                         sizeof(current);
+        matches = (CY_RSLT_SUCCESS ==
+                   _mtb_block_storage_nvm_hal_read(ctx->hal_obj, addr + offset, chunk, current)) &&
+                  (0 == memcmp(current, &buf[offset], chunk));
     }
-    #endif // if defined(MTB_BLOCK_STORAGE_FLASH_SUPPORT)
-    return NULL;
-    #else // if !defined(CYHAL_API_AVAILABLE_NVM_GET_REGION_FOR_ADDRESS)
-    return (mtb_block_storage_nvm_region_info_t*)cyhal_nvm_get_region_for_address((cyhal_nvm_t*)obj,
-                                                                                  addr, length);
-    #endif // if !defined(CYHAL_API_AVAILABLE_NVM_GET_REGION_FOR_ADDRESS)
+    return matches;
 }
 
 
-#else // if defined(CY_USING_HAL) || defined(CY_USING_HAL_LITE)
-
-
-#include "mtb_hal.h"
-
-typedef mtb_hal_nvm_region_info_t mtb_block_storage_nvm_region_info_t;
-typedef mtb_hal_nvm_t             mtb_block_storage_nvm_t;
-typedef mtb_hal_nvm_info_t        mtb_block_storage_nvm_info_t;
-
-/** Deprecated, for backwards compatibility */
-#define mtb_block_storage_nvm_get_region_for_address mtb_hal_nvm_get_region_for_address
-
-#define MTB_BLOCK_STORAGE_NVM_SUPPORT
-
-#endif // if defined(CY_USING_HAL) || defined(CY_USING_HAL_LITE)
-
-#if (CPUSS_FLASHC_ECT == 1)
-static cy_rslt_t WorkFlashProgramRow(
-    const uint32_t* addr,
-    const uint32_t* data,
-    uint32_t prog_size);
-#endif
 //--------------------------------------------------------------------------------------------------
-// mtb_block_storage_nvm_read_size
+// mtb_block_storage_nvm_read
 //--------------------------------------------------------------------------------------------------
-static uint32_t mtb_block_storage_nvm_read_size(void* context, uint32_t addr)
+cy_rslt_t mtb_block_storage_nvm_read(void* context, uint32_t addr, uint32_t length, uint8_t* buf)
 {
-    CY_UNUSED_PARAMETER(context);
-    CY_UNUSED_PARAMETER(addr);
-    //Read operation is based on direct memory access so read size is always one 32-bit word.
-    return 1;
+    uint32_t trace = MTB_BLOCK_STORAGE_TRACE_BEGIN(MTB_BLOCK_STORAGE_TRACE_READ, context, addr,
+                                                   length);
+    cy_rslt_t result;
+    _mtb_block_storage_nvm_complete_for_read((_mtb_block_storage_nvm_context_t*)context, addr,
+                                             length);
+    result = _mtb_block_storage_nvm_hal_read(
+        ((_mtb_block_storage_nvm_context_t*)context)->hal_obj, addr, length, buf);
+    MTB_BLOCK_STORAGE_TRACE_END(trace, result);
+    return result;
 }
 
 
+#if (CPUSS_FLASHC_ECT == 1)
 //--------------------------------------------------------------------------------------------------
-// mtb_block_storage_nvm_program_size
+// _mtb_block_storage_nvm_ect_program_run
 //--------------------------------------------------------------------------------------------------
-static uint32_t mtb_block_storage_nvm_program_size(void* context, uint32_t addr)
+static cy_rslt_t _mtb_block_storage_nvm_ect_program_run(_mtb_block_storage_nvm_context_t* ctx,
+                                                        uint32_t addr, uint32_t length,
+                                                        const uint8_t* buf, uint32_t prog_size)
 {
-    uint32_t programSize = 0;
-
-    const mtb_block_storage_nvm_region_info_t* region_info =
-        mtb_block_storage_nvm_get_region_for_address(
-            (mtb_block_storage_nvm_t*)context, addr, 0);
-    if (NULL != region_info)
-    {
-        //For Flash NVM block size represents the minimum programmable size and sector size
-        //represents the minimum erasable size. As they do not always match, it is necessary to
-        // use the bigger
-        //metric so that program and erase are performed on the same area.
-        //However for RRAM NVM where we don't have an erase operation, block size represents the
-        // actual
-        //minimum programmable size and sector size represents the overall physical
-        // sectorization of the memory.
-        //For this reason we need to select different measures for this function based on the
-        // memory type.
-        #if defined(MTB_BLOCK_STORAGE_NVM_SUPPORT)
-        if (region_info->nvm_type == MTB_HAL_NVM_TYPE_RRAM)
-        {
-            programSize = (region_info->block_size);
-        }
-        else
-        #endif // defined(MTB_BLOCK_STORAGE_NVM_SUPPORT)
-        {
-            #if (CYHAL_DRIVER_AVAILABLE_NVM) || (MTB_HAL_DRIVER_AVAILABLE_NVM)
-            programSize = region_info->block_size;
-            #elif (CYHAL_DRIVER_AVAILABLE_FLASH)
-            programSize = region_info->sector_size;
-            #endif /* (CYHAL_DRIVER_AVAILABLE_NVM) || (MTB_HAL_DRIVER_AVAILABLE_NVM)*/
-        }
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    #if defined(MTB_BLOCK_STORAGE_NON_BLOCKING_SUPPORTED)
+    if ((0u != length) && (0u != (ctx->options & MTB_BLOCK_STORAGE_OPTION_READ_WHILE_WRITE)))
+    {
+        result = _mtb_block_storage_nvm_run(ctx, _MTB_BLOCK_STORAGE_NVM_NB_PROGRAM, addr, length,
+                                            buf);
     }
-    return programSize;
+    else
+    #else
+    CY_UNUSED_PARAMETER(ctx);
+    #endif
+    {
+        result = _mtb_block_storage_nvm_ect_program(addr, length, buf, prog_size);
+    }
+    return result;
 }
 
 
+#endif // if (CPUSS_FLASHC_ECT == 1)
 //--------------------------------------------------------------------------------------------------
-// mtb_block_storage_nvm_erase_size
+// _mtb_block_storage_nvm_program_rows
 //--------------------------------------------------------------------------------------------------
-static uint32_t mtb_block_storage_nvm_erase_size(void* context, uint32_t addr)
+static cy_rslt_t _mtb_block_storage_nvm_program_rows(_mtb_block_storage_nvm_context_t* ctx,
+                                                     const _mtb_block_storage_nvm_region_t* region,
+                                                     uint32_t addr, uint32_t length,
+                                                     const uint8_t* buf)
 {
-    uint32_t eraseSize = 0;
-
-    const mtb_block_storage_nvm_region_info_t* region_info =
-        mtb_block_storage_nvm_get_region_for_address(
-            (mtb_block_storage_nvm_t*)context, addr, 0);
-    if (NULL != region_info)
-    {
-        //For Flash NVM block size represents the minimum programmable size and sector size
-        //represents the minimum erasable size. However for RRAM NVM where we don't
-        //have an erase operation, block size represents the actual minimum programmable size
-        //and sector size represents the overal physical sectorization of the memory.
-        //For this reason we need to select different measures for this function based on the
-        //memory type.
-        #if defined(MTB_BLOCK_STORAGE_NVM_SUPPORT)
-        if (region_info->nvm_type == MTB_HAL_NVM_TYPE_RRAM)
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint32_t prog_size = region->program_size;
+    bool compare = (0u != (ctx->options & MTB_BLOCK_STORAGE_OPTION_COMPARE_BEFORE_PROGRAM));
+
+    #if (CPUSS_FLASHC_ECT == 1)
+    //The rows to program are gathered into runs, each programmed with the widest work flash rows
+    //its alignment and length allow; only the rows that already hold the data split a run
+    uint32_t run = addr;
+    for (uint32_t loc = addr; compare && (result == CY_RSLT_SUCCESS) && (loc < addr + length);
+         loc += prog_size)
+    {
+        if (_mtb_block_storage_nvm_row_matches(ctx, region, loc, &buf[loc - addr], prog_size))
         {
-            eraseSize = (region_info->block_size);
+            result = _mtb_block_storage_nvm_ect_program_run(ctx, run, loc - run,
+                                                            &buf[run - addr], prog_size);
+            run = loc + prog_size;
         }
-        else
-        #endif // defined (MTB_BLOCK_STORAGE_NVM_SUPPORT)
+    }
+    if (result == CY_RSLT_SUCCESS)
+    {
+        result = _mtb_block_storage_nvm_ect_program_run(ctx, run, addr + length - run,
+                                                        &buf[run - addr], prog_size);
+    }
+    #else // if (CPUSS_FLASHC_ECT == 1)
+    for (uint32_t loc = addr; result == CY_RSLT_SUCCESS && loc < addr + length;
+         loc += prog_size, buf += prog_size)
+    {
+        if (compare && _mtb_block_storage_nvm_row_matches(ctx, region, loc, buf, prog_size))
+        {
+            continue;
+        }
+        #if defined(MTB_BLOCK_STORAGE_NON_BLOCKING_SUPPORTED)
+        if (0u != (ctx->options & MTB_BLOCK_STORAGE_OPTION_READ_WHILE_WRITE))
         {
-            eraseSize = region_info->sector_size;
+            result = _mtb_block_storage_nvm_run(ctx, _MTB_BLOCK_STORAGE_NVM_NB_PROGRAM, loc,
+                                                prog_size, buf);
+            continue;
         }
+        #endif
+        #if (MTB_HAL_DRIVER_AVAILABLE_NVM)
+        result = mtb_hal_nvm_program(ctx->hal_obj, loc, (const uint32_t*)buf);
+        #elif (CYHAL_DRIVER_AVAILABLE_NVM)
+        result = cyhal_nvm_program(ctx->hal_obj, loc, (const uint32_t*)buf);
+        #else // if (CYHAL_DRIVER_AVAILABLE_NVM)
+        result = cyhal_flash_program(ctx->hal_obj, loc, (const uint32_t*)buf);
+        #endif // if (CYHAL_DRIVER_AVAILABLE_NVM)
     }
-
-    return eraseSize;
+    #endif // if (CPUSS_FLASHC_ECT == 1)
+    return result;
 }
 
 
 //--------------------------------------------------------------------------------------------------
-// mtb_block_storage_nvm_erase_value
+// mtb_block_storage_nvm_program
 //--------------------------------------------------------------------------------------------------
-static uint8_t mtb_block_storage_nvm_erase_value(void* context, uint32_t addr)
+cy_rslt_t mtb_block_storage_nvm_program(void* context, uint32_t addr, uint32_t length,
+                                        const uint8_t* buf)
 {
-    uint8_t eraseValue = 0;
-
-    const mtb_block_storage_nvm_region_info_t* region_info =
-        mtb_block_storage_nvm_get_region_for_address(
-            (mtb_block_storage_nvm_t*)context, addr, 0);
+    _mtb_block_storage_nvm_context_t* ctx = (_mtb_block_storage_nvm_context_t*)context;
+    //The whole area must be in one region, whose program and erase sizes apply to all of it
+    const _mtb_block_storage_nvm_region_t* region =
+        _mtb_block_storage_nvm_find_region(ctx, addr, length);
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint32_t trace = MTB_BLOCK_STORAGE_TRACE_BEGIN(MTB_BLOCK_STORAGE_TRACE_PROGRAM, context, addr,
+                                                   length);
 
-    if (NULL != region_info)
+    if (NULL == region)
+    {
+        result = MTB_BLOCK_STORAGE_NOT_IN_RANGE_ERROR;
+    }
+    else if (!_mtb_block_storage_nvm_is_multiple(length, region->program_size,
+                                                 region->program_shift))
     {
-        eraseValue = region_info->erase_value;
+        result = MTB_BLOCK_STORAGE_INVALID_SIZE_ERROR;
     }
 
-    return eraseValue;
+    if (result == CY_RSLT_SUCCESS)
+    {
+        _mtb_block_storage_nvm_complete(ctx);
+        result = _mtb_block_storage_nvm_program_rows(ctx, region, addr, length, buf);
+    }
+    MTB_BLOCK_STORAGE_TRACE_END(trace, result);
+    return result;
 }
 
 
 //--------------------------------------------------------------------------------------------------
-// mtb_block_storage_nvm_read
+// mtb_block_storage_nvm_readv
 //--------------------------------------------------------------------------------------------------
-static cy_rslt_t mtb_block_storage_nvm_read(void* context, uint32_t addr, uint32_t length,
-                                            uint8_t* buf)
+static cy_rslt_t mtb_block_storage_nvm_readv(void* context,
+                                             const mtb_block_storage_read_vec_t* vecs,
+                                             uint32_t count)
 {
-    #if (MTB_HAL_DRIVER_AVAILABLE_NVM)
-    return mtb_hal_nvm_read((mtb_hal_nvm_t*)context, addr, buf, length);
-    #elif (CYHAL_DRIVER_AVAILABLE_NVM)
-    return cyhal_nvm_read((cyhal_nvm_t*)context, addr, buf, length);
-    #else // if (CYHAL_DRIVER_AVAILABLE_NVM)
-    return cyhal_flash_read((cyhal_flash_t*)context, addr, buf, length);
-    #endif // if (CYHAL_DRIVER_AVAILABLE_NVM)
+    _mtb_block_storage_nvm_context_t* ctx = (_mtb_block_storage_nvm_context_t*)context;
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    for (uint32_t i = 0; (result == CY_RSLT_SUCCESS) && (i < count); i++)
+    {
+        uint32_t trace = MTB_BLOCK_STORAGE_TRACE_BEGIN(MTB_BLOCK_STORAGE_TRACE_READ, context,
+                                                       vecs[i].addr, vecs[i].length);
+        //Only waits for the first fragment, unless a fragment is in a bank being written
+        _mtb_block_storage_nvm_complete_for_read(ctx, vecs[i].addr, vecs[i].length);
+        result = _mtb_block_storage_nvm_hal_read(ctx->hal_obj, vecs[i].addr, vecs[i].length,
+                                                 vecs[i].buf);
+        MTB_BLOCK_STORAGE_TRACE_END(trace, result);
+    }
+    return result;
 }
 
 
 //--------------------------------------------------------------------------------------------------
-// mtb_block_storage_nvm_program
+// mtb_block_storage_nvm_programv
 //--------------------------------------------------------------------------------------------------
-static cy_rslt_t mtb_block_storage_nvm_program(void* context, uint32_t addr, uint32_t length,
-                                               const uint8_t* buf)
+static cy_rslt_t mtb_block_storage_nvm_programv(void* context,
+                                                const mtb_block_storage_program_vec_t* vecs,
+                                                uint32_t count)
 {
-    uint32_t prog_size = mtb_block_storage_nvm_program_size(context, addr);
+    _mtb_block_storage_nvm_context_t* ctx = (_mtb_block_storage_nvm_context_t*)context;
+    const _mtb_block_storage_nvm_region_t* region = NULL;
     cy_rslt_t result = CY_RSLT_SUCCESS;
 
-    if ((0 != (length % prog_size)))
+    //The whole batch is checked before anything is programmed. The fragments of a batch are
+    //usually in the same region, which is only looked up again when a fragment leaves it.
+    for (uint32_t i = 0; (result == CY_RSLT_SUCCESS) && (i < count); i++)
     {
-        result = MTB_BLOCK_STORAGE_INVALID_SIZE_ERROR;
+        if ((NULL == region) ||
+            !_mtb_block_storage_nvm_region_contains(region, vecs[i].addr, vecs[i].length))
+        {
+            region = _mtb_block_storage_nvm_find_region(ctx, vecs[i].addr, vecs[i].length);
+        }
+        if (NULL == region)
+        {
+            result = MTB_BLOCK_STORAGE_NOT_IN_RANGE_ERROR;
+        }
+        else if (!_mtb_block_storage_nvm_is_multiple(vecs[i].length, region->program_size,
+                                                     region->program_shift))
+        {
+            result = MTB_BLOCK_STORAGE_INVALID_SIZE_ERROR;
+        }
     }
 
-    if (result == CY_RSLT_SUCCESS)
+    if ((result == CY_RSLT_SUCCESS) && (0u != count))
     {
-        for (uint32_t loc = addr; result == CY_RSLT_SUCCESS && loc < addr + length;
-             loc += prog_size, buf += prog_size)
+        _mtb_block_storage_nvm_complete(ctx);
+    }
+    for (uint32_t i = 0; (result == CY_RSLT_SUCCESS) && (i < count); i++)
+    {
+        uint32_t trace = MTB_BLOCK_STORAGE_TRACE_BEGIN(MTB_BLOCK_STORAGE_TRACE_PROGRAM, context,
+                                                       vecs[i].addr, vecs[i].length);
+        if (!_mtb_block_storage_nvm_region_contains(region, vecs[i].addr, vecs[i].length))
         {
-            #if (CPUSS_FLASHC_ECT == 1)
-            result = WorkFlashProgramRow((uint32_t*)loc, (const uint32_t*)buf, prog_size);
-            #else // if (CPUSS_FLASHC_ECT == 1)
-            #if (MTB_HAL_DRIVER_AVAILABLE_NVM)
-            result = mtb_hal_nvm_program((mtb_hal_nvm_t*)context, loc, (const uint32_t*)buf);
-            #elif (CYHAL_DRIVER_AVAILABLE_NVM)
-            result = cyhal_nvm_program((cyhal_nvm_t*)context, loc, (const uint32_t*)buf);
-            #else // if (CYHAL_DRIVER_AVAILABLE_NVM)
-            result = cyhal_flash_program((cyhal_flash_t*)context, loc, (const uint32_t*)buf);
-            #endif // if (CYHAL_DRIVER_AVAILABLE_NVM)
-            #endif // if (CPUSS_FLASHC_ECT == 1)
+            region = _mtb_block_storage_nvm_find_region(ctx, vecs[i].addr, vecs[i].length);
         }
+        result = _mtb_block_storage_nvm_program_rows(ctx, region, vecs[i].addr, vecs[i].length,
+                                                     vecs[i].buf);
+        MTB_BLOCK_STORAGE_TRACE_END(trace, result);
     }
     return result;
 }
 
 
-#if (CPUSS_FLASHC_ECT == 1)
-/*******************************************************************************
-* Function Name: WorkFlashProgramRow
-****************************************************************************//**
-*
-* Programs XMC7xxx Work Flash Sector from address provided
-*
-* \param addr
-* The XMC7xxx Work Flash Sector from addr
-*
-* \param data
-* The data to be programmed into the Work Flash Sector
-*
-* \param prog_size
-* The device's program size, needed to determine program row data size in bits
-*
-*******************************************************************************/
-static cy_rslt_t WorkFlashProgramRow(const uint32_t* addr, const uint32_t* data, uint32_t prog_size)
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_nvm_map
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t mtb_block_storage_nvm_map(void* context, uint32_t addr, uint32_t length,
+                                           const uint8_t** ptr)
 {
-    cy_rslt_t result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
-    cy_stc_flash_programrow_config_t config;
-    cy_en_flashdrv_status_t status = CY_FLASH_DRV_SUCCESS;
-    const uint32_t* cur_addr = (uint32_t*)addr;
-    const uint32_t* cur_data = (uint32_t*)data;
-
-    cy_en_flash_programrow_datasize_t prog_data_size;
-    uint32_t page_increase = 0;
-    bool found_prog_data_size = false;
-    switch (prog_size)
-    {
-        case 128:
-            prog_data_size = CY_FLASH_PROGRAMROW_DATA_SIZE_1024BIT;
-            found_prog_data_size = true;
-            page_increase = 128;
-            break;
-
-        case 2048:
-            prog_data_size = CY_FLASH_PROGRAMROW_DATA_SIZE_4096BIT;
-            found_prog_data_size = true;
-            page_increase = 512;
-            break;
-
-        case 4:
-            prog_data_size = CY_FLASH_PROGRAMROW_DATA_SIZE_32BIT;
-            found_prog_data_size = true;
-            page_increase = 4;
-            break;
+    _mtb_block_storage_nvm_context_t* ctx = (_mtb_block_storage_nvm_context_t*)context;
+    cy_rslt_t result = CY_RSLT_SUCCESS;
 
-        default:
-            found_prog_data_size = false;
-            break;
+    if (NULL == _mtb_block_storage_nvm_find_region(ctx, addr, length))
+    {
+        result = MTB_BLOCK_STORAGE_NOT_IN_RANGE_ERROR;
     }
-
-    if (found_prog_data_size)
+    else
     {
-        config.blocking  =   CY_FLASH_PROGRAMROW_BLOCKING;
-        config.skipBC    =   CY_FLASH_PROGRAMROW_SKIP_BLANK_CHECK;
-        config.dataSize  =   prog_data_size;
-        config.dataLoc   =   CY_FLASH_PROGRAMROW_DATA_LOCATION_SRAM;
-        config.intrMask  =   CY_FLASH_PROGRAMROW_SET_INTR_MASK;
-
-        for (uint32_t cur_pg_size = 0; cur_pg_size < prog_size; cur_pg_size += page_increase)
-        {
-            config.destAddr  =   cur_addr;
-            config.dataAddr  =   cur_data;
-            status = Cy_Flash_Program_WorkFlash(&config);
-
-            if (status != CY_FLASH_DRV_SUCCESS)
-            {
-                break;
-            }
-            cur_addr += page_increase /4;
-            cur_data += (page_increase / 4U);
-        }
-        result = (cy_rslt_t)status;
+        //The NVM is mapped at its addresses, it can be read in place once it is not busy
+        _mtb_block_storage_nvm_complete_for_read(ctx, addr, length);
+        *ptr = (const uint8_t*)(uintptr_t)addr;
     }
+    return result;
+}
+
 
-    return (result);
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_nvm_unmap
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t mtb_block_storage_nvm_unmap(void* context, const uint8_t* ptr, uint32_t length)
+{
+    CY_UNUSED_PARAMETER(context);
+    CY_UNUSED_PARAMETER(ptr);
+    CY_UNUSED_PARAMETER(length);
+    return CY_RSLT_SUCCESS;
 }
 
 
-#endif // if (CPUSS_FLASHC_ECT == 1)
 
 //--------------------------------------------------------------------------------------------------
 // mtb_block_storage_nvm_is_erase_required
@@ -380,19 +1145,13 @@ static bool mtb_block_storage_nvm_is_erase_required(void* context, uint32_t addr
 {
     bool isEraseRequired = true;
 
-    #if !defined(MTB_BLOCK_STORAGE_FLASH_SUPPORT)
-    const mtb_block_storage_nvm_region_info_t* region_info =
-        mtb_block_storage_nvm_get_region_for_address(
-            (mtb_block_storage_nvm_t*)context, addr, length);
-    if (NULL != region_info)
+    const _mtb_block_storage_nvm_region_t* region =
+        _mtb_block_storage_nvm_find_region((_mtb_block_storage_nvm_context_t*)context, addr,
+                                           length);
+    if (NULL != region)
     {
-        isEraseRequired = region_info->is_erase_required;
+        isEraseRequired = region->is_erase_required;
     }
-    #else // if !defined(MTB_BLOCK_STORAGE_FLASH_SUPPORT)
-    CY_UNUSED_PARAMETER(context);
-    CY_UNUSED_PARAMETER(addr);
-    CY_UNUSED_PARAMETER(length);
-    #endif // if !defined(MTB_BLOCK_STORAGE_FLASH_SUPPORT)
 
     return isEraseRequired;
 }
@@ -401,35 +1160,77 @@ static bool mtb_block_storage_nvm_is_erase_required(void* context, uint32_t addr
 //--------------------------------------------------------------------------------------------------
 // mtb_block_storage_nvm_erase
 //--------------------------------------------------------------------------------------------------
-static cy_rslt_t mtb_block_storage_nvm_erase(void* context, uint32_t addr, uint32_t length)
+cy_rslt_t mtb_block_storage_nvm_erase(void* context, uint32_t addr, uint32_t length)
 {
-    uint32_t erase_size = mtb_block_storage_nvm_erase_size(context, addr);
+    _mtb_block_storage_nvm_context_t* ctx = (_mtb_block_storage_nvm_context_t*)context;
+    //The whole area must be in one region, whose program and erase sizes apply to all of it
+    const _mtb_block_storage_nvm_region_t* region =
+        _mtb_block_storage_nvm_find_region(ctx, addr, length);
     cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint32_t trace = MTB_BLOCK_STORAGE_TRACE_BEGIN(MTB_BLOCK_STORAGE_TRACE_ERASE, context, addr,
+                                                   length);
 
-    if ((0 != (length % erase_size)))
+    if (NULL == region)
+    {
+        result = MTB_BLOCK_STORAGE_NOT_IN_RANGE_ERROR;
+    }
+    else if (!_mtb_block_storage_nvm_is_multiple(length, region->erase_size, region->erase_shift))
     {
         result = MTB_BLOCK_STORAGE_INVALID_SIZE_ERROR;
     }
 
     if (result == CY_RSLT_SUCCESS)
     {
+        _mtb_block_storage_nvm_complete(ctx);
+        uint32_t erase_size = region->erase_size;
         for (uint32_t loc = addr; result == CY_RSLT_SUCCESS && loc < addr + length;
              loc += erase_size)
         {
+            #if defined(MTB_BLOCK_STORAGE_NON_BLOCKING_SUPPORTED)
+            if (0u != (ctx->options & MTB_BLOCK_STORAGE_OPTION_READ_WHILE_WRITE))
+            {
+                result = _mtb_block_storage_nvm_run(ctx, _MTB_BLOCK_STORAGE_NVM_NB_ERASE, loc,
+                                                    erase_size, NULL);
+                continue;
+            }
+            #endif
             #if (MTB_HAL_DRIVER_AVAILABLE_NVM)
-            result = mtb_hal_nvm_erase((mtb_hal_nvm_t*)context, loc);
+            result = mtb_hal_nvm_erase(ctx->hal_obj, loc);
             #elif (CYHAL_DRIVER_AVAILABLE_NVM)
-            result = cyhal_nvm_erase((cyhal_nvm_t*)context, loc);
+            result = cyhal_nvm_erase(ctx->hal_obj, loc);
             #else // if (CYHAL_DRIVER_AVAILABLE_NVM)
-            result = cyhal_flash_erase((cyhal_flash_t*)context, loc);
+            result = cyhal_flash_erase(ctx->hal_obj, loc);
             #endif // if (CYHAL_DRIVER_AVAILABLE_NVM)
         }
     }
 
+    MTB_BLOCK_STORAGE_TRACE_END(trace, result);
     return result;
 }
 
 
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_nvm_register_callback
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t mtb_block_storage_nvm_register_callback(
+    void* context, mtb_block_storage_async_callback_t callback, void* callback_arg)
+{
+    #if !defined(MTB_BLOCK_STORAGE_NON_BLOCKING_SUPPORTED)
+    CY_UNUSED_PARAMETER(context);
+    CY_UNUSED_PARAMETER(callback);
+    CY_UNUSED_PARAMETER(callback_arg);
+    return MTB_BLOCK_STORAGE_NOT_SUPPORTED_ERROR;
+    #else // if !defined(MTB_BLOCK_STORAGE_NON_BLOCKING_SUPPORTED)
+    _mtb_block_storage_nvm_context_t* ctx = (_mtb_block_storage_nvm_context_t*)context;
+    uint32_t state = cyhal_system_critical_section_enter();
+    ctx->callback = callback;
+    ctx->callback_arg = callback_arg;
+    cyhal_system_critical_section_exit(state);
+    return CY_RSLT_SUCCESS;
+    #endif // if !defined(MTB_BLOCK_STORAGE_NON_BLOCKING_SUPPORTED)
+}
+
+
 //--------------------------------------------------------------------------------------------------
 // mtb_block_storage_nvm_program_nb
 //--------------------------------------------------------------------------------------------------
@@ -443,32 +1244,9 @@ static cy_rslt_t mtb_block_storage_nvm_program_nb(void* context, uint32_t addr,
     CY_UNUSED_PARAMETER(buf);
     return MTB_BLOCK_STORAGE_NOT_SUPPORTED_ERROR;
     #else // if !defined(MTB_BLOCK_STORAGE_NON_BLOCKING_SUPPORTED)
-
-    uint32_t prog_size = mtb_block_storage_nvm_program_size(context, addr);
-    cy_rslt_t result = CY_RSLT_SUCCESS;
-
-    if ((0 != (length % prog_size)))
-    {
-        result = MTB_BLOCK_STORAGE_INVALID_SIZE_ERROR;
-    }
-
-    if (result == CY_RSLT_SUCCESS)
-    {
-        for (uint32_t loc = addr; result == CY_RSLT_SUCCESS && loc < addr + length;
-             loc += prog_size, buf += prog_size)
-        {
-            #if (CYHAL_DRIVER_AVAILABLE_NVM)
-            result = cyhal_nvm_start_program((cyhal_nvm_t*)context, loc, (const uint32_t*)buf);
-            while (!cyhal_nvm_is_operation_complete((cyhal_nvm_t*)context))
-            #else // if (CYHAL_DRIVER_AVAILABLE_NVM)
-            result = cyhal_flash_start_program((cyhal_flash_t*)context, loc, (const uint32_t*)buf);
-            while (!cyhal_flash_is_operation_complete((cyhal_flash_t*)context))
-            #endif // if (CYHAL_DRIVER_AVAILABLE_NVM)
-            {
-            }
-        }
-    }
-    return result;
+    return _mtb_block_storage_nvm_start((_mtb_block_storage_nvm_context_t*)context,
+                                        _MTB_BLOCK_STORAGE_NVM_NB_PROGRAM, addr, length, buf,
+                                        false);
     #endif // if !defined(MTB_BLOCK_STORAGE_NON_BLOCKING_SUPPORTED)
 }
 
@@ -484,31 +1262,9 @@ static cy_rslt_t mtb_block_storage_nvm_erase_nb(void* context, uint32_t addr, ui
     CY_UNUSED_PARAMETER(length);
     return MTB_BLOCK_STORAGE_NOT_SUPPORTED_ERROR;
     #else // if !defined(MTB_BLOCK_STORAGE_NON_BLOCKING_SUPPORTED)
-    uint32_t erase_size = mtb_block_storage_nvm_erase_size(context, addr);
-    cy_rslt_t result = CY_RSLT_SUCCESS;
-
-    if ((0 != (length % erase_size)))
-    {
-        result = MTB_BLOCK_STORAGE_INVALID_SIZE_ERROR;
-    }
-
-    if (result == CY_RSLT_SUCCESS)
-    {
-        for (uint32_t loc = addr; result == CY_RSLT_SUCCESS && loc < addr + length;
-             loc += erase_size)
-        {
-            #if (CYHAL_DRIVER_AVAILABLE_NVM)
-            result = cyhal_nvm_start_erase((cyhal_nvm_t*)context, loc);
-            while (!cyhal_nvm_is_operation_complete((cyhal_nvm_t*)context))
-            #else // if (CYHAL_DRIVER_AVAILABLE_NVM)
-            result = cyhal_flash_start_erase((cyhal_flash_t*)context, loc);
-            while (!cyhal_flash_is_operation_complete((cyhal_flash_t*)context))
-            #endif // if (CYHAL_DRIVER_AVAILABLE_NVM)
-            {
-            }
-        }
-    }
-    return result;
+    return _mtb_block_storage_nvm_start((_mtb_block_storage_nvm_context_t*)context,
+                                        _MTB_BLOCK_STORAGE_NVM_NB_ERASE, addr, length, NULL,
+                                        false);
     #endif // if !defined(MTB_BLOCK_STORAGE_NON_BLOCKING_SUPPORTED)
 }
 
@@ -518,16 +1274,39 @@ static cy_rslt_t mtb_block_storage_nvm_erase_nb(void* context, uint32_t addr, ui
 //--------------------------------------------------------------------------------------------------
 static bool mtb_block_storage_nvm_is_in_range(void* context, uint32_t addr, uint32_t length)
 {
-    bool isInRange = false;
+    return (NULL != _mtb_block_storage_nvm_find_region((_mtb_block_storage_nvm_context_t*)context,
+                                                       addr, length));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_nvm_get_geometry
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t mtb_block_storage_nvm_get_geometry(void* context,
+                                                    mtb_block_storage_region_t* regions,
+                                                    uint32_t max_regions, uint32_t* region_count)
+{
+    const _mtb_block_storage_nvm_context_t* ctx = (const _mtb_block_storage_nvm_context_t*)context;
+    cy_rslt_t result = CY_RSLT_SUCCESS;
 
-    const mtb_block_storage_nvm_region_info_t* region_info =
-        mtb_block_storage_nvm_get_region_for_address(
-            (mtb_block_storage_nvm_t*)context, addr, length);
-    if (NULL != region_info)
+    for (uint32_t region = 0; (region < ctx->region_count) && (region < max_regions); region++)
     {
-        isInRange = true;
+        const _mtb_block_storage_nvm_region_t* info = &ctx->regions[region];
+        regions[region].start_address = info->start_address;
+        regions[region].size = info->size;
+        regions[region].read_size = mtb_block_storage_nvm_read_size(context, info->start_address);
+        regions[region].program_size = info->program_size;
+        regions[region].erase_size = info->erase_size;
+        regions[region].erase_value = info->erase_value;
+        regions[region].is_erase_required = info->is_erase_required;
+        regions[region].bank = info->bank;
     }
-    return isInRange;
+    *region_count = ctx->region_count;
+    if (ctx->region_count > max_regions)
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_SIZE_ERROR;
+    }
+    return result;
 }
 
 
@@ -549,23 +1328,52 @@ cy_rslt_t mtb_block_storage_create_hal_nvm(mtb_block_storage_t* bsd, void* obj)
     //Also used in HAL next as a dummy object if the NVM object pointer passed in is NULL.
     static mtb_block_storage_nvm_t hal_obj;
 
+    _mtb_block_storage_nvm_context_t* ctx = NULL;
+    bool in_use = false;
+    #if !(MTB_HAL_DRIVER_AVAILABLE_NVM)
+    CY_UNUSED_PARAMETER(obj);
+    mtb_block_storage_nvm_t* nvm_obj = &hal_obj;
+    bool hal_initialized = false;
+    #else
+    mtb_block_storage_nvm_t* nvm_obj = (obj != NULL) ? obj : &hal_obj;
+    #endif
+
     if (NULL == bsd)
     {
         result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
     }
+    else
+    {
+        ctx = _mtb_block_storage_nvm_get_context(nvm_obj, &in_use);
+        if (NULL == ctx)
+        {
+            //MTB_BLOCK_STORAGE_NVM_MAX_INSTANCES needs to be increased
+            result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+        }
+    }
 
     #if !(MTB_HAL_DRIVER_AVAILABLE_NVM)
-    CY_UNUSED_PARAMETER(obj);
-    if (result == CY_RSLT_SUCCESS)
+    //All the devices share the static HAL object, it is initialized by the first one created
+    if ((result == CY_RSLT_SUCCESS) && !in_use)
     {
         #if (CYHAL_DRIVER_AVAILABLE_NVM)
         result = cyhal_nvm_init(&hal_obj);
         #else // (CYHAL_DRIVER_AVAILABLE_NVM)
         result = cyhal_flash_init(&hal_obj);
         #endif // (CYHAL_DRIVER_AVAILABLE_NVM)
+        hal_initialized = (result == CY_RSLT_SUCCESS);
     }
     #endif // !(MTB_HAL_DRIVER_AVAILABLE_NVM)
 
+    if ((result == CY_RSLT_SUCCESS) && !in_use)
+    {
+        result = _mtb_block_storage_nvm_init_context(ctx, nvm_obj);
+        if (result != CY_RSLT_SUCCESS)
+        {
+            ctx->hal_obj = NULL;
+        }
+    }
+
     if (result == CY_RSLT_SUCCESS)
     {
         bsd->read = mtb_block_storage_nvm_read;
@@ -579,14 +1387,18 @@ cy_rslt_t mtb_block_storage_create_hal_nvm(mtb_block_storage_t* bsd, void* obj)
         bsd->get_erase_value = mtb_block_storage_nvm_erase_value;
         bsd->is_in_range = mtb_block_storage_nvm_is_in_range;
         bsd->is_erase_required = mtb_block_storage_nvm_is_erase_required;
-        #if !(MTB_HAL_DRIVER_AVAILABLE_NVM)
-        bsd->context = &hal_obj;
-        #else
-        bsd->context = (obj != NULL) ? obj : &hal_obj;
-        #endif
+        bsd->get_geometry = mtb_block_storage_nvm_get_geometry;
+        bsd->register_callback = mtb_block_storage_nvm_register_callback;
+        bsd->poll = mtb_block_storage_nvm_poll;
+        bsd->readv = mtb_block_storage_nvm_readv;
+        bsd->programv = mtb_block_storage_nvm_programv;
+        bsd->map = mtb_block_storage_nvm_map;
+        bsd->unmap = mtb_block_storage_nvm_unmap;
+        bsd->context = ctx;
+        ctx->users++;
     }
     #if !(MTB_HAL_DRIVER_AVAILABLE_NVM)
-    else
+    else if (hal_initialized)
     {
         #if (CYHAL_DRIVER_AVAILABLE_NVM)
         cyhal_nvm_free(&hal_obj);
@@ -599,6 +1411,63 @@ cy_rslt_t mtb_block_storage_create_hal_nvm(mtb_block_storage_t* bsd, void* obj)
 }
 
 
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_nvm_set_options
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t mtb_block_storage_nvm_set_options(mtb_block_storage_t* bsd, uint32_t options)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    if ((NULL == bsd) || (bsd->program != mtb_block_storage_nvm_program) ||
+        (NULL == bsd->context))
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+    }
+    else
+    {
+        ((_mtb_block_storage_nvm_context_t*)bsd->context)->options = options;
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_nvm_deinit
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t mtb_block_storage_nvm_deinit(mtb_block_storage_t* bsd)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    if ((NULL == bsd) || (bsd->program != mtb_block_storage_nvm_program) ||
+        (NULL == bsd->context))
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+    }
+    else
+    {
+        _mtb_block_storage_nvm_context_t* ctx = (_mtb_block_storage_nvm_context_t*)bsd->context;
+        //The context is released with its last device, which first finishes the non blocking
+        //operation in progress so that its buffer and callback are not used afterwards
+        ctx->users--;
+        if (0u == ctx->users)
+        {
+            _mtb_block_storage_nvm_complete(ctx);
+            #if !(MTB_HAL_DRIVER_AVAILABLE_NVM)
+            //The static HAL object was initialized by the first device created on it
+            #if (CYHAL_DRIVER_AVAILABLE_NVM)
+            cyhal_nvm_free(ctx->hal_obj);
+            #elif (CYHAL_DRIVER_AVAILABLE_FLASH)
+            cyhal_flash_free(ctx->hal_obj);
+            #endif
+            #endif // !(MTB_HAL_DRIVER_AVAILABLE_NVM)
+            ctx->hal_obj = NULL;
+        }
+        bsd->context = NULL;
+    }
+    return result;
+}
+
+
 #endif \
     // (CYHAL_DRIVER_AVAILABLE_NVM)||(CYHAL_DRIVER_AVAILABLE_FLASH)||(MTB_HAL_DRIVER_AVAILABLE_NVM)
 #endif // if !defined(COMPONENT_CAT2)
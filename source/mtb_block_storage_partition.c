@@ -0,0 +1,410 @@
+/***********************************************************************************************//**
+ * \file mtb_block_storage_partition.c
+ *
+ * \brief
+ * Partitions of a block storage device. Exposes a contiguous area of a device as a block storage
+ * device of its own, starting at address 0.
+ *
+ ***************************************************************************************************
+ * \copyright
+ * Copyright 2024 Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **************************************************************************************************/
+#include "mtb_block_storage_partition.h"
+
+//Number of fragments of a vectored call forwarded to the parent at a time
+#define _MTB_BLOCK_STORAGE_PARTITION_VEC_BATCH  (8u)
+
+/*******************************************************************************
+*                       Private Function Definitions
+*******************************************************************************/
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_partition_is_in_range
+//--------------------------------------------------------------------------------------------------
+static bool _mtb_block_storage_partition_is_in_range(void* context, uint32_t addr,
+                                                     uint32_t length)
+{
+    const mtb_block_storage_partition_t* obj = (const mtb_block_storage_partition_t*)context;
+    return (addr < obj->size) && (length <= (obj->size - addr));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_partition_read_size
+//--------------------------------------------------------------------------------------------------
+static uint32_t _mtb_block_storage_partition_read_size(void* context, uint32_t addr)
+{
+    const mtb_block_storage_partition_t* obj = (const mtb_block_storage_partition_t*)context;
+    return obj->parent->get_read_size(obj->parent->context, obj->offset + addr);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_partition_program_size
+//--------------------------------------------------------------------------------------------------
+static uint32_t _mtb_block_storage_partition_program_size(void* context, uint32_t addr)
+{
+    const mtb_block_storage_partition_t* obj = (const mtb_block_storage_partition_t*)context;
+    return obj->parent->get_program_size(obj->parent->context, obj->offset + addr);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_partition_erase_size
+//--------------------------------------------------------------------------------------------------
+static uint32_t _mtb_block_storage_partition_erase_size(void* context, uint32_t addr)
+{
+    const mtb_block_storage_partition_t* obj = (const mtb_block_storage_partition_t*)context;
+    return obj->parent->get_erase_size(obj->parent->context, obj->offset + addr);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_partition_erase_value
+//--------------------------------------------------------------------------------------------------
+static uint8_t _mtb_block_storage_partition_erase_value(void* context, uint32_t addr)
+{
+    const mtb_block_storage_partition_t* obj = (const mtb_block_storage_partition_t*)context;
+    return obj->parent->get_erase_value(obj->parent->context, obj->offset + addr);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_partition_read
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_partition_read(void* context, uint32_t addr, uint32_t length,
+                                                   uint8_t* buf)
+{
+    const mtb_block_storage_partition_t* obj = (const mtb_block_storage_partition_t*)context;
+    return _mtb_block_storage_partition_is_in_range(context, addr, length) ?
+           obj->parent->read(obj->parent->context, obj->offset + addr, length, buf) :
+           MTB_BLOCK_STORAGE_NOT_IN_RANGE_ERROR;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_partition_program
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_partition_program(void* context, uint32_t addr,
+                                                      uint32_t length, const uint8_t* buf)
+{
+    const mtb_block_storage_partition_t* obj = (const mtb_block_storage_partition_t*)context;
+    return _mtb_block_storage_partition_is_in_range(context, addr, length) ?
+           obj->parent->program(obj->parent->context, obj->offset + addr, length, buf) :
+           MTB_BLOCK_STORAGE_NOT_IN_RANGE_ERROR;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_partition_readv
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_partition_readv(void* context,
+                                                    const mtb_block_storage_read_vec_t* vecs,
+                                                    uint32_t count)
+{
+    const mtb_block_storage_partition_t* obj = (const mtb_block_storage_partition_t*)context;
+    mtb_block_storage_read_vec_t parent_vecs[_MTB_BLOCK_STORAGE_PARTITION_VEC_BATCH];
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint32_t done = 0;
+
+    //The fragments are moved to the parent addresses in batches of a fixed size
+    while ((result == CY_RSLT_SUCCESS) && (done < count))
+    {
+        uint32_t batch = 0;
+        while ((result == CY_RSLT_SUCCESS) && (batch < _MTB_BLOCK_STORAGE_PARTITION_VEC_BATCH) &&
+               ((done + batch) < count))
+        {
+            const mtb_block_storage_read_vec_t* vec = &vecs[done + batch];
+            if (!_mtb_block_storage_partition_is_in_range(context, vec->addr, vec->length))
+            {
+                result = MTB_BLOCK_STORAGE_NOT_IN_RANGE_ERROR;
+            }
+            else
+            {
+                parent_vecs[batch] = *vec;
+                parent_vecs[batch].addr += obj->offset;
+                batch++;
+            }
+        }
+        if (0u != batch)
+        {
+            cy_rslt_t parent_result = obj->parent->readv(obj->parent->context, parent_vecs, batch);
+            result = (parent_result != CY_RSLT_SUCCESS) ? parent_result : result;
+        }
+        done += batch;
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_partition_programv
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_partition_programv(void* context,
+                                                       const mtb_block_storage_program_vec_t* vecs,
+                                                       uint32_t count)
+{
+    const mtb_block_storage_partition_t* obj = (const mtb_block_storage_partition_t*)context;
+    mtb_block_storage_program_vec_t parent_vecs[_MTB_BLOCK_STORAGE_PARTITION_VEC_BATCH];
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint32_t done = 0;
+
+    while ((result == CY_RSLT_SUCCESS) && (done < count))
+    {
+        uint32_t batch = 0;
+        while ((result == CY_RSLT_SUCCESS) && (batch < _MTB_BLOCK_STORAGE_PARTITION_VEC_BATCH) &&
+               ((done + batch) < count))
+        {
+            const mtb_block_storage_program_vec_t* vec = &vecs[done + batch];
+            if (!_mtb_block_storage_partition_is_in_range(context, vec->addr, vec->length))
+            {
+                result = MTB_BLOCK_STORAGE_NOT_IN_RANGE_ERROR;
+            }
+            else
+            {
+                parent_vecs[batch] = *vec;
+                parent_vecs[batch].addr += obj->offset;
+                batch++;
+            }
+        }
+        if (0u != batch)
+        {
+            cy_rslt_t parent_result = obj->parent->programv(obj->parent->context, parent_vecs,
+                                                            batch);
+            result = (parent_result != CY_RSLT_SUCCESS) ? parent_result : result;
+        }
+        done += batch;
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_partition_map
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_partition_map(void* context, uint32_t addr, uint32_t length,
+                                                  const uint8_t** ptr)
+{
+    const mtb_block_storage_partition_t* obj = (const mtb_block_storage_partition_t*)context;
+    return _mtb_block_storage_partition_is_in_range(context, addr, length) ?
+           obj->parent->map(obj->parent->context, obj->offset + addr, length, ptr) :
+           MTB_BLOCK_STORAGE_NOT_IN_RANGE_ERROR;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_partition_unmap
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_partition_unmap(void* context, const uint8_t* ptr,
+                                                    uint32_t length)
+{
+    const mtb_block_storage_partition_t* obj = (const mtb_block_storage_partition_t*)context;
+    return obj->parent->unmap(obj->parent->context, ptr, length);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_partition_erase
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_partition_erase(void* context, uint32_t addr, uint32_t length)
+{
+    const mtb_block_storage_partition_t* obj = (const mtb_block_storage_partition_t*)context;
+    return _mtb_block_storage_partition_is_in_range(context, addr, length) ?
+           obj->parent->erase(obj->parent->context, obj->offset + addr, length) :
+           MTB_BLOCK_STORAGE_NOT_IN_RANGE_ERROR;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_partition_program_nb
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_partition_program_nb(void* context, uint32_t addr,
+                                                         uint32_t length, const uint8_t* buf)
+{
+    const mtb_block_storage_partition_t* obj = (const mtb_block_storage_partition_t*)context;
+    return _mtb_block_storage_partition_is_in_range(context, addr, length) ?
+           obj->parent->program_nb(obj->parent->context, obj->offset + addr, length, buf) :
+           MTB_BLOCK_STORAGE_NOT_IN_RANGE_ERROR;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_partition_erase_nb
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_partition_erase_nb(void* context, uint32_t addr,
+                                                       uint32_t length)
+{
+    const mtb_block_storage_partition_t* obj = (const mtb_block_storage_partition_t*)context;
+    return _mtb_block_storage_partition_is_in_range(context, addr, length) ?
+           obj->parent->erase_nb(obj->parent->context, obj->offset + addr, length) :
+           MTB_BLOCK_STORAGE_NOT_IN_RANGE_ERROR;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_partition_is_erase_required
+//--------------------------------------------------------------------------------------------------
+static bool _mtb_block_storage_partition_is_erase_required(void* context, uint32_t addr,
+                                                           uint32_t length)
+{
+    const mtb_block_storage_partition_t* obj = (const mtb_block_storage_partition_t*)context;
+    //A parent that does not tell is assumed to need an erase before a program
+    return (NULL == obj->parent->is_erase_required) ||
+           obj->parent->is_erase_required(obj->parent->context, obj->offset + addr, length);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_partition_get_geometry
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_partition_get_geometry(void* context,
+                                                           mtb_block_storage_region_t* regions,
+                                                           uint32_t max_regions,
+                                                           uint32_t* region_count)
+{
+    const mtb_block_storage_partition_t* obj = (const mtb_block_storage_partition_t*)context;
+    uint32_t end = obj->offset + obj->size;
+    uint32_t parent_count = 0;
+    uint32_t count = 0;
+    bool complete = false;
+    cy_rslt_t result = obj->parent->get_geometry(obj->parent->context, regions, max_regions,
+                                                 &parent_count);
+
+    //The regions of the parent are clipped to the partition in place. If regions is too small
+    //for the parent, the partition is only described if it lies in the regions that were filled.
+    if ((result == CY_RSLT_SUCCESS) || (result == MTB_BLOCK_STORAGE_INVALID_SIZE_ERROR))
+    {
+        uint32_t filled = (parent_count < max_regions) ? parent_count : max_regions;
+        for (uint32_t i = 0; i < filled; i++)
+        {
+            uint32_t start = regions[i].start_address;
+            uint32_t stop = start + regions[i].size;
+            if ((start < end) && (stop > obj->offset))
+            {
+                regions[count] = regions[i];
+                regions[count].start_address = ((start > obj->offset) ? start : obj->offset) -
+                                               obj->offset;
+                regions[count].size = ((stop < end) ? stop : end) - obj->offset -
+                                      regions[count].start_address;
+                count++;
+            }
+            complete = complete || (stop >= end);
+        }
+        result = CY_RSLT_SUCCESS;
+    }
+
+    if ((result == CY_RSLT_SUCCESS) && !complete)
+    {
+        //Upper bound of the number of regions of the partition
+        count = parent_count;
+        result = MTB_BLOCK_STORAGE_INVALID_SIZE_ERROR;
+    }
+    *region_count = count;
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_partition_register_callback
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_partition_register_callback(
+    void* context, mtb_block_storage_async_callback_t callback, void* callback_arg)
+{
+    const mtb_block_storage_partition_t* obj = (const mtb_block_storage_partition_t*)context;
+    return obj->parent->register_callback(obj->parent->context, callback, callback_arg);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_partition_poll
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_partition_poll(void* context)
+{
+    const mtb_block_storage_partition_t* obj = (const mtb_block_storage_partition_t*)context;
+    return obj->parent->poll(obj->parent->context);
+}
+
+
+/*******************************************************************************
+*                        Public Function Definitions
+*******************************************************************************/
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_create_partition
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t mtb_block_storage_create_partition(mtb_block_storage_t* child,
+                                             mtb_block_storage_partition_t* obj,
+                                             mtb_block_storage_t* parent, uint32_t offset,
+                                             uint32_t size)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    if ((NULL == child) || (NULL == obj) || (NULL == parent) || (0u == size))
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+    }
+    else if ((size > (UINT32_MAX - offset)) ||
+             ((NULL != parent->is_in_range) &&
+              !parent->is_in_range(parent->context, offset, size)))
+    {
+        result = MTB_BLOCK_STORAGE_NOT_IN_RANGE_ERROR;
+    }
+    else
+    {
+        uint32_t erase_size = parent->get_erase_size(parent->context, offset);
+        uint32_t last_erase_size = parent->get_erase_size(parent->context, offset + size - 1u);
+        if ((0u == erase_size) || (0u == last_erase_size) || (0u != (offset % erase_size)) ||
+            (0u != ((offset + size) % last_erase_size)))
+        {
+            result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+        }
+    }
+
+    if (result == CY_RSLT_SUCCESS)
+    {
+        obj->parent = parent;
+        obj->offset = offset;
+        obj->size = size;
+
+        child->get_read_size = _mtb_block_storage_partition_read_size;
+        child->get_program_size = _mtb_block_storage_partition_program_size;
+        child->get_erase_size = _mtb_block_storage_partition_erase_size;
+        child->get_erase_value = _mtb_block_storage_partition_erase_value;
+        child->read = _mtb_block_storage_partition_read;
+        child->program = _mtb_block_storage_partition_program;
+        child->erase = _mtb_block_storage_partition_erase;
+        child->is_in_range = _mtb_block_storage_partition_is_in_range;
+        child->is_erase_required = _mtb_block_storage_partition_is_erase_required;
+        //The optional functions are only provided if the parent provides them
+        child->program_nb = (NULL != parent->program_nb) ?
+                            _mtb_block_storage_partition_program_nb : NULL;
+        child->erase_nb = (NULL != parent->erase_nb) ?
+                          _mtb_block_storage_partition_erase_nb : NULL;
+        child->get_geometry = (NULL != parent->get_geometry) ?
+                              _mtb_block_storage_partition_get_geometry : NULL;
+        child->register_callback = (NULL != parent->register_callback) ?
+                                   _mtb_block_storage_partition_register_callback : NULL;
+        child->poll = (NULL != parent->poll) ? _mtb_block_storage_partition_poll : NULL;
+        child->readv = (NULL != parent->readv) ? _mtb_block_storage_partition_readv : NULL;
+        child->programv = (NULL != parent->programv) ? _mtb_block_storage_partition_programv :
+                          NULL;
+        child->map = (NULL != parent->map) ? _mtb_block_storage_partition_map : NULL;
+        child->unmap = (NULL != parent->unmap) ? _mtb_block_storage_partition_unmap : NULL;
+        child->context = obj;
+    }
+    return result;
+}
@@ -26,12 +26,217 @@
 #if defined(COMPONENT_CAT2)
 
 #include "mtb_block_storage.h"
+#include "mtb_block_storage_trace.h"
 #include "cy_flash.h"
+#include "cy_syslib.h"
 
 #include <string.h>
 
 #define MTB_BLOCK_STORAGE_PDL_ERASE_VALUE   (0x00)
 
+//MTB_BLOCK_STORAGE_OPTION_* values of the device
+static uint32_t _mtb_block_storage_pdl_options = 0;
+
+//Data of an erased row, written by erase
+static const uint32_t _mtb_block_storage_pdl_zero_row[CY_FLASH_SIZEOF_ROW / sizeof(uint32_t)] =
+{ 0u };
+
+//The rows are written in the background on the devices whose PDL can start a row write
+#if (CY_FLASH_NON_BLOCKING_SUPPORTED)
+#define _MTB_BLOCK_STORAGE_PDL_NON_BLOCKING
+#endif
+
+#if defined(_MTB_BLOCK_STORAGE_PDL_NON_BLOCKING)
+#define _MTB_BLOCK_STORAGE_PDL_NB_IDLE      (0u)
+#define _MTB_BLOCK_STORAGE_PDL_NB_PROGRAM   (1u)
+#define _MTB_BLOCK_STORAGE_PDL_NB_ERASE     (2u)
+
+/* State of the non blocking operation, there is a single flash so it is not part of a context */
+static struct
+{
+    volatile uint8_t                    operation;
+    uint32_t                            addr;       //Row being written, none once addr is end
+    uint32_t                            end;
+    const uint8_t*                      buf;        //Data of the row, NULL when erasing
+    cy_rslt_t                           result;
+    mtb_block_storage_async_callback_t  callback;
+    void*                               callback_arg;
+} _mtb_block_storage_pdl_nb;
+#endif // defined(_MTB_BLOCK_STORAGE_PDL_NON_BLOCKING)
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_pdl_status
+//--------------------------------------------------------------------------------------------------
+static inline cy_rslt_t _mtb_block_storage_pdl_status(cy_en_flashdrv_status_t status)
+{
+    //The status codes of the flash driver are result codes of its own module
+    return (CY_FLASH_DRV_SUCCESS == status) ? CY_RSLT_SUCCESS : (cy_rslt_t)status;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_pdl_row_matches
+//--------------------------------------------------------------------------------------------------
+static inline bool _mtb_block_storage_pdl_row_matches(uint32_t loc, const uint8_t* buf)
+{
+    //Flash is memory mapped, so the row is compared in place
+    return (0u != (_mtb_block_storage_pdl_options &
+                   MTB_BLOCK_STORAGE_OPTION_COMPARE_BEFORE_PROGRAM)) &&
+           (0 == memcmp((const void*)loc, buf, CY_FLASH_SIZEOF_ROW));
+}
+
+
+#if defined(_MTB_BLOCK_STORAGE_PDL_NON_BLOCKING)
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_pdl_start_row
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_pdl_start_row(void)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    //Skips the rows that already hold the data, then starts the next one
+    while ((_mtb_block_storage_pdl_nb.addr < _mtb_block_storage_pdl_nb.end) &&
+           (NULL != _mtb_block_storage_pdl_nb.buf) &&
+           _mtb_block_storage_pdl_row_matches(_mtb_block_storage_pdl_nb.addr,
+                                              _mtb_block_storage_pdl_nb.buf))
+    {
+        _mtb_block_storage_pdl_nb.addr += CY_FLASH_SIZEOF_ROW;
+        _mtb_block_storage_pdl_nb.buf += CY_FLASH_SIZEOF_ROW;
+    }
+    if (_mtb_block_storage_pdl_nb.addr < _mtb_block_storage_pdl_nb.end)
+    {
+        const uint32_t* data = (NULL != _mtb_block_storage_pdl_nb.buf)
+            ? (const uint32_t*)_mtb_block_storage_pdl_nb.buf : _mtb_block_storage_pdl_zero_row;
+        cy_en_flashdrv_status_t status = Cy_Flash_StartWrite(_mtb_block_storage_pdl_nb.addr,
+                                                             (uint32_t*)data);
+        //A row that completes at once is also reported by Cy_Flash_IsOperationComplete
+        result = ((CY_FLASH_DRV_OPERATION_STARTED == status) || (CY_FLASH_DRV_SUCCESS == status))
+            ? MTB_BLOCK_STORAGE_BUSY : _mtb_block_storage_pdl_status(status);
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_pdl_start
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_pdl_start(uint8_t operation, uint32_t addr, uint32_t length,
+                                              const uint8_t* buf)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    if ((0u == length) || (0u != (length % CY_FLASH_SIZEOF_ROW)))
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_SIZE_ERROR;
+    }
+
+    if (result == CY_RSLT_SUCCESS)
+    {
+        //The operation is claimed, described and its first row started in one critical section,
+        //as poll, which can be called from an interrupt, uses all of it once it is claimed. The
+        //following rows are started by poll. When all the rows already hold the data, the next
+        //poll reports the completion.
+        uint32_t state = Cy_SysLib_EnterCriticalSection();
+        if (_MTB_BLOCK_STORAGE_PDL_NB_IDLE != _mtb_block_storage_pdl_nb.operation)
+        {
+            result = MTB_BLOCK_STORAGE_BUSY;
+        }
+        else
+        {
+            _mtb_block_storage_pdl_nb.addr = addr;
+            _mtb_block_storage_pdl_nb.end = addr + length;
+            _mtb_block_storage_pdl_nb.buf = buf;
+            result = _mtb_block_storage_pdl_start_row();
+            if ((result == MTB_BLOCK_STORAGE_BUSY) || (result == CY_RSLT_SUCCESS))
+            {
+                result = CY_RSLT_SUCCESS;
+                _mtb_block_storage_pdl_nb.result = MTB_BLOCK_STORAGE_BUSY;
+                _mtb_block_storage_pdl_nb.operation = operation;
+            }
+            else
+            {
+                _mtb_block_storage_pdl_nb.result = result;
+            }
+        }
+        Cy_SysLib_ExitCriticalSection(state);
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_pdl_poll
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t mtb_block_storage_pdl_poll(void* context)
+{
+    CY_UNUSED_PARAMETER(context);
+    cy_rslt_t result = MTB_BLOCK_STORAGE_BUSY;
+    bool finished = false;
+
+    //The step is claimed in a critical section so that poll can be called both from the
+    //application and from an interrupt
+    uint32_t state = Cy_SysLib_EnterCriticalSection();
+    if (_MTB_BLOCK_STORAGE_PDL_NB_IDLE == _mtb_block_storage_pdl_nb.operation)
+    {
+        result = _mtb_block_storage_pdl_nb.result;
+    }
+    else
+    {
+        cy_rslt_t row_result = CY_RSLT_SUCCESS;
+        if (_mtb_block_storage_pdl_nb.addr < _mtb_block_storage_pdl_nb.end)
+        {
+            //The row write is moved on by Cy_Flash_ResumeWrite in the SPCIF interrupt
+            cy_en_flashdrv_status_t status = Cy_Flash_IsOperationComplete();
+            row_result = (CY_FLASH_DRV_OPCODE_BUSY == status) ? MTB_BLOCK_STORAGE_BUSY :
+                         _mtb_block_storage_pdl_status(status);
+            if (row_result == CY_RSLT_SUCCESS)
+            {
+                _mtb_block_storage_pdl_nb.addr += CY_FLASH_SIZEOF_ROW;
+                if (NULL != _mtb_block_storage_pdl_nb.buf)
+                {
+                    _mtb_block_storage_pdl_nb.buf += CY_FLASH_SIZEOF_ROW;
+                }
+                row_result = _mtb_block_storage_pdl_start_row();
+            }
+        }
+        if (row_result != MTB_BLOCK_STORAGE_BUSY)
+        {
+            //Mark the device as idle before leaving the critical section, the callback is
+            //invoked outside of it
+            result = row_result;
+            finished = true;
+            _mtb_block_storage_pdl_nb.result = result;
+            _mtb_block_storage_pdl_nb.operation = _MTB_BLOCK_STORAGE_PDL_NB_IDLE;
+        }
+    }
+    Cy_SysLib_ExitCriticalSection(state);
+
+    if (finished && (NULL != _mtb_block_storage_pdl_nb.callback))
+    {
+        _mtb_block_storage_pdl_nb.callback(_mtb_block_storage_pdl_nb.callback_arg, result);
+    }
+    return result;
+}
+
+
+#endif // defined(_MTB_BLOCK_STORAGE_PDL_NON_BLOCKING)
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_pdl_complete
+//--------------------------------------------------------------------------------------------------
+static inline void _mtb_block_storage_pdl_complete(void)
+{
+    #if defined(_MTB_BLOCK_STORAGE_PDL_NON_BLOCKING)
+    //Blocking operations finish the non blocking one first, as the flash cannot be read or
+    //written while a row is being written
+    while (mtb_block_storage_pdl_poll(NULL) == MTB_BLOCK_STORAGE_BUSY)
+    {
+    }
+    #endif
+}
+
 
 //--------------------------------------------------------------------------------------------------
 // mtb_block_storage_pdl_read_size
@@ -81,11 +286,14 @@ static uint8_t mtb_block_storage_pdl_erase_value(void* context, uint32_t addr)
 //--------------------------------------------------------------------------------------------------
 // mtb_block_storage_pdl_read
 //--------------------------------------------------------------------------------------------------
-static cy_rslt_t mtb_block_storage_pdl_read(void* context, uint32_t addr, uint32_t length,
-                                            uint8_t* buf)
+cy_rslt_t mtb_block_storage_pdl_read(void* context, uint32_t addr, uint32_t length, uint8_t* buf)
 {
+    uint32_t trace = MTB_BLOCK_STORAGE_TRACE_BEGIN(MTB_BLOCK_STORAGE_TRACE_READ, context, addr,
+                                                   length);
     CY_UNUSED_PARAMETER(context);
+    _mtb_block_storage_pdl_complete();
     (void)memcpy((uint8_t*)buf, (const uint8_t*)(addr), length);
+    MTB_BLOCK_STORAGE_TRACE_END(trace, CY_RSLT_SUCCESS);
     return CY_RSLT_SUCCESS;
 }
 
@@ -93,10 +301,12 @@ static cy_rslt_t mtb_block_storage_pdl_read(void* context, uint32_t addr, uint32
 //--------------------------------------------------------------------------------------------------
 // mtb_block_storage_pdl_program
 //--------------------------------------------------------------------------------------------------
-static cy_rslt_t mtb_block_storage_pdl_program(void* context, uint32_t addr, uint32_t length,
-                                               const uint8_t* buf)
+cy_rslt_t mtb_block_storage_pdl_program(void* context, uint32_t addr, uint32_t length,
+                                        const uint8_t* buf)
 {
     cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint32_t trace = MTB_BLOCK_STORAGE_TRACE_BEGIN(MTB_BLOCK_STORAGE_TRACE_PROGRAM, context, addr,
+                                                   length);
     uint32_t prog_size = mtb_block_storage_pdl_program_size(context, addr);
 
 
@@ -107,16 +317,19 @@ static cy_rslt_t mtb_block_storage_pdl_program(void* context, uint32_t addr, uin
 
     if (result == CY_RSLT_SUCCESS)
     {
+        _mtb_block_storage_pdl_complete();
         for (uint32_t loc = addr; result == CY_RSLT_SUCCESS && loc < addr + length;
              loc += prog_size, buf += prog_size)
         {
-            if (CY_FLASH_DRV_SUCCESS == Cy_Flash_WriteRow((uint32_t)loc, (uint32_t*)buf))
+            if (!_mtb_block_storage_pdl_row_matches(loc, buf))
             {
-                result = CY_RSLT_SUCCESS;
+                result = _mtb_block_storage_pdl_status(Cy_Flash_WriteRow((uint32_t)loc,
+                                                                         (uint32_t*)buf));
             }
         }
     }
 
+    MTB_BLOCK_STORAGE_TRACE_END(trace, result);
     return result;
 }
 
@@ -124,11 +337,12 @@ static cy_rslt_t mtb_block_storage_pdl_program(void* context, uint32_t addr, uin
 //--------------------------------------------------------------------------------------------------
 // mtb_block_storage_pdl_erase
 //--------------------------------------------------------------------------------------------------
-static cy_rslt_t mtb_block_storage_pdl_erase(void* context, uint32_t addr, uint32_t length)
+cy_rslt_t mtb_block_storage_pdl_erase(void* context, uint32_t addr, uint32_t length)
 {
     cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint32_t trace = MTB_BLOCK_STORAGE_TRACE_BEGIN(MTB_BLOCK_STORAGE_TRACE_ERASE, context, addr,
+                                                   length);
     uint32_t erase_size = mtb_block_storage_pdl_erase_size(context, addr);
-    uint32_t buffer[CY_FLASH_SIZEOF_ROW] = { 0u };
 
     if ((0 != (length % erase_size)))
     {
@@ -137,19 +351,57 @@ static cy_rslt_t mtb_block_storage_pdl_erase(void* context, uint32_t addr, uint3
 
     if (result == CY_RSLT_SUCCESS)
     {
+        _mtb_block_storage_pdl_complete();
         for (uint32_t loc = addr; result == CY_RSLT_SUCCESS && loc < addr + length;
              loc += erase_size)
         {
-            if (CY_FLASH_DRV_SUCCESS == Cy_Flash_WriteRow((uint32_t)loc, &buffer[0]))
-            {
-                result = CY_RSLT_SUCCESS;
-            }
+            result = _mtb_block_storage_pdl_status(
+                Cy_Flash_WriteRow((uint32_t)loc, (uint32_t*)_mtb_block_storage_pdl_zero_row));
         }
     }
+    MTB_BLOCK_STORAGE_TRACE_END(trace, result);
     return result;
 }
 
 
+#if defined(_MTB_BLOCK_STORAGE_PDL_NON_BLOCKING)
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_pdl_program_nb
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t mtb_block_storage_pdl_program_nb(void* context, uint32_t addr, uint32_t length,
+                                                  const uint8_t* buf)
+{
+    CY_UNUSED_PARAMETER(context);
+    return _mtb_block_storage_pdl_start(_MTB_BLOCK_STORAGE_PDL_NB_PROGRAM, addr, length, buf);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_pdl_erase_nb
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t mtb_block_storage_pdl_erase_nb(void* context, uint32_t addr, uint32_t length)
+{
+    CY_UNUSED_PARAMETER(context);
+    return _mtb_block_storage_pdl_start(_MTB_BLOCK_STORAGE_PDL_NB_ERASE, addr, length, NULL);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_pdl_register_callback
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t mtb_block_storage_pdl_register_callback(
+    void* context, mtb_block_storage_async_callback_t callback, void* callback_arg)
+{
+    CY_UNUSED_PARAMETER(context);
+    uint32_t state = Cy_SysLib_EnterCriticalSection();
+    _mtb_block_storage_pdl_nb.callback = callback;
+    _mtb_block_storage_pdl_nb.callback_arg = callback_arg;
+    Cy_SysLib_ExitCriticalSection(state);
+    return CY_RSLT_SUCCESS;
+}
+
+
+#endif // defined(_MTB_BLOCK_STORAGE_PDL_NON_BLOCKING)
 //--------------------------------------------------------------------------------------------------
 // mtb_block_storage_pdl_is_in_range
 //--------------------------------------------------------------------------------------------------
@@ -157,7 +409,7 @@ static bool mtb_block_storage_pdl_is_in_range(void* context, uint32_t addr, uint
 {
     CY_UNUSED_PARAMETER(context);
     bool result = false;
-    if ((((addr) > CY_FLASH_BASE) && ((addr+length) <= (CY_FLASH_BASE + CY_FLASH_SIZE))))
+    if ((((addr) >= CY_FLASH_BASE) && ((addr+length) <= (CY_FLASH_BASE + CY_FLASH_SIZE))))
     {
         result = true;
     }
@@ -177,6 +429,69 @@ static bool mtb_block_storage_pdl_is_erase_required(void* context, uint32_t addr
 }
 
 
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_pdl_map
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t mtb_block_storage_pdl_map(void* context, uint32_t addr, uint32_t length,
+                                           const uint8_t** ptr)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    if (!mtb_block_storage_pdl_is_in_range(context, addr, length))
+    {
+        result = MTB_BLOCK_STORAGE_NOT_IN_RANGE_ERROR;
+    }
+    else
+    {
+        _mtb_block_storage_pdl_complete();
+        *ptr = (const uint8_t*)(addr);
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_pdl_unmap
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t mtb_block_storage_pdl_unmap(void* context, const uint8_t* ptr, uint32_t length)
+{
+    CY_UNUSED_PARAMETER(context);
+    CY_UNUSED_PARAMETER(ptr);
+    CY_UNUSED_PARAMETER(length);
+    return CY_RSLT_SUCCESS;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_pdl_get_geometry
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t mtb_block_storage_pdl_get_geometry(void* context,
+                                                    mtb_block_storage_region_t* regions,
+                                                    uint32_t max_regions, uint32_t* region_count)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    //The whole flash is made of rows of the same size
+    if (max_regions > 0u)
+    {
+        regions[0].start_address = CY_FLASH_BASE;
+        regions[0].size = CY_FLASH_SIZE;
+        regions[0].read_size = mtb_block_storage_pdl_read_size(context, CY_FLASH_BASE);
+        regions[0].program_size = mtb_block_storage_pdl_program_size(context, CY_FLASH_BASE);
+        regions[0].erase_size = mtb_block_storage_pdl_erase_size(context, CY_FLASH_BASE);
+        regions[0].erase_value = MTB_BLOCK_STORAGE_PDL_ERASE_VALUE;
+        regions[0].is_erase_required =
+            mtb_block_storage_pdl_is_erase_required(context, CY_FLASH_BASE, 0);
+        regions[0].bank = 0;
+    }
+    else
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_SIZE_ERROR;
+    }
+    *region_count = 1;
+    return result;
+}
+
+
 //--------------------------------------------------------------------------------------------------
 // mtb_block_storage_create_pdl
 //--------------------------------------------------------------------------------------------------
@@ -194,18 +509,51 @@ cy_rslt_t mtb_block_storage_create_pdl(mtb_block_storage_t* bsd)
         bsd->read = mtb_block_storage_pdl_read;
         bsd->program = mtb_block_storage_pdl_program;
         bsd->erase = mtb_block_storage_pdl_erase;
+        #if defined(_MTB_BLOCK_STORAGE_PDL_NON_BLOCKING)
+        bsd->program_nb = mtb_block_storage_pdl_program_nb;
+        bsd->erase_nb = mtb_block_storage_pdl_erase_nb;
+        bsd->register_callback = mtb_block_storage_pdl_register_callback;
+        bsd->poll = mtb_block_storage_pdl_poll;
+        #else
         bsd->program_nb = NULL; //Setting NULL, as program_nb is not supported
         bsd->erase_nb = NULL; //Setting NULL, as erase_nb is not supported
+        bsd->register_callback = NULL; //Setting NULL, as non blocking operations are not supported
+        bsd->poll = NULL; //Setting NULL, as non blocking operations are not supported
+        #endif
         bsd->get_read_size = mtb_block_storage_pdl_read_size;
         bsd->get_program_size = mtb_block_storage_pdl_program_size;
         bsd->get_erase_size = mtb_block_storage_pdl_erase_size;
         bsd->get_erase_value = mtb_block_storage_pdl_erase_value;
         bsd->is_in_range = mtb_block_storage_pdl_is_in_range;
         bsd->is_erase_required = mtb_block_storage_pdl_is_erase_required;
+        bsd->get_geometry = mtb_block_storage_pdl_get_geometry;
+        bsd->readv = NULL; //Setting NULL, mtb_block_storage_readv reads the fragments one by one
+        bsd->programv = NULL; //Setting NULL, mtb_block_storage_programv programs them one by one
+        bsd->map = mtb_block_storage_pdl_map;
+        bsd->unmap = mtb_block_storage_pdl_unmap;
         bsd->context = NULL;
     }
     return result;
 }
 
 
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_pdl_set_options
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t mtb_block_storage_pdl_set_options(mtb_block_storage_t* bsd, uint32_t options)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    if ((NULL == bsd) || (bsd->program != mtb_block_storage_pdl_program))
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+    }
+    else
+    {
+        _mtb_block_storage_pdl_options = options;
+    }
+    return result;
+}
+
+
 #endif // if defined(COMPONENT_CAT2)
@@ -0,0 +1,678 @@
+/***********************************************************************************************//**
+ * \file mtb_block_storage_queue.c
+ *
+ * \brief
+ * Request queue for block storage devices. Read, program and erase requests from several clients
+ * are collected, merged and ordered before being issued to the device.
+ *
+ ***************************************************************************************************
+ * \copyright
+ * Copyright 2024 Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **************************************************************************************************/
+#include "mtb_block_storage_queue.h"
+#include "cy_utils.h"
+
+#include <string.h>
+
+#if defined(MTB_BLOCK_STORAGE_QUEUE_WORKER_SUPPORTED)
+//Time the worker waits between two checks of an operation started without waiting
+#define _MTB_BLOCK_STORAGE_QUEUE_POLL_MS    (1u)
+#endif
+
+/*******************************************************************************
+*                       Private Function Definitions
+*******************************************************************************/
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_queue_lock
+//--------------------------------------------------------------------------------------------------
+static inline void _mtb_block_storage_queue_lock(mtb_block_storage_queue_t* queue)
+{
+    #if defined(MTB_BLOCK_STORAGE_QUEUE_WORKER_SUPPORTED)
+    (void)cy_rtos_get_mutex(&queue->mutex, CY_RTOS_NEVER_TIMEOUT);
+    #else
+    CY_UNUSED_PARAMETER(queue);
+    #endif
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_queue_unlock
+//--------------------------------------------------------------------------------------------------
+static inline void _mtb_block_storage_queue_unlock(mtb_block_storage_queue_t* queue)
+{
+    #if defined(MTB_BLOCK_STORAGE_QUEUE_WORKER_SUPPORTED)
+    (void)cy_rtos_set_mutex(&queue->mutex);
+    #else
+    CY_UNUSED_PARAMETER(queue);
+    #endif
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_queue_overlaps
+//--------------------------------------------------------------------------------------------------
+static inline bool _mtb_block_storage_queue_overlaps(const mtb_block_storage_request_t* request,
+                                                     uint32_t addr, uint32_t end)
+{
+    return (request->range_addr < end) && (addr < request->range_end);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_queue_unlink
+//--------------------------------------------------------------------------------------------------
+static void _mtb_block_storage_queue_unlink(mtb_block_storage_queue_t* queue,
+                                            mtb_block_storage_request_t* prev,
+                                            mtb_block_storage_request_t* request)
+{
+    if (NULL == prev)
+    {
+        queue->head = request->next;
+    }
+    else
+    {
+        prev->next = request->next;
+    }
+    if (queue->tail == request)
+    {
+        queue->tail = prev;
+    }
+    request->next = NULL;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_queue_can_merge
+//--------------------------------------------------------------------------------------------------
+static bool _mtb_block_storage_queue_can_merge(const mtb_block_storage_queue_t* queue,
+                                               const mtb_block_storage_request_t* first,
+                                               const mtb_block_storage_request_t* second)
+{
+    if (first->type != second->type)
+    {
+        return false;
+    }
+
+    //Programs are only merged when they touch, as programming the same area twice is not the
+    //same as programming it once. Reads and erases can also overlap.
+    bool touches = (first->range_end == second->range_addr) ||
+                   (second->range_end == first->range_addr);
+    bool overlaps = _mtb_block_storage_queue_overlaps(first, second->range_addr,
+                                                      second->range_end);
+    if (!touches && !(overlaps && (first->type != MTB_BLOCK_STORAGE_REQUEST_PROGRAM)))
+    {
+        return false;
+    }
+
+    uint32_t addr = (first->range_addr < second->range_addr) ? first->range_addr :
+                    second->range_addr;
+    uint32_t end = (first->range_end > second->range_end) ? first->range_end : second->range_end;
+    bool covered = (addr == first->range_addr) && (end == first->range_end);
+
+    if ((first->type != MTB_BLOCK_STORAGE_REQUEST_ERASE) && ((end - addr) > queue->staging_size))
+    {
+        return false;
+    }
+    //The merged operation is issued as one call, so it has to stay in a single region
+    if (!covered && (NULL != queue->bsd->is_in_range) &&
+        !queue->bsd->is_in_range(queue->bsd->context, addr, end - addr))
+    {
+        return false;
+    }
+
+    //Merging moves the second request to the position of the first one, so it overtakes all the
+    //requests submitted in between. Two requests with overlapping ranges must complete in
+    //submission order, unless both are reads.
+    for (const mtb_block_storage_request_t* later = first->next;
+         (NULL != later) && (later != second); later = later->next)
+    {
+        if (_mtb_block_storage_queue_overlaps(later, second->range_addr, second->range_end) &&
+            !((later->type == MTB_BLOCK_STORAGE_REQUEST_READ) &&
+              (second->type == MTB_BLOCK_STORAGE_REQUEST_READ)))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_queue_join
+//--------------------------------------------------------------------------------------------------
+static void _mtb_block_storage_queue_join(mtb_block_storage_request_t* first,
+                                          mtb_block_storage_request_t* second)
+{
+    mtb_block_storage_request_t* last = first;
+    while (NULL != last->merged)
+    {
+        last = last->merged;
+    }
+    last->merged = second;
+    if (second->range_addr < first->range_addr)
+    {
+        first->range_addr = second->range_addr;
+    }
+    if (second->range_end > first->range_end)
+    {
+        first->range_end = second->range_end;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_queue_try_merge
+//--------------------------------------------------------------------------------------------------
+static bool _mtb_block_storage_queue_try_merge(mtb_block_storage_queue_t* queue,
+                                               mtb_block_storage_request_t* request)
+{
+    mtb_block_storage_request_t* target = NULL;
+
+    //An erase already covered by a pending erase is dropped and completes together with it
+    for (mtb_block_storage_request_t* pending = queue->head; NULL != pending;
+         pending = pending->next)
+    {
+        if (_mtb_block_storage_queue_can_merge(queue, pending, request))
+        {
+            _mtb_block_storage_queue_join(pending, request);
+            target = pending;
+            break;
+        }
+    }
+
+    //The grown range can now touch other pending requests, e.g. programs submitted out of order
+    bool merged = (NULL != target);
+    while (merged)
+    {
+        merged = false;
+        bool target_seen = false;
+        mtb_block_storage_request_t* prev = NULL;
+        for (mtb_block_storage_request_t* other = queue->head; NULL != other;
+             prev = other, other = other->next)
+        {
+            if (other == target)
+            {
+                target_seen = true;
+            }
+            else if (target_seen && _mtb_block_storage_queue_can_merge(queue, target, other))
+            {
+                _mtb_block_storage_queue_unlink(queue, prev, other);
+                _mtb_block_storage_queue_join(target, other);
+                merged = true;
+                break;
+            }
+            else if (!target_seen && _mtb_block_storage_queue_can_merge(queue, other, target))
+            {
+                mtb_block_storage_request_t* target_prev = other;
+                while (target_prev->next != target)
+                {
+                    target_prev = target_prev->next;
+                }
+                _mtb_block_storage_queue_unlink(queue, target_prev, target);
+                _mtb_block_storage_queue_join(other, target);
+                target = other;
+                merged = true;
+                break;
+            }
+        }
+    }
+    return (NULL != target);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_queue_pick
+//--------------------------------------------------------------------------------------------------
+static mtb_block_storage_request_t* _mtb_block_storage_queue_pick(mtb_block_storage_queue_t* queue)
+{
+    mtb_block_storage_request_t* ahead = NULL;
+    mtb_block_storage_request_t* lowest = NULL;
+    mtb_block_storage_request_t* prev = NULL;
+    mtb_block_storage_request_t* ahead_prev = NULL;
+    mtb_block_storage_request_t* lowest_prev = NULL;
+
+    for (mtb_block_storage_request_t* candidate = queue->head; NULL != candidate;
+         prev = candidate, candidate = candidate->next)
+    {
+        //A request that overlaps an earlier one has to wait for it, reads can overtake reads
+        bool ready = true;
+        for (const mtb_block_storage_request_t* earlier = queue->head; earlier != candidate;
+             earlier = earlier->next)
+        {
+            if (_mtb_block_storage_queue_overlaps(earlier, candidate->range_addr,
+                                                  candidate->range_end) &&
+                !((earlier->type == MTB_BLOCK_STORAGE_REQUEST_READ) &&
+                  (candidate->type == MTB_BLOCK_STORAGE_REQUEST_READ)))
+            {
+                ready = false;
+                break;
+            }
+        }
+        if (!ready)
+        {
+            continue;
+        }
+
+        //Keep moving in ascending address order, wrap around to the lowest address at the end
+        if ((candidate->range_addr >= queue->position) &&
+            ((NULL == ahead) || (candidate->range_addr < ahead->range_addr)))
+        {
+            ahead = candidate;
+            ahead_prev = prev;
+        }
+        if ((NULL == lowest) || (candidate->range_addr < lowest->range_addr))
+        {
+            lowest = candidate;
+            lowest_prev = prev;
+        }
+    }
+
+    mtb_block_storage_request_t* picked = (NULL != ahead) ? ahead : lowest;
+    if (NULL != picked)
+    {
+        _mtb_block_storage_queue_unlink(queue, (NULL != ahead) ? ahead_prev : lowest_prev,
+                                        picked);
+        queue->position = picked->range_end;
+    }
+    return picked;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_queue_prepare
+//--------------------------------------------------------------------------------------------------
+static const uint8_t* _mtb_block_storage_queue_prepare(mtb_block_storage_queue_t* queue,
+                                                       const mtb_block_storage_request_t* request)
+{
+    const uint8_t* data = request->buf;
+    if ((request->type == MTB_BLOCK_STORAGE_REQUEST_PROGRAM) && (NULL != request->merged))
+    {
+        //Gather the data of all the merged programs in the staging buffer
+        for (const mtb_block_storage_request_t* part = request; NULL != part; part = part->merged)
+        {
+            (void)memcpy(&queue->staging_buf[part->addr - request->range_addr], part->buf,
+                         part->length);
+        }
+        data = queue->staging_buf;
+    }
+    return data;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_queue_execute
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_queue_execute(mtb_block_storage_queue_t* queue,
+                                                  const mtb_block_storage_request_t* request)
+{
+    mtb_block_storage_t* bsd = queue->bsd;
+    uint32_t length = request->range_end - request->range_addr;
+    cy_rslt_t result;
+
+    if (request->type == MTB_BLOCK_STORAGE_REQUEST_READ)
+    {
+        if (NULL == request->merged)
+        {
+            result = bsd->read(bsd->context, request->addr, request->length, request->buf);
+        }
+        else
+        {
+            result = bsd->read(bsd->context, request->range_addr, length, queue->staging_buf);
+            for (const mtb_block_storage_request_t* part = request;
+                 (result == CY_RSLT_SUCCESS) && (NULL != part); part = part->merged)
+            {
+                (void)memcpy(part->buf, &queue->staging_buf[part->addr - request->range_addr],
+                             part->length);
+            }
+        }
+    }
+    else if (request->type == MTB_BLOCK_STORAGE_REQUEST_PROGRAM)
+    {
+        result = bsd->program(bsd->context, request->range_addr, length,
+                              _mtb_block_storage_queue_prepare(queue, request));
+    }
+    else
+    {
+        result = bsd->erase(bsd->context, request->range_addr, length);
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_queue_start
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_queue_start(mtb_block_storage_queue_t* queue,
+                                                const mtb_block_storage_request_t* request)
+{
+    mtb_block_storage_t* bsd = queue->bsd;
+    uint32_t length = request->range_end - request->range_addr;
+    cy_rslt_t result;
+
+    if (request->type == MTB_BLOCK_STORAGE_REQUEST_PROGRAM)
+    {
+        result = bsd->program_nb(bsd->context, request->range_addr, length,
+                                 _mtb_block_storage_queue_prepare(queue, request));
+    }
+    else
+    {
+        result = bsd->erase_nb(bsd->context, request->range_addr, length);
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_queue_complete
+//--------------------------------------------------------------------------------------------------
+static void _mtb_block_storage_queue_complete(mtb_block_storage_request_t* request,
+                                              cy_rslt_t result)
+{
+    while (NULL != request)
+    {
+        //Read the link first, the request can be reused as soon as its callback is invoked
+        mtb_block_storage_request_t* merged = request->merged;
+        request->merged = NULL;
+        if (NULL != request->callback)
+        {
+            request->callback(request->callback_arg, result);
+        }
+        request = merged;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_queue_process
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_queue_process(mtb_block_storage_queue_t* queue)
+{
+    mtb_block_storage_request_t* done = NULL;
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    if (NULL != queue->active)
+    {
+        //Only the thread processing the queue touches the active request
+        result = queue->bsd->poll(queue->bsd->context);
+        if (result != MTB_BLOCK_STORAGE_BUSY)
+        {
+            done = queue->active;
+            queue->active = NULL;
+        }
+    }
+    else
+    {
+        _mtb_block_storage_queue_lock(queue);
+        mtb_block_storage_request_t* request = _mtb_block_storage_queue_pick(queue);
+        _mtb_block_storage_queue_unlock(queue);
+
+        if (NULL != request)
+        {
+            if (queue->use_nb && (request->type != MTB_BLOCK_STORAGE_REQUEST_READ))
+            {
+                result = _mtb_block_storage_queue_start(queue, request);
+                if (result == CY_RSLT_SUCCESS)
+                {
+                    queue->active = request;
+                    result = MTB_BLOCK_STORAGE_BUSY;
+                }
+                else if (result == MTB_BLOCK_STORAGE_NOT_SUPPORTED_ERROR)
+                {
+                    //The device only provides the blocking operations
+                    queue->use_nb = false;
+                }
+                else
+                {
+                    done = request;
+                }
+            }
+            if ((NULL == queue->active) && (NULL == done))
+            {
+                result = _mtb_block_storage_queue_execute(queue, request);
+                done = request;
+            }
+        }
+    }
+
+    if (NULL != done)
+    {
+        _mtb_block_storage_queue_complete(done, result);
+    }
+
+    _mtb_block_storage_queue_lock(queue);
+    bool idle = (NULL == queue->head) && (NULL == queue->active);
+    _mtb_block_storage_queue_unlock(queue);
+    return idle ? CY_RSLT_SUCCESS : MTB_BLOCK_STORAGE_BUSY;
+}
+
+
+#if defined(MTB_BLOCK_STORAGE_QUEUE_WORKER_SUPPORTED)
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_queue_worker
+//--------------------------------------------------------------------------------------------------
+static void _mtb_block_storage_queue_worker(cy_thread_arg_t arg)
+{
+    mtb_block_storage_queue_t* queue = (mtb_block_storage_queue_t*)arg;
+
+    while (!queue->stop)
+    {
+        if (_mtb_block_storage_queue_process(queue) == MTB_BLOCK_STORAGE_BUSY)
+        {
+            if (NULL != queue->active)
+            {
+                //Give the CPU away while the device works on its own
+                (void)cy_rtos_delay_milliseconds(_MTB_BLOCK_STORAGE_QUEUE_POLL_MS);
+            }
+        }
+        else
+        {
+            (void)cy_rtos_get_semaphore(&queue->semaphore, CY_RTOS_NEVER_TIMEOUT, false);
+        }
+    }
+    (void)cy_rtos_exit_thread();
+}
+
+
+#endif // defined(MTB_BLOCK_STORAGE_QUEUE_WORKER_SUPPORTED)
+
+/*******************************************************************************
+*                        Public Function Definitions
+*******************************************************************************/
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_queue_init
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t mtb_block_storage_queue_init(mtb_block_storage_queue_t* queue, mtb_block_storage_t* bsd,
+                                       uint8_t* staging_buf, uint32_t staging_size)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    if ((NULL == queue) || (NULL == bsd) || ((NULL == staging_buf) && (0u != staging_size)))
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+    }
+
+    if (result == CY_RSLT_SUCCESS)
+    {
+        (void)memset(queue, 0, sizeof(*queue));
+        queue->bsd = bsd;
+        queue->staging_buf = staging_buf;
+        queue->staging_size = (NULL != staging_buf) ? staging_size : 0u;
+        queue->use_nb = (NULL != bsd->program_nb) && (NULL != bsd->erase_nb) &&
+                        (NULL != bsd->poll);
+
+        #if defined(MTB_BLOCK_STORAGE_QUEUE_WORKER_SUPPORTED)
+        result = cy_rtos_init_mutex(&queue->mutex);
+        if (result == CY_RSLT_SUCCESS)
+        {
+            result = cy_rtos_init_semaphore(&queue->semaphore, 1u, 0u);
+            if (result != CY_RSLT_SUCCESS)
+            {
+                (void)cy_rtos_deinit_mutex(&queue->mutex);
+            }
+        }
+        #endif // defined(MTB_BLOCK_STORAGE_QUEUE_WORKER_SUPPORTED)
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_queue_submit
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t mtb_block_storage_queue_submit(mtb_block_storage_queue_t* queue,
+                                         mtb_block_storage_request_t* request)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    if ((NULL == queue) || (NULL == request) || (request->type > MTB_BLOCK_STORAGE_REQUEST_ERASE) ||
+        ((NULL == request->buf) && (request->type != MTB_BLOCK_STORAGE_REQUEST_ERASE)))
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+    }
+    else if ((0u == request->length) || ((request->addr + request->length) < request->addr))
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_SIZE_ERROR;
+    }
+
+    if (result == CY_RSLT_SUCCESS)
+    {
+        request->next = NULL;
+        request->merged = NULL;
+        request->range_addr = request->addr;
+        request->range_end = request->addr + request->length;
+
+        _mtb_block_storage_queue_lock(queue);
+        if (!_mtb_block_storage_queue_try_merge(queue, request))
+        {
+            if (NULL == queue->tail)
+            {
+                queue->head = request;
+            }
+            else
+            {
+                queue->tail->next = request;
+            }
+            queue->tail = request;
+        }
+        _mtb_block_storage_queue_unlock(queue);
+
+        #if defined(MTB_BLOCK_STORAGE_QUEUE_WORKER_SUPPORTED)
+        if (queue->worker_started)
+        {
+            (void)cy_rtos_set_semaphore(&queue->semaphore, false);
+        }
+        #endif
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_queue_process
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t mtb_block_storage_queue_process(mtb_block_storage_queue_t* queue)
+{
+    cy_rslt_t result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+
+    if (NULL != queue)
+    {
+        result = _mtb_block_storage_queue_process(queue);
+    }
+    return result;
+}
+
+
+#if defined(MTB_BLOCK_STORAGE_QUEUE_WORKER_SUPPORTED)
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_queue_start_worker
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t mtb_block_storage_queue_start_worker(mtb_block_storage_queue_t* queue, void* stack,
+                                               uint32_t stack_size,
+                                               cy_thread_priority_t priority)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    if ((NULL == queue) || queue->worker_started)
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+    }
+
+    if (result == CY_RSLT_SUCCESS)
+    {
+        queue->stop = false;
+        result = cy_rtos_create_thread(&queue->thread, _mtb_block_storage_queue_worker,
+                                       "block_storage_queue", stack, stack_size, priority,
+                                       (cy_thread_arg_t)queue);
+        queue->worker_started = (result == CY_RSLT_SUCCESS);
+    }
+    return result;
+}
+
+
+#endif // defined(MTB_BLOCK_STORAGE_QUEUE_WORKER_SUPPORTED)
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_queue_deinit
+//--------------------------------------------------------------------------------------------------
+void mtb_block_storage_queue_deinit(mtb_block_storage_queue_t* queue)
+{
+    if (NULL != queue)
+    {
+        #if defined(MTB_BLOCK_STORAGE_QUEUE_WORKER_SUPPORTED)
+        if (queue->worker_started)
+        {
+            queue->stop = true;
+            (void)cy_rtos_set_semaphore(&queue->semaphore, false);
+            (void)cy_rtos_join_thread(&queue->thread);
+            queue->worker_started = false;
+        }
+        #endif // defined(MTB_BLOCK_STORAGE_QUEUE_WORKER_SUPPORTED)
+
+        //The device cannot stop an operation it started, it is completed with its result
+        if (NULL != queue->active)
+        {
+            cy_rslt_t result;
+            do
+            {
+                result = queue->bsd->poll(queue->bsd->context);
+            } while (result == MTB_BLOCK_STORAGE_BUSY);
+            _mtb_block_storage_queue_complete(queue->active, result);
+            queue->active = NULL;
+        }
+
+        //No thread processes the queue anymore, the pending requests are not issued
+        _mtb_block_storage_queue_lock(queue);
+        mtb_block_storage_request_t* request = queue->head;
+        queue->head = NULL;
+        queue->tail = NULL;
+        _mtb_block_storage_queue_unlock(queue);
+        while (NULL != request)
+        {
+            mtb_block_storage_request_t* next = request->next;
+            request->next = NULL;
+            _mtb_block_storage_queue_complete(request, MTB_BLOCK_STORAGE_CANCELLED_ERROR);
+            request = next;
+        }
+
+        #if defined(MTB_BLOCK_STORAGE_QUEUE_WORKER_SUPPORTED)
+        (void)cy_rtos_deinit_semaphore(&queue->semaphore);
+        (void)cy_rtos_deinit_mutex(&queue->mutex);
+        #endif // defined(MTB_BLOCK_STORAGE_QUEUE_WORKER_SUPPORTED)
+    }
+}
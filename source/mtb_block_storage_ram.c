@@ -0,0 +1,692 @@
+/***********************************************************************************************//**
+ * \file mtb_block_storage_ram.c
+ *
+ * \brief
+ * Utility library for defining a simulated storage backed by RAM. It models the geometry,
+ * the programming rules and the timing of a flash device so that code built on top of the
+ * block storage interface can be tested without hardware.
+ *
+ ***************************************************************************************************
+ * \copyright
+ * Copyright 2024 Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **************************************************************************************************/
+#include "mtb_block_storage.h"
+#include "mtb_block_storage_trace.h"
+#include "cy_utils.h"
+
+#include <string.h>
+
+#define _MTB_BLOCK_STORAGE_RAM_NB_IDLE      (0u)
+#define _MTB_BLOCK_STORAGE_RAM_NB_PROGRAM   (1u)
+#define _MTB_BLOCK_STORAGE_RAM_NB_ERASE     (2u)
+
+/*******************************************************************************
+*                       Private Function Definitions
+*******************************************************************************/
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ram_get_region
+//--------------------------------------------------------------------------------------------------
+static int32_t _mtb_block_storage_ram_get_region(const mtb_block_storage_ram_t* obj, uint32_t addr,
+                                                 uint32_t length)
+{
+    for (uint32_t region = 0; region < obj->config.region_count; region++)
+    {
+        const mtb_block_storage_ram_region_t* info = &obj->config.regions[region];
+        if ((addr >= info->start_address) && ((addr - info->start_address) < info->size) &&
+            (length <= (info->size - (addr - info->start_address))))
+        {
+            return (int32_t)region;
+        }
+    }
+    return -1;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ram_spend
+//--------------------------------------------------------------------------------------------------
+static void _mtb_block_storage_ram_spend(mtb_block_storage_ram_t* obj, uint32_t latency_us)
+{
+    obj->elapsed_us += latency_us;
+    if ((NULL != obj->config.delay) && (0u != latency_us))
+    {
+        obj->config.delay(latency_us);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ram_load_program_map
+//--------------------------------------------------------------------------------------------------
+static void _mtb_block_storage_ram_load_program_map(mtb_block_storage_ram_t* obj)
+{
+    //The program units of existing content that do not read as erased are programmed
+    for (uint32_t region = 0; region < obj->config.region_count; region++)
+    {
+        const mtb_block_storage_ram_region_t* info = &obj->config.regions[region];
+        const uint8_t* mem = &obj->config.memory[obj->memory_offset[region]];
+        uint32_t unit_count = info->is_erase_required ? (info->size / info->program_size) : 0u;
+        for (uint32_t unit = 0; unit < unit_count; unit++)
+        {
+            for (uint32_t i = unit * info->program_size; i < ((unit + 1u) * info->program_size);
+                 i++)
+            {
+                if (mem[i] != info->erase_value)
+                {
+                    uint32_t bit = obj->map_offset[region] + unit;
+                    obj->config.program_map[bit / 32u] |= (1u << (bit % 32u));
+                    break;
+                }
+            }
+        }
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ram_read_size
+//--------------------------------------------------------------------------------------------------
+static uint32_t _mtb_block_storage_ram_read_size(void* context, uint32_t addr)
+{
+    CY_UNUSED_PARAMETER(context);
+    CY_UNUSED_PARAMETER(addr);
+    return 1;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ram_program_size
+//--------------------------------------------------------------------------------------------------
+static uint32_t _mtb_block_storage_ram_program_size(void* context, uint32_t addr)
+{
+    const mtb_block_storage_ram_t* obj = (const mtb_block_storage_ram_t*)context;
+    int32_t region = _mtb_block_storage_ram_get_region(obj, addr, 0);
+    return (region < 0) ? 0u : obj->config.regions[region].program_size;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ram_erase_size
+//--------------------------------------------------------------------------------------------------
+static uint32_t _mtb_block_storage_ram_erase_size(void* context, uint32_t addr)
+{
+    const mtb_block_storage_ram_t* obj = (const mtb_block_storage_ram_t*)context;
+    int32_t region = _mtb_block_storage_ram_get_region(obj, addr, 0);
+    return (region < 0) ? 0u : obj->config.regions[region].erase_size;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ram_erase_value
+//--------------------------------------------------------------------------------------------------
+static uint8_t _mtb_block_storage_ram_erase_value(void* context, uint32_t addr)
+{
+    const mtb_block_storage_ram_t* obj = (const mtb_block_storage_ram_t*)context;
+    int32_t region = _mtb_block_storage_ram_get_region(obj, addr, 0);
+    return (region < 0) ? 0u : obj->config.regions[region].erase_value;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ram_do_program
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_ram_do_program(mtb_block_storage_ram_t* obj, uint32_t addr,
+                                                   uint32_t length, const uint8_t* buf)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    int32_t region = _mtb_block_storage_ram_get_region(obj, addr, length);
+    const mtb_block_storage_ram_region_t* info = NULL;
+
+    if (region < 0)
+    {
+        result = MTB_BLOCK_STORAGE_NOT_IN_RANGE_ERROR;
+    }
+    else
+    {
+        info = &obj->config.regions[region];
+        if (0u != ((addr - info->start_address) % info->program_size))
+        {
+            result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+        }
+        else if (0u != (length % info->program_size))
+        {
+            result = MTB_BLOCK_STORAGE_INVALID_SIZE_ERROR;
+        }
+    }
+
+    if (result == CY_RSLT_SUCCESS)
+    {
+        uint32_t first_unit = (addr - info->start_address) / info->program_size;
+        uint32_t unit_count = length / info->program_size;
+        uint32_t* map = obj->config.program_map;
+        uint8_t* mem = &obj->config.memory[obj->memory_offset[region] +
+                                           (addr - info->start_address)];
+
+        //Check the whole range first so that a rejected program leaves the memory untouched. A
+        //device with regions requiring an erase always has a program map.
+        if (info->is_erase_required)
+        {
+            for (uint32_t unit = 0; unit < unit_count; unit++)
+            {
+                uint32_t bit = obj->map_offset[region] + first_unit + unit;
+                if (0u != (map[bit / 32u] & (1u << (bit % 32u))))
+                {
+                    result = MTB_BLOCK_STORAGE_NOT_ERASED_ERROR;
+                    break;
+                }
+            }
+        }
+
+        if (result == CY_RSLT_SUCCESS)
+        {
+            if (info->is_erase_required)
+            {
+                //Programming can only move bits away from the erased state
+                uint8_t erase_value = info->erase_value;
+                for (uint32_t i = 0; i < length; i++)
+                {
+                    mem[i] = (uint8_t)(erase_value ^ ((mem[i] ^ erase_value) |
+                                                      (buf[i] ^ erase_value)));
+                }
+                for (uint32_t unit = 0; unit < unit_count; unit++)
+                {
+                    uint32_t bit = obj->map_offset[region] + first_unit + unit;
+                    map[bit / 32u] |= (1u << (bit % 32u));
+                }
+            }
+            else
+            {
+                (void)memcpy(mem, buf, length);
+            }
+            _mtb_block_storage_ram_spend(obj, info->program_latency_us * unit_count);
+        }
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ram_do_erase
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_ram_do_erase(mtb_block_storage_ram_t* obj, uint32_t addr,
+                                                 uint32_t length)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    int32_t region = _mtb_block_storage_ram_get_region(obj, addr, length);
+    const mtb_block_storage_ram_region_t* info = NULL;
+
+    if (region < 0)
+    {
+        result = MTB_BLOCK_STORAGE_NOT_IN_RANGE_ERROR;
+    }
+    else
+    {
+        info = &obj->config.regions[region];
+        if (0u != ((addr - info->start_address) % info->erase_size))
+        {
+            result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+        }
+        else if (0u != (length % info->erase_size))
+        {
+            result = MTB_BLOCK_STORAGE_INVALID_SIZE_ERROR;
+        }
+    }
+
+    if (result == CY_RSLT_SUCCESS)
+    {
+        (void)memset(&obj->config.memory[obj->memory_offset[region] +
+                                         (addr - info->start_address)],
+                     info->erase_value, length);
+
+        if (NULL != obj->config.program_map)
+        {
+            uint32_t first_bit = obj->map_offset[region] +
+                                 ((addr - info->start_address) / info->program_size);
+            for (uint32_t bit = first_bit; bit < first_bit + (length / info->program_size); bit++)
+            {
+                obj->config.program_map[bit / 32u] &= ~(1u << (bit % 32u));
+            }
+        }
+        _mtb_block_storage_ram_spend(obj, info->erase_latency_us * (length / info->erase_size));
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ram_poll
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_ram_poll(void* context)
+{
+    mtb_block_storage_ram_t* obj = (mtb_block_storage_ram_t*)context;
+    cy_rslt_t result = obj->nb_result;
+
+    if (_MTB_BLOCK_STORAGE_RAM_NB_IDLE != obj->nb_operation)
+    {
+        //Every call performs one program or erase unit, like a device completing one row
+        int32_t region = _mtb_block_storage_ram_get_region(obj, obj->nb_addr, 0);
+        if (_MTB_BLOCK_STORAGE_RAM_NB_PROGRAM == obj->nb_operation)
+        {
+            uint32_t unit = obj->config.regions[region].program_size;
+            result = _mtb_block_storage_ram_do_program(obj, obj->nb_addr, unit, obj->nb_buf);
+            obj->nb_buf += unit;
+            obj->nb_addr += unit;
+        }
+        else
+        {
+            uint32_t unit = obj->config.regions[region].erase_size;
+            result = _mtb_block_storage_ram_do_erase(obj, obj->nb_addr, unit);
+            obj->nb_addr += unit;
+        }
+
+        if ((result == CY_RSLT_SUCCESS) && (obj->nb_addr < obj->nb_end))
+        {
+            result = MTB_BLOCK_STORAGE_BUSY;
+        }
+        else
+        {
+            obj->nb_operation = _MTB_BLOCK_STORAGE_RAM_NB_IDLE;
+            obj->nb_result = result;
+            if (NULL != obj->callback)
+            {
+                obj->callback(obj->callback_arg, result);
+            }
+        }
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ram_complete
+//--------------------------------------------------------------------------------------------------
+static void _mtb_block_storage_ram_complete(mtb_block_storage_ram_t* obj)
+{
+    //Blocking operations finish the non blocking one first, as a device can only do one at a time
+    while (_mtb_block_storage_ram_poll(obj) == MTB_BLOCK_STORAGE_BUSY)
+    {
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ram_complete_for_read
+//--------------------------------------------------------------------------------------------------
+static void _mtb_block_storage_ram_complete_for_read(mtb_block_storage_ram_t* obj,
+                                                     const mtb_block_storage_ram_region_t* info)
+{
+    //A bank cannot be read while it is being programmed or erased, the other banks can
+    if (_MTB_BLOCK_STORAGE_RAM_NB_IDLE != obj->nb_operation)
+    {
+        int32_t nb_region = _mtb_block_storage_ram_get_region(obj, obj->nb_addr, 0);
+        if ((nb_region < 0) || (obj->config.regions[nb_region].bank == info->bank))
+        {
+            _mtb_block_storage_ram_complete(obj);
+        }
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ram_map
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_ram_map(void* context, uint32_t addr, uint32_t length,
+                                            const uint8_t** ptr)
+{
+    mtb_block_storage_ram_t* obj = (mtb_block_storage_ram_t*)context;
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    int32_t region = _mtb_block_storage_ram_get_region(obj, addr, length);
+
+    if (region < 0)
+    {
+        result = MTB_BLOCK_STORAGE_NOT_IN_RANGE_ERROR;
+    }
+    else
+    {
+        //Like the internal flash, the memory is read in place without any read latency
+        const mtb_block_storage_ram_region_t* info = &obj->config.regions[region];
+        _mtb_block_storage_ram_complete_for_read(obj, info);
+        *ptr = &obj->config.memory[obj->memory_offset[region] + (addr - info->start_address)];
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ram_unmap
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_ram_unmap(void* context, const uint8_t* ptr, uint32_t length)
+{
+    CY_UNUSED_PARAMETER(context);
+    CY_UNUSED_PARAMETER(ptr);
+    CY_UNUSED_PARAMETER(length);
+    return CY_RSLT_SUCCESS;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ram_start
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_ram_start(mtb_block_storage_ram_t* obj, uint8_t operation,
+                                              uint32_t addr, uint32_t length, const uint8_t* buf)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    int32_t region = _mtb_block_storage_ram_get_region(obj, addr, length);
+
+    if (_MTB_BLOCK_STORAGE_RAM_NB_IDLE != obj->nb_operation)
+    {
+        result = MTB_BLOCK_STORAGE_BUSY;
+    }
+    else if (region < 0)
+    {
+        result = MTB_BLOCK_STORAGE_NOT_IN_RANGE_ERROR;
+    }
+    else
+    {
+        const mtb_block_storage_ram_region_t* info = &obj->config.regions[region];
+        uint32_t unit = (_MTB_BLOCK_STORAGE_RAM_NB_PROGRAM == operation)
+            ? info->program_size : info->erase_size;
+        if (0u != ((addr - info->start_address) % unit))
+        {
+            result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+        }
+        else if ((0u == length) || (0u != (length % unit)))
+        {
+            result = MTB_BLOCK_STORAGE_INVALID_SIZE_ERROR;
+        }
+    }
+
+    if (result == CY_RSLT_SUCCESS)
+    {
+        obj->nb_addr = addr;
+        obj->nb_end = addr + length;
+        obj->nb_buf = buf;
+        obj->nb_result = MTB_BLOCK_STORAGE_BUSY;
+        obj->nb_operation = operation;
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ram_program_nb
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_ram_program_nb(void* context, uint32_t addr, uint32_t length,
+                                                   const uint8_t* buf)
+{
+    return _mtb_block_storage_ram_start((mtb_block_storage_ram_t*)context,
+                                        _MTB_BLOCK_STORAGE_RAM_NB_PROGRAM, addr, length, buf);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ram_erase_nb
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_ram_erase_nb(void* context, uint32_t addr, uint32_t length)
+{
+    return _mtb_block_storage_ram_start((mtb_block_storage_ram_t*)context,
+                                        _MTB_BLOCK_STORAGE_RAM_NB_ERASE, addr, length, NULL);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ram_register_callback
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_ram_register_callback(
+    void* context, mtb_block_storage_async_callback_t callback, void* callback_arg)
+{
+    mtb_block_storage_ram_t* obj = (mtb_block_storage_ram_t*)context;
+    obj->callback = callback;
+    obj->callback_arg = callback_arg;
+    return CY_RSLT_SUCCESS;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ram_is_in_range
+//--------------------------------------------------------------------------------------------------
+static bool _mtb_block_storage_ram_is_in_range(void* context, uint32_t addr, uint32_t length)
+{
+    return _mtb_block_storage_ram_get_region((const mtb_block_storage_ram_t*)context, addr,
+                                             length) >= 0;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ram_is_erase_required
+//--------------------------------------------------------------------------------------------------
+static bool _mtb_block_storage_ram_is_erase_required(void* context, uint32_t addr, uint32_t length)
+{
+    const mtb_block_storage_ram_t* obj = (const mtb_block_storage_ram_t*)context;
+    int32_t region = _mtb_block_storage_ram_get_region(obj, addr, length);
+    return (region < 0) ? true : obj->config.regions[region].is_erase_required;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_ram_get_geometry
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_ram_get_geometry(void* context,
+                                                     mtb_block_storage_region_t* regions,
+                                                     uint32_t max_regions, uint32_t* region_count)
+{
+    const mtb_block_storage_ram_t* obj = (const mtb_block_storage_ram_t*)context;
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    for (uint32_t region = 0; (region < obj->config.region_count) && (region < max_regions);
+         region++)
+    {
+        const mtb_block_storage_ram_region_t* info = &obj->config.regions[region];
+        regions[region].start_address = info->start_address;
+        regions[region].size = info->size;
+        regions[region].read_size = 1;
+        regions[region].program_size = info->program_size;
+        regions[region].erase_size = info->erase_size;
+        regions[region].erase_value = info->erase_value;
+        regions[region].is_erase_required = info->is_erase_required;
+        regions[region].bank = info->bank;
+    }
+    *region_count = obj->config.region_count;
+    if (obj->config.region_count > max_regions)
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_SIZE_ERROR;
+    }
+    return result;
+}
+
+
+/*******************************************************************************
+*                        Public Function Definitions
+*******************************************************************************/
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_ram_read
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t mtb_block_storage_ram_read(void* context, uint32_t addr, uint32_t length, uint8_t* buf)
+{
+    mtb_block_storage_ram_t* obj = (mtb_block_storage_ram_t*)context;
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint32_t trace = MTB_BLOCK_STORAGE_TRACE_BEGIN(MTB_BLOCK_STORAGE_TRACE_READ, context, addr,
+                                                   length);
+    int32_t region = _mtb_block_storage_ram_get_region(obj, addr, length);
+
+    if (region < 0)
+    {
+        result = MTB_BLOCK_STORAGE_NOT_IN_RANGE_ERROR;
+    }
+    else
+    {
+        const mtb_block_storage_ram_region_t* info = &obj->config.regions[region];
+        _mtb_block_storage_ram_complete_for_read(obj, info);
+        (void)memcpy(buf, &obj->config.memory[obj->memory_offset[region] +
+                                              (addr - info->start_address)], length);
+        _mtb_block_storage_ram_spend(obj, info->read_latency_us);
+    }
+    MTB_BLOCK_STORAGE_TRACE_END(trace, result);
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_ram_program
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t mtb_block_storage_ram_program(void* context, uint32_t addr, uint32_t length,
+                                        const uint8_t* buf)
+{
+    mtb_block_storage_ram_t* obj = (mtb_block_storage_ram_t*)context;
+    uint32_t trace = MTB_BLOCK_STORAGE_TRACE_BEGIN(MTB_BLOCK_STORAGE_TRACE_PROGRAM, context, addr,
+                                                   length);
+    cy_rslt_t result;
+    _mtb_block_storage_ram_complete(obj);
+    result = _mtb_block_storage_ram_do_program(obj, addr, length, buf);
+    MTB_BLOCK_STORAGE_TRACE_END(trace, result);
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_ram_erase
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t mtb_block_storage_ram_erase(void* context, uint32_t addr, uint32_t length)
+{
+    mtb_block_storage_ram_t* obj = (mtb_block_storage_ram_t*)context;
+    uint32_t trace = MTB_BLOCK_STORAGE_TRACE_BEGIN(MTB_BLOCK_STORAGE_TRACE_ERASE, context, addr,
+                                                   length);
+    cy_rslt_t result;
+    _mtb_block_storage_ram_complete(obj);
+    result = _mtb_block_storage_ram_do_erase(obj, addr, length);
+    MTB_BLOCK_STORAGE_TRACE_END(trace, result);
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_ram_get_program_map_size
+//--------------------------------------------------------------------------------------------------
+uint32_t mtb_block_storage_ram_get_program_map_size(const mtb_block_storage_ram_region_t* regions,
+                                                    uint32_t region_count)
+{
+    uint32_t bits = 0;
+    for (uint32_t region = 0; region < region_count; region++)
+    {
+        if (0u != regions[region].program_size)
+        {
+            bits += regions[region].size / regions[region].program_size;
+        }
+    }
+    return (bits + 31u) / 32u;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_create_ram
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t mtb_block_storage_create_ram(mtb_block_storage_t* bsd, mtb_block_storage_ram_t* obj,
+                                       const mtb_block_storage_ram_config_t* config)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    if ((NULL == bsd) || (NULL == obj) || (NULL == config) || (NULL == config->regions) ||
+        (NULL == config->memory) || (0u == config->region_count) ||
+        (config->region_count > MTB_BLOCK_STORAGE_RAM_MAX_REGIONS))
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+    }
+
+    if (result == CY_RSLT_SUCCESS)
+    {
+        uint32_t memory_offset = 0;
+        uint32_t map_offset = 0;
+        for (uint32_t region = 0; region < config->region_count; region++)
+        {
+            const mtb_block_storage_ram_region_t* info = &config->regions[region];
+            const mtb_block_storage_ram_region_t* prev = (region > 0u) ? (info - 1) : NULL;
+            if ((0u == info->program_size) || (0u == info->erase_size) || (0u == info->size) ||
+                (0u != (info->erase_size % info->program_size)) ||
+                (0u != (info->size % info->erase_size)) ||
+                ((NULL != prev) && ((info->start_address < prev->start_address) ||
+                                    ((info->start_address - prev->start_address) < prev->size))))
+            {
+                result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+                break;
+            }
+            //Reprogramming without an erase is only detected with a program map
+            if (info->is_erase_required && (NULL == config->program_map))
+            {
+                result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+                break;
+            }
+            obj->memory_offset[region] = memory_offset;
+            obj->map_offset[region] = map_offset;
+            memory_offset += info->size;
+            map_offset += info->size / info->program_size;
+        }
+    }
+
+    if (result == CY_RSLT_SUCCESS)
+    {
+        obj->config = *config;
+        obj->elapsed_us = 0;
+        obj->nb_operation = _MTB_BLOCK_STORAGE_RAM_NB_IDLE;
+        obj->nb_result = CY_RSLT_SUCCESS;
+        obj->callback = NULL;
+        obj->callback_arg = NULL;
+
+        if (NULL != config->program_map)
+        {
+            (void)memset(config->program_map, 0,
+                         mtb_block_storage_ram_get_program_map_size(config->regions,
+                                                                    config->region_count) *
+                         sizeof(uint32_t));
+            if (!config->initialize)
+            {
+                _mtb_block_storage_ram_load_program_map(obj);
+            }
+        }
+        if (config->initialize)
+        {
+            for (uint32_t region = 0; region < config->region_count; region++)
+            {
+                (void)memset(&config->memory[obj->memory_offset[region]],
+                             config->regions[region].erase_value, config->regions[region].size);
+            }
+        }
+
+        bsd->read = mtb_block_storage_ram_read;
+        bsd->program = mtb_block_storage_ram_program;
+        bsd->erase = mtb_block_storage_ram_erase;
+        bsd->program_nb = _mtb_block_storage_ram_program_nb;
+        bsd->erase_nb = _mtb_block_storage_ram_erase_nb;
+        bsd->get_read_size = _mtb_block_storage_ram_read_size;
+        bsd->get_program_size = _mtb_block_storage_ram_program_size;
+        bsd->get_erase_size = _mtb_block_storage_ram_erase_size;
+        bsd->get_erase_value = _mtb_block_storage_ram_erase_value;
+        bsd->is_in_range = _mtb_block_storage_ram_is_in_range;
+        bsd->is_erase_required = _mtb_block_storage_ram_is_erase_required;
+        bsd->get_geometry = _mtb_block_storage_ram_get_geometry;
+        bsd->register_callback = _mtb_block_storage_ram_register_callback;
+        bsd->poll = _mtb_block_storage_ram_poll;
+        //Setting NULL, the vectored calls are split by mtb_block_storage_readv and programv
+        bsd->readv = NULL;
+        bsd->programv = NULL;
+        bsd->map = _mtb_block_storage_ram_map;
+        bsd->unmap = _mtb_block_storage_ram_unmap;
+        bsd->context = obj;
+    }
+    return result;
+}
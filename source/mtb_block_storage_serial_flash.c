@@ -26,6 +26,7 @@
 #if defined(COMPONENT_SERIAL_FLASH)
 
 #include "mtb_block_storage.h"
+#include "mtb_block_storage_trace.h"
 
 /*******************************************************************************
 *                       Private Function Definitions
@@ -80,8 +81,12 @@ static cy_rslt_t _mtb_block_storage_serial_flash_read(void* context, uint32_t ad
                                                       uint32_t length,
                                                       uint8_t* buf)
 {
+    uint32_t trace = MTB_BLOCK_STORAGE_TRACE_BEGIN(MTB_BLOCK_STORAGE_TRACE_READ, context, addr,
+                                                   length);
     CY_UNUSED_PARAMETER(context);
-    return cy_serial_flash_qspi_read(addr, length, buf);
+    cy_rslt_t result = cy_serial_flash_qspi_read(addr, length, buf);
+    MTB_BLOCK_STORAGE_TRACE_END(trace, result);
+    return result;
 }
 
 
@@ -92,8 +97,24 @@ static cy_rslt_t _mtb_block_storage_serial_flash_program(void* context, uint32_t
                                                          uint32_t length,
                                                          const uint8_t* buf)
 {
+    uint32_t trace = MTB_BLOCK_STORAGE_TRACE_BEGIN(MTB_BLOCK_STORAGE_TRACE_PROGRAM, context, addr,
+                                                   length);
+    CY_UNUSED_PARAMETER(context);
+    cy_rslt_t result = cy_serial_flash_qspi_write(addr, length, buf);
+    MTB_BLOCK_STORAGE_TRACE_END(trace, result);
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_serial_flash_is_in_range
+//--------------------------------------------------------------------------------------------------
+static bool _mtb_block_storage_serial_flash_is_in_range(void* context, uint32_t addr,
+                                                        uint32_t length)
+{
+    uint32_t size = (uint32_t)cy_serial_flash_qspi_get_size();
     CY_UNUSED_PARAMETER(context);
-    return cy_serial_flash_qspi_write(addr, length, buf);
+    return (addr < size) && (length <= (size - addr));
 }
 
 
@@ -118,8 +139,77 @@ static bool _mtb_block_storage_serial_flash_is_erase_required(void* context, uin
 static cy_rslt_t _mtb_block_storage_serial_flash_erase(void* context, uint32_t addr,
                                                        uint32_t length)
 {
+    uint32_t trace = MTB_BLOCK_STORAGE_TRACE_BEGIN(MTB_BLOCK_STORAGE_TRACE_ERASE, context, addr,
+                                                   length);
     CY_UNUSED_PARAMETER(context);
-    return cy_serial_flash_qspi_erase(addr, length);
+    cy_rslt_t result = cy_serial_flash_qspi_erase(addr, length);
+    MTB_BLOCK_STORAGE_TRACE_END(trace, result);
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_serial_flash_get_geometry
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_serial_flash_get_geometry(void* context,
+                                                              mtb_block_storage_region_t* regions,
+                                                              uint32_t max_regions,
+                                                              uint32_t* region_count)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint32_t size = (uint32_t)cy_serial_flash_qspi_get_size();
+    uint32_t count = 0;
+    uint32_t addr = 0;
+    uint32_t last_program_size = 0;
+    uint32_t last_erase_size = 0;
+
+    //Walk the sectors and merge consecutive ones of the same geometry, so that hybrid sector
+    //layouts show up as separate regions
+    while ((result == CY_RSLT_SUCCESS) && (addr < size))
+    {
+        uint32_t program_size = cy_serial_flash_qspi_get_prog_size(addr);
+        uint32_t erase_size = cy_serial_flash_qspi_get_erase_size(addr);
+
+        if (0u == erase_size)
+        {
+            result = MTB_BLOCK_STORAGE_NOT_SUPPORTED_ERROR;
+        }
+        else if ((count > 0u) && (last_program_size == program_size) &&
+                 (last_erase_size == erase_size))
+        {
+            if (count <= max_regions)
+            {
+                regions[count - 1u].size += erase_size;
+            }
+        }
+        else
+        {
+            if (count < max_regions)
+            {
+                regions[count].start_address = addr;
+                regions[count].size = erase_size;
+                regions[count].read_size = 1;
+                regions[count].program_size = program_size;
+                regions[count].erase_size = erase_size;
+                regions[count].erase_value =
+                    _mtb_block_storage_serial_flash_erase_value(context, addr);
+                regions[count].is_erase_required =
+                    _mtb_block_storage_serial_flash_is_erase_required(context, addr, erase_size);
+                regions[count].bank = 0;
+            }
+            last_program_size = program_size;
+            last_erase_size = erase_size;
+            count++;
+        }
+        addr += erase_size;
+    }
+
+    *region_count = count;
+    if ((result == CY_RSLT_SUCCESS) && (count > max_regions))
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_SIZE_ERROR;
+    }
+    return result;
 }
 
 
@@ -146,9 +236,16 @@ cy_rslt_t mtb_block_storage_create_serial_flash(mtb_block_storage_t* bsd)
         bsd->get_erase_size = _mtb_block_storage_serial_flash_erase_size;
         bsd->get_erase_value = _mtb_block_storage_serial_flash_erase_value;
         bsd->is_erase_required = _mtb_block_storage_serial_flash_is_erase_required;
+        bsd->get_geometry = _mtb_block_storage_serial_flash_get_geometry;
+        bsd->register_callback = NULL; //Setting NULL, as non blocking operations are not supported
+        bsd->poll = NULL; //Setting NULL, as non blocking operations are not supported
+        bsd->readv = NULL; //Setting NULL, mtb_block_storage_readv reads the fragments one by one
+        bsd->programv = NULL; //Setting NULL, mtb_block_storage_programv programs them one by one
+        bsd->map = NULL; //Setting NULL, the memory is read through the serial interface
+        bsd->unmap = NULL; //Setting NULL, as map is not supported
         bsd->program_nb = NULL; //Setting NULL, as program_nb is not supported
         bsd->erase_nb = NULL; //Setting NULL, as erase_nb is not supported
-        bsd->is_in_range = NULL; //Setting NULL, as is_in_range is not supported
+        bsd->is_in_range = _mtb_block_storage_serial_flash_is_in_range;
         bsd->context = NULL; //Context is not used
     }
     return result;
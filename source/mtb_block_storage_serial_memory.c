@@ -26,6 +26,9 @@
 #if defined(COMPONENT_MW_SERIAL_MEMORY)
 
 #include "mtb_block_storage.h"
+#include "mtb_block_storage_trace.h"
+
+#include <string.h>
 
 /*******************************************************************************
 *                       Private Function Definitions
@@ -78,7 +81,11 @@ static cy_rslt_t _mtb_block_storage_serial_memory_read(void* context, uint32_t a
                                                        uint32_t length,
                                                        uint8_t* buf)
 {
-    return mtb_serial_memory_read((mtb_serial_memory_t*)context, addr, length, buf);
+    uint32_t trace = MTB_BLOCK_STORAGE_TRACE_BEGIN(MTB_BLOCK_STORAGE_TRACE_READ, context, addr,
+                                                   length);
+    cy_rslt_t result = mtb_serial_memory_read((mtb_serial_memory_t*)context, addr, length, buf);
+    MTB_BLOCK_STORAGE_TRACE_END(trace, result);
+    return result;
 }
 
 
@@ -89,7 +96,22 @@ static cy_rslt_t _mtb_block_storage_serial_memory_program(void* context, uint32_
                                                           uint32_t length,
                                                           const uint8_t* buf)
 {
-    return mtb_serial_memory_write((mtb_serial_memory_t*)context, addr, length, buf);
+    uint32_t trace = MTB_BLOCK_STORAGE_TRACE_BEGIN(MTB_BLOCK_STORAGE_TRACE_PROGRAM, context, addr,
+                                                   length);
+    cy_rslt_t result = mtb_serial_memory_write((mtb_serial_memory_t*)context, addr, length, buf);
+    MTB_BLOCK_STORAGE_TRACE_END(trace, result);
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_serial_memory_is_in_range
+//--------------------------------------------------------------------------------------------------
+static bool _mtb_block_storage_serial_memory_is_in_range(void* context, uint32_t addr,
+                                                         uint32_t length)
+{
+    uint32_t size = (uint32_t)mtb_serial_memory_get_size((mtb_serial_memory_t*)context);
+    return (addr < size) && (length <= (size - addr));
 }
 
 
@@ -114,7 +136,316 @@ static bool _mtb_block_storage_serial_memory_is_erase_required(void* context, ui
 static cy_rslt_t _mtb_block_storage_serial_memory_erase(void* context, uint32_t addr,
                                                         uint32_t length)
 {
-    return mtb_serial_memory_erase((mtb_serial_memory_t*)context, addr, length);
+    uint32_t trace = MTB_BLOCK_STORAGE_TRACE_BEGIN(MTB_BLOCK_STORAGE_TRACE_ERASE, context, addr,
+                                                   length);
+    cy_rslt_t result = mtb_serial_memory_erase((mtb_serial_memory_t*)context, addr, length);
+    MTB_BLOCK_STORAGE_TRACE_END(trace, result);
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_serial_memory_get_geometry
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_serial_memory_get_geometry(void* context,
+                                                               mtb_block_storage_region_t* regions,
+                                                               uint32_t max_regions,
+                                                               uint32_t* region_count)
+{
+    mtb_serial_memory_t* obj = (mtb_serial_memory_t*)context;
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint32_t size = mtb_serial_memory_get_size(obj);
+    uint32_t count = 0;
+    uint32_t addr = 0;
+    uint32_t last_program_size = 0;
+    uint32_t last_erase_size = 0;
+
+    //Walk the sectors and merge consecutive ones of the same geometry, so that hybrid sector
+    //layouts show up as separate regions
+    while ((result == CY_RSLT_SUCCESS) && (addr < size))
+    {
+        uint32_t program_size = mtb_serial_memory_get_prog_size(obj, addr);
+        uint32_t erase_size = mtb_serial_memory_get_erase_size(obj, addr);
+
+        if (0u == erase_size)
+        {
+            result = MTB_BLOCK_STORAGE_NOT_SUPPORTED_ERROR;
+        }
+        else if ((count > 0u) && (last_program_size == program_size) &&
+                 (last_erase_size == erase_size))
+        {
+            if (count <= max_regions)
+            {
+                regions[count - 1u].size += erase_size;
+            }
+        }
+        else
+        {
+            if (count < max_regions)
+            {
+                regions[count].start_address = addr;
+                regions[count].size = erase_size;
+                regions[count].read_size = 1;
+                regions[count].program_size = program_size;
+                regions[count].erase_size = erase_size;
+                regions[count].erase_value =
+                    _mtb_block_storage_serial_memory_erase_value(context, addr);
+                regions[count].is_erase_required =
+                    _mtb_block_storage_serial_memory_is_erase_required(context, addr, erase_size);
+                regions[count].bank = 0;
+            }
+            last_program_size = program_size;
+            last_erase_size = erase_size;
+            count++;
+        }
+        addr += erase_size;
+    }
+
+    *region_count = count;
+    if ((result == CY_RSLT_SUCCESS) && (count > max_regions))
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_SIZE_ERROR;
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_serial_memory_cached_program_size
+//--------------------------------------------------------------------------------------------------
+static uint32_t _mtb_block_storage_serial_memory_cached_program_size(void* context, uint32_t addr)
+{
+    mtb_block_storage_serial_memory_cached_t* cached =
+        (mtb_block_storage_serial_memory_cached_t*)context;
+    return _mtb_block_storage_serial_memory_program_size(cached->memory, addr);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_serial_memory_cached_erase_size
+//--------------------------------------------------------------------------------------------------
+static uint32_t _mtb_block_storage_serial_memory_cached_erase_size(void* context, uint32_t addr)
+{
+    mtb_block_storage_serial_memory_cached_t* cached =
+        (mtb_block_storage_serial_memory_cached_t*)context;
+    return _mtb_block_storage_serial_memory_erase_size(cached->memory, addr);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_serial_memory_cached_is_in_range
+//--------------------------------------------------------------------------------------------------
+static bool _mtb_block_storage_serial_memory_cached_is_in_range(void* context, uint32_t addr,
+                                                                uint32_t length)
+{
+    mtb_block_storage_serial_memory_cached_t* cached =
+        (mtb_block_storage_serial_memory_cached_t*)context;
+    return _mtb_block_storage_serial_memory_is_in_range(cached->memory, addr, length);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_serial_memory_cached_get_geometry
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_serial_memory_cached_get_geometry(
+    void* context, mtb_block_storage_region_t* regions, uint32_t max_regions,
+    uint32_t* region_count)
+{
+    mtb_block_storage_serial_memory_cached_t* cached =
+        (mtb_block_storage_serial_memory_cached_t*)context;
+    return _mtb_block_storage_serial_memory_get_geometry(cached->memory, regions, max_regions,
+                                                         region_count);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_serial_memory_cached_lookup
+//--------------------------------------------------------------------------------------------------
+static mtb_block_storage_serial_memory_cache_line_t* _mtb_block_storage_serial_memory_cached_lookup(
+    mtb_block_storage_serial_memory_cached_t* cached, uint32_t line_addr)
+{
+    for (uint32_t i = 0; i < cached->line_count; i++)
+    {
+        if (cached->lines[i].valid && (cached->lines[i].addr == line_addr))
+        {
+            return &cached->lines[i];
+        }
+    }
+    return NULL;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_serial_memory_cached_fill
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_serial_memory_cached_fill(
+    mtb_block_storage_serial_memory_cached_t* cached, uint32_t line_addr, uint32_t count,
+    mtb_block_storage_serial_memory_cache_line_t** filled)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint32_t line_size = cached->config.line_size;
+    uint32_t size = (uint32_t)mtb_serial_memory_get_size(cached->memory);
+
+    //Stop the prefetch at the end of the memory and at the first line that is already cached
+    for (uint32_t i = 1; i < count; i++)
+    {
+        uint32_t addr = line_addr + (i * line_size);
+        if ((addr >= size) ||
+            (NULL != _mtb_block_storage_serial_memory_cached_lookup(cached, addr)))
+        {
+            count = i;
+        }
+    }
+
+    //The lines are read with one command, so they need consecutive slots. Take the slots whose
+    //most recent use is the oldest.
+    uint32_t first = 0;
+    uint32_t first_use = UINT32_MAX;
+    for (uint32_t i = 0; (i + count) <= cached->line_count; i++)
+    {
+        uint32_t use = 0;
+        for (uint32_t j = i; j < (i + count); j++)
+        {
+            uint32_t line_use = cached->lines[j].valid ? cached->lines[j].last_use : 0u;
+            use = (line_use > use) ? line_use : use;
+        }
+        if (use < first_use)
+        {
+            first = i;
+            first_use = use;
+        }
+    }
+
+    for (uint32_t i = first; i < (first + count); i++)
+    {
+        cached->lines[i].valid = false;
+    }
+    result = mtb_serial_memory_read(cached->memory, line_addr, count * line_size,
+                                    &cached->config.buffer[first * line_size]);
+    if (result == CY_RSLT_SUCCESS)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            cached->lines[first + i].addr = line_addr + (i * line_size);
+            cached->lines[first + i].last_use = cached->use_counter;
+            cached->lines[first + i].valid = true;
+        }
+        *filled = &cached->lines[first];
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_serial_memory_cached_read
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_serial_memory_cached_read(void* context, uint32_t addr,
+                                                              uint32_t length, uint8_t* buf)
+{
+    uint32_t trace = MTB_BLOCK_STORAGE_TRACE_BEGIN(MTB_BLOCK_STORAGE_TRACE_READ, context, addr,
+                                                   length);
+    mtb_block_storage_serial_memory_cached_t* cached =
+        (mtb_block_storage_serial_memory_cached_t*)context;
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint32_t line_size = cached->config.line_size;
+    uint32_t end = addr + length;
+    bool sequential = (addr == cached->next_addr);
+
+    cached->next_addr = end;
+    //A read of at least a line costs one command either way, so it does not go through the cache
+    if ((length >= line_size) || (addr >= mtb_serial_memory_get_size(cached->memory)))
+    {
+        result = mtb_serial_memory_read(cached->memory, addr, length, buf);
+    }
+    else
+    {
+        uint32_t current = addr;
+        while ((result == CY_RSLT_SUCCESS) && (current < end))
+        {
+            uint32_t line_addr = current - (current % line_size);
+            mtb_block_storage_serial_memory_cache_line_t* line =
+                _mtb_block_storage_serial_memory_cached_lookup(cached, line_addr);
+            cached->use_counter++;
+            if (NULL == line)
+            {
+                uint32_t count = sequential ? (1u + cached->config.prefetch_lines) : 1u;
+                if (count > cached->line_count)
+                {
+                    count = cached->line_count;
+                }
+                result = _mtb_block_storage_serial_memory_cached_fill(cached, line_addr, count,
+                                                                      &line);
+            }
+            if (result == CY_RSLT_SUCCESS)
+            {
+                uint32_t offset = current - line_addr;
+                uint32_t chunk = ((end - current) < (line_size - offset)) ? (end - current) :
+                                 (line_size - offset);
+                uint32_t slot = (uint32_t)(line - cached->lines);
+                memcpy(&buf[current - addr], &cached->config.buffer[(slot * line_size) + offset],
+                       chunk);
+                line->last_use = cached->use_counter;
+                current += chunk;
+            }
+        }
+    }
+    MTB_BLOCK_STORAGE_TRACE_END(trace, result);
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_serial_memory_cached_invalidate
+//--------------------------------------------------------------------------------------------------
+static void _mtb_block_storage_serial_memory_cached_invalidate(
+    mtb_block_storage_serial_memory_cached_t* cached, uint32_t addr, uint32_t length)
+{
+    for (uint32_t i = 0; i < cached->line_count; i++)
+    {
+        mtb_block_storage_serial_memory_cache_line_t* line = &cached->lines[i];
+        if (line->valid && (line->addr < (addr + length)) &&
+            (addr < (line->addr + cached->config.line_size)))
+        {
+            line->valid = false;
+        }
+    }
+    cached->next_addr = UINT32_MAX;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_serial_memory_cached_program
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_serial_memory_cached_program(void* context, uint32_t addr,
+                                                                 uint32_t length,
+                                                                 const uint8_t* buf)
+{
+    uint32_t trace = MTB_BLOCK_STORAGE_TRACE_BEGIN(MTB_BLOCK_STORAGE_TRACE_PROGRAM, context, addr,
+                                                   length);
+    mtb_block_storage_serial_memory_cached_t* cached =
+        (mtb_block_storage_serial_memory_cached_t*)context;
+    //Invalidated whatever the result, a failed program can leave part of the area modified
+    _mtb_block_storage_serial_memory_cached_invalidate(cached, addr, length);
+    cy_rslt_t result = mtb_serial_memory_write(cached->memory, addr, length, buf);
+    MTB_BLOCK_STORAGE_TRACE_END(trace, result);
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_serial_memory_cached_erase
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_serial_memory_cached_erase(void* context, uint32_t addr,
+                                                               uint32_t length)
+{
+    uint32_t trace = MTB_BLOCK_STORAGE_TRACE_BEGIN(MTB_BLOCK_STORAGE_TRACE_ERASE, context, addr,
+                                                   length);
+    mtb_block_storage_serial_memory_cached_t* cached =
+        (mtb_block_storage_serial_memory_cached_t*)context;
+    _mtb_block_storage_serial_memory_cached_invalidate(cached, addr, length);
+    cy_rslt_t result = mtb_serial_memory_erase(cached->memory, addr, length);
+    MTB_BLOCK_STORAGE_TRACE_END(trace, result);
+    return result;
 }
 
 
@@ -141,13 +472,63 @@ cy_rslt_t mtb_block_storage_create_serial_memory(mtb_block_storage_t* bsd, mtb_s
         bsd->get_erase_size = _mtb_block_storage_serial_memory_erase_size;
         bsd->get_erase_value = _mtb_block_storage_serial_memory_erase_value;
         bsd->is_erase_required = _mtb_block_storage_serial_memory_is_erase_required;
+        bsd->get_geometry = _mtb_block_storage_serial_memory_get_geometry;
+        bsd->register_callback = NULL; //Setting NULL, as non blocking operations are not supported
+        bsd->poll = NULL; //Setting NULL, as non blocking operations are not supported
+        bsd->readv = NULL; //Setting NULL, mtb_block_storage_readv reads the fragments one by one
+        bsd->programv = NULL; //Setting NULL, mtb_block_storage_programv programs them one by one
+        bsd->map = NULL; //Setting NULL, the memory is read through the serial interface
+        bsd->unmap = NULL; //Setting NULL, as map is not supported
         bsd->program_nb = NULL; //Setting NULL, as program_nb is not supported
         bsd->erase_nb = NULL; //Setting NULL, as erase_nb is not supported
-        bsd->is_in_range = NULL; //Setting NULL, as is_in_range is not supported
+        bsd->is_in_range = _mtb_block_storage_serial_memory_is_in_range;
         bsd->context = obj;
     }
     return result;
 }
 
 
+/** Creates and sets up the block storage object for serial memory with a read cache */
+cy_rslt_t mtb_block_storage_create_serial_memory_cached(
+    mtb_block_storage_t* bsd, mtb_block_storage_serial_memory_cached_t* cached,
+    mtb_serial_memory_t* obj, const mtb_block_storage_serial_memory_cache_config_t* config)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    if ((NULL == bsd) || (NULL == cached) || (NULL == obj) || (NULL == config) ||
+        (NULL == config->buffer) || (0u == config->line_size) ||
+        (config->buffer_size < config->line_size) ||
+        (0u != (mtb_serial_memory_get_size(obj) % config->line_size)))
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+    }
+    if (result == CY_RSLT_SUCCESS)
+    {
+        result = mtb_block_storage_create_serial_memory(bsd, obj);
+    }
+    if (result == CY_RSLT_SUCCESS)
+    {
+        memset(cached, 0, sizeof(*cached));
+        cached->memory = obj;
+        cached->config = *config;
+        cached->line_count = config->buffer_size / config->line_size;
+        if (cached->line_count > MTB_BLOCK_STORAGE_SERIAL_MEMORY_CACHE_MAX_LINES)
+        {
+            cached->line_count = MTB_BLOCK_STORAGE_SERIAL_MEMORY_CACHE_MAX_LINES;
+        }
+        cached->next_addr = UINT32_MAX;
+
+        bsd->read = _mtb_block_storage_serial_memory_cached_read;
+        bsd->program = _mtb_block_storage_serial_memory_cached_program;
+        bsd->erase = _mtb_block_storage_serial_memory_cached_erase;
+        bsd->get_program_size = _mtb_block_storage_serial_memory_cached_program_size;
+        bsd->get_erase_size = _mtb_block_storage_serial_memory_cached_erase_size;
+        bsd->get_geometry = _mtb_block_storage_serial_memory_cached_get_geometry;
+        bsd->is_in_range = _mtb_block_storage_serial_memory_cached_is_in_range;
+        bsd->context = cached;
+    }
+    return result;
+}
+
+
 #endif // defined(COMPONENT_MW_SERIAL_MEMORY)
@@ -0,0 +1,561 @@
+/***********************************************************************************************//**
+ * \file mtb_block_storage_stats.c
+ *
+ * \brief
+ * Statistics for block storage devices. Wraps a block storage device and records the count, size,
+ * latency and errors of its operations, and how many times each erase unit was erased.
+ *
+ ***************************************************************************************************
+ * \copyright
+ * Copyright 2024 Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **************************************************************************************************/
+#if defined(__unix__) || defined(__APPLE__)
+#if !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+#endif // if defined(__unix__) || defined(__APPLE__)
+
+#include "mtb_block_storage_stats.h"
+#include "cy_utils.h"
+
+#include <string.h>
+
+#if (MTB_BLOCK_STORAGE_STATS_ENABLED)
+
+//Built-in clock: monotonic clock on host builds, DWT cycle counter on the cores that have one
+#if defined(__unix__) || defined(__APPLE__)
+#include <time.h>
+#define _MTB_BLOCK_STORAGE_STATS_HOST_CLOCK
+#elif defined(COMPONENT_CAT1) || defined(COMPONENT_CAT2)
+#include "cy_device_headers.h"
+#if defined(DWT_CTRL_CYCCNTENA_Msk)
+#define _MTB_BLOCK_STORAGE_STATS_DWT_CLOCK
+#endif
+#endif
+
+#define _MTB_BLOCK_STORAGE_STATS_NB_NONE    (0xFFu)
+
+/*******************************************************************************
+*                       Private Function Definitions
+*******************************************************************************/
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_stats_now
+//--------------------------------------------------------------------------------------------------
+static inline uint32_t _mtb_block_storage_stats_now(const mtb_block_storage_stats_device_t* obj)
+{
+    uint32_t now = 0;
+    if (NULL != obj->config.clock)
+    {
+        now = obj->config.clock();
+    }
+    #if defined(_MTB_BLOCK_STORAGE_STATS_HOST_CLOCK)
+    else
+    {
+        struct timespec ts;
+        (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+        now = ((uint32_t)ts.tv_sec * 1000000000u) + (uint32_t)ts.tv_nsec;
+    }
+    #elif defined(_MTB_BLOCK_STORAGE_STATS_DWT_CLOCK)
+    else
+    {
+        now = DWT->CYCCNT;
+    }
+    #endif
+    return now;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_stats_record
+//--------------------------------------------------------------------------------------------------
+static void _mtb_block_storage_stats_record(mtb_block_storage_stats_device_t* obj, uint8_t op,
+                                            uint32_t length, uint32_t start, cy_rslt_t result)
+{
+    mtb_block_storage_stats_op_t* stats = &obj->stats.ops[op];
+    uint32_t ticks = _mtb_block_storage_stats_now(obj) - start;
+    uint32_t bucket = 0;
+
+    //Bucket of the latency: number of significant bits of the tick count
+    for (uint32_t value = ticks; (value != 0u) && (bucket < (MTB_BLOCK_STORAGE_STATS_BUCKETS - 1u));
+         value >>= 1)
+    {
+        bucket++;
+    }
+
+    stats->count++;
+    stats->bytes += length;
+    stats->total_ticks += ticks;
+    stats->max_ticks = (ticks > stats->max_ticks) ? ticks : stats->max_ticks;
+    stats->histogram[bucket]++;
+    if (result != CY_RSLT_SUCCESS)
+    {
+        stats->errors++;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_stats_count_erase
+//--------------------------------------------------------------------------------------------------
+static void _mtb_block_storage_stats_count_erase(mtb_block_storage_stats_device_t* obj,
+                                                 uint32_t addr, uint32_t length)
+{
+    const mtb_block_storage_stats_config_t* config = &obj->config;
+    if ((NULL != config->erase_counts) && (0u != length) && ((addr + length) > config->erase_start))
+    {
+        uint32_t first = (addr > config->erase_start) ?
+                         ((addr - config->erase_start) / config->erase_unit) : 0u;
+        uint32_t end = ((addr + length - config->erase_start) + config->erase_unit - 1u) /
+                       config->erase_unit;
+        end = (end < config->erase_count_size) ? end : config->erase_count_size;
+        for (uint32_t i = first; i < end; i++)
+        {
+            config->erase_counts[i]++;
+        }
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_stats_read_size
+//--------------------------------------------------------------------------------------------------
+static uint32_t _mtb_block_storage_stats_read_size(void* context, uint32_t addr)
+{
+    mtb_block_storage_t* bsd = ((mtb_block_storage_stats_device_t*)context)->config.bsd;
+    return bsd->get_read_size(bsd->context, addr);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_stats_program_size
+//--------------------------------------------------------------------------------------------------
+static uint32_t _mtb_block_storage_stats_program_size(void* context, uint32_t addr)
+{
+    mtb_block_storage_t* bsd = ((mtb_block_storage_stats_device_t*)context)->config.bsd;
+    return bsd->get_program_size(bsd->context, addr);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_stats_erase_size
+//--------------------------------------------------------------------------------------------------
+static uint32_t _mtb_block_storage_stats_erase_size(void* context, uint32_t addr)
+{
+    mtb_block_storage_t* bsd = ((mtb_block_storage_stats_device_t*)context)->config.bsd;
+    return bsd->get_erase_size(bsd->context, addr);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_stats_erase_value
+//--------------------------------------------------------------------------------------------------
+static uint8_t _mtb_block_storage_stats_erase_value(void* context, uint32_t addr)
+{
+    mtb_block_storage_t* bsd = ((mtb_block_storage_stats_device_t*)context)->config.bsd;
+    return bsd->get_erase_value(bsd->context, addr);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_stats_read
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_stats_read(void* context, uint32_t addr, uint32_t length,
+                                               uint8_t* buf)
+{
+    mtb_block_storage_stats_device_t* obj = (mtb_block_storage_stats_device_t*)context;
+    uint32_t start = _mtb_block_storage_stats_now(obj);
+    cy_rslt_t result = obj->config.bsd->read(obj->config.bsd->context, addr, length, buf);
+    _mtb_block_storage_stats_record(obj, MTB_BLOCK_STORAGE_STATS_READ, length, start, result);
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_stats_program
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_stats_program(void* context, uint32_t addr, uint32_t length,
+                                                  const uint8_t* buf)
+{
+    mtb_block_storage_stats_device_t* obj = (mtb_block_storage_stats_device_t*)context;
+    uint32_t start = _mtb_block_storage_stats_now(obj);
+    cy_rslt_t result = obj->config.bsd->program(obj->config.bsd->context, addr, length, buf);
+    _mtb_block_storage_stats_record(obj, MTB_BLOCK_STORAGE_STATS_PROGRAM, length, start, result);
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_stats_readv
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_stats_readv(void* context,
+                                                const mtb_block_storage_read_vec_t* vecs,
+                                                uint32_t count)
+{
+    mtb_block_storage_stats_device_t* obj = (mtb_block_storage_stats_device_t*)context;
+    uint32_t length = 0;
+    uint32_t start;
+    cy_rslt_t result;
+
+    //A batch counts as one operation of the total length
+    for (uint32_t i = 0; i < count; i++)
+    {
+        length += vecs[i].length;
+    }
+    start = _mtb_block_storage_stats_now(obj);
+    result = obj->config.bsd->readv(obj->config.bsd->context, vecs, count);
+    _mtb_block_storage_stats_record(obj, MTB_BLOCK_STORAGE_STATS_READ, length, start, result);
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_stats_programv
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_stats_programv(void* context,
+                                                   const mtb_block_storage_program_vec_t* vecs,
+                                                   uint32_t count)
+{
+    mtb_block_storage_stats_device_t* obj = (mtb_block_storage_stats_device_t*)context;
+    uint32_t length = 0;
+    uint32_t start;
+    cy_rslt_t result;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        length += vecs[i].length;
+    }
+    start = _mtb_block_storage_stats_now(obj);
+    result = obj->config.bsd->programv(obj->config.bsd->context, vecs, count);
+    _mtb_block_storage_stats_record(obj, MTB_BLOCK_STORAGE_STATS_PROGRAM, length, start, result);
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_stats_map
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_stats_map(void* context, uint32_t addr, uint32_t length,
+                                              const uint8_t** ptr)
+{
+    mtb_block_storage_stats_device_t* obj = (mtb_block_storage_stats_device_t*)context;
+    //Not counted, the data is then read through the pointer without going through the device
+    return obj->config.bsd->map(obj->config.bsd->context, addr, length, ptr);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_stats_unmap
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_stats_unmap(void* context, const uint8_t* ptr,
+                                                uint32_t length)
+{
+    mtb_block_storage_stats_device_t* obj = (mtb_block_storage_stats_device_t*)context;
+    return obj->config.bsd->unmap(obj->config.bsd->context, ptr, length);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_stats_erase
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_stats_erase(void* context, uint32_t addr, uint32_t length)
+{
+    mtb_block_storage_stats_device_t* obj = (mtb_block_storage_stats_device_t*)context;
+    uint32_t start = _mtb_block_storage_stats_now(obj);
+    cy_rslt_t result = obj->config.bsd->erase(obj->config.bsd->context, addr, length);
+    _mtb_block_storage_stats_record(obj, MTB_BLOCK_STORAGE_STATS_ERASE, length, start, result);
+    if (result == CY_RSLT_SUCCESS)
+    {
+        _mtb_block_storage_stats_count_erase(obj, addr, length);
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_stats_program_nb
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_stats_program_nb(void* context, uint32_t addr,
+                                                     uint32_t length, const uint8_t* buf)
+{
+    mtb_block_storage_stats_device_t* obj = (mtb_block_storage_stats_device_t*)context;
+    //A started operation is recorded when poll or the callback reports its completion, which the
+    //callback may do before program_nb returns. The operation in progress, if any, is restored
+    //when the device rejects the new one
+    uint8_t prev_op = obj->nb_op;
+    uint32_t prev_start = obj->nb_start;
+    uint32_t start = _mtb_block_storage_stats_now(obj);
+    obj->nb_start = start;
+    obj->nb_op = MTB_BLOCK_STORAGE_STATS_PROGRAM_NB;
+    cy_rslt_t result = obj->config.bsd->program_nb(obj->config.bsd->context, addr, length, buf);
+    if (result == CY_RSLT_SUCCESS)
+    {
+        obj->stats.ops[MTB_BLOCK_STORAGE_STATS_PROGRAM_NB].bytes += length;
+    }
+    else
+    {
+        obj->nb_op = prev_op;
+        obj->nb_start = prev_start;
+        _mtb_block_storage_stats_record(obj, MTB_BLOCK_STORAGE_STATS_PROGRAM_NB, length, start,
+                                        result);
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_stats_erase_nb
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_stats_erase_nb(void* context, uint32_t addr, uint32_t length)
+{
+    mtb_block_storage_stats_device_t* obj = (mtb_block_storage_stats_device_t*)context;
+    uint8_t prev_op = obj->nb_op;
+    uint32_t prev_start = obj->nb_start;
+    uint32_t start = _mtb_block_storage_stats_now(obj);
+    obj->nb_start = start;
+    obj->nb_op = MTB_BLOCK_STORAGE_STATS_ERASE_NB;
+    cy_rslt_t result = obj->config.bsd->erase_nb(obj->config.bsd->context, addr, length);
+    if (result == CY_RSLT_SUCCESS)
+    {
+        obj->stats.ops[MTB_BLOCK_STORAGE_STATS_ERASE_NB].bytes += length;
+        _mtb_block_storage_stats_count_erase(obj, addr, length);
+    }
+    else
+    {
+        obj->nb_op = prev_op;
+        obj->nb_start = prev_start;
+        _mtb_block_storage_stats_record(obj, MTB_BLOCK_STORAGE_STATS_ERASE_NB, length, start,
+                                        result);
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_stats_complete
+//--------------------------------------------------------------------------------------------------
+static void _mtb_block_storage_stats_complete(mtb_block_storage_stats_device_t* obj,
+                                              cy_rslt_t result)
+{
+    //Reported by the callback, the poll or both, the operation is only recorded once
+    if (obj->nb_op != _MTB_BLOCK_STORAGE_STATS_NB_NONE)
+    {
+        //The bytes were added when the operation started
+        _mtb_block_storage_stats_record(obj, obj->nb_op, 0u, obj->nb_start, result);
+        obj->nb_op = _MTB_BLOCK_STORAGE_STATS_NB_NONE;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_stats_poll
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_stats_poll(void* context)
+{
+    mtb_block_storage_stats_device_t* obj = (mtb_block_storage_stats_device_t*)context;
+    cy_rslt_t result = obj->config.bsd->poll(obj->config.bsd->context);
+    if (result != MTB_BLOCK_STORAGE_BUSY)
+    {
+        _mtb_block_storage_stats_complete(obj, result);
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_stats_callback
+//--------------------------------------------------------------------------------------------------
+static void _mtb_block_storage_stats_callback(void* callback_arg, cy_rslt_t result)
+{
+    mtb_block_storage_stats_device_t* obj = (mtb_block_storage_stats_device_t*)callback_arg;
+    _mtb_block_storage_stats_complete(obj, result);
+    if (NULL != obj->callback)
+    {
+        obj->callback(obj->callback_arg, result);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_stats_register_callback
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_stats_register_callback(
+    void* context, mtb_block_storage_async_callback_t callback, void* callback_arg)
+{
+    mtb_block_storage_stats_device_t* obj = (mtb_block_storage_stats_device_t*)context;
+    mtb_block_storage_t* bsd = obj->config.bsd;
+    cy_rslt_t result;
+
+    //The completions are recorded by a callback of the device, which then calls the one of the
+    //application, as they can be reported from an interrupt without any poll
+    obj->callback = callback;
+    obj->callback_arg = callback_arg;
+    if (NULL != callback)
+    {
+        result = bsd->register_callback(bsd->context, _mtb_block_storage_stats_callback, obj);
+    }
+    else
+    {
+        result = bsd->register_callback(bsd->context, NULL, NULL);
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_stats_is_in_range
+//--------------------------------------------------------------------------------------------------
+static bool _mtb_block_storage_stats_is_in_range(void* context, uint32_t addr, uint32_t length)
+{
+    mtb_block_storage_t* bsd = ((mtb_block_storage_stats_device_t*)context)->config.bsd;
+    return bsd->is_in_range(bsd->context, addr, length);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_stats_is_erase_required
+//--------------------------------------------------------------------------------------------------
+static bool _mtb_block_storage_stats_is_erase_required(void* context, uint32_t addr,
+                                                       uint32_t length)
+{
+    mtb_block_storage_t* bsd = ((mtb_block_storage_stats_device_t*)context)->config.bsd;
+    //An inner device that does not tell is assumed to need an erase before a program
+    return (NULL == bsd->is_erase_required) ||
+           bsd->is_erase_required(bsd->context, addr, length);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_stats_get_geometry
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t _mtb_block_storage_stats_get_geometry(void* context,
+                                                       mtb_block_storage_region_t* regions,
+                                                       uint32_t max_regions,
+                                                       uint32_t* region_count)
+{
+    mtb_block_storage_t* bsd = ((mtb_block_storage_stats_device_t*)context)->config.bsd;
+    return bsd->get_geometry(bsd->context, regions, max_regions, region_count);
+}
+
+
+#endif // (MTB_BLOCK_STORAGE_STATS_ENABLED)
+
+/*******************************************************************************
+*                        Public Function Definitions
+*******************************************************************************/
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_create_stats
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t mtb_block_storage_create_stats(mtb_block_storage_t* bsd,
+                                         mtb_block_storage_stats_device_t* obj,
+                                         const mtb_block_storage_stats_config_t* config)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    if ((NULL == bsd) || (NULL == obj) || (NULL == config) || (NULL == config->bsd) ||
+        ((NULL != config->erase_counts) && (0u == config->erase_unit)))
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+    }
+
+    if (result == CY_RSLT_SUCCESS)
+    {
+        obj->config = *config;
+        #if (MTB_BLOCK_STORAGE_STATS_ENABLED)
+        mtb_block_storage_stats_reset(obj);
+        obj->nb_op = _MTB_BLOCK_STORAGE_STATS_NB_NONE;
+        obj->callback = NULL;
+        obj->callback_arg = NULL;
+        #if defined(_MTB_BLOCK_STORAGE_STATS_DWT_CLOCK)
+        if (NULL == config->clock)
+        {
+            CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+            DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+        }
+        #endif
+
+        bsd->get_read_size = _mtb_block_storage_stats_read_size;
+        bsd->get_program_size = _mtb_block_storage_stats_program_size;
+        bsd->get_erase_size = _mtb_block_storage_stats_erase_size;
+        bsd->get_erase_value = _mtb_block_storage_stats_erase_value;
+        bsd->read = _mtb_block_storage_stats_read;
+        bsd->program = _mtb_block_storage_stats_program;
+        bsd->erase = _mtb_block_storage_stats_erase;
+        bsd->is_erase_required = _mtb_block_storage_stats_is_erase_required;
+        //The optional functions are only provided if the inner device provides them
+        bsd->program_nb = (NULL != config->bsd->program_nb) ?
+                          _mtb_block_storage_stats_program_nb : NULL;
+        bsd->erase_nb = (NULL != config->bsd->erase_nb) ? _mtb_block_storage_stats_erase_nb : NULL;
+        bsd->is_in_range = (NULL != config->bsd->is_in_range) ?
+                           _mtb_block_storage_stats_is_in_range : NULL;
+        bsd->get_geometry = (NULL != config->bsd->get_geometry) ?
+                            _mtb_block_storage_stats_get_geometry : NULL;
+        bsd->register_callback = (NULL != config->bsd->register_callback) ?
+                                 _mtb_block_storage_stats_register_callback : NULL;
+        bsd->poll = (NULL != config->bsd->poll) ? _mtb_block_storage_stats_poll : NULL;
+        bsd->readv = (NULL != config->bsd->readv) ? _mtb_block_storage_stats_readv : NULL;
+        bsd->programv = (NULL != config->bsd->programv) ? _mtb_block_storage_stats_programv :
+                        NULL;
+        bsd->map = (NULL != config->bsd->map) ? _mtb_block_storage_stats_map : NULL;
+        bsd->unmap = (NULL != config->bsd->unmap) ? _mtb_block_storage_stats_unmap : NULL;
+        bsd->context = obj;
+        #else // if (MTB_BLOCK_STORAGE_STATS_ENABLED)
+        //Compiled out, the calls go straight to the inner device
+        *bsd = *config->bsd;
+        #endif // if (MTB_BLOCK_STORAGE_STATS_ENABLED)
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_stats_get
+//--------------------------------------------------------------------------------------------------
+void mtb_block_storage_stats_get(const mtb_block_storage_stats_device_t* obj,
+                                 mtb_block_storage_stats_t* stats)
+{
+    #if (MTB_BLOCK_STORAGE_STATS_ENABLED)
+    *stats = obj->stats;
+    #else
+    CY_UNUSED_PARAMETER(obj);
+    (void)memset(stats, 0, sizeof(*stats));
+    #endif
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_stats_reset
+//--------------------------------------------------------------------------------------------------
+void mtb_block_storage_stats_reset(mtb_block_storage_stats_device_t* obj)
+{
+    #if (MTB_BLOCK_STORAGE_STATS_ENABLED)
+    (void)memset(&obj->stats, 0, sizeof(obj->stats));
+    #if defined(_MTB_BLOCK_STORAGE_STATS_HOST_CLOCK)
+    obj->stats.clock_hz = (NULL != obj->config.clock) ? obj->config.clock_hz : 1000000000u;
+    #elif defined(_MTB_BLOCK_STORAGE_STATS_DWT_CLOCK)
+    obj->stats.clock_hz = (NULL != obj->config.clock) ? obj->config.clock_hz : SystemCoreClock;
+    #else
+    obj->stats.clock_hz = (NULL != obj->config.clock) ? obj->config.clock_hz : 0u;
+    #endif
+    #endif // if (MTB_BLOCK_STORAGE_STATS_ENABLED)
+    if (NULL != obj->config.erase_counts)
+    {
+        (void)memset(obj->config.erase_counts, 0,
+                     obj->config.erase_count_size * sizeof(uint32_t));
+    }
+}
@@ -0,0 +1,189 @@
+/***********************************************************************************************//**
+ * \file mtb_block_storage_trace.c
+ *
+ * \brief
+ * Trace of the operations of the block storage devices. Records the read, program and erase calls
+ * of the devices in a ring buffer that can be dumped after a crash or a watchdog reset.
+ *
+ ***************************************************************************************************
+ * \copyright
+ * Copyright 2024 Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **************************************************************************************************/
+#include "mtb_block_storage_trace.h"
+
+#include <string.h>
+
+//The ARMv6-M cores, such as the Cortex-M0+ of CAT2 devices or the CM0+ of CAT1A devices, have no
+//exclusive access instructions and compilers such as IAR have no __atomic builtins, so a critical
+//section is used there
+#if defined(COMPONENT_CAT2) || defined(COMPONENT_CM0P) || defined(__ARM_ARCH_6M__) || \
+    !(defined(__GNUC__) || defined(__clang__))
+#define _MTB_BLOCK_STORAGE_TRACE_CRITICAL_SECTION
+#include "cy_syslib.h"
+#endif
+
+//Trace buffer in use, NULL when the trace is stopped
+static mtb_block_storage_trace_header_t* volatile _mtb_block_storage_trace_header = NULL;
+static mtb_block_storage_trace_clock_t _mtb_block_storage_trace_clock = NULL;
+
+/*******************************************************************************
+*                       Private Function Definitions
+*******************************************************************************/
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_trace_reserve
+//--------------------------------------------------------------------------------------------------
+static inline uint32_t _mtb_block_storage_trace_reserve(mtb_block_storage_trace_header_t* header)
+{
+    #if defined(_MTB_BLOCK_STORAGE_TRACE_CRITICAL_SECTION)
+    //MTB_BLOCK_STORAGE_TRACE_NO_RECORD is skipped when the numbering wraps, its sequence would
+    //also be 0
+    uint32_t state = Cy_SysLib_EnterCriticalSection();
+    uint32_t record = header->next;
+    if (record == MTB_BLOCK_STORAGE_TRACE_NO_RECORD)
+    {
+        record = 0u;
+    }
+    header->next = record + 1u;
+    Cy_SysLib_ExitCriticalSection(state);
+    return record;
+    #else
+    uint32_t record;
+    do
+    {
+        record = __atomic_fetch_add(&header->next, 1u, __ATOMIC_RELAXED);
+    } while (record == MTB_BLOCK_STORAGE_TRACE_NO_RECORD);
+    return record;
+    #endif
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// _mtb_block_storage_trace_record
+//--------------------------------------------------------------------------------------------------
+static inline volatile mtb_block_storage_trace_record_t* _mtb_block_storage_trace_record(
+    mtb_block_storage_trace_header_t* header, uint32_t record)
+{
+    volatile mtb_block_storage_trace_record_t* records =
+        (volatile mtb_block_storage_trace_record_t*)(header + 1);
+    return &records[record % header->record_count];
+}
+
+
+/*******************************************************************************
+*                        Public Function Definitions
+*******************************************************************************/
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_trace_start
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t mtb_block_storage_trace_start(void* buffer, uint32_t size,
+                                        mtb_block_storage_trace_clock_t clock, uint32_t clock_hz)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    if ((NULL == buffer) || (0u != ((uintptr_t)buffer % sizeof(uint32_t))) ||
+        (size < (sizeof(mtb_block_storage_trace_header_t) +
+                 sizeof(mtb_block_storage_trace_record_t))))
+    {
+        result = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+    }
+    if (result == CY_RSLT_SUCCESS)
+    {
+        mtb_block_storage_trace_header_t* header = (mtb_block_storage_trace_header_t*)buffer;
+        _mtb_block_storage_trace_header = NULL;
+        (void)memset(buffer, 0, size);
+        header->magic = MTB_BLOCK_STORAGE_TRACE_MAGIC;
+        header->version = MTB_BLOCK_STORAGE_TRACE_VERSION;
+        header->record_size = sizeof(mtb_block_storage_trace_record_t);
+        header->record_count = (uint32_t)((size - sizeof(mtb_block_storage_trace_header_t)) /
+                                          sizeof(mtb_block_storage_trace_record_t));
+        header->clock_hz = clock_hz;
+        _mtb_block_storage_trace_clock = clock;
+        _mtb_block_storage_trace_header = header;
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_trace_stop
+//--------------------------------------------------------------------------------------------------
+void mtb_block_storage_trace_stop(void)
+{
+    _mtb_block_storage_trace_header = NULL;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_trace_begin
+//--------------------------------------------------------------------------------------------------
+uint32_t mtb_block_storage_trace_begin(mtb_block_storage_trace_op_t op, const void* context,
+                                       uint32_t addr, uint32_t length)
+{
+    mtb_block_storage_trace_header_t* header = _mtb_block_storage_trace_header;
+    uint32_t record = MTB_BLOCK_STORAGE_TRACE_NO_RECORD;
+
+    if (NULL != header)
+    {
+        mtb_block_storage_trace_clock_t clock = _mtb_block_storage_trace_clock;
+        volatile mtb_block_storage_trace_record_t* entry;
+        record = _mtb_block_storage_trace_reserve(header);
+        entry = _mtb_block_storage_trace_record(header, record);
+
+        //The sequence is cleared while the fields are written, so a dump never shows a record
+        //mixing two calls
+        entry->sequence = 0u;
+        entry->op = (uint32_t)op;
+        entry->context = (uint32_t)(uintptr_t)context;
+        entry->addr = addr;
+        entry->length = length;
+        entry->start = (NULL != clock) ? clock() : 0u;
+        entry->end = 0u;
+        entry->result = MTB_BLOCK_STORAGE_TRACE_IN_PROGRESS;
+        entry->sequence = record + 1u;
+    }
+    return record;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// mtb_block_storage_trace_end
+//--------------------------------------------------------------------------------------------------
+void mtb_block_storage_trace_end(uint32_t record, cy_rslt_t result)
+{
+    mtb_block_storage_trace_header_t* header = _mtb_block_storage_trace_header;
+
+    //MTB_BLOCK_STORAGE_TRACE_NO_RECORD if the trace was not running when the call started
+    if ((NULL != header) && (record != MTB_BLOCK_STORAGE_TRACE_NO_RECORD))
+    {
+        mtb_block_storage_trace_clock_t clock = _mtb_block_storage_trace_clock;
+        volatile mtb_block_storage_trace_record_t* entry =
+            _mtb_block_storage_trace_record(header, record);
+        if (entry->sequence == (record + 1u))
+        {
+            entry->end = (NULL != clock) ? clock() : 0u;
+            entry->result = (uint32_t)result;
+            //A call that wrapped the ring meanwhile may have reused the record, which would then
+            //hold the end of this call, so the record is dropped
+            if (entry->sequence != (record + 1u))
+            {
+                entry->sequence = 0u;
+            }
+        }
+    }
+}
@@ -0,0 +1,161 @@
+/***********************************************************************************************//**
+ * \file cy_flash.h
+ *
+ * \brief
+ * Host stand-in for the PDL flash driver: the work flash functions of the devices with the ECT
+ * flash controller (CPUSS_FLASHC_ECT) used by the HAL NVM block storage device, and the row
+ * functions of CAT2 devices used by the PDL block storage device. The memory map constants are
+ * only the defaults of the tests, a test can define its own.
+ *
+ ***************************************************************************************************
+ * \copyright
+ * Copyright 2024 Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **************************************************************************************************/
+#pragma once
+
+#include "cy_result.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/** Status of the flash driver */
+typedef enum
+{
+    CY_FLASH_DRV_SUCCESS                = 0x00000000UL, /**< Success */
+    CY_FLASH_DRV_INV_PROT               = 0x00D50000UL, /**< Invalid protection */
+    CY_FLASH_DRV_INVALID_FLASH_ADDR     = 0x00D50001UL, /**< Address outside of the flash */
+    CY_FLASH_DRV_ERR_UNC                = 0x00D50003UL, /**< Failed operation */
+    CY_FLASH_DRV_INVALID_INPUT_PARAMETERS = 0x00D50004UL, /**< Invalid parameter */
+    CY_FLASH_DRV_OPERATION_STARTED      = 0x00D50010UL, /**< Non blocking operation started */
+    CY_FLASH_DRV_OPCODE_BUSY            = 0x00D50011UL, /**< Operation in progress */
+    CY_FLASH_DRV_PROGRESS_NO_ERROR      = 0x00D50012UL, /**< Operation in progress, no error */
+} cy_en_flashdrv_status_t;
+
+/** Returns the status of the operation in progress */
+cy_en_flashdrv_status_t Cy_Flash_IsOperationComplete(void);
+
+#if (CPUSS_FLASHC_ECT == 1)
+#if !defined(CY_FLASH_BASE)
+#define CY_FLASH_BASE                   (0x10000000UL)
+#endif
+#if !defined(CY_FLASH_SIZE)
+#define CY_FLASH_SIZE                   (0x00200000UL)
+#endif
+#if !defined(CY_WFLASH_BASE)
+#define CY_WFLASH_BASE                  (0x14000000UL)
+#endif
+#if !defined(CY_WFLASH_SIZE)
+#define CY_WFLASH_SIZE                  (0x00040000UL)
+#endif
+
+/** Data size of a ProgramRow call */
+typedef enum
+{
+    CY_FLASH_PROGRAMROW_DATA_SIZE_32BIT,    /**< 32 bits */
+    CY_FLASH_PROGRAMROW_DATA_SIZE_1024BIT,  /**< 1024 bits */
+    CY_FLASH_PROGRAMROW_DATA_SIZE_4096BIT,  /**< 4096 bits */
+} cy_en_flash_programrow_datasize_t;
+
+/** Blocking mode of a ProgramRow call */
+typedef enum
+{
+    CY_FLASH_PROGRAMROW_NON_BLOCKING,       /**< Returns once the row is started */
+    CY_FLASH_PROGRAMROW_BLOCKING,           /**< Returns once the row is programmed */
+} cy_en_flash_programrow_blocking_t;
+
+/** Blank check of a ProgramRow call */
+typedef enum
+{
+    CY_FLASH_PROGRAMROW_BLANK_CHECK,        /**< Checks that the row is erased */
+    CY_FLASH_PROGRAMROW_SKIP_BLANK_CHECK,   /**< Programs the row without checking it */
+} cy_en_flash_programrow_skipblankcheck_t;
+
+/** Location of the data of a ProgramRow call */
+typedef enum
+{
+    CY_FLASH_PROGRAMROW_DATA_LOCATION_SRAM, /**< Data in SRAM */
+} cy_en_flash_programrow_location_t;
+
+/** Interrupt mask of a ProgramRow call */
+typedef enum
+{
+    CY_FLASH_PROGRAMROW_NOT_SET_INTR_MASK,  /**< No completion interrupt */
+    CY_FLASH_PROGRAMROW_SET_INTR_MASK,      /**< Completion interrupt */
+} cy_en_flash_programrow_intrmask_t;
+
+/** Blocking mode of the driver functions */
+typedef enum
+{
+    CY_FLASH_DRIVER_NON_BLOCKING,           /**< Returns once the operation is started */
+    CY_FLASH_DRIVER_BLOCKING,               /**< Returns once the operation is complete */
+} cy_en_flash_driver_blocking_t;
+
+/** Configuration of a ProgramRow call */
+typedef struct
+{
+    cy_en_flash_programrow_blocking_t       blocking;   /**< Blocking mode */
+    cy_en_flash_programrow_skipblankcheck_t skipBC;     /**< Blank check */
+    cy_en_flash_programrow_datasize_t       dataSize;   /**< Size of the row */
+    cy_en_flash_programrow_location_t       dataLoc;    /**< Location of the data */
+    cy_en_flash_programrow_intrmask_t       intrMask;   /**< Interrupt mask */
+    const uint32_t*                         destAddr;   /**< Address of the row */
+    const uint32_t*                         dataAddr;   /**< Data of the row */
+} cy_stc_flash_programrow_config_t;
+
+/** Configuration of a BlankCheck call */
+typedef struct
+{
+    uint32_t*   addrToBeChecked;        /**< First word to check */
+    uint32_t    numOfWordsToBeChecked;  /**< Number of words to check */
+} cy_stc_flash_blankcheck_config_t;
+
+/** Programs a row of the work flash */
+cy_en_flashdrv_status_t Cy_Flash_Program_WorkFlash(const cy_stc_flash_programrow_config_t* config);
+
+/** Checks that an area of the work flash is erased, CY_FLASH_DRV_SUCCESS if it is */
+cy_en_flashdrv_status_t Cy_Flash_BlankCheck(const cy_stc_flash_blankcheck_config_t* config,
+                                            cy_en_flash_driver_blocking_t block);
+#endif // if (CPUSS_FLASHC_ECT == 1)
+
+#if defined(COMPONENT_CAT2)
+#if !defined(CY_FLASH_BASE)
+#define CY_FLASH_BASE                   (0x10000000UL)
+#endif
+#if !defined(CY_FLASH_SIZE)
+#define CY_FLASH_SIZE                   (0x00010000UL)
+#endif
+#if !defined(CY_FLASH_SIZEOF_ROW)
+#define CY_FLASH_SIZEOF_ROW             (128UL)
+#endif
+#if !defined(CY_FLASH_NON_BLOCKING_SUPPORTED)
+#define CY_FLASH_NON_BLOCKING_SUPPORTED (1)
+#endif
+
+/** Writes a row */
+cy_en_flashdrv_status_t Cy_Flash_WriteRow(uint32_t rowAddr, const uint32_t* data);
+
+/** Starts writing a row */
+cy_en_flashdrv_status_t Cy_Flash_StartWrite(uint32_t rowAddr, const uint32_t* data);
+#endif // defined(COMPONENT_CAT2)
+
+#if defined(__cplusplus)
+}
+#endif
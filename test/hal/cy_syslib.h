@@ -0,0 +1,43 @@
+/***********************************************************************************************//**
+ * \file cy_syslib.h
+ *
+ * \brief
+ * Host stand-in for the critical section functions of the PDL system library used by the PDL
+ * block storage device and by the trace on CAT2 devices.
+ *
+ ***************************************************************************************************
+ * \copyright
+ * Copyright 2024 Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **************************************************************************************************/
+#pragma once
+
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/** Enters a critical section, the tests run on a single thread */
+uint32_t Cy_SysLib_EnterCriticalSection(void);
+
+/** Exits a critical section */
+void Cy_SysLib_ExitCriticalSection(uint32_t savedIntrStatus);
+
+#if defined(__cplusplus)
+}
+#endif
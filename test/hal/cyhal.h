@@ -0,0 +1,55 @@
+/***********************************************************************************************//**
+ * \file cyhal.h
+ *
+ * \brief
+ * Host stand-in for the part of the classic HAL and of the PDL used by the HAL NVM block storage
+ * device, so that the tests can run mtb_block_storage_nvm.c without any hardware. The functions
+ * are implemented by the test programs.
+ *
+ ***************************************************************************************************
+ * \copyright
+ * Copyright 2024 Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **************************************************************************************************/
+#pragma once
+
+#include "cy_result.h"
+#include "cy_utils.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define CYHAL_DRIVER_AVAILABLE_NVM      (1)
+#define CYHAL_DRIVER_AVAILABLE_FLASH    (0)
+#define CYHAL_DRIVER_AVAILABLE_DMA      (0)
+
+#include "cyhal_nvm.h"
+#include "cy_flash.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/** Enters a critical section, the tests run on a single thread */
+uint32_t cyhal_system_critical_section_enter(void);
+
+/** Exits a critical section */
+void cyhal_system_critical_section_exit(uint32_t old_state);
+
+#if defined(__cplusplus)
+}
+#endif
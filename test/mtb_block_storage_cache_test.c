@@ -0,0 +1,334 @@
+/***********************************************************************************************//**
+ * \file mtb_block_storage_cache_test.c
+ *
+ * \brief
+ * Host test of the write-back cache on a RAM device whose functions count the calls made by the
+ * cache, with and without the compare before program and program without erase options.
+ *
+ * Build and run on host, with the core-lib include folder providing cy_result.h and cy_utils.h:
+ *
+ *     gcc -std=c99 -Iinclude -I<core-lib>/include test/mtb_block_storage_cache_test.c \
+ *         source/mtb_block_storage.c source/mtb_block_storage_cache.c \
+ *         source/mtb_block_storage_ram.c -o mtb_block_storage_cache_test
+ *     ./mtb_block_storage_cache_test
+ *
+ ***************************************************************************************************
+ * \copyright
+ * Copyright 2024 Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **************************************************************************************************/
+#include "mtb_block_storage_cache.h"
+#include "mtb_block_storage_test.h"
+
+#include <string.h>
+
+#define TEST_UNIT_SIZE          (512u)
+#define TEST_MEMORY_SIZE        (4u * TEST_UNIT_SIZE)
+//Error returned by the device when test_program_fails is set
+#define TEST_PROGRAM_ERROR      (0xDEADu)
+
+//Flash, programmed once between erases, and NOR memory accepting programs over programmed data
+static const mtb_block_storage_ram_region_t test_flash_regions[] =
+{
+    { 0x00000000u, TEST_MEMORY_SIZE, 4u, TEST_UNIT_SIZE, 0xFFu, true, 0u, 0u, 0u, 0u },
+};
+static const mtb_block_storage_ram_region_t test_nor_regions[] =
+{
+    { 0x00000000u, TEST_MEMORY_SIZE, 4u, TEST_UNIT_SIZE, 0xFFu, false, 0u, 0u, 0u, 0u },
+};
+
+static uint8_t test_memory[TEST_MEMORY_SIZE];
+static uint32_t test_program_map[TEST_MEMORY_SIZE / 4u / 32u];
+static uint8_t test_buffer[2u * TEST_UNIT_SIZE];
+static uint8_t test_data[TEST_UNIT_SIZE];
+
+//RAM device, and the device given to the cache that counts the calls forwarded to it
+static mtb_block_storage_t test_ram;
+static mtb_block_storage_ram_t test_ram_obj;
+static mtb_block_storage_t test_bsd;
+static mtb_block_storage_cache_t test_cache;
+static uint32_t test_reads;
+static uint32_t test_programs;
+static uint32_t test_erases;
+static bool test_program_fails;
+
+
+//--------------------------------------------------------------------------------------------------
+// test_read
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t test_read(void* context, uint32_t addr, uint32_t length, uint8_t* buf)
+{
+    test_reads++;
+    return test_ram.read(context, addr, length, buf);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_program
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t test_program(void* context, uint32_t addr, uint32_t length, const uint8_t* buf)
+{
+    test_programs++;
+    return test_program_fails ? TEST_PROGRAM_ERROR : test_ram.program(context, addr, length, buf);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_erase
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t test_erase(void* context, uint32_t addr, uint32_t length)
+{
+    test_erases++;
+    return test_ram.erase(context, addr, length);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_is_erase_required
+//--------------------------------------------------------------------------------------------------
+static bool test_is_erase_required(void* context, uint32_t addr, uint32_t length)
+{
+    (void)context;
+    (void)addr;
+    (void)length;
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_cache_init
+//--------------------------------------------------------------------------------------------------
+static void test_cache_init(const mtb_block_storage_ram_region_t* regions, uint32_t options)
+{
+    mtb_block_storage_ram_config_t config;
+
+    (void)memset(&config, 0, sizeof(config));
+    config.regions = regions;
+    config.region_count = 1u;
+    config.memory = test_memory;
+    config.program_map = test_program_map;
+    config.initialize = true;
+    TEST_ASSERT(mtb_block_storage_create_ram(&test_ram, &test_ram_obj, &config) ==
+                CY_RSLT_SUCCESS);
+
+    //The NOR memory is reported as needing an erase, the cache skips it when it can
+    test_bsd = test_ram;
+    test_bsd.read = test_read;
+    test_bsd.program = test_program;
+    test_bsd.erase = test_erase;
+    test_bsd.is_erase_required = test_is_erase_required;
+    TEST_ASSERT(mtb_block_storage_cache_init(&test_cache, &test_bsd, test_buffer,
+                                             sizeof(test_buffer), TEST_UNIT_SIZE) ==
+                CY_RSLT_SUCCESS);
+    TEST_ASSERT(mtb_block_storage_cache_set_options(&test_cache, options) == CY_RSLT_SUCCESS);
+    test_reads = 0;
+    test_programs = 0;
+    test_erases = 0;
+    test_program_fails = false;
+    for (uint32_t i = 0; i < sizeof(test_data); i++)
+    {
+        test_data[i] = (uint8_t)(i * 3u);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_cache_write_flush
+//--------------------------------------------------------------------------------------------------
+static void test_cache_write_flush(void)
+{
+    uint8_t read[32];
+
+    //A write across two units reads both of them and leaves the device unchanged until the flush
+    test_cache_init(test_flash_regions, 0u);
+    TEST_ASSERT(mtb_block_storage_cache_write(&test_cache, TEST_UNIT_SIZE - 12u, 20u, test_data) ==
+                CY_RSLT_SUCCESS);
+    TEST_ASSERT((test_reads == 2u) && (test_programs == 0u) && (test_erases == 0u));
+    TEST_ASSERT(test_memory[TEST_UNIT_SIZE - 12u] == 0xFFu);
+    TEST_ASSERT(mtb_block_storage_cache_read(&test_cache, TEST_UNIT_SIZE - 16u, sizeof(read),
+                                             read) == CY_RSLT_SUCCESS);
+    TEST_ASSERT((read[0] == 0xFFu) && (read[3] == 0xFFu) && (read[24] == 0xFFu));
+    TEST_ASSERT(0 == memcmp(&read[4], test_data, 20u));
+
+    //Each unit is erased and programmed once, a second flush has nothing to write
+    TEST_ASSERT(mtb_block_storage_cache_flush(&test_cache) == CY_RSLT_SUCCESS);
+    TEST_ASSERT((test_programs == 2u) && (test_erases == 2u));
+    TEST_ASSERT(0 == memcmp(&test_memory[TEST_UNIT_SIZE - 12u], test_data, 20u));
+    TEST_ASSERT(mtb_block_storage_cache_flush(&test_cache) == CY_RSLT_SUCCESS);
+    TEST_ASSERT((test_programs == 2u) && (test_erases == 2u));
+
+    //Repeated writes of a cached unit are written back once
+    TEST_ASSERT(mtb_block_storage_cache_write(&test_cache, 0u, 4u, &test_data[4]) ==
+                CY_RSLT_SUCCESS);
+    TEST_ASSERT(mtb_block_storage_cache_write(&test_cache, 8u, 4u, &test_data[8]) ==
+                CY_RSLT_SUCCESS);
+    TEST_ASSERT(mtb_block_storage_cache_flush(&test_cache) == CY_RSLT_SUCCESS);
+    TEST_ASSERT((test_reads == 2u) && (test_programs == 3u) && (test_erases == 3u));
+    TEST_ASSERT((0 == memcmp(&test_memory[0], &test_data[4], 4u)) &&
+                (0 == memcmp(&test_memory[8], &test_data[8], 4u)));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_cache_evict
+//--------------------------------------------------------------------------------------------------
+static void test_cache_evict(void)
+{
+    uint8_t read[TEST_UNIT_SIZE];
+
+    //A whole unit is not read, it is written back when a third unit needs its entry
+    test_cache_init(test_flash_regions, 0u);
+    TEST_ASSERT(mtb_block_storage_cache_write(&test_cache, 0u, TEST_UNIT_SIZE, test_data) ==
+                CY_RSLT_SUCCESS);
+    TEST_ASSERT(test_reads == 0u);
+    TEST_ASSERT(mtb_block_storage_cache_write(&test_cache, TEST_UNIT_SIZE, 4u, test_data) ==
+                CY_RSLT_SUCCESS);
+    TEST_ASSERT((test_programs == 0u) && (test_erases == 0u));
+    TEST_ASSERT(mtb_block_storage_cache_write(&test_cache, 2u * TEST_UNIT_SIZE, 4u, test_data) ==
+                CY_RSLT_SUCCESS);
+    TEST_ASSERT((test_programs == 1u) && (test_erases == 1u));
+    TEST_ASSERT(0 == memcmp(test_memory, test_data, TEST_UNIT_SIZE));
+
+    //The evicted unit is read from the device, the least recently used one is evicted next
+    TEST_ASSERT(mtb_block_storage_cache_read(&test_cache, 0u, sizeof(read), read) ==
+                CY_RSLT_SUCCESS);
+    TEST_ASSERT(0 == memcmp(read, test_data, sizeof(read)));
+    TEST_ASSERT(mtb_block_storage_cache_write(&test_cache, 3u * TEST_UNIT_SIZE, 4u, test_data) ==
+                CY_RSLT_SUCCESS);
+    TEST_ASSERT((test_programs == 2u) && (test_erases == 2u));
+    TEST_ASSERT(0 == memcmp(&test_memory[TEST_UNIT_SIZE], test_data, 4u));
+    TEST_ASSERT(test_memory[2u * TEST_UNIT_SIZE] == 0xFFu);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_cache_deinit
+//--------------------------------------------------------------------------------------------------
+static void test_cache_deinit(void)
+{
+    uint8_t read[4];
+
+    //A failed write back keeps the unit, the next deinit writes it
+    test_cache_init(test_flash_regions, 0u);
+    TEST_ASSERT(mtb_block_storage_cache_write(&test_cache, 3u * TEST_UNIT_SIZE, 4u, test_data) ==
+                CY_RSLT_SUCCESS);
+    test_program_fails = true;
+    TEST_ASSERT(mtb_block_storage_cache_deinit(&test_cache) == TEST_PROGRAM_ERROR);
+    TEST_ASSERT(mtb_block_storage_cache_read(&test_cache, 3u * TEST_UNIT_SIZE, sizeof(read),
+                                             read) == CY_RSLT_SUCCESS);
+    TEST_ASSERT(0 == memcmp(read, test_data, sizeof(read)));
+    test_program_fails = false;
+    TEST_ASSERT(mtb_block_storage_cache_deinit(&test_cache) == CY_RSLT_SUCCESS);
+    TEST_ASSERT(0 == memcmp(&test_memory[3u * TEST_UNIT_SIZE], test_data, sizeof(read)));
+
+    //No unit is left, a read goes to the device
+    for (uint32_t i = 0; i < test_cache.entry_count; i++)
+    {
+        TEST_ASSERT(0u == test_cache.entries[i].size);
+    }
+    test_reads = 0;
+    TEST_ASSERT(mtb_block_storage_cache_read(&test_cache, 3u * TEST_UNIT_SIZE, sizeof(read),
+                                             read) == CY_RSLT_SUCCESS);
+    TEST_ASSERT(test_reads == 1u);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_cache_compare
+//--------------------------------------------------------------------------------------------------
+static void test_cache_compare(void)
+{
+    uint8_t value = 0xF0u;
+
+    //A unit that already holds the data is not written back
+    test_cache_init(test_flash_regions, MTB_BLOCK_STORAGE_OPTION_COMPARE_BEFORE_PROGRAM);
+    TEST_ASSERT(test_ram.program(test_ram.context, 0u, TEST_UNIT_SIZE, test_data) ==
+                CY_RSLT_SUCCESS);
+    TEST_ASSERT(mtb_block_storage_cache_write(&test_cache, 100u, 20u, &test_data[100]) ==
+                CY_RSLT_SUCCESS);
+    TEST_ASSERT(mtb_block_storage_cache_flush(&test_cache) == CY_RSLT_SUCCESS);
+    TEST_ASSERT((test_programs == 0u) && (test_erases == 0u));
+
+    //Without the program without erase option a changed unit is always erased
+    TEST_ASSERT(mtb_block_storage_cache_write(&test_cache, TEST_UNIT_SIZE, 1u, &value) ==
+                CY_RSLT_SUCCESS);
+    TEST_ASSERT(mtb_block_storage_cache_flush(&test_cache) == CY_RSLT_SUCCESS);
+    TEST_ASSERT((test_programs == 1u) && (test_erases == 1u));
+    TEST_ASSERT(test_memory[TEST_UNIT_SIZE] == value);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_cache_program_without_erase
+//--------------------------------------------------------------------------------------------------
+static void test_cache_program_without_erase(void)
+{
+    uint8_t value = 0xF0u;
+
+    //Bits only moving away from the erase value are programmed over the unit
+    test_cache_init(test_nor_regions, MTB_BLOCK_STORAGE_OPTION_COMPARE_BEFORE_PROGRAM |
+                    MTB_BLOCK_STORAGE_OPTION_PROGRAM_WITHOUT_ERASE);
+    TEST_ASSERT(mtb_block_storage_cache_write(&test_cache, 10u, 1u, &value) == CY_RSLT_SUCCESS);
+    TEST_ASSERT(mtb_block_storage_cache_flush(&test_cache) == CY_RSLT_SUCCESS);
+    TEST_ASSERT((test_programs == 1u) && (test_erases == 0u));
+    TEST_ASSERT(test_memory[10] == value);
+    value = 0x30u;
+    TEST_ASSERT(mtb_block_storage_cache_write(&test_cache, 10u, 1u, &value) == CY_RSLT_SUCCESS);
+    TEST_ASSERT(mtb_block_storage_cache_flush(&test_cache) == CY_RSLT_SUCCESS);
+    TEST_ASSERT((test_programs == 2u) && (test_erases == 0u));
+
+    //A bit going back to the erase value needs an erase
+    value = 0x38u;
+    TEST_ASSERT(mtb_block_storage_cache_write(&test_cache, 10u, 1u, &value) == CY_RSLT_SUCCESS);
+    TEST_ASSERT(mtb_block_storage_cache_flush(&test_cache) == CY_RSLT_SUCCESS);
+    TEST_ASSERT((test_programs == 3u) && (test_erases == 1u));
+    TEST_ASSERT((test_memory[10] == value) && (test_memory[11] == 0xFFu));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_cache_erase_required_unknown
+//--------------------------------------------------------------------------------------------------
+static void test_cache_erase_required_unknown(void)
+{
+    //A device without is_erase_required is erased before the unit is programmed
+    test_cache_init(test_flash_regions, 0u);
+    test_bsd.is_erase_required = NULL;
+    TEST_ASSERT(test_ram.program(test_ram.context, 0u, TEST_UNIT_SIZE, test_data) ==
+                CY_RSLT_SUCCESS);
+    TEST_ASSERT(mtb_block_storage_cache_write(&test_cache, 0u, 4u, &test_data[8]) ==
+                CY_RSLT_SUCCESS);
+    TEST_ASSERT(mtb_block_storage_cache_flush(&test_cache) == CY_RSLT_SUCCESS);
+    TEST_ASSERT((test_programs == 1u) && (test_erases == 1u));
+    TEST_ASSERT(0 == memcmp(test_memory, &test_data[8], 4u));
+    TEST_ASSERT(0 == memcmp(&test_memory[4], &test_data[4], TEST_UNIT_SIZE - 4u));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// main
+//--------------------------------------------------------------------------------------------------
+int main(void)
+{
+    TEST_RUN(test_cache_write_flush);
+    TEST_RUN(test_cache_evict);
+    TEST_RUN(test_cache_deinit);
+    TEST_RUN(test_cache_compare);
+    TEST_RUN(test_cache_program_without_erase);
+    TEST_RUN(test_cache_erase_required_unknown);
+    return TEST_RESULT();
+}
@@ -0,0 +1,103 @@
+/***********************************************************************************************//**
+ * \file mtb_block_storage_common_test.c
+ *
+ * \brief
+ * Host test of the helpers of mtb_block_storage.c, run on RAM devices.
+ *
+ * Build and run on host, with the core-lib include folder providing cy_result.h and cy_utils.h:
+ *
+ *     gcc -std=c99 -O2 -fstrict-aliasing -Iinclude -I<core-lib>/include \
+ *         test/mtb_block_storage_common_test.c source/mtb_block_storage.c \
+ *         source/mtb_block_storage_ram.c -o mtb_block_storage_common_test
+ *     ./mtb_block_storage_common_test
+ *
+ ***************************************************************************************************
+ * \copyright
+ * Copyright 2024 Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **************************************************************************************************/
+#include "mtb_block_storage.h"
+#include "mtb_block_storage_test.h"
+
+#include <string.h>
+
+#define TEST_UNIT_SIZE          (64u)
+#define TEST_UNIT_COUNT         (4u)
+#define TEST_MEMORY_SIZE        (TEST_UNIT_SIZE * TEST_UNIT_COUNT)
+
+static const mtb_block_storage_ram_region_t test_regions[] =
+{
+    { 0x00000000u, TEST_MEMORY_SIZE, 1u, TEST_UNIT_SIZE, 0xFFu, false, 0u, 0u, 0u, 0u },
+};
+
+//One more byte than the memory, which starts at an odd address
+static uint8_t test_storage[TEST_MEMORY_SIZE + sizeof(uint32_t)];
+static uint8_t test_scratch[TEST_UNIT_SIZE + sizeof(uint32_t)];
+
+
+//--------------------------------------------------------------------------------------------------
+// test_blank_check_device
+//--------------------------------------------------------------------------------------------------
+static void test_blank_check_device(bool mapped)
+{
+    mtb_block_storage_t bsd;
+    mtb_block_storage_ram_t obj;
+    mtb_block_storage_ram_config_t config;
+    uint8_t* memory = &test_storage[1];
+    uint32_t skipped = 0;
+
+    (void)memset(&config, 0, sizeof(config));
+    config.regions = test_regions;
+    config.region_count = 1u;
+    config.memory = memory;
+    config.initialize = true;
+    TEST_ASSERT(mtb_block_storage_create_ram(&bsd, &obj, &config) == CY_RSLT_SUCCESS);
+    if (!mapped)
+    {
+        //The units are then read through scratch, also misaligned
+        bsd.map = NULL;
+    }
+
+    //A byte inside a word of the second unit and the last byte of the fourth one are programmed
+    memory[TEST_UNIT_SIZE + 6u] = 0x7Fu;
+    memory[TEST_MEMORY_SIZE - 1u] = 0x00u;
+    TEST_ASSERT(mtb_block_storage_erase_blank_check(&bsd, 0u, TEST_MEMORY_SIZE, &test_scratch[3],
+                                                    TEST_UNIT_SIZE, &skipped) == CY_RSLT_SUCCESS);
+    TEST_ASSERT(skipped == 2u);
+    TEST_ASSERT(memory[TEST_UNIT_SIZE + 6u] == 0xFFu);
+    TEST_ASSERT(memory[TEST_MEMORY_SIZE - 1u] == 0xFFu);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_blank_check_misaligned
+//--------------------------------------------------------------------------------------------------
+static void test_blank_check_misaligned(void)
+{
+    test_blank_check_device(true);
+    test_blank_check_device(false);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// main
+//--------------------------------------------------------------------------------------------------
+int main(void)
+{
+    TEST_RUN(test_blank_check_misaligned);
+    return TEST_RESULT();
+}
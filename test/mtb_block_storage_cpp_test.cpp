@@ -0,0 +1,103 @@
+/***********************************************************************************************//**
+ * \file mtb_block_storage_cpp_test.cpp
+ *
+ * \brief
+ * Host test of the C++ block device template on the function backend of a device of this
+ * library, without any mtb_block_storage_t function pointer on the call path.
+ *
+ * Build and run on host, with the core-lib include folder providing cy_result.h and cy_utils.h:
+ *
+ *     gcc -std=c99 -Iinclude -I<core-lib>/include -c source/mtb_block_storage_ram.c
+ *     g++ -std=c++11 -Iinclude -I<core-lib>/include test/mtb_block_storage_cpp_test.cpp \
+ *         mtb_block_storage_ram.o -o mtb_block_storage_cpp_test
+ *     ./mtb_block_storage_cpp_test
+ *
+ ***************************************************************************************************
+ * \copyright
+ * Copyright 2024 Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **************************************************************************************************/
+#include "mtb_block_storage.hpp"
+#include "mtb_block_storage_test.h"
+
+#include <string.h>
+
+namespace
+{
+const uint32_t TEST_MEMORY_SIZE = 4096u;
+
+const mtb_block_storage_ram_region_t test_regions[] =
+{
+    { 0x00000000u, TEST_MEMORY_SIZE, 4u, 512u, 0xFFu, true, 0u, 0u, 0u, 0u },
+};
+
+uint8_t test_memory[TEST_MEMORY_SIZE];
+uint32_t test_program_map[TEST_MEMORY_SIZE / 4u / 32u];
+
+typedef mtb_block_storage::StaticGeometry<1u, 4u, 512u, 0xFFu> TestGeometry;
+typedef mtb_block_storage::BlockDevice<mtb_block_storage::RamBackend, TestGeometry> TestDevice;
+
+
+//--------------------------------------------------------------------------------------------------
+// test_cpp_ram_backend
+//--------------------------------------------------------------------------------------------------
+void test_cpp_ram_backend()
+{
+    mtb_block_storage_t bsd;
+    mtb_block_storage_ram_t obj;
+    mtb_block_storage_ram_config_t config;
+    uint8_t data[64];
+    uint8_t read[64];
+
+    memset(&config, 0, sizeof(config));
+    config.regions = test_regions;
+    config.region_count = 1u;
+    config.memory = test_memory;
+    config.program_map = test_program_map;
+    config.initialize = true;
+    TEST_ASSERT(mtb_block_storage_create_ram(&bsd, &obj, &config) == CY_RSLT_SUCCESS);
+
+    //The backend only keeps the context, the functions are the template arguments
+    TestDevice device(mtb_block_storage::RamBackend(bsd.context));
+    for (uint32_t i = 0; i < sizeof(data); i++)
+    {
+        data[i] = (uint8_t)(i + 1u);
+    }
+    TEST_ASSERT(device.program(512u, sizeof(data), data) == CY_RSLT_SUCCESS);
+    TEST_ASSERT(device.read(512u, sizeof(read), read) == CY_RSLT_SUCCESS);
+    TEST_ASSERT(0 == memcmp(read, data, sizeof(data)));
+    TEST_ASSERT(0 == memcmp(&test_memory[512], data, sizeof(data)));
+
+    //The alignment is checked by the template, the reprogramming by the device
+    TEST_ASSERT(device.program(514u, 4u, data) == MTB_BLOCK_STORAGE_INVALID_SIZE_ERROR);
+    TEST_ASSERT(device.program(512u, 4u, data) == MTB_BLOCK_STORAGE_NOT_ERASED_ERROR);
+    TEST_ASSERT(device.erase(512u, 512u) == CY_RSLT_SUCCESS);
+    TEST_ASSERT(device.read(512u, sizeof(read), read) == CY_RSLT_SUCCESS);
+    TEST_ASSERT((read[0] == TestGeometry::ERASE_VALUE) && (read[63] == TestGeometry::ERASE_VALUE));
+    TEST_ASSERT(device.read(TEST_MEMORY_SIZE, 4u, read) == MTB_BLOCK_STORAGE_NOT_IN_RANGE_ERROR);
+}
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// main
+//--------------------------------------------------------------------------------------------------
+int main()
+{
+    TEST_RUN(test_cpp_ram_backend);
+    return TEST_RESULT();
+}
@@ -0,0 +1,259 @@
+/***********************************************************************************************//**
+ * \file mtb_block_storage_dma_test.c
+ *
+ * \brief
+ * Host test of the DMA read, run with the simulated DMA engine on a RAM device whose memory is
+ * the mapped memory, advanced by polling or by a simulated completion interrupt.
+ *
+ * Build and run on host, with the core-lib include folder providing cy_result.h and cy_utils.h:
+ *
+ *     gcc -std=c99 -Iinclude -I<core-lib>/include test/mtb_block_storage_dma_test.c \
+ *         source/mtb_block_storage_dma.c source/mtb_block_storage_ram.c \
+ *         -o mtb_block_storage_dma_test
+ *     ./mtb_block_storage_dma_test
+ *
+ ***************************************************************************************************
+ * \copyright
+ * Copyright 2024 Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **************************************************************************************************/
+#include "mtb_block_storage_dma.h"
+#include "mtb_block_storage_test.h"
+
+#include <string.h>
+
+#define TEST_MEMORY_SIZE        (160u * 1024u)
+#define TEST_LINE_SIZE          (32u)
+//Burst and longest transfer of the DataWire channels in 2D mode
+#define TEST_DMA_BURST_LENGTH   (256u)
+#define TEST_DMA_MAX_LENGTH     (256u * TEST_DMA_BURST_LENGTH)
+//Misaligned read spanning more than two of the longest transfers
+#define TEST_READ_ADDR          (3u)
+#define TEST_READ_LENGTH        (140000u)
+
+static const mtb_block_storage_ram_region_t test_regions[] =
+{
+    { 0x00000000u, TEST_MEMORY_SIZE, 4u, 512u, 0xFFu, false, 0u, 0u, 0u, 0u },
+};
+
+static uint8_t test_memory[TEST_MEMORY_SIZE];
+static uint8_t test_buf[TEST_READ_LENGTH + 8u];
+static uint8_t test_bounce_storage[(MTB_BLOCK_STORAGE_DMA_BOUNCE_COUNT + 1u) * TEST_LINE_SIZE];
+
+//Engine recording the transfers started through the simulated engine it wraps
+static mtb_block_storage_dma_engine_t test_sim_engine;
+static uint32_t test_transfers;
+static uint32_t test_longest_transfer;
+
+//Completion handler registered by the DMA read, invoked by the test as the interrupt would be
+static mtb_block_storage_dma_event_t test_event;
+static void* test_event_arg;
+static uint32_t test_completions;
+static cy_rslt_t test_completion_result;
+
+
+//--------------------------------------------------------------------------------------------------
+// test_engine_start
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t test_engine_start(void* arg, uint8_t* dst, const uint8_t* src, uint32_t length)
+{
+    test_transfers++;
+    if (length > test_longest_transfer)
+    {
+        test_longest_transfer = length;
+    }
+    return test_sim_engine.start(arg, dst, src, length);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_engine_register
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t test_engine_register(void* arg, mtb_block_storage_dma_event_t callback,
+                                      void* callback_arg)
+{
+    (void)arg;
+    test_event = callback;
+    test_event_arg = callback_arg;
+    return CY_RSLT_SUCCESS;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_completion
+//--------------------------------------------------------------------------------------------------
+static void test_completion(void* callback_arg, cy_rslt_t result)
+{
+    (void)callback_arg;
+    test_completions++;
+    test_completion_result = result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_dma_init
+//--------------------------------------------------------------------------------------------------
+static void test_dma_init(mtb_block_storage_t* bsd, mtb_block_storage_ram_t* ram,
+                          mtb_block_storage_dma_t* dma, mtb_block_storage_dma_sim_t* sim,
+                          uint32_t bytes_per_check, bool interrupt)
+{
+    mtb_block_storage_ram_config_t ram_config;
+    mtb_block_storage_dma_config_t config;
+    uintptr_t bounce = (uintptr_t)test_bounce_storage;
+
+    (void)memset(&ram_config, 0, sizeof(ram_config));
+    ram_config.regions = test_regions;
+    ram_config.region_count = 1u;
+    ram_config.memory = test_memory;
+    for (uint32_t i = 0; i < TEST_MEMORY_SIZE; i++)
+    {
+        test_memory[i] = (uint8_t)(i * 7u);
+    }
+    TEST_ASSERT(mtb_block_storage_create_ram(bsd, ram, &ram_config) == CY_RSLT_SUCCESS);
+
+    mtb_block_storage_dma_create_sim_engine(&test_sim_engine, sim, bytes_per_check);
+    (void)memset(&config, 0, sizeof(config));
+    config.bsd = bsd;
+    config.map_base = (uintptr_t)test_memory;
+    config.engine = test_sim_engine;
+    config.engine.start = test_engine_start;
+    if (interrupt)
+    {
+        config.engine.register_callback = test_engine_register;
+    }
+    config.bounce = (uint8_t*)((bounce + TEST_LINE_SIZE - 1u) & ~(uintptr_t)(TEST_LINE_SIZE - 1u));
+    config.line_size = TEST_LINE_SIZE;
+    config.min_dma_length = 16u;
+    test_event = NULL;
+    TEST_ASSERT(mtb_block_storage_dma_init(dma, &config) == CY_RSLT_SUCCESS);
+    TEST_ASSERT(interrupt == (NULL != test_event));
+    test_transfers = 0;
+    test_longest_transfer = 0;
+    test_completions = 0;
+    (void)memset(test_buf, 0, sizeof(test_buf));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_dma_sim_max_length
+//--------------------------------------------------------------------------------------------------
+static void test_dma_sim_max_length(void)
+{
+    mtb_block_storage_dma_engine_t engine;
+    mtb_block_storage_dma_sim_t sim;
+
+    //The simulated engine has the limits of the HAL engine and rejects a transfer over them
+    mtb_block_storage_dma_create_sim_engine(&engine, &sim, 0u);
+    TEST_ASSERT(engine.max_length == TEST_DMA_MAX_LENGTH);
+    TEST_ASSERT(engine.burst_length == TEST_DMA_BURST_LENGTH);
+    TEST_ASSERT(NULL == engine.register_callback);
+    TEST_ASSERT(engine.start(engine.arg, test_buf, test_memory, TEST_DMA_MAX_LENGTH + 1u) ==
+                MTB_BLOCK_STORAGE_INVALID_SIZE_ERROR);
+    TEST_ASSERT(engine.start(engine.arg, test_buf, test_memory, TEST_DMA_BURST_LENGTH + 1u) ==
+                MTB_BLOCK_STORAGE_INVALID_SIZE_ERROR);
+    TEST_ASSERT(engine.start(engine.arg, test_buf, test_memory, TEST_DMA_BURST_LENGTH - 1u) ==
+                CY_RSLT_SUCCESS);
+    TEST_ASSERT(engine.is_complete(engine.arg));
+    TEST_ASSERT(engine.start(engine.arg, test_buf, test_memory, TEST_DMA_MAX_LENGTH) ==
+                CY_RSLT_SUCCESS);
+    TEST_ASSERT(engine.is_complete(engine.arg));
+    TEST_ASSERT(0 == memcmp(test_buf, test_memory, TEST_DMA_MAX_LENGTH));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_dma_read_split
+//--------------------------------------------------------------------------------------------------
+static void test_dma_read_split(void)
+{
+    mtb_block_storage_t bsd;
+    mtb_block_storage_ram_t ram;
+    mtb_block_storage_dma_t dma;
+    mtb_block_storage_dma_sim_t sim;
+    cy_rslt_t result;
+    uint32_t polls = 0;
+
+    test_dma_init(&bsd, &ram, &dma, &sim, 4096u, false);
+
+    //The body is split into the longest transfers, then whole bursts, then the rest. With the
+    //head and the tail that is at most six transfers.
+    TEST_ASSERT(mtb_block_storage_dma_read(&dma, TEST_READ_ADDR, TEST_READ_LENGTH, &test_buf[5],
+                                           test_completion, NULL) == CY_RSLT_SUCCESS);
+    do
+    {
+        result = mtb_block_storage_dma_poll(&dma);
+        polls++;
+    } while ((result == MTB_BLOCK_STORAGE_BUSY) && (polls < 10000u));
+    TEST_ASSERT(result == CY_RSLT_SUCCESS);
+    TEST_ASSERT(0 == memcmp(&test_buf[5], &test_memory[TEST_READ_ADDR], TEST_READ_LENGTH));
+    TEST_ASSERT(test_longest_transfer == TEST_DMA_MAX_LENGTH);
+    TEST_ASSERT(test_transfers <= 6u);
+    TEST_ASSERT(test_completions == 1u);
+    TEST_ASSERT(test_completion_result == CY_RSLT_SUCCESS);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_dma_read_interrupt
+//--------------------------------------------------------------------------------------------------
+static void test_dma_read_interrupt(void)
+{
+    mtb_block_storage_t bsd;
+    mtb_block_storage_ram_t ram;
+    mtb_block_storage_dma_t dma;
+    mtb_block_storage_dma_sim_t sim;
+    uint32_t interrupts = 0;
+
+    //Every check completes the transfer, like a channel that is done when its interrupt fires
+    test_dma_init(&bsd, &ram, &dma, &sim, 0u, true);
+    TEST_ASSERT(mtb_block_storage_dma_read(&dma, TEST_READ_ADDR, TEST_READ_LENGTH, &test_buf[5],
+                                           test_completion, NULL) == CY_RSLT_SUCCESS);
+    TEST_ASSERT(test_transfers == 1u);
+
+    //The poll only reports the state, the transfers are started from the interrupt
+    TEST_ASSERT(mtb_block_storage_dma_poll(&dma) == MTB_BLOCK_STORAGE_BUSY);
+    TEST_ASSERT(0u != sim.left);
+    TEST_ASSERT(test_transfers == 1u);
+
+    while ((0u == test_completions) && (interrupts < 100u))
+    {
+        test_event(test_event_arg);
+        interrupts++;
+    }
+    TEST_ASSERT(test_completions == 1u);
+    TEST_ASSERT(test_completion_result == CY_RSLT_SUCCESS);
+    TEST_ASSERT(interrupts == test_transfers);
+    TEST_ASSERT(test_transfers <= 6u);
+    TEST_ASSERT(0 == memcmp(&test_buf[5], &test_memory[TEST_READ_ADDR], TEST_READ_LENGTH));
+    TEST_ASSERT(mtb_block_storage_dma_poll(&dma) == CY_RSLT_SUCCESS);
+
+    //A spurious interrupt once the read is complete is ignored
+    test_event(test_event_arg);
+    TEST_ASSERT(test_completions == 1u);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// main
+//--------------------------------------------------------------------------------------------------
+int main(void)
+{
+    TEST_RUN(test_dma_sim_max_length);
+    TEST_RUN(test_dma_read_split);
+    TEST_RUN(test_dma_read_interrupt);
+    return TEST_RESULT();
+}
@@ -0,0 +1,349 @@
+/***********************************************************************************************//**
+ * \file mtb_block_storage_ftl_test.c
+ *
+ * \brief
+ * Host test of the FTL on a RAM device: random programs, erases, collections and remounts checked
+ * against a copy of the logical device, then power losses injected in the middle of a program or
+ * an erase of the RAM device, after which the remounted FTL must hold either the old or the new
+ * content of the interrupted page and the content of every other page.
+ *
+ * Build and run on host, with the core-lib include folder providing cy_result.h and cy_utils.h:
+ *
+ *     gcc -std=c99 -Iinclude -I<core-lib>/include test/mtb_block_storage_ftl_test.c \
+ *         source/mtb_block_storage_ftl.c source/mtb_block_storage_ram.c \
+ *         -o mtb_block_storage_ftl_test
+ *     ./mtb_block_storage_ftl_test
+ *
+ ***************************************************************************************************
+ * \copyright
+ * Copyright 2024 Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **************************************************************************************************/
+#include "mtb_block_storage.h"
+#include "mtb_block_storage_ftl.h"
+#include "mtb_block_storage_test.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_MEMORY_SIZE        (32u * 1024u)
+#define TEST_BLOCK_SIZE         (4096u)
+#define TEST_BLOCK_COUNT        (TEST_MEMORY_SIZE / TEST_BLOCK_SIZE)
+#define TEST_PAGE_SIZE          (256u)
+#define TEST_PROGRAM_SIZE       (16u)
+#define TEST_MAX_PAGES          (TEST_MEMORY_SIZE / TEST_PAGE_SIZE)
+//Result of the operations of the RAM device once the power is lost
+#define TEST_POWER_LOSS_ERROR   (0xDEADu)
+
+static uint8_t test_memory[TEST_MEMORY_SIZE];
+static uint32_t test_program_map[TEST_MEMORY_SIZE / TEST_PROGRAM_SIZE / 32u];
+static uint32_t test_map[TEST_MAX_PAGES];
+static mtb_block_storage_ftl_block_t test_blocks[TEST_BLOCK_COUNT];
+static uint8_t test_scratch[64];
+//Expected content of the logical device
+static uint8_t test_shadow[TEST_MAX_PAGES * TEST_PAGE_SIZE];
+
+//RAM device, and the device given to the FTL that loses the power
+static mtb_block_storage_t test_ram;
+static mtb_block_storage_ram_t test_ram_obj;
+static mtb_block_storage_t test_device;
+//Operations left before the power is lost, negative for no power loss
+static int32_t test_budget = -1;
+
+
+//--------------------------------------------------------------------------------------------------
+// test_power_loss_program
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t test_power_loss_program(void* context, uint32_t addr, uint32_t length,
+                                         const uint8_t* buf)
+{
+    cy_rslt_t result = TEST_POWER_LOSS_ERROR;
+    (void)context;
+    if ((test_budget < 0) || (test_budget > 1))
+    {
+        test_budget = (test_budget < 0) ? test_budget : (test_budget - 1);
+        result = test_ram.program(test_ram.context, addr, length, buf);
+    }
+    else if (1 == test_budget)
+    {
+        //The power is lost after some of the program units are written
+        uint32_t part = ((uint32_t)rand() % ((length / TEST_PROGRAM_SIZE) + 1u)) *
+                        TEST_PROGRAM_SIZE;
+        test_budget = 0;
+        if (0u != part)
+        {
+            (void)test_ram.program(test_ram.context, addr, part, buf);
+        }
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_power_loss_erase
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t test_power_loss_erase(void* context, uint32_t addr, uint32_t length)
+{
+    cy_rslt_t result = TEST_POWER_LOSS_ERROR;
+    (void)context;
+    if ((test_budget < 0) || (test_budget > 1))
+    {
+        test_budget = (test_budget < 0) ? test_budget : (test_budget - 1);
+        result = test_ram.erase(test_ram.context, addr, length);
+    }
+    else if (1 == test_budget)
+    {
+        //The power is lost either before or after the erase
+        test_budget = 0;
+        if (0 != (rand() % 2))
+        {
+            (void)test_ram.erase(test_ram.context, addr, length);
+        }
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_ftl_init
+//--------------------------------------------------------------------------------------------------
+static uint32_t test_ftl_init(mtb_block_storage_ftl_config_t* config, uint8_t erase_value,
+                              bool is_erase_required, uint32_t gc_pages_per_write,
+                              uint32_t wear_threshold)
+{
+    static mtb_block_storage_ram_region_t region;
+    mtb_block_storage_ram_config_t ram_config;
+    uint32_t pages;
+
+    region.start_address = 0u;
+    region.size = TEST_MEMORY_SIZE;
+    region.program_size = TEST_PROGRAM_SIZE;
+    region.erase_size = TEST_BLOCK_SIZE;
+    region.erase_value = erase_value;
+    region.is_erase_required = is_erase_required;
+    (void)memset(&ram_config, 0, sizeof(ram_config));
+    ram_config.regions = &region;
+    ram_config.region_count = 1u;
+    ram_config.memory = test_memory;
+    ram_config.program_map = test_program_map;
+    ram_config.initialize = true;
+    TEST_ASSERT(mtb_block_storage_create_ram(&test_ram, &test_ram_obj, &ram_config) ==
+                CY_RSLT_SUCCESS);
+
+    //The FTL only uses the blocking functions of the device losing the power
+    test_device = test_ram;
+    test_device.program = test_power_loss_program;
+    test_device.erase = test_power_loss_erase;
+    test_device.program_nb = NULL;
+    test_device.erase_nb = NULL;
+    test_budget = -1;
+
+    (void)memset(config, 0, sizeof(*config));
+    config->bsd = &test_device;
+    config->start_address = 0u;
+    config->size = TEST_MEMORY_SIZE;
+    config->block_size = TEST_BLOCK_SIZE;
+    config->page_size = TEST_PAGE_SIZE;
+    config->reserved_blocks = 2u;
+    config->gc_pages_per_write = gc_pages_per_write;
+    config->wear_threshold = wear_threshold;
+    config->map = test_map;
+    config->blocks = test_blocks;
+    config->scratch = test_scratch;
+    config->scratch_size = sizeof(test_scratch);
+    pages = mtb_block_storage_ftl_get_page_count(config);
+    TEST_ASSERT((pages > 0u) && (pages <= TEST_MAX_PAGES));
+    (void)memset(test_shadow, erase_value, sizeof(test_shadow));
+    return pages;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_ftl_check
+//--------------------------------------------------------------------------------------------------
+static bool test_ftl_check(mtb_block_storage_t* ftl, uint32_t pages)
+{
+    uint8_t read[TEST_PAGE_SIZE];
+    bool match = true;
+
+    for (uint32_t page = 0; match && (page < pages); page++)
+    {
+        match = (ftl->read(ftl->context, page * TEST_PAGE_SIZE, TEST_PAGE_SIZE, read) ==
+                 CY_RSLT_SUCCESS) &&
+                (0 == memcmp(read, &test_shadow[page * TEST_PAGE_SIZE], TEST_PAGE_SIZE));
+    }
+    return match;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_ftl_random
+//--------------------------------------------------------------------------------------------------
+static void test_ftl_random(void)
+{
+    mtb_block_storage_ftl_config_t config;
+    mtb_block_storage_t ftl;
+    mtb_block_storage_ftl_t obj;
+    uint8_t data[TEST_PAGE_SIZE];
+    uint8_t read[TEST_PAGE_SIZE];
+    uint32_t pages = test_ftl_init(&config, 0xFFu, true, 2u, 3u);
+    uint32_t min_erases = UINT32_MAX;
+    uint32_t max_erases = 0u;
+
+    srand(1u);
+    TEST_ASSERT(mtb_block_storage_create_ftl(&ftl, &obj, &config) == CY_RSLT_SUCCESS);
+    for (uint32_t i = 0; i < 50000u; i++)
+    {
+        //Most of the programs hit a few pages, so that the blocks wear unevenly
+        uint32_t op = (uint32_t)rand() % 100u;
+        uint32_t page = (0 == (rand() % 4)) ? ((uint32_t)rand() % pages) : ((uint32_t)rand() % 4u);
+        uint8_t* shadow = &test_shadow[page * TEST_PAGE_SIZE];
+        cy_rslt_t result = CY_RSLT_SUCCESS;
+        if (op < 80u)
+        {
+            for (uint32_t j = 0; j < TEST_PAGE_SIZE; j++)
+            {
+                data[j] = (uint8_t)rand();
+            }
+            result = ftl.program(ftl.context, page * TEST_PAGE_SIZE, TEST_PAGE_SIZE, data);
+            (void)memcpy(shadow, data, TEST_PAGE_SIZE);
+        }
+        else if (op < 85u)
+        {
+            result = ftl.erase(ftl.context, page * TEST_PAGE_SIZE, TEST_PAGE_SIZE);
+            (void)memset(shadow, 0xFF, TEST_PAGE_SIZE);
+        }
+        else if (op < 86u)
+        {
+            result = mtb_block_storage_create_ftl(&ftl, &obj, &config);
+        }
+        else if (op < 88u)
+        {
+            result = mtb_block_storage_ftl_collect(&obj, 5u);
+            result = (result == MTB_BLOCK_STORAGE_BUSY) ? CY_RSLT_SUCCESS : result;
+        }
+        else
+        {
+            result = ftl.read(ftl.context, page * TEST_PAGE_SIZE, TEST_PAGE_SIZE, read);
+            TEST_ASSERT(0 == memcmp(read, shadow, TEST_PAGE_SIZE));
+        }
+        TEST_ASSERT(result == CY_RSLT_SUCCESS);
+        if (test_failures > 0u)
+        {
+            break;
+        }
+    }
+    TEST_ASSERT(test_ftl_check(&ftl, pages));
+
+    //The wear leveling keeps the erase counts of the blocks close to each other
+    for (uint32_t block = 0; block < TEST_BLOCK_COUNT; block++)
+    {
+        min_erases = (test_blocks[block].erase_count < min_erases) ?
+                     test_blocks[block].erase_count : min_erases;
+        max_erases = (test_blocks[block].erase_count > max_erases) ?
+                     test_blocks[block].erase_count : max_erases;
+    }
+    printf("erase counts %u to %u\n", (unsigned)min_erases, (unsigned)max_erases);
+    TEST_ASSERT(min_erases > 0u);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_ftl_power_loss
+//--------------------------------------------------------------------------------------------------
+static void test_ftl_power_loss(uint8_t erase_value, bool is_erase_required)
+{
+    mtb_block_storage_ftl_config_t config;
+    mtb_block_storage_t ftl;
+    mtb_block_storage_ftl_t obj;
+    uint8_t data[TEST_PAGE_SIZE];
+    uint8_t read[TEST_PAGE_SIZE];
+    uint32_t pages = test_ftl_init(&config, erase_value, is_erase_required, 1u, 0u);
+
+    srand(1u);
+    TEST_ASSERT(mtb_block_storage_create_ftl(&ftl, &obj, &config) == CY_RSLT_SUCCESS);
+    for (uint32_t cycle = 0; (cycle < 2000u) && (0u == test_failures); cycle++)
+    {
+        uint32_t page;
+        bool program;
+
+        //Pages are written until the power is lost, in the write or in the collection it starts.
+        //Some cycles lose the power in the first write after the mount, so that the interrupted
+        //writes follow each other in the open block.
+        test_budget = (0u == (cycle % 4u)) ? 1 : (1 + (rand() % 400));
+        for (;;)
+        {
+            page = (0 == (rand() % 3)) ? ((uint32_t)rand() % pages) : ((uint32_t)rand() % 3u);
+            program = (0 != (rand() % 10));
+            for (uint32_t j = 0; j < TEST_PAGE_SIZE; j++)
+            {
+                data[j] = program ? (uint8_t)rand() : erase_value;
+            }
+            if ((program ? ftl.program(ftl.context, page * TEST_PAGE_SIZE, TEST_PAGE_SIZE, data)
+                 : ftl.erase(ftl.context, page * TEST_PAGE_SIZE, TEST_PAGE_SIZE)) !=
+                CY_RSLT_SUCCESS)
+            {
+                break;
+            }
+            (void)memcpy(&test_shadow[page * TEST_PAGE_SIZE], data, TEST_PAGE_SIZE);
+        }
+        //The write failed only because the power was lost
+        TEST_ASSERT(0 == test_budget);
+        test_budget = -1;
+
+        //The interrupted page has either content, every other page its last content
+        TEST_ASSERT(mtb_block_storage_create_ftl(&ftl, &obj, &config) == CY_RSLT_SUCCESS);
+        TEST_ASSERT(ftl.read(ftl.context, page * TEST_PAGE_SIZE, TEST_PAGE_SIZE, read) ==
+                    CY_RSLT_SUCCESS);
+        if (0 == memcmp(read, data, TEST_PAGE_SIZE))
+        {
+            (void)memcpy(&test_shadow[page * TEST_PAGE_SIZE], data, TEST_PAGE_SIZE);
+        }
+        TEST_ASSERT(test_ftl_check(&ftl, pages));
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_ftl_power_loss_flash
+//--------------------------------------------------------------------------------------------------
+static void test_ftl_power_loss_flash(void)
+{
+    test_ftl_power_loss(0xFFu, true);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_ftl_power_loss_rram
+//--------------------------------------------------------------------------------------------------
+static void test_ftl_power_loss_rram(void)
+{
+    //A memory that is programmed without erase, whose erase writes zeros
+    test_ftl_power_loss(0x00u, false);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// main
+//--------------------------------------------------------------------------------------------------
+int main(void)
+{
+    TEST_RUN(test_ftl_random);
+    TEST_RUN(test_ftl_power_loss_flash);
+    TEST_RUN(test_ftl_power_loss_rram);
+    return TEST_RESULT();
+}
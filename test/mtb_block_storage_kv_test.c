@@ -0,0 +1,330 @@
+/***********************************************************************************************//**
+ * \file mtb_block_storage_kv_test.c
+ *
+ * \brief
+ * Host test of the key-value store on a RAM device with power losses injected in the middle of a
+ * program or an erase. After each power loss the store is mounted again and must hold either the
+ * old or the new value of the interrupted key and the last value of every other key.
+ *
+ * Build and run on host, with the core-lib include folder providing cy_result.h and cy_utils.h:
+ *
+ *     gcc -std=c99 -Iinclude -I<core-lib>/include test/mtb_block_storage_kv_test.c \
+ *         source/mtb_block_storage.c source/mtb_block_storage_kv.c source/mtb_block_storage_ram.c \
+ *         -o mtb_block_storage_kv_test
+ *     ./mtb_block_storage_kv_test
+ *
+ ***************************************************************************************************
+ * \copyright
+ * Copyright 2024 Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **************************************************************************************************/
+#include "mtb_block_storage.h"
+#include "mtb_block_storage_kv.h"
+#include "mtb_block_storage_test.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_MEMORY_SIZE        (16u * 1024u)
+#define TEST_SECTOR_SIZE        (2048u)
+#define TEST_PROGRAM_SIZE       (16u)
+#define TEST_KEY_COUNT          (24u)
+#define TEST_MAX_VALUE          (200u)
+#define TEST_CYCLES             (2000u)
+//Result of the operations of the RAM device once the power is lost
+#define TEST_POWER_LOSS_ERROR   (0xDEADu)
+
+static const mtb_block_storage_ram_region_t test_regions[] =
+{
+    { 0x00000000u, TEST_MEMORY_SIZE, TEST_PROGRAM_SIZE, TEST_SECTOR_SIZE, 0xFFu, true, 0u, 0u, 0u,
+      0u },
+};
+
+static uint8_t test_memory[TEST_MEMORY_SIZE];
+static uint32_t test_program_map[TEST_MEMORY_SIZE / TEST_PROGRAM_SIZE / 32u];
+static mtb_block_storage_kv_entry_t test_index[32];
+static uint8_t test_scratch[64];
+//Expected value of each key, absent when its length is negative
+static uint8_t test_values[TEST_KEY_COUNT][TEST_MAX_VALUE];
+static int32_t test_lengths[TEST_KEY_COUNT];
+
+//RAM device, and the device given to the store that loses the power
+static mtb_block_storage_t test_ram;
+static mtb_block_storage_ram_t test_ram_obj;
+static mtb_block_storage_t test_device;
+//Operations left before the power is lost, negative for no power loss
+static int32_t test_budget = -1;
+//Whether the power is lost at the next erase, before the area is erased
+static bool test_erase_loss;
+
+
+//--------------------------------------------------------------------------------------------------
+// test_power_loss_program
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t test_power_loss_program(void* context, uint32_t addr, uint32_t length,
+                                         const uint8_t* buf)
+{
+    cy_rslt_t result = TEST_POWER_LOSS_ERROR;
+    (void)context;
+    if ((test_budget < 0) || (test_budget > 1))
+    {
+        test_budget = (test_budget < 0) ? test_budget : (test_budget - 1);
+        result = test_ram.program(test_ram.context, addr, length, buf);
+    }
+    else if (1 == test_budget)
+    {
+        //The power is lost after some of the program units are written
+        uint32_t part = ((uint32_t)rand() % ((length / TEST_PROGRAM_SIZE) + 1u)) *
+                        TEST_PROGRAM_SIZE;
+        test_budget = 0;
+        if (0u != part)
+        {
+            (void)test_ram.program(test_ram.context, addr, part, buf);
+        }
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_power_loss_erase
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t test_power_loss_erase(void* context, uint32_t addr, uint32_t length)
+{
+    cy_rslt_t result = TEST_POWER_LOSS_ERROR;
+    (void)context;
+    if (test_erase_loss)
+    {
+        test_erase_loss = false;
+        test_budget = 0;
+    }
+    else if ((test_budget < 0) || (test_budget > 1))
+    {
+        test_budget = (test_budget < 0) ? test_budget : (test_budget - 1);
+        result = test_ram.erase(test_ram.context, addr, length);
+    }
+    else if (1 == test_budget)
+    {
+        //The power is lost either before or after the erase
+        test_budget = 0;
+        if (0 != (rand() % 2))
+        {
+            (void)test_ram.erase(test_ram.context, addr, length);
+        }
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_kv_init
+//--------------------------------------------------------------------------------------------------
+static void test_kv_init(mtb_block_storage_kv_t* kv, mtb_block_storage_kv_config_t* config,
+                         bool checkpoint)
+{
+    mtb_block_storage_ram_config_t ram_config;
+
+    (void)memset(&ram_config, 0, sizeof(ram_config));
+    ram_config.regions = test_regions;
+    ram_config.region_count = 1u;
+    ram_config.memory = test_memory;
+    ram_config.program_map = test_program_map;
+    ram_config.initialize = true;
+    TEST_ASSERT(mtb_block_storage_create_ram(&test_ram, &test_ram_obj, &ram_config) ==
+                CY_RSLT_SUCCESS);
+
+    //The store only uses the blocking functions of the device losing the power
+    test_device = test_ram;
+    test_device.program = test_power_loss_program;
+    test_device.erase = test_power_loss_erase;
+    test_device.program_nb = NULL;
+    test_device.erase_nb = NULL;
+    test_budget = -1;
+    test_erase_loss = false;
+
+    (void)memset(config, 0, sizeof(*config));
+    config->bsd = &test_device;
+    config->start_address = 0u;
+    config->size = TEST_MEMORY_SIZE;
+    config->sector_size = TEST_SECTOR_SIZE;
+    config->index = test_index;
+    config->index_size = sizeof(test_index) / sizeof(test_index[0]);
+    config->scratch = test_scratch;
+    config->scratch_size = sizeof(test_scratch);
+    config->checkpoint = checkpoint;
+    TEST_ASSERT(mtb_block_storage_kv_init(kv, config) == CY_RSLT_SUCCESS);
+    for (uint32_t k = 0; k < TEST_KEY_COUNT; k++)
+    {
+        test_lengths[k] = -1;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_kv_matches
+//--------------------------------------------------------------------------------------------------
+static bool test_kv_matches(mtb_block_storage_kv_t* kv, uint32_t k, const uint8_t* value,
+                            int32_t length)
+{
+    uint8_t read[TEST_MAX_VALUE];
+    uint32_t read_length = 0u;
+    char key[16];
+    cy_rslt_t result;
+
+    (void)snprintf(key, sizeof(key), "key%u", (unsigned)k);
+    result = mtb_block_storage_kv_get(kv, key, read, sizeof(read), &read_length);
+    return (length < 0) ? (result == MTB_BLOCK_STORAGE_NOT_FOUND_ERROR) :
+           ((result == CY_RSLT_SUCCESS) && (read_length == (uint32_t)length) &&
+            (0 == memcmp(read, value, read_length)));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_kv_write
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t test_kv_write(mtb_block_storage_kv_t* kv, uint32_t k, const uint8_t* value,
+                               int32_t length)
+{
+    char key[16];
+    cy_rslt_t result;
+
+    //A value is put, or the key deleted when the length is negative
+    (void)snprintf(key, sizeof(key), "key%u", (unsigned)k);
+    result = (length >= 0) ? mtb_block_storage_kv_put(kv, key, value, (uint32_t)length)
+             : mtb_block_storage_kv_delete(kv, key);
+    if ((result == MTB_BLOCK_STORAGE_NOT_FOUND_ERROR) && (test_lengths[k] < 0))
+    {
+        //Deleting a key that is not stored
+        result = CY_RSLT_SUCCESS;
+    }
+    if (result == CY_RSLT_SUCCESS)
+    {
+        if (length > 0)
+        {
+            (void)memcpy(test_values[k], value, (size_t)length);
+        }
+        test_lengths[k] = length;
+    }
+    else
+    {
+        //The operation failed only because the power was lost
+        TEST_ASSERT(0 == test_budget);
+    }
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_kv_remount
+//--------------------------------------------------------------------------------------------------
+static void test_kv_remount(mtb_block_storage_kv_t* kv, mtb_block_storage_kv_config_t* config,
+                            uint32_t k, const uint8_t* value, int32_t length)
+{
+    //The interrupted key has either value, every other key its last value
+    test_budget = -1;
+    test_erase_loss = false;
+    TEST_ASSERT(mtb_block_storage_kv_init(kv, config) == CY_RSLT_SUCCESS);
+    if (test_kv_matches(kv, k, value, length))
+    {
+        if (length > 0)
+        {
+            (void)memcpy(test_values[k], value, (size_t)length);
+        }
+        test_lengths[k] = length;
+    }
+    for (uint32_t q = 0; q < TEST_KEY_COUNT; q++)
+    {
+        TEST_ASSERT(test_kv_matches(kv, q, test_values[q], test_lengths[q]));
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_kv_random_write
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t test_kv_random_write(mtb_block_storage_kv_t* kv, uint32_t* k, uint8_t* value,
+                                      int32_t* length)
+{
+    *k = (uint32_t)rand() % TEST_KEY_COUNT;
+    *length = (0 != (rand() % 8)) ? (rand() % (int32_t)TEST_MAX_VALUE) : -1;
+    for (int32_t i = 0; i < *length; i++)
+    {
+        value[i] = (uint8_t)rand();
+    }
+    return test_kv_write(kv, *k, value, *length);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_kv_power_loss
+//--------------------------------------------------------------------------------------------------
+static void test_kv_power_loss(bool checkpoint)
+{
+    mtb_block_storage_kv_config_t config;
+    mtb_block_storage_kv_t kv;
+    uint8_t value[TEST_MAX_VALUE];
+
+    test_kv_init(&kv, &config, checkpoint);
+    srand(1u);
+    for (uint32_t cycle = 0; (cycle < TEST_CYCLES) && (0u == test_failures); cycle++)
+    {
+        uint32_t k = 0u;
+        int32_t length = -1;
+
+        //Every tenth cycle runs without power loss, so that the store fills up and compacts. Half
+        //of the others lose the power at the first erase at the latest, which ends a compaction.
+        test_budget = (9u == (cycle % 10u)) ? -1 : (1 + (rand() % 300));
+        test_erase_loss = (test_budget > 0) && (0 != (rand() % 2));
+        for (uint32_t op = 0; op < 300u; op++)
+        {
+            if (test_kv_random_write(&kv, &k, value, &length) != CY_RSLT_SUCCESS)
+            {
+                break;
+            }
+        }
+        test_kv_remount(&kv, &config, k, value, length);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_kv_power_loss_log
+//--------------------------------------------------------------------------------------------------
+static void test_kv_power_loss_log(void)
+{
+    test_kv_power_loss(false);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_kv_power_loss_checkpoint
+//--------------------------------------------------------------------------------------------------
+static void test_kv_power_loss_checkpoint(void)
+{
+    test_kv_power_loss(true);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// main
+//--------------------------------------------------------------------------------------------------
+int main(void)
+{
+    TEST_RUN(test_kv_power_loss_log);
+    TEST_RUN(test_kv_power_loss_checkpoint);
+    return TEST_RESULT();
+}
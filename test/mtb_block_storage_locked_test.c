@@ -0,0 +1,350 @@
+/***********************************************************************************************//**
+ * \file mtb_block_storage_locked_test.c
+ *
+ * \brief
+ * Host test of the locked device on a RAM device of two banks, called from POSIX threads. The
+ * inner functions record how many writes run at the same time and wait a little, so that the
+ * calls of the threads overlap.
+ *
+ * Build and run on a POSIX host, with the core-lib include folder providing cy_result.h and
+ * cy_utils.h:
+ *
+ *     gcc -std=c99 -pthread -Iinclude -I<core-lib>/include test/mtb_block_storage_locked_test.c \
+ *         source/mtb_block_storage_locked.c source/mtb_block_storage_ram.c \
+ *         -o mtb_block_storage_locked_test
+ *     ./mtb_block_storage_locked_test
+ *
+ ***************************************************************************************************
+ * \copyright
+ * Copyright 2024 Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **************************************************************************************************/
+#if !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "mtb_block_storage.h"
+#include "mtb_block_storage_locked.h"
+#include "mtb_block_storage_test.h"
+
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+
+#define TEST_BANK_SIZE          (4096u)
+#define TEST_UNIT_SIZE          (512u)
+#define TEST_WRITES             (50u)
+
+static const mtb_block_storage_ram_region_t test_regions[] =
+{
+    { 0x00000000u, TEST_BANK_SIZE, 4u, TEST_UNIT_SIZE, 0xFFu, true, 0u, 0u, 0u, 0u },
+    { TEST_BANK_SIZE, TEST_BANK_SIZE, 4u, TEST_UNIT_SIZE, 0xFFu, true, 0u, 0u, 0u, 1u },
+};
+
+static uint8_t test_memory[2u * TEST_BANK_SIZE];
+static uint32_t test_program_map[(2u * TEST_BANK_SIZE) / 4u / 32u];
+
+//RAM device, and the locked device built on it
+static mtb_block_storage_t test_ram;
+static mtb_block_storage_ram_t test_ram_obj;
+static mtb_block_storage_t test_inner;
+static mtb_block_storage_t test_bsd;
+static mtb_block_storage_locked_t test_locked;
+
+//Writes of the inner device in progress, the most seen at once and the reads made meanwhile
+static pthread_mutex_t test_counters = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t test_writers;
+static uint32_t test_max_writers;
+static uint32_t test_reads_during_write;
+static long test_write_delay_ns;
+
+
+//--------------------------------------------------------------------------------------------------
+// test_sleep
+//--------------------------------------------------------------------------------------------------
+static void test_sleep(long ns)
+{
+    struct timespec delay = { 0, ns };
+    (void)nanosleep(&delay, NULL);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_write_begin
+//--------------------------------------------------------------------------------------------------
+static void test_write_begin(void)
+{
+    (void)pthread_mutex_lock(&test_counters);
+    test_writers++;
+    test_max_writers = (test_writers > test_max_writers) ? test_writers : test_max_writers;
+    (void)pthread_mutex_unlock(&test_counters);
+    test_sleep(test_write_delay_ns);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_write_end
+//--------------------------------------------------------------------------------------------------
+static void test_write_end(void)
+{
+    (void)pthread_mutex_lock(&test_counters);
+    test_writers--;
+    (void)pthread_mutex_unlock(&test_counters);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_writers_now
+//--------------------------------------------------------------------------------------------------
+static uint32_t test_writers_now(void)
+{
+    uint32_t writers;
+    (void)pthread_mutex_lock(&test_counters);
+    writers = test_writers;
+    (void)pthread_mutex_unlock(&test_counters);
+    return writers;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_inner_read
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t test_inner_read(void* context, uint32_t addr, uint32_t length, uint8_t* buf)
+{
+    (void)pthread_mutex_lock(&test_counters);
+    test_reads_during_write += (test_writers > 0u) ? 1u : 0u;
+    (void)pthread_mutex_unlock(&test_counters);
+    return test_ram.read(context, addr, length, buf);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_inner_program
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t test_inner_program(void* context, uint32_t addr, uint32_t length,
+                                    const uint8_t* buf)
+{
+    cy_rslt_t result;
+    test_write_begin();
+    result = test_ram.program(context, addr, length, buf);
+    test_write_end();
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_inner_erase
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t test_inner_erase(void* context, uint32_t addr, uint32_t length)
+{
+    cy_rslt_t result;
+    test_write_begin();
+    result = test_ram.erase(context, addr, length);
+    test_write_end();
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_locked_init
+//--------------------------------------------------------------------------------------------------
+static void test_locked_init(long write_delay_ns)
+{
+    mtb_block_storage_ram_config_t ram_config;
+    mtb_block_storage_locked_config_t config;
+
+    (void)memset(&ram_config, 0, sizeof(ram_config));
+    ram_config.regions = test_regions;
+    ram_config.region_count = 2u;
+    ram_config.memory = test_memory;
+    ram_config.program_map = test_program_map;
+    ram_config.initialize = true;
+    TEST_ASSERT(mtb_block_storage_create_ram(&test_ram, &test_ram_obj, &ram_config) ==
+                CY_RSLT_SUCCESS);
+    test_inner = test_ram;
+    test_inner.read = test_inner_read;
+    test_inner.program = test_inner_program;
+    test_inner.erase = test_inner_erase;
+    test_inner.program_nb = NULL;
+    test_inner.erase_nb = NULL;
+    test_inner.readv = NULL;
+    test_inner.programv = NULL;
+
+    //The lock regions are the banks of the inner geometry
+    (void)memset(&config, 0, sizeof(config));
+    config.bsd = &test_inner;
+    config.per_region = true;
+    TEST_ASSERT(mtb_block_storage_create_locked(&test_bsd, &test_locked, &config) ==
+                CY_RSLT_SUCCESS);
+    test_writers = 0u;
+    test_max_writers = 0u;
+    test_reads_during_write = 0u;
+    test_write_delay_ns = write_delay_ns;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_writer
+//--------------------------------------------------------------------------------------------------
+static void* test_writer(void* arg)
+{
+    uint32_t bank = (uint32_t)(uintptr_t)arg;
+    uint32_t addr = bank * TEST_BANK_SIZE;
+    uint8_t data[TEST_UNIT_SIZE];
+    uint8_t read[TEST_UNIT_SIZE];
+    bool ok = true;
+
+    for (uint32_t i = 0; ok && (i < TEST_WRITES); i++)
+    {
+        (void)memset(data, (int)((bank << 4) | (i & 0x0Fu)), sizeof(data));
+        ok = (test_bsd.erase(test_bsd.context, addr, TEST_UNIT_SIZE) == CY_RSLT_SUCCESS) &&
+             (test_bsd.program(test_bsd.context, addr, sizeof(data), data) == CY_RSLT_SUCCESS) &&
+             (test_bsd.read(test_bsd.context, addr, sizeof(read), read) == CY_RSLT_SUCCESS) &&
+             (0 == memcmp(read, data, sizeof(data)));
+    }
+    return ok ? arg : NULL;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_locked_write_order
+//--------------------------------------------------------------------------------------------------
+static void test_locked_write_order(void)
+{
+    pthread_t threads[2];
+    void* results[2] = { NULL, NULL };
+
+    //The banks have their own locks, but their writes still go one at a time to the inner device
+    test_locked_init(20000);
+    for (uint32_t bank = 0; bank < 2u; bank++)
+    {
+        TEST_ASSERT(0 == pthread_create(&threads[bank], NULL, test_writer,
+                                        (void*)(uintptr_t)bank));
+    }
+    for (uint32_t bank = 0; bank < 2u; bank++)
+    {
+        TEST_ASSERT(0 == pthread_join(threads[bank], &results[bank]));
+    }
+    TEST_ASSERT((results[0] == (void*)(uintptr_t)0u) && (results[1] == (void*)(uintptr_t)1u));
+    TEST_ASSERT(test_max_writers == 1u);
+    mtb_block_storage_locked_deinit(&test_locked);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_eraser
+//--------------------------------------------------------------------------------------------------
+static void* test_eraser(void* arg)
+{
+    uint32_t addr = (uint32_t)(uintptr_t)arg;
+    return (test_bsd.erase(test_bsd.context, addr, TEST_BANK_SIZE) == CY_RSLT_SUCCESS) ?
+           &test_bsd : NULL;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_locked_read_during_write
+//--------------------------------------------------------------------------------------------------
+static void test_locked_read_during_write(void)
+{
+    pthread_t thread;
+    void* result = NULL;
+    uint8_t read[16];
+
+    //A read of the other bank runs while the erase is in progress, one of the same bank waits
+    test_locked_init(50000000);
+    TEST_ASSERT(0 == pthread_create(&thread, NULL, test_eraser, (void*)(uintptr_t)0u));
+    while (0u == test_writers_now())
+    {
+        test_sleep(100000);
+    }
+    TEST_ASSERT(test_bsd.read(test_bsd.context, TEST_BANK_SIZE, sizeof(read), read) ==
+                CY_RSLT_SUCCESS);
+    TEST_ASSERT(test_reads_during_write == 1u);
+    TEST_ASSERT(test_bsd.read(test_bsd.context, 0u, sizeof(read), read) == CY_RSLT_SUCCESS);
+    TEST_ASSERT(test_reads_during_write == 1u);
+    TEST_ASSERT(0 == pthread_join(thread, &result));
+    TEST_ASSERT(result == &test_bsd);
+    mtb_block_storage_locked_deinit(&test_locked);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_locked_read_behind_write
+//--------------------------------------------------------------------------------------------------
+static void test_locked_read_behind_write(void)
+{
+    pthread_t threads[2];
+    void* results[2] = { NULL, NULL };
+    uint8_t read[16];
+
+    //The erase of the second bank waits for the one of the first bank without holding the lock of
+    //its bank, so a read of the second bank still runs while the first bank is erased
+    test_locked_init(50000000);
+    TEST_ASSERT(0 == pthread_create(&threads[0], NULL, test_eraser, (void*)(uintptr_t)0u));
+    while (0u == test_writers_now())
+    {
+        test_sleep(100000);
+    }
+    TEST_ASSERT(0 == pthread_create(&threads[1], NULL, test_eraser,
+                                    (void*)(uintptr_t)TEST_BANK_SIZE));
+    test_sleep(10000000);
+    TEST_ASSERT(test_bsd.read(test_bsd.context, TEST_BANK_SIZE, sizeof(read), read) ==
+                CY_RSLT_SUCCESS);
+    TEST_ASSERT(test_reads_during_write == 1u);
+    for (uint32_t i = 0; i < 2u; i++)
+    {
+        TEST_ASSERT(0 == pthread_join(threads[i], &results[i]));
+        TEST_ASSERT(results[i] == &test_bsd);
+    }
+    TEST_ASSERT(test_max_writers == 1u);
+    mtb_block_storage_locked_deinit(&test_locked);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_locked_erase_required_unknown
+//--------------------------------------------------------------------------------------------------
+static void test_locked_erase_required_unknown(void)
+{
+    mtb_block_storage_locked_config_t config;
+
+    //An inner device without is_erase_required is reported as needing an erase
+    test_locked_init(0);
+    TEST_ASSERT(test_bsd.is_erase_required(test_bsd.context, 0u, TEST_UNIT_SIZE));
+    mtb_block_storage_locked_deinit(&test_locked);
+    test_inner.is_erase_required = NULL;
+    (void)memset(&config, 0, sizeof(config));
+    config.bsd = &test_inner;
+    TEST_ASSERT(mtb_block_storage_create_locked(&test_bsd, &test_locked, &config) ==
+                CY_RSLT_SUCCESS);
+    TEST_ASSERT(test_bsd.is_erase_required(test_bsd.context, 0u, TEST_UNIT_SIZE));
+    mtb_block_storage_locked_deinit(&test_locked);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// main
+//--------------------------------------------------------------------------------------------------
+int main(void)
+{
+    TEST_RUN(test_locked_write_order);
+    TEST_RUN(test_locked_read_during_write);
+    TEST_RUN(test_locked_read_behind_write);
+    TEST_RUN(test_locked_erase_required_unknown);
+    return TEST_RESULT();
+}
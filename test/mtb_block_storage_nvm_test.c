@@ -0,0 +1,623 @@
+/***********************************************************************************************//**
+ * \file mtb_block_storage_nvm_test.c
+ *
+ * \brief
+ * Host test of the HAL NVM block storage device. The classic HAL and the PDL flash functions it
+ * calls are implemented below on top of RAM arrays, with non blocking operations that complete
+ * after a few polls, so mtb_block_storage_nvm.c runs without any hardware.
+ *
+ * Build and run on host, with the core-lib include folder providing cy_result.h and cy_utils.h,
+ * once as a CAT1C device with the ECT flash controller and once as a CAT1A device:
+ *
+ *     gcc -std=c99 -DCY_USING_HAL -DCOMPONENT_CAT1C -DCPUSS_FLASHC_ECT=1 -Iinclude -Itest/hal \
+ *         -I<core-lib>/include test/mtb_block_storage_nvm_test.c source/mtb_block_storage.c \
+ *         source/mtb_block_storage_nvm.c -o mtb_block_storage_nvm_test
+ *     ./mtb_block_storage_nvm_test
+ *     gcc -std=c99 -DCY_USING_HAL -DCOMPONENT_CAT1A -Iinclude -Itest/hal -I<core-lib>/include \
+ *         test/mtb_block_storage_nvm_test.c source/mtb_block_storage.c \
+ *         source/mtb_block_storage_nvm.c -o mtb_block_storage_nvm_test
+ *     ./mtb_block_storage_nvm_test
+ *
+ ***************************************************************************************************
+ * \copyright
+ * Copyright 2024 Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **************************************************************************************************/
+#include "mtb_block_storage.h"
+#include "mtb_block_storage_test.h"
+
+#include <string.h>
+
+#define SIM_REGION_COUNT        (4u)
+#define SIM_REGION_MAX_SIZE     (0x10000u)
+#define SIM_ROW_MAX_SIZE        (512u)
+//Number of completion checks a non blocking operation takes
+#define SIM_OPERATION_POLLS     (3u)
+
+#define SIM_OP_NONE             (0u)
+#define SIM_OP_PROGRAM          (1u)
+#define SIM_OP_ERASE            (2u)
+
+/* CAT1C like layout: the large and small sector regions of the code flash, then of the work
+   flash. The code flash regions are one bank, the work flash regions another one. */
+static const cyhal_nvm_region_info_t sim_regions[SIM_REGION_COUNT] =
+{
+    { CYHAL_NVM_TYPE_FLASH, 0x10000000u, 0u, 0x10000u, 0x8000u, 512u, true, 0xFFu },
+    { CYHAL_NVM_TYPE_FLASH, 0x10010000u, 0u, 0x8000u,  0x2000u, 512u, true, 0xFFu },
+    { CYHAL_NVM_TYPE_FLASH, 0x14000000u, 0u, 0x8000u,  0x800u,  512u, true, 0xFFu },
+    { CYHAL_NVM_TYPE_FLASH, 0x14008000u, 0u, 0x1000u,  0x80u,   128u, true, 0xFFu },
+};
+
+static uint8_t sim_memory[SIM_REGION_COUNT][SIM_REGION_MAX_SIZE];
+
+//Non blocking operation in progress in the simulated flash controller
+static struct
+{
+    uint32_t op;
+    uint32_t addr;
+    uint32_t length;
+    uint32_t polls;
+    uint8_t  data[SIM_ROW_MAX_SIZE];
+} sim_pending;
+
+//Rows programmed through Cy_Flash_Program_WorkFlash, and blank checks outside of the work flash
+static uint32_t sim_work_flash_rows;
+static uint32_t sim_code_flash_blank_checks;
+//Interrupt handler run once at the next poll of the flash controller, NULL for none
+static void (* sim_interrupt)(void);
+
+
+//--------------------------------------------------------------------------------------------------
+// sim_memory_at
+//--------------------------------------------------------------------------------------------------
+static uint8_t* sim_memory_at(uint32_t addr, uint32_t length, uint32_t* region_index)
+{
+    for (uint32_t region = 0; region < SIM_REGION_COUNT; region++)
+    {
+        const cyhal_nvm_region_info_t* info = &sim_regions[region];
+        if ((addr >= info->start_address) && ((addr - info->start_address) < info->size) &&
+            (length <= (info->size - (addr - info->start_address))))
+        {
+            if (NULL != region_index)
+            {
+                *region_index = region;
+            }
+            return &sim_memory[region][addr - info->start_address];
+        }
+    }
+    return NULL;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// sim_apply
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t sim_apply(uint32_t op, uint32_t addr, uint32_t length, const uint8_t* data)
+{
+    uint8_t* memory = sim_memory_at(addr, length, NULL);
+    if (NULL == memory)
+    {
+        return MTB_BLOCK_STORAGE_NOT_IN_RANGE_ERROR;
+    }
+    if (SIM_OP_PROGRAM == op)
+    {
+        (void)memcpy(memory, data, length);
+    }
+    else
+    {
+        (void)memset(memory, 0xFF, length);
+    }
+    return CY_RSLT_SUCCESS;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// sim_start
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t sim_start(uint32_t op, uint32_t addr, uint32_t length, const uint8_t* data)
+{
+    if ((SIM_OP_NONE != sim_pending.op) || (NULL == sim_memory_at(addr, length, NULL)) ||
+        ((SIM_OP_PROGRAM == op) && (length > SIM_ROW_MAX_SIZE)))
+    {
+        return MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+    }
+    sim_pending.op = op;
+    sim_pending.addr = addr;
+    sim_pending.length = length;
+    sim_pending.polls = SIM_OPERATION_POLLS;
+    if (SIM_OP_PROGRAM == op)
+    {
+        (void)memcpy(sim_pending.data, data, length);
+    }
+    return CY_RSLT_SUCCESS;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// sim_is_complete
+//--------------------------------------------------------------------------------------------------
+static bool sim_is_complete(void)
+{
+    void (* interrupt)(void) = sim_interrupt;
+    if (NULL != interrupt)
+    {
+        sim_interrupt = NULL;
+        interrupt();
+    }
+    if (SIM_OP_NONE != sim_pending.op)
+    {
+        sim_pending.polls--;
+        if (0u == sim_pending.polls)
+        {
+            (void)sim_apply(sim_pending.op, sim_pending.addr, sim_pending.length,
+                            sim_pending.data);
+            sim_pending.op = SIM_OP_NONE;
+        }
+    }
+    return (SIM_OP_NONE == sim_pending.op);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// sim_reset
+//--------------------------------------------------------------------------------------------------
+static void sim_reset(void)
+{
+    (void)memset(sim_memory, 0xFF, sizeof(sim_memory));
+    (void)memset(&sim_pending, 0, sizeof(sim_pending));
+    sim_interrupt = NULL;
+    sim_work_flash_rows = 0;
+    sim_code_flash_blank_checks = 0;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// cyhal_system_critical_section_enter
+//--------------------------------------------------------------------------------------------------
+uint32_t cyhal_system_critical_section_enter(void)
+{
+    return 0u;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// cyhal_system_critical_section_exit
+//--------------------------------------------------------------------------------------------------
+void cyhal_system_critical_section_exit(uint32_t old_state)
+{
+    CY_UNUSED_PARAMETER(old_state);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// cyhal_nvm_init
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t cyhal_nvm_init(cyhal_nvm_t* obj)
+{
+    CY_UNUSED_PARAMETER(obj);
+    return CY_RSLT_SUCCESS;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// cyhal_nvm_free
+//--------------------------------------------------------------------------------------------------
+void cyhal_nvm_free(cyhal_nvm_t* obj)
+{
+    CY_UNUSED_PARAMETER(obj);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// cyhal_nvm_get_info
+//--------------------------------------------------------------------------------------------------
+void cyhal_nvm_get_info(cyhal_nvm_t* obj, cyhal_nvm_info_t* info)
+{
+    CY_UNUSED_PARAMETER(obj);
+    info->region_count = SIM_REGION_COUNT;
+    info->regions = sim_regions;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// cyhal_nvm_read
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t cyhal_nvm_read(cyhal_nvm_t* obj, uint32_t address, uint8_t* data, size_t size)
+{
+    const uint8_t* memory = sim_memory_at(address, (uint32_t)size, NULL);
+    CY_UNUSED_PARAMETER(obj);
+    if (NULL == memory)
+    {
+        return MTB_BLOCK_STORAGE_NOT_IN_RANGE_ERROR;
+    }
+    (void)memcpy(data, memory, size);
+    return CY_RSLT_SUCCESS;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// cyhal_nvm_program
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t cyhal_nvm_program(cyhal_nvm_t* obj, uint32_t address, const uint32_t* data)
+{
+    uint32_t region = 0;
+    CY_UNUSED_PARAMETER(obj);
+    if (NULL == sim_memory_at(address, 1u, &region))
+    {
+        return MTB_BLOCK_STORAGE_NOT_IN_RANGE_ERROR;
+    }
+    return sim_apply(SIM_OP_PROGRAM, address, sim_regions[region].block_size,
+                     (const uint8_t*)data);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// cyhal_nvm_erase
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t cyhal_nvm_erase(cyhal_nvm_t* obj, uint32_t address)
+{
+    uint32_t region = 0;
+    CY_UNUSED_PARAMETER(obj);
+    if (NULL == sim_memory_at(address, 1u, &region))
+    {
+        return MTB_BLOCK_STORAGE_NOT_IN_RANGE_ERROR;
+    }
+    return sim_apply(SIM_OP_ERASE, address, sim_regions[region].sector_size, NULL);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// cyhal_nvm_start_program
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t cyhal_nvm_start_program(cyhal_nvm_t* obj, uint32_t address, const uint32_t* data)
+{
+    uint32_t region = 0;
+    CY_UNUSED_PARAMETER(obj);
+    if (NULL == sim_memory_at(address, 1u, &region))
+    {
+        return MTB_BLOCK_STORAGE_NOT_IN_RANGE_ERROR;
+    }
+    return sim_start(SIM_OP_PROGRAM, address, sim_regions[region].block_size,
+                     (const uint8_t*)data);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// cyhal_nvm_start_erase
+//--------------------------------------------------------------------------------------------------
+cy_rslt_t cyhal_nvm_start_erase(cyhal_nvm_t* obj, uint32_t address)
+{
+    uint32_t region = 0;
+    CY_UNUSED_PARAMETER(obj);
+    if (NULL == sim_memory_at(address, 1u, &region))
+    {
+        return MTB_BLOCK_STORAGE_NOT_IN_RANGE_ERROR;
+    }
+    return sim_start(SIM_OP_ERASE, address, sim_regions[region].sector_size, NULL);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// cyhal_nvm_is_operation_complete
+//--------------------------------------------------------------------------------------------------
+bool cyhal_nvm_is_operation_complete(cyhal_nvm_t* obj)
+{
+    CY_UNUSED_PARAMETER(obj);
+    return sim_is_complete();
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// Cy_Flash_IsOperationComplete
+//--------------------------------------------------------------------------------------------------
+cy_en_flashdrv_status_t Cy_Flash_IsOperationComplete(void)
+{
+    return sim_is_complete() ? CY_FLASH_DRV_SUCCESS : CY_FLASH_DRV_OPCODE_BUSY;
+}
+
+
+#if (CPUSS_FLASHC_ECT == 1)
+//--------------------------------------------------------------------------------------------------
+// Cy_Flash_Program_WorkFlash
+//--------------------------------------------------------------------------------------------------
+cy_en_flashdrv_status_t Cy_Flash_Program_WorkFlash(const cy_stc_flash_programrow_config_t* config)
+{
+    uint32_t addr = (uint32_t)(uintptr_t)config->destAddr;
+    uint32_t length = (config->dataSize == CY_FLASH_PROGRAMROW_DATA_SIZE_4096BIT) ? 512u :
+                      (config->dataSize == CY_FLASH_PROGRAMROW_DATA_SIZE_1024BIT) ? 128u : 4u;
+    cy_rslt_t result;
+
+    sim_work_flash_rows++;
+    if (config->blocking == CY_FLASH_PROGRAMROW_BLOCKING)
+    {
+        result = sim_apply(SIM_OP_PROGRAM, addr, length, (const uint8_t*)config->dataAddr);
+    }
+    else
+    {
+        result = sim_start(SIM_OP_PROGRAM, addr, length, (const uint8_t*)config->dataAddr);
+    }
+    return (result == CY_RSLT_SUCCESS)
+        ? ((config->blocking == CY_FLASH_PROGRAMROW_BLOCKING) ? CY_FLASH_DRV_SUCCESS :
+           CY_FLASH_DRV_OPERATION_STARTED)
+        : CY_FLASH_DRV_INVALID_FLASH_ADDR;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// Cy_Flash_BlankCheck
+//--------------------------------------------------------------------------------------------------
+cy_en_flashdrv_status_t Cy_Flash_BlankCheck(const cy_stc_flash_blankcheck_config_t* config,
+                                            cy_en_flash_driver_blocking_t block)
+{
+    uint32_t length = config->numOfWordsToBeChecked * sizeof(uint32_t);
+    const uint8_t* memory = sim_memory_at((uint32_t)(uintptr_t)config->addrToBeChecked, length,
+                                          NULL);
+    uint32_t addr = (uint32_t)(uintptr_t)config->addrToBeChecked;
+    CY_UNUSED_PARAMETER(block);
+    if ((addr < CY_WFLASH_BASE) || (addr >= (CY_WFLASH_BASE + CY_WFLASH_SIZE)))
+    {
+        sim_code_flash_blank_checks++;
+    }
+    if (NULL == memory)
+    {
+        return CY_FLASH_DRV_INVALID_FLASH_ADDR;
+    }
+    for (uint32_t i = 0; i < length; i++)
+    {
+        if (memory[i] != 0xFFu)
+        {
+            return CY_FLASH_DRV_ERR_UNC;
+        }
+    }
+    return CY_FLASH_DRV_SUCCESS;
+}
+
+
+#endif // if (CPUSS_FLASHC_ECT == 1)
+//--------------------------------------------------------------------------------------------------
+// test_nvm_banks
+//--------------------------------------------------------------------------------------------------
+static void test_nvm_banks(void)
+{
+    #if defined(MTB_BLOCK_STORAGE_NVM_BANKS)
+    //The code flash regions share the first bank, the work flash regions the second one
+    static const uint8_t expected[SIM_REGION_COUNT] = { 0u, 0u, 1u, 1u };
+    #else
+    static const uint8_t expected[SIM_REGION_COUNT] = { 0u, 1u, 2u, 3u };
+    #endif
+    mtb_block_storage_region_t regions[SIM_REGION_COUNT];
+    mtb_block_storage_t bsd;
+    uint32_t count = 0;
+
+    sim_reset();
+    TEST_ASSERT(mtb_block_storage_create_hal_nvm(&bsd, NULL) == CY_RSLT_SUCCESS);
+    TEST_ASSERT(mtb_block_storage_get_geometry(&bsd, regions, SIM_REGION_COUNT, &count) ==
+                CY_RSLT_SUCCESS);
+    TEST_ASSERT(count == SIM_REGION_COUNT);
+    for (uint32_t region = 0; (region < count) && (region < SIM_REGION_COUNT); region++)
+    {
+        TEST_ASSERT(regions[region].start_address == sim_regions[region].start_address);
+        TEST_ASSERT(regions[region].bank == expected[region]);
+    }
+    TEST_ASSERT(mtb_block_storage_nvm_deinit(&bsd) == CY_RSLT_SUCCESS);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_nvm_region_boundary
+//--------------------------------------------------------------------------------------------------
+static void test_nvm_region_boundary(void)
+{
+    static uint8_t data[0x400];
+    mtb_block_storage_t bsd;
+    uint32_t boundary = sim_regions[1].start_address;
+
+    sim_reset();
+    (void)memset(data, 0x5A, sizeof(data));
+    (void)memset(sim_memory[0], 0x00, sim_regions[0].size);
+    TEST_ASSERT(mtb_block_storage_create_hal_nvm(&bsd, NULL) == CY_RSLT_SUCCESS);
+
+    //An area starting in one region and ending in the next one is rejected before any change
+    TEST_ASSERT(bsd.program(bsd.context, boundary - 0x200u, sizeof(data), data) ==
+                MTB_BLOCK_STORAGE_NOT_IN_RANGE_ERROR);
+    TEST_ASSERT(sim_memory[0][sim_regions[0].size - 0x200u] == 0x00u);
+    TEST_ASSERT(sim_memory[1][0] == 0xFFu);
+    TEST_ASSERT(bsd.erase(bsd.context, boundary - sim_regions[0].sector_size,
+                          sim_regions[0].sector_size * 2u) == MTB_BLOCK_STORAGE_NOT_IN_RANGE_ERROR);
+    TEST_ASSERT(sim_memory[0][sim_regions[0].size - sim_regions[0].sector_size] == 0x00u);
+
+    //The same areas inside the first region are accepted
+    TEST_ASSERT(bsd.erase(bsd.context, boundary - sim_regions[0].sector_size,
+                          sim_regions[0].sector_size) == CY_RSLT_SUCCESS);
+    TEST_ASSERT(bsd.program(bsd.context, boundary - sizeof(data), sizeof(data), data) ==
+                CY_RSLT_SUCCESS);
+    TEST_ASSERT(0 == memcmp(&sim_memory[0][sim_regions[0].size - sizeof(data)], data,
+                            sizeof(data)));
+    TEST_ASSERT(mtb_block_storage_nvm_deinit(&bsd) == CY_RSLT_SUCCESS);
+}
+
+
+#if (CPUSS_FLASHC_ECT == 1)
+//--------------------------------------------------------------------------------------------------
+// test_nvm_ect_compare
+//--------------------------------------------------------------------------------------------------
+static void test_nvm_ect_compare(void)
+{
+    static uint8_t data[512];
+    mtb_block_storage_t bsd;
+
+    sim_reset();
+    for (uint32_t i = 0; i < sizeof(data); i++)
+    {
+        data[i] = (uint8_t)(i * 3u);
+    }
+    TEST_ASSERT(mtb_block_storage_create_hal_nvm(&bsd, NULL) == CY_RSLT_SUCCESS);
+    TEST_ASSERT(mtb_block_storage_nvm_set_options(
+                    &bsd, MTB_BLOCK_STORAGE_OPTION_COMPARE_BEFORE_PROGRAM) == CY_RSLT_SUCCESS);
+
+    //A code flash row already holding the data is read and compared, without a blank check
+    (void)memcpy(sim_memory[0], data, sizeof(data));
+    TEST_ASSERT(bsd.program(bsd.context, sim_regions[0].start_address, sizeof(data), data) ==
+                CY_RSLT_SUCCESS);
+    TEST_ASSERT(sim_work_flash_rows == 0u);
+    TEST_ASSERT(sim_code_flash_blank_checks == 0u);
+
+    //An erased code flash row is read as is and programmed
+    TEST_ASSERT(bsd.program(bsd.context, sim_regions[1].start_address, sizeof(data), data) ==
+                CY_RSLT_SUCCESS);
+    TEST_ASSERT(sim_work_flash_rows == 1u);
+    TEST_ASSERT(sim_code_flash_blank_checks == 0u);
+    TEST_ASSERT(0 == memcmp(sim_memory[1], data, sizeof(data)));
+
+    //An erased work flash row is blank checked, it holds data made of the erase value
+    (void)memset(data, 0xFF, sizeof(data));
+    TEST_ASSERT(bsd.program(bsd.context, sim_regions[2].start_address, sizeof(data), data) ==
+                CY_RSLT_SUCCESS);
+    TEST_ASSERT(sim_work_flash_rows == 1u);
+    TEST_ASSERT(sim_code_flash_blank_checks == 0u);
+    TEST_ASSERT(mtb_block_storage_nvm_deinit(&bsd) == CY_RSLT_SUCCESS);
+}
+
+
+#endif // if (CPUSS_FLASHC_ECT == 1)
+#if defined(MTB_BLOCK_STORAGE_NON_BLOCKING_SUPPORTED)
+//--------------------------------------------------------------------------------------------------
+// test_nvm_read_while_write
+//--------------------------------------------------------------------------------------------------
+static void test_nvm_read_while_write(void)
+{
+    mtb_block_storage_t bsd;
+    uint8_t data[16];
+
+    sim_reset();
+    (void)memset(sim_memory[0], 0x5A, sim_regions[0].sector_size);
+    TEST_ASSERT(mtb_block_storage_create_hal_nvm(&bsd, NULL) == CY_RSLT_SUCCESS);
+    TEST_ASSERT(mtb_block_storage_nvm_set_options(&bsd, MTB_BLOCK_STORAGE_OPTION_READ_WHILE_WRITE)
+                == CY_RSLT_SUCCESS);
+    TEST_ASSERT(bsd.erase_nb(bsd.context, sim_regions[0].start_address,
+                             sim_regions[0].sector_size) == CY_RSLT_SUCCESS);
+
+    //A read of the work flash does not wait for the erase of the code flash
+    TEST_ASSERT(bsd.read(bsd.context, sim_regions[2].start_address, sizeof(data), data) ==
+                CY_RSLT_SUCCESS);
+    TEST_ASSERT(sim_pending.op == SIM_OP_ERASE);
+
+    //The other code flash region is in the same bank only when the banks are configured
+    TEST_ASSERT(bsd.read(bsd.context, sim_regions[1].start_address, sizeof(data), data) ==
+                CY_RSLT_SUCCESS);
+    #if defined(MTB_BLOCK_STORAGE_NVM_BANKS)
+    TEST_ASSERT(sim_pending.op == SIM_OP_NONE);
+    #else
+    TEST_ASSERT(sim_pending.op == SIM_OP_ERASE);
+    #endif
+
+    //A read of the region being erased always waits and returns the erased data
+    TEST_ASSERT(bsd.read(bsd.context, sim_regions[0].start_address, sizeof(data), data) ==
+                CY_RSLT_SUCCESS);
+    TEST_ASSERT(sim_pending.op == SIM_OP_NONE);
+    TEST_ASSERT((data[0] == 0xFFu) && (data[sizeof(data) - 1u] == 0xFFu));
+    TEST_ASSERT(bsd.poll(bsd.context) == CY_RSLT_SUCCESS);
+    TEST_ASSERT(mtb_block_storage_nvm_deinit(&bsd) == CY_RSLT_SUCCESS);
+}
+
+
+//Results of the calls made by the interrupt of test_nvm_read_while_write_claim
+static mtb_block_storage_t* test_claim_bsd;
+static cy_rslt_t test_claim_program_nb;
+static cy_rslt_t test_claim_read;
+static uint8_t test_claim_data[16];
+static uint32_t test_claim_callbacks;
+
+
+//--------------------------------------------------------------------------------------------------
+// test_claim_interrupt
+//--------------------------------------------------------------------------------------------------
+static void test_claim_interrupt(void)
+{
+    uint8_t data[512];
+    (void)memset(data, 0x11, sizeof(data));
+    test_claim_program_nb = test_claim_bsd->program_nb(test_claim_bsd->context,
+                                                       sim_regions[2].start_address,
+                                                       sizeof(data), data);
+    test_claim_read = test_claim_bsd->read(test_claim_bsd->context, sim_regions[0].start_address,
+                                           sizeof(test_claim_data), test_claim_data);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_claim_callback
+//--------------------------------------------------------------------------------------------------
+static void test_claim_callback(void* callback_arg, cy_rslt_t result)
+{
+    CY_UNUSED_PARAMETER(callback_arg);
+    CY_UNUSED_PARAMETER(result);
+    test_claim_callbacks++;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_nvm_read_while_write_claim
+//--------------------------------------------------------------------------------------------------
+static void test_nvm_read_while_write_claim(void)
+{
+    mtb_block_storage_t bsd;
+
+    sim_reset();
+    (void)memset(sim_memory[0], 0x5A, sim_regions[0].sector_size);
+    TEST_ASSERT(mtb_block_storage_create_hal_nvm(&bsd, NULL) == CY_RSLT_SUCCESS);
+    TEST_ASSERT(mtb_block_storage_nvm_set_options(&bsd, MTB_BLOCK_STORAGE_OPTION_READ_WHILE_WRITE)
+                == CY_RSLT_SUCCESS);
+    TEST_ASSERT(bsd.register_callback(bsd.context, test_claim_callback, NULL) == CY_RSLT_SUCCESS);
+    test_claim_bsd = &bsd;
+    test_claim_program_nb = CY_RSLT_SUCCESS;
+    test_claim_read = MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR;
+    test_claim_callbacks = 0;
+
+    //An interrupt during a blocking erase cannot start another operation, and its read of the
+    //bank being erased waits for the erase
+    sim_interrupt = test_claim_interrupt;
+    TEST_ASSERT(bsd.erase(bsd.context, sim_regions[0].start_address, sim_regions[0].sector_size)
+                == CY_RSLT_SUCCESS);
+    TEST_ASSERT(NULL == sim_interrupt);
+    TEST_ASSERT(test_claim_program_nb == MTB_BLOCK_STORAGE_BUSY);
+    TEST_ASSERT(test_claim_read == CY_RSLT_SUCCESS);
+    TEST_ASSERT((test_claim_data[0] == 0xFFu) && (test_claim_data[15] == 0xFFu));
+    TEST_ASSERT(sim_memory[2][0] == 0xFFu);
+
+    //The completion callback is only invoked for the non blocking operations
+    TEST_ASSERT(test_claim_callbacks == 0u);
+    TEST_ASSERT(mtb_block_storage_nvm_deinit(&bsd) == CY_RSLT_SUCCESS);
+}
+
+
+#endif // defined(MTB_BLOCK_STORAGE_NON_BLOCKING_SUPPORTED)
+//--------------------------------------------------------------------------------------------------
+// main
+//--------------------------------------------------------------------------------------------------
+int main(void)
+{
+    TEST_RUN(test_nvm_banks);
+    TEST_RUN(test_nvm_region_boundary);
+    #if (CPUSS_FLASHC_ECT == 1)
+    TEST_RUN(test_nvm_ect_compare);
+    #endif
+    #if defined(MTB_BLOCK_STORAGE_NON_BLOCKING_SUPPORTED)
+    TEST_RUN(test_nvm_read_while_write);
+    TEST_RUN(test_nvm_read_while_write_claim);
+    #endif
+    return TEST_RESULT();
+}
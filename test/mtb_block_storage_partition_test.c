@@ -0,0 +1,86 @@
+/***********************************************************************************************//**
+ * \file mtb_block_storage_partition_test.c
+ *
+ * \brief
+ * Host test of the partition device, run on a RAM device.
+ *
+ * Build and run on host, with the core-lib include folder providing cy_result.h and cy_utils.h:
+ *
+ *     gcc -std=c99 -Iinclude -I<core-lib>/include test/mtb_block_storage_partition_test.c \
+ *         source/mtb_block_storage_partition.c source/mtb_block_storage_ram.c \
+ *         -o mtb_block_storage_partition_test
+ *     ./mtb_block_storage_partition_test
+ *
+ ***************************************************************************************************
+ * \copyright
+ * Copyright 2024 Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **************************************************************************************************/
+#include "mtb_block_storage.h"
+#include "mtb_block_storage_partition.h"
+#include "mtb_block_storage_test.h"
+
+#include <string.h>
+
+#define TEST_UNIT_SIZE          (512u)
+#define TEST_MEMORY_SIZE        (4u * TEST_UNIT_SIZE)
+
+static const mtb_block_storage_ram_region_t test_regions[] =
+{
+    { 0x00000000u, TEST_MEMORY_SIZE, 4u, TEST_UNIT_SIZE, 0xFFu, true, 0u, 0u, 0u, 0u },
+};
+
+static uint8_t test_memory[TEST_MEMORY_SIZE];
+static uint32_t test_program_map[TEST_MEMORY_SIZE / 4u / 32u];
+
+
+//--------------------------------------------------------------------------------------------------
+// test_partition_erase_required
+//--------------------------------------------------------------------------------------------------
+static void test_partition_erase_required(void)
+{
+    mtb_block_storage_t parent;
+    mtb_block_storage_ram_t ram;
+    mtb_block_storage_ram_config_t config;
+    mtb_block_storage_t child;
+    mtb_block_storage_partition_t partition;
+
+    (void)memset(&config, 0, sizeof(config));
+    config.regions = test_regions;
+    config.region_count = 1u;
+    config.memory = test_memory;
+    config.program_map = test_program_map;
+    config.initialize = true;
+    TEST_ASSERT(mtb_block_storage_create_ram(&parent, &ram, &config) == CY_RSLT_SUCCESS);
+    TEST_ASSERT(mtb_block_storage_create_partition(&child, &partition, &parent, TEST_UNIT_SIZE,
+                                                   2u * TEST_UNIT_SIZE) == CY_RSLT_SUCCESS);
+    TEST_ASSERT(child.is_erase_required(child.context, 0u, TEST_UNIT_SIZE));
+
+    //A parent without is_erase_required is assumed to need an erase before a program
+    parent.is_erase_required = NULL;
+    TEST_ASSERT(child.is_erase_required(child.context, 0u, TEST_UNIT_SIZE));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// main
+//--------------------------------------------------------------------------------------------------
+int main(void)
+{
+    TEST_RUN(test_partition_erase_required);
+    return TEST_RESULT();
+}
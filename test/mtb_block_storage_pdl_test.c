@@ -0,0 +1,167 @@
+/***********************************************************************************************//**
+ * \file mtb_block_storage_pdl_test.c
+ *
+ * \brief
+ * Host test of the range check of the PDL device, run on a stand-in of the PDL flash driver
+ * (test/hal) whose flash is a memory area mapped at the flash base address of the device.
+ *
+ * Build and run on a Linux host, with the core-lib include folder providing cy_result.h and
+ * cy_utils.h:
+ *
+ *     gcc -std=gnu99 -DCOMPONENT_CAT2 -Iinclude -Itest/hal -I<core-lib>/include \
+ *         test/mtb_block_storage_pdl_test.c source/mtb_block_storage_pdl.c \
+ *         -o mtb_block_storage_pdl_test
+ *     ./mtb_block_storage_pdl_test
+ *
+ ***************************************************************************************************
+ * \copyright
+ * Copyright 2024 Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **************************************************************************************************/
+#include "mtb_block_storage.h"
+#include "mtb_block_storage_test.h"
+#include "cy_flash.h"
+#include "cy_syslib.h"
+
+#include <string.h>
+#include <sys/mman.h>
+
+//Flash of the device, mapped at CY_FLASH_BASE, NULL when the address is not available
+static uint8_t* sim_flash;
+
+
+//--------------------------------------------------------------------------------------------------
+// Cy_Flash_WriteRow
+//--------------------------------------------------------------------------------------------------
+cy_en_flashdrv_status_t Cy_Flash_WriteRow(uint32_t rowAddr, const uint32_t* data)
+{
+    (void)memcpy(&sim_flash[rowAddr - CY_FLASH_BASE], data, CY_FLASH_SIZEOF_ROW);
+    return CY_FLASH_DRV_SUCCESS;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// Cy_Flash_StartWrite
+//--------------------------------------------------------------------------------------------------
+cy_en_flashdrv_status_t Cy_Flash_StartWrite(uint32_t rowAddr, const uint32_t* data)
+{
+    //The row is written at once, Cy_Flash_IsOperationComplete reports its completion
+    (void)Cy_Flash_WriteRow(rowAddr, data);
+    return CY_FLASH_DRV_OPERATION_STARTED;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// Cy_Flash_IsOperationComplete
+//--------------------------------------------------------------------------------------------------
+cy_en_flashdrv_status_t Cy_Flash_IsOperationComplete(void)
+{
+    return CY_FLASH_DRV_SUCCESS;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// Cy_SysLib_EnterCriticalSection
+//--------------------------------------------------------------------------------------------------
+uint32_t Cy_SysLib_EnterCriticalSection(void)
+{
+    return 0u;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// Cy_SysLib_ExitCriticalSection
+//--------------------------------------------------------------------------------------------------
+void Cy_SysLib_ExitCriticalSection(uint32_t savedIntrStatus)
+{
+    (void)savedIntrStatus;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_pdl_range
+//--------------------------------------------------------------------------------------------------
+static void test_pdl_range(void)
+{
+    mtb_block_storage_t bsd;
+
+    TEST_ASSERT(mtb_block_storage_create_pdl(&bsd) == CY_RSLT_SUCCESS);
+
+    //The first and the last row of the flash are in range, the bytes around it are not
+    TEST_ASSERT(bsd.is_in_range(bsd.context, CY_FLASH_BASE, CY_FLASH_SIZEOF_ROW));
+    TEST_ASSERT(bsd.is_in_range(bsd.context, CY_FLASH_BASE, CY_FLASH_SIZE));
+    TEST_ASSERT(bsd.is_in_range(bsd.context, CY_FLASH_BASE + CY_FLASH_SIZE - CY_FLASH_SIZEOF_ROW,
+                                CY_FLASH_SIZEOF_ROW));
+    TEST_ASSERT(!bsd.is_in_range(bsd.context, CY_FLASH_BASE - 1u, CY_FLASH_SIZEOF_ROW));
+    TEST_ASSERT(!bsd.is_in_range(bsd.context, CY_FLASH_BASE, CY_FLASH_SIZE + 1u));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_pdl_map_base
+//--------------------------------------------------------------------------------------------------
+static void test_pdl_map_base(void)
+{
+    mtb_block_storage_t bsd;
+    const uint8_t* ptr = NULL;
+    uint8_t data[CY_FLASH_SIZEOF_ROW];
+    uint8_t read[CY_FLASH_SIZEOF_ROW];
+
+    TEST_ASSERT(mtb_block_storage_create_pdl(&bsd) == CY_RSLT_SUCCESS);
+    TEST_ASSERT(bsd.map(bsd.context, CY_FLASH_BASE - 1u, 1u, &ptr) ==
+                MTB_BLOCK_STORAGE_NOT_IN_RANGE_ERROR);
+    TEST_ASSERT(bsd.map(bsd.context, CY_FLASH_BASE, CY_FLASH_SIZEOF_ROW, &ptr) ==
+                CY_RSLT_SUCCESS);
+    TEST_ASSERT(ptr == (const uint8_t*)(uintptr_t)CY_FLASH_BASE);
+
+    //The first row is programmed and read through the mapping when the host provides the address
+    if (NULL != sim_flash)
+    {
+        for (uint32_t i = 0; i < CY_FLASH_SIZEOF_ROW; i++)
+        {
+            data[i] = (uint8_t)(i + 1u);
+        }
+        TEST_ASSERT(bsd.program(bsd.context, CY_FLASH_BASE, sizeof(data), data) ==
+                    CY_RSLT_SUCCESS);
+        TEST_ASSERT(bsd.read(bsd.context, CY_FLASH_BASE, sizeof(read), read) == CY_RSLT_SUCCESS);
+        TEST_ASSERT(0 == memcmp(read, data, sizeof(data)));
+        TEST_ASSERT((NULL != ptr) && (0 == memcmp(ptr, data, sizeof(data))));
+        TEST_ASSERT(bsd.unmap(bsd.context, ptr, CY_FLASH_SIZEOF_ROW) == CY_RSLT_SUCCESS);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// main
+//--------------------------------------------------------------------------------------------------
+int main(void)
+{
+    void* flash = mmap((void*)(uintptr_t)CY_FLASH_BASE, CY_FLASH_SIZE, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+    if (flash == (void*)(uintptr_t)CY_FLASH_BASE)
+    {
+        sim_flash = (uint8_t*)flash;
+    }
+    else
+    {
+        printf("flash base address not available, the flash is not accessed\n");
+    }
+
+    TEST_RUN(test_pdl_range);
+    TEST_RUN(test_pdl_map_base);
+    return TEST_RESULT();
+}
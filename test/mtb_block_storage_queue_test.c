@@ -0,0 +1,461 @@
+/***********************************************************************************************//**
+ * \file mtb_block_storage_queue_test.c
+ *
+ * \brief
+ * Host test of the request queue in poll mode on a RAM device whose functions log the operations
+ * issued by the queue, with and without the non blocking functions of the device.
+ *
+ * Build and run on host, with the core-lib include folder providing cy_result.h and cy_utils.h:
+ *
+ *     gcc -std=c99 -Iinclude -I<core-lib>/include test/mtb_block_storage_queue_test.c \
+ *         source/mtb_block_storage_queue.c source/mtb_block_storage_ram.c \
+ *         -o mtb_block_storage_queue_test
+ *     ./mtb_block_storage_queue_test
+ *
+ ***************************************************************************************************
+ * \copyright
+ * Copyright 2024 Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **************************************************************************************************/
+#include "mtb_block_storage_queue.h"
+#include "mtb_block_storage_test.h"
+
+#include <string.h>
+
+#define TEST_UNIT_SIZE          (512u)
+#define TEST_MEMORY_SIZE        (4u * TEST_UNIT_SIZE)
+#define TEST_STAGING_SIZE       (TEST_UNIT_SIZE)
+#define TEST_MAX_OPS            (16u)
+#define TEST_MAX_POLLS          (1000u)
+
+static const mtb_block_storage_ram_region_t test_regions[] =
+{
+    { 0x00000000u, TEST_MEMORY_SIZE, 4u, TEST_UNIT_SIZE, 0xFFu, true, 0u, 0u, 0u, 0u },
+};
+
+static uint8_t test_memory[TEST_MEMORY_SIZE];
+static uint32_t test_program_map[TEST_MEMORY_SIZE / 4u / 32u];
+static uint8_t test_staging[TEST_STAGING_SIZE];
+static uint8_t test_data[64];
+
+//Operation issued to the device: 'r'ead, 'p'rogram, 'e'rase, non blocking 'P'rogram and 'E'rase
+typedef struct
+{
+    char        op;
+    uint32_t    addr;
+    uint32_t    length;
+} test_op_t;
+
+//Completion of a request
+typedef struct
+{
+    uint32_t    calls;
+    uint32_t    order;
+    cy_rslt_t   result;
+} test_done_t;
+
+//RAM device, and the device given to the queue that logs the operations forwarded to it
+static mtb_block_storage_t test_ram;
+static mtb_block_storage_ram_t test_ram_obj;
+static mtb_block_storage_t test_bsd;
+static mtb_block_storage_queue_t test_queue;
+static test_op_t test_ops[TEST_MAX_OPS];
+static uint32_t test_op_count;
+static uint32_t test_completions;
+
+
+//--------------------------------------------------------------------------------------------------
+// test_log
+//--------------------------------------------------------------------------------------------------
+static void test_log(char op, uint32_t addr, uint32_t length)
+{
+    if (test_op_count < TEST_MAX_OPS)
+    {
+        test_ops[test_op_count].op = op;
+        test_ops[test_op_count].addr = addr;
+        test_ops[test_op_count].length = length;
+    }
+    test_op_count++;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_logged
+//--------------------------------------------------------------------------------------------------
+static bool test_logged(uint32_t index, char op, uint32_t addr, uint32_t length)
+{
+    return (index < test_op_count) && (index < TEST_MAX_OPS) && (test_ops[index].op == op) &&
+           (test_ops[index].addr == addr) && (test_ops[index].length == length);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_read
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t test_read(void* context, uint32_t addr, uint32_t length, uint8_t* buf)
+{
+    test_log('r', addr, length);
+    return test_ram.read(context, addr, length, buf);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_program
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t test_program(void* context, uint32_t addr, uint32_t length, const uint8_t* buf)
+{
+    test_log('p', addr, length);
+    return test_ram.program(context, addr, length, buf);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_erase
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t test_erase(void* context, uint32_t addr, uint32_t length)
+{
+    test_log('e', addr, length);
+    return test_ram.erase(context, addr, length);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_program_nb
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t test_program_nb(void* context, uint32_t addr, uint32_t length,
+                                 const uint8_t* buf)
+{
+    test_log('P', addr, length);
+    return test_ram.program_nb(context, addr, length, buf);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_erase_nb
+//--------------------------------------------------------------------------------------------------
+static cy_rslt_t test_erase_nb(void* context, uint32_t addr, uint32_t length)
+{
+    test_log('E', addr, length);
+    return test_ram.erase_nb(context, addr, length);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_callback
+//--------------------------------------------------------------------------------------------------
+static void test_callback(void* callback_arg, cy_rslt_t result)
+{
+    test_done_t* done = (test_done_t*)callback_arg;
+    done->calls++;
+    done->order = ++test_completions;
+    done->result = result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_queue_init
+//--------------------------------------------------------------------------------------------------
+static void test_queue_init(bool non_blocking)
+{
+    mtb_block_storage_ram_config_t config;
+
+    (void)memset(&config, 0, sizeof(config));
+    config.regions = test_regions;
+    config.region_count = 1u;
+    config.memory = test_memory;
+    config.program_map = test_program_map;
+    config.initialize = true;
+    TEST_ASSERT(mtb_block_storage_create_ram(&test_ram, &test_ram_obj, &config) ==
+                CY_RSLT_SUCCESS);
+
+    test_bsd = test_ram;
+    test_bsd.read = test_read;
+    test_bsd.program = test_program;
+    test_bsd.erase = test_erase;
+    test_bsd.program_nb = non_blocking ? test_program_nb : NULL;
+    test_bsd.erase_nb = non_blocking ? test_erase_nb : NULL;
+    TEST_ASSERT(mtb_block_storage_queue_init(&test_queue, &test_bsd, test_staging,
+                                             sizeof(test_staging)) == CY_RSLT_SUCCESS);
+    test_op_count = 0;
+    test_completions = 0;
+    for (uint32_t i = 0; i < sizeof(test_data); i++)
+    {
+        test_data[i] = (uint8_t)(i + 1u);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_submit
+//--------------------------------------------------------------------------------------------------
+static void test_submit(mtb_block_storage_request_t* request, test_done_t* done,
+                        mtb_block_storage_request_type_t type, uint32_t addr, uint32_t length,
+                        uint8_t* buf)
+{
+    (void)memset(done, 0, sizeof(*done));
+    (void)memset(request, 0, sizeof(*request));
+    request->type = type;
+    request->addr = addr;
+    request->length = length;
+    request->buf = buf;
+    request->callback = test_callback;
+    request->callback_arg = done;
+    TEST_ASSERT(mtb_block_storage_queue_submit(&test_queue, request) == CY_RSLT_SUCCESS);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_process_all
+//--------------------------------------------------------------------------------------------------
+static void test_process_all(void)
+{
+    cy_rslt_t result;
+    uint32_t polls = 0;
+    do
+    {
+        result = mtb_block_storage_queue_process(&test_queue);
+        polls++;
+    } while ((result == MTB_BLOCK_STORAGE_BUSY) && (polls < TEST_MAX_POLLS));
+    TEST_ASSERT(result == CY_RSLT_SUCCESS);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_queue_merge
+//--------------------------------------------------------------------------------------------------
+static void test_queue_merge(void)
+{
+    mtb_block_storage_request_t requests[5];
+    test_done_t done[5];
+    uint8_t read[2][24];
+
+    //Programs submitted out of order join once the gap between them is filled
+    test_queue_init(false);
+    test_submit(&requests[0], &done[0], MTB_BLOCK_STORAGE_REQUEST_PROGRAM, 0u, 16u,
+                &test_data[0]);
+    test_submit(&requests[1], &done[1], MTB_BLOCK_STORAGE_REQUEST_PROGRAM, 32u, 16u,
+                &test_data[32]);
+    test_submit(&requests[2], &done[2], MTB_BLOCK_STORAGE_REQUEST_PROGRAM, 16u, 16u,
+                &test_data[16]);
+
+    //Overlapping reads join, the read of the programmed data waits for the programs
+    test_submit(&requests[3], &done[3], MTB_BLOCK_STORAGE_REQUEST_READ, 8u, 24u, read[0]);
+    test_submit(&requests[4], &done[4], MTB_BLOCK_STORAGE_REQUEST_READ, 16u, 24u, read[1]);
+    test_process_all();
+
+    TEST_ASSERT(test_op_count == 2u);
+    TEST_ASSERT(test_logged(0u, 'p', 0u, 48u));
+    TEST_ASSERT(test_logged(1u, 'r', 8u, 32u));
+    TEST_ASSERT(0 == memcmp(test_memory, test_data, 48u));
+    TEST_ASSERT(0 == memcmp(read[0], &test_data[8], 24u));
+    TEST_ASSERT(0 == memcmp(read[1], &test_data[16], 24u));
+    for (uint32_t i = 0; i < 5u; i++)
+    {
+        TEST_ASSERT((done[i].calls == 1u) && (done[i].result == CY_RSLT_SUCCESS));
+    }
+    TEST_ASSERT((done[3].order > done[0].order) && (done[4].order > done[0].order));
+    mtb_block_storage_queue_deinit(&test_queue);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_queue_order
+//--------------------------------------------------------------------------------------------------
+static void test_queue_order(void)
+{
+    mtb_block_storage_request_t requests[7];
+    test_done_t done[7];
+    uint8_t read[3][16];
+
+    //Overlapping programs and erases are issued in submission order and are not merged
+    test_queue_init(false);
+    test_submit(&requests[0], &done[0], MTB_BLOCK_STORAGE_REQUEST_PROGRAM, 0u, 16u,
+                &test_data[0]);
+    test_submit(&requests[1], &done[1], MTB_BLOCK_STORAGE_REQUEST_ERASE, 0u, TEST_UNIT_SIZE,
+                NULL);
+    test_submit(&requests[2], &done[2], MTB_BLOCK_STORAGE_REQUEST_PROGRAM, 0u, 16u,
+                &test_data[16]);
+
+    //The others are issued in ascending address order from the end of the last operation, then
+    //from the lowest address. The read of the program waits for it.
+    test_submit(&requests[3], &done[3], MTB_BLOCK_STORAGE_REQUEST_READ, 3u * TEST_UNIT_SIZE, 16u,
+                read[0]);
+    test_submit(&requests[4], &done[4], MTB_BLOCK_STORAGE_REQUEST_PROGRAM, TEST_UNIT_SIZE, 16u,
+                &test_data[32]);
+    test_submit(&requests[5], &done[5], MTB_BLOCK_STORAGE_REQUEST_READ, TEST_UNIT_SIZE, 16u,
+                read[1]);
+
+    //A read ahead of the elevator still waits for the erase it overlaps
+    test_submit(&requests[6], &done[6], MTB_BLOCK_STORAGE_REQUEST_READ, TEST_UNIT_SIZE / 2u, 16u,
+                read[2]);
+    test_process_all();
+
+    TEST_ASSERT(test_op_count == 7u);
+    TEST_ASSERT(test_logged(0u, 'p', 0u, 16u));
+    TEST_ASSERT(test_logged(1u, 'p', TEST_UNIT_SIZE, 16u));
+    TEST_ASSERT(test_logged(2u, 'r', 3u * TEST_UNIT_SIZE, 16u));
+    TEST_ASSERT(test_logged(3u, 'e', 0u, TEST_UNIT_SIZE));
+    TEST_ASSERT(test_logged(4u, 'r', TEST_UNIT_SIZE, 16u));
+    TEST_ASSERT(test_logged(5u, 'p', 0u, 16u));
+    TEST_ASSERT(test_logged(6u, 'r', TEST_UNIT_SIZE / 2u, 16u));
+    for (uint32_t i = 0; i < 7u; i++)
+    {
+        TEST_ASSERT((done[i].calls == 1u) && (done[i].result == CY_RSLT_SUCCESS));
+    }
+    TEST_ASSERT(0 == memcmp(test_memory, &test_data[16], 16u));
+    TEST_ASSERT(0 == memcmp(read[1], &test_data[32], 16u));
+    TEST_ASSERT(read[0][0] == 0xFFu);
+    mtb_block_storage_queue_deinit(&test_queue);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_queue_overlapping_programs
+//--------------------------------------------------------------------------------------------------
+static void test_queue_overlapping_programs(void)
+{
+    mtb_block_storage_request_t requests[2];
+    test_done_t done[2];
+
+    //Programming an area twice is not merged into one program, the device rejects the second one
+    test_queue_init(false);
+    test_submit(&requests[0], &done[0], MTB_BLOCK_STORAGE_REQUEST_PROGRAM, 0u, 16u, test_data);
+    test_submit(&requests[1], &done[1], MTB_BLOCK_STORAGE_REQUEST_PROGRAM, 8u, 16u,
+                &test_data[16]);
+    test_process_all();
+
+    TEST_ASSERT(test_op_count == 2u);
+    TEST_ASSERT(test_logged(0u, 'p', 0u, 16u));
+    TEST_ASSERT(test_logged(1u, 'p', 8u, 16u));
+    TEST_ASSERT((done[0].calls == 1u) && (done[0].result == CY_RSLT_SUCCESS));
+    TEST_ASSERT((done[1].calls == 1u) &&
+                (done[1].result == MTB_BLOCK_STORAGE_NOT_ERASED_ERROR));
+    TEST_ASSERT(0 == memcmp(test_memory, test_data, 16u));
+    mtb_block_storage_queue_deinit(&test_queue);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_queue_erase_dropped
+//--------------------------------------------------------------------------------------------------
+static void test_queue_erase_dropped(void)
+{
+    mtb_block_storage_request_t requests[3];
+    test_done_t done[3];
+
+    //An erase covered by a pending one is dropped, an adjacent one extends it
+    test_queue_init(false);
+    TEST_ASSERT(test_ram.program(test_ram.context, TEST_UNIT_SIZE, 16u, test_data) ==
+                CY_RSLT_SUCCESS);
+    test_submit(&requests[0], &done[0], MTB_BLOCK_STORAGE_REQUEST_ERASE, 0u,
+                2u * TEST_UNIT_SIZE, NULL);
+    test_submit(&requests[1], &done[1], MTB_BLOCK_STORAGE_REQUEST_ERASE, TEST_UNIT_SIZE,
+                TEST_UNIT_SIZE, NULL);
+    test_submit(&requests[2], &done[2], MTB_BLOCK_STORAGE_REQUEST_ERASE, 2u * TEST_UNIT_SIZE,
+                TEST_UNIT_SIZE, NULL);
+    test_process_all();
+
+    TEST_ASSERT(test_op_count == 1u);
+    TEST_ASSERT(test_logged(0u, 'e', 0u, 3u * TEST_UNIT_SIZE));
+    TEST_ASSERT(test_memory[TEST_UNIT_SIZE] == 0xFFu);
+    for (uint32_t i = 0; i < 3u; i++)
+    {
+        TEST_ASSERT((done[i].calls == 1u) && (done[i].result == CY_RSLT_SUCCESS));
+    }
+    mtb_block_storage_queue_deinit(&test_queue);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_queue_non_blocking
+//--------------------------------------------------------------------------------------------------
+static void test_queue_non_blocking(void)
+{
+    mtb_block_storage_request_t requests[2];
+    test_done_t done[2];
+    uint32_t polls = 0;
+
+    //The program is started without waiting and completes through the poll of the device
+    test_queue_init(true);
+    test_submit(&requests[0], &done[0], MTB_BLOCK_STORAGE_REQUEST_PROGRAM, 0u, 16u, test_data);
+    test_submit(&requests[1], &done[1], MTB_BLOCK_STORAGE_REQUEST_ERASE, TEST_UNIT_SIZE,
+                TEST_UNIT_SIZE, NULL);
+    TEST_ASSERT(mtb_block_storage_queue_process(&test_queue) == MTB_BLOCK_STORAGE_BUSY);
+    TEST_ASSERT(test_logged(0u, 'P', 0u, 16u));
+    while ((0u == done[0].calls) && (polls < TEST_MAX_POLLS))
+    {
+        TEST_ASSERT(test_op_count == 1u);
+        (void)mtb_block_storage_queue_process(&test_queue);
+        polls++;
+    }
+    TEST_ASSERT(polls == 4u);
+    TEST_ASSERT((done[0].calls == 1u) && (done[0].result == CY_RSLT_SUCCESS));
+    TEST_ASSERT(0 == memcmp(test_memory, test_data, 16u));
+
+    test_process_all();
+    TEST_ASSERT(test_op_count == 2u);
+    TEST_ASSERT(test_logged(1u, 'E', TEST_UNIT_SIZE, TEST_UNIT_SIZE));
+    TEST_ASSERT((done[1].calls == 1u) && (done[1].result == CY_RSLT_SUCCESS));
+    mtb_block_storage_queue_deinit(&test_queue);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_queue_deinit_cancel
+//--------------------------------------------------------------------------------------------------
+static void test_queue_deinit_cancel(void)
+{
+    mtb_block_storage_request_t requests[3];
+    test_done_t done[3];
+    uint8_t read[16];
+
+    //The operation in progress completes with its result, the pending requests are cancelled
+    test_queue_init(true);
+    test_submit(&requests[0], &done[0], MTB_BLOCK_STORAGE_REQUEST_PROGRAM, 0u, 16u, test_data);
+    test_submit(&requests[1], &done[1], MTB_BLOCK_STORAGE_REQUEST_ERASE, TEST_UNIT_SIZE,
+                TEST_UNIT_SIZE, NULL);
+    test_submit(&requests[2], &done[2], MTB_BLOCK_STORAGE_REQUEST_READ, 2u * TEST_UNIT_SIZE,
+                sizeof(read), read);
+    TEST_ASSERT(mtb_block_storage_queue_process(&test_queue) == MTB_BLOCK_STORAGE_BUSY);
+    TEST_ASSERT(0u == done[0].calls);
+    mtb_block_storage_queue_deinit(&test_queue);
+
+    TEST_ASSERT(test_op_count == 1u);
+    TEST_ASSERT((done[0].calls == 1u) && (done[0].result == CY_RSLT_SUCCESS));
+    TEST_ASSERT(0 == memcmp(test_memory, test_data, 16u));
+    for (uint32_t i = 1; i < 3u; i++)
+    {
+        TEST_ASSERT((done[i].calls == 1u) &&
+                    (done[i].result == MTB_BLOCK_STORAGE_CANCELLED_ERROR));
+        TEST_ASSERT(done[i].order > done[0].order);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// main
+//--------------------------------------------------------------------------------------------------
+int main(void)
+{
+    TEST_RUN(test_queue_merge);
+    TEST_RUN(test_queue_order);
+    TEST_RUN(test_queue_overlapping_programs);
+    TEST_RUN(test_queue_erase_dropped);
+    TEST_RUN(test_queue_non_blocking);
+    TEST_RUN(test_queue_deinit_cancel);
+    return TEST_RESULT();
+}
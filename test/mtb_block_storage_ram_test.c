@@ -0,0 +1,196 @@
+/***********************************************************************************************//**
+ * \file mtb_block_storage_ram_test.c
+ *
+ * \brief
+ * Host test of the RAM and file devices reopened on existing content: the program units that do
+ * not read as erased must not be programmed again before an erase. A file device that fails to
+ * be created must leave its image file as it was found.
+ *
+ * Build and run on a POSIX host, with the core-lib include folder providing cy_result.h and
+ * cy_utils.h:
+ *
+ *     gcc -std=c99 -Iinclude -I<core-lib>/include test/mtb_block_storage_ram_test.c \
+ *         source/mtb_block_storage_ram.c source/mtb_block_storage_file.c \
+ *         -o mtb_block_storage_ram_test
+ *     ./mtb_block_storage_ram_test
+ *
+ ***************************************************************************************************
+ * \copyright
+ * Copyright 2024 Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **************************************************************************************************/
+#include "mtb_block_storage.h"
+#include "mtb_block_storage_test.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#define TEST_UNIT_SIZE          (512u)
+#define TEST_MEMORY_SIZE        (4u * TEST_UNIT_SIZE)
+#define TEST_IMAGE_PATH         "mtb_block_storage_ram_test.bin"
+
+static const mtb_block_storage_ram_region_t test_regions[] =
+{
+    { 0x00000000u, TEST_MEMORY_SIZE, 4u, TEST_UNIT_SIZE, 0xFFu, true, 0u, 0u, 0u, 0u },
+};
+
+//Rejected by the RAM device once the image is mapped: the erase size is not a multiple of the
+//program size. The image of the small regions has another size than the one of test_regions.
+static const mtb_block_storage_ram_region_t test_invalid_regions[] =
+{
+    { 0x00000000u, TEST_MEMORY_SIZE, 3u, TEST_UNIT_SIZE, 0xFFu, true, 0u, 0u, 0u, 0u },
+};
+static const mtb_block_storage_ram_region_t test_small_regions[] =
+{
+    { 0x00000000u, TEST_UNIT_SIZE, 4u, TEST_UNIT_SIZE, 0xFFu, true, 0u, 0u, 0u, 0u },
+};
+
+static uint8_t test_memory[TEST_MEMORY_SIZE];
+static uint32_t test_program_map[TEST_MEMORY_SIZE / 4u / 32u];
+static uint8_t test_data[16];
+
+
+//--------------------------------------------------------------------------------------------------
+// test_reprogram
+//--------------------------------------------------------------------------------------------------
+static void test_reprogram(mtb_block_storage_t* bsd)
+{
+    uint8_t read[sizeof(test_data)];
+
+    //The programmed words are rejected until erased, the erased ones next to them are not
+    TEST_ASSERT(bsd->read(bsd->context, TEST_UNIT_SIZE, sizeof(read), read) == CY_RSLT_SUCCESS);
+    TEST_ASSERT(0 == memcmp(read, test_data, sizeof(test_data)));
+    TEST_ASSERT(bsd->program(bsd->context, TEST_UNIT_SIZE, sizeof(test_data), test_data) ==
+                MTB_BLOCK_STORAGE_NOT_ERASED_ERROR);
+    TEST_ASSERT(bsd->program(bsd->context, TEST_UNIT_SIZE + sizeof(test_data), sizeof(test_data),
+                             test_data) == CY_RSLT_SUCCESS);
+    TEST_ASSERT(bsd->erase(bsd->context, TEST_UNIT_SIZE, TEST_UNIT_SIZE) == CY_RSLT_SUCCESS);
+    TEST_ASSERT(bsd->program(bsd->context, TEST_UNIT_SIZE, sizeof(test_data), test_data) ==
+                CY_RSLT_SUCCESS);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_ram_reopen
+//--------------------------------------------------------------------------------------------------
+static void test_ram_reopen(void)
+{
+    mtb_block_storage_t bsd;
+    mtb_block_storage_ram_t obj;
+    mtb_block_storage_ram_config_t config;
+
+    (void)memset(&config, 0, sizeof(config));
+    config.regions = test_regions;
+    config.region_count = 1u;
+    config.memory = test_memory;
+    config.program_map = test_program_map;
+    config.initialize = true;
+    TEST_ASSERT(mtb_block_storage_create_ram(&bsd, &obj, &config) == CY_RSLT_SUCCESS);
+    TEST_ASSERT(bsd.program(bsd.context, TEST_UNIT_SIZE, sizeof(test_data), test_data) ==
+                CY_RSLT_SUCCESS);
+
+    //The device is created again on the same memory, the program map is rebuilt from it
+    config.initialize = false;
+    TEST_ASSERT(mtb_block_storage_create_ram(&bsd, &obj, &config) == CY_RSLT_SUCCESS);
+    test_reprogram(&bsd);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_file_reopen
+//--------------------------------------------------------------------------------------------------
+static void test_file_reopen(void)
+{
+    mtb_block_storage_t bsd;
+    mtb_block_storage_file_t obj;
+
+    (void)remove(TEST_IMAGE_PATH);
+    TEST_ASSERT(mtb_block_storage_create_file(&bsd, &obj, TEST_IMAGE_PATH, test_regions, 1u) ==
+                CY_RSLT_SUCCESS);
+    TEST_ASSERT(bsd.program(bsd.context, TEST_UNIT_SIZE, sizeof(test_data), test_data) ==
+                CY_RSLT_SUCCESS);
+    TEST_ASSERT(mtb_block_storage_file_close(&obj) == CY_RSLT_SUCCESS);
+
+    //The image keeps the data, which is marked as programmed when the file is opened again
+    TEST_ASSERT(mtb_block_storage_create_file(&bsd, &obj, TEST_IMAGE_PATH, test_regions, 1u) ==
+                CY_RSLT_SUCCESS);
+    test_reprogram(&bsd);
+    TEST_ASSERT(mtb_block_storage_file_close(&obj) == CY_RSLT_SUCCESS);
+    (void)remove(TEST_IMAGE_PATH);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_file_create_error
+//--------------------------------------------------------------------------------------------------
+static void test_file_create_error(void)
+{
+    mtb_block_storage_t bsd;
+    mtb_block_storage_file_t obj;
+    struct stat file_stat;
+    FILE* file;
+
+    //A file created by a failed create is removed
+    (void)remove(TEST_IMAGE_PATH);
+    TEST_ASSERT(mtb_block_storage_create_file(&bsd, &obj, TEST_IMAGE_PATH, test_invalid_regions,
+                                              1u) == MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR);
+    TEST_ASSERT(0 != stat(TEST_IMAGE_PATH, &file_stat));
+
+    //An empty file given to a failed create is left empty
+    file = fopen(TEST_IMAGE_PATH, "wb");
+    TEST_ASSERT(NULL != file);
+    if (NULL != file)
+    {
+        (void)fclose(file);
+    }
+    TEST_ASSERT(mtb_block_storage_create_file(&bsd, &obj, TEST_IMAGE_PATH, test_invalid_regions,
+                                              1u) == MTB_BLOCK_STORAGE_INVALID_INPUT_ERROR);
+    TEST_ASSERT((0 == stat(TEST_IMAGE_PATH, &file_stat)) && (0 == file_stat.st_size));
+
+    //An image of another size is neither resized nor modified
+    TEST_ASSERT(mtb_block_storage_create_file(&bsd, &obj, TEST_IMAGE_PATH, test_regions, 1u) ==
+                CY_RSLT_SUCCESS);
+    TEST_ASSERT(bsd.program(bsd.context, TEST_UNIT_SIZE, sizeof(test_data), test_data) ==
+                CY_RSLT_SUCCESS);
+    TEST_ASSERT(mtb_block_storage_file_close(&obj) == CY_RSLT_SUCCESS);
+    TEST_ASSERT(mtb_block_storage_create_file(&bsd, &obj, TEST_IMAGE_PATH, test_small_regions,
+                                              1u) == MTB_BLOCK_STORAGE_INVALID_SIZE_ERROR);
+    TEST_ASSERT((0 == stat(TEST_IMAGE_PATH, &file_stat)) &&
+                (TEST_MEMORY_SIZE == (uint32_t)file_stat.st_size));
+    TEST_ASSERT(mtb_block_storage_create_file(&bsd, &obj, TEST_IMAGE_PATH, test_regions, 1u) ==
+                CY_RSLT_SUCCESS);
+    test_reprogram(&bsd);
+    TEST_ASSERT(mtb_block_storage_file_close(&obj) == CY_RSLT_SUCCESS);
+    (void)remove(TEST_IMAGE_PATH);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// main
+//--------------------------------------------------------------------------------------------------
+int main(void)
+{
+    for (uint32_t i = 0; i < sizeof(test_data); i++)
+    {
+        test_data[i] = (uint8_t)(i + 1u);
+    }
+    TEST_RUN(test_ram_reopen);
+    TEST_RUN(test_file_reopen);
+    TEST_RUN(test_file_create_error);
+    return TEST_RESULT();
+}
@@ -0,0 +1,226 @@
+/***********************************************************************************************//**
+ * \file mtb_block_storage_stats_test.c
+ *
+ * \brief
+ * Host test of the statistics device on a RAM device, with a clock advancing by a fixed number of
+ * ticks on each reading so that the latencies are known.
+ *
+ * Build and run on host, with the core-lib include folder providing cy_result.h and cy_utils.h:
+ *
+ *     gcc -std=c99 -Iinclude -I<core-lib>/include test/mtb_block_storage_stats_test.c \
+ *         source/mtb_block_storage_stats.c source/mtb_block_storage_ram.c \
+ *         -o mtb_block_storage_stats_test
+ *     ./mtb_block_storage_stats_test
+ *
+ ***************************************************************************************************
+ * \copyright
+ * Copyright 2024 Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **************************************************************************************************/
+#include "mtb_block_storage_stats.h"
+#include "mtb_block_storage_test.h"
+
+#include <string.h>
+
+#define TEST_UNIT_SIZE          (512u)
+#define TEST_UNIT_COUNT         (4u)
+#define TEST_MEMORY_SIZE        (TEST_UNIT_COUNT * TEST_UNIT_SIZE)
+//Ticks between two readings of the clock, and the histogram bucket of that latency
+#define TEST_TICKS              (5u)
+#define TEST_TICKS_BUCKET       (3u)
+#define TEST_CLOCK_HZ           (1000u)
+
+static const mtb_block_storage_ram_region_t test_regions[] =
+{
+    { 0x00000000u, TEST_MEMORY_SIZE, 4u, TEST_UNIT_SIZE, 0xFFu, true, 0u, 0u, 0u, 0u },
+};
+
+static uint8_t test_memory[TEST_MEMORY_SIZE];
+static uint32_t test_program_map[TEST_MEMORY_SIZE / 4u / 32u];
+static uint32_t test_erase_counts[TEST_UNIT_COUNT];
+static uint8_t test_data[64];
+
+static mtb_block_storage_t test_ram;
+static mtb_block_storage_ram_t test_ram_obj;
+static mtb_block_storage_t test_bsd;
+static mtb_block_storage_stats_device_t test_stats_obj;
+static uint32_t test_now;
+
+
+//--------------------------------------------------------------------------------------------------
+// test_clock
+//--------------------------------------------------------------------------------------------------
+static uint32_t test_clock(void)
+{
+    test_now += TEST_TICKS;
+    return test_now;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_stats_init
+//--------------------------------------------------------------------------------------------------
+static void test_stats_init(void)
+{
+    mtb_block_storage_ram_config_t ram_config;
+    mtb_block_storage_stats_config_t config;
+
+    (void)memset(&ram_config, 0, sizeof(ram_config));
+    ram_config.regions = test_regions;
+    ram_config.region_count = 1u;
+    ram_config.memory = test_memory;
+    ram_config.program_map = test_program_map;
+    ram_config.initialize = true;
+    TEST_ASSERT(mtb_block_storage_create_ram(&test_ram, &test_ram_obj, &ram_config) ==
+                CY_RSLT_SUCCESS);
+
+    (void)memset(&config, 0, sizeof(config));
+    config.bsd = &test_ram;
+    config.clock = test_clock;
+    config.clock_hz = TEST_CLOCK_HZ;
+    config.erase_counts = test_erase_counts;
+    config.erase_count_size = TEST_UNIT_COUNT;
+    config.erase_start = 0u;
+    config.erase_unit = TEST_UNIT_SIZE;
+    TEST_ASSERT(mtb_block_storage_create_stats(&test_bsd, &test_stats_obj, &config) ==
+                CY_RSLT_SUCCESS);
+    for (uint32_t i = 0; i < sizeof(test_data); i++)
+    {
+        test_data[i] = (uint8_t)(i + 1u);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_stats_check_op
+//--------------------------------------------------------------------------------------------------
+static void test_stats_check_op(const mtb_block_storage_stats_op_t* op, uint32_t count,
+                                uint32_t errors, uint64_t bytes)
+{
+    TEST_ASSERT(op->count == count);
+    TEST_ASSERT(op->errors == errors);
+    TEST_ASSERT(op->bytes == bytes);
+    TEST_ASSERT(op->total_ticks == ((uint64_t)count * TEST_TICKS));
+    TEST_ASSERT(op->max_ticks == ((0u != count) ? TEST_TICKS : 0u));
+    TEST_ASSERT(op->histogram[TEST_TICKS_BUCKET] == count);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_stats_counts
+//--------------------------------------------------------------------------------------------------
+static void test_stats_counts(void)
+{
+    mtb_block_storage_stats_t stats;
+    uint8_t read[64];
+
+    test_stats_init();
+    TEST_ASSERT(test_bsd.read(test_bsd.context, 0u, 16u, read) == CY_RSLT_SUCCESS);
+    TEST_ASSERT(test_bsd.read(test_bsd.context, 16u, 32u, read) == CY_RSLT_SUCCESS);
+    TEST_ASSERT(test_bsd.read(test_bsd.context, TEST_MEMORY_SIZE, 8u, read) ==
+                MTB_BLOCK_STORAGE_NOT_IN_RANGE_ERROR);
+    TEST_ASSERT(test_bsd.program(test_bsd.context, 0u, 16u, test_data) == CY_RSLT_SUCCESS);
+    TEST_ASSERT(test_bsd.program(test_bsd.context, 16u, 64u, test_data) == CY_RSLT_SUCCESS);
+    TEST_ASSERT(test_bsd.program(test_bsd.context, 0u, 16u, test_data) ==
+                MTB_BLOCK_STORAGE_NOT_ERASED_ERROR);
+    TEST_ASSERT(test_bsd.erase(test_bsd.context, 0u, 2u * TEST_UNIT_SIZE) == CY_RSLT_SUCCESS);
+    TEST_ASSERT(test_bsd.erase(test_bsd.context, TEST_UNIT_SIZE, TEST_UNIT_SIZE) ==
+                CY_RSLT_SUCCESS);
+
+    //The failed calls are counted with their bytes, the erases of each unit only once done
+    mtb_block_storage_stats_get(&test_stats_obj, &stats);
+    TEST_ASSERT(stats.clock_hz == TEST_CLOCK_HZ);
+    test_stats_check_op(&stats.ops[MTB_BLOCK_STORAGE_STATS_READ], 3u, 1u, 56u);
+    test_stats_check_op(&stats.ops[MTB_BLOCK_STORAGE_STATS_PROGRAM], 3u, 1u, 96u);
+    test_stats_check_op(&stats.ops[MTB_BLOCK_STORAGE_STATS_ERASE], 2u, 0u, 3u * TEST_UNIT_SIZE);
+    test_stats_check_op(&stats.ops[MTB_BLOCK_STORAGE_STATS_PROGRAM_NB], 0u, 0u, 0u);
+    TEST_ASSERT((test_erase_counts[0] == 1u) && (test_erase_counts[1] == 2u) &&
+                (test_erase_counts[2] == 0u) && (test_erase_counts[3] == 0u));
+
+    //A reset clears everything but the clock frequency
+    mtb_block_storage_stats_reset(&test_stats_obj);
+    mtb_block_storage_stats_get(&test_stats_obj, &stats);
+    TEST_ASSERT(stats.clock_hz == TEST_CLOCK_HZ);
+    for (uint32_t op = 0; op < MTB_BLOCK_STORAGE_STATS_OP_COUNT; op++)
+    {
+        test_stats_check_op(&stats.ops[op], 0u, 0u, 0u);
+    }
+    TEST_ASSERT((test_erase_counts[0] == 0u) && (test_erase_counts[1] == 0u));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_stats_non_blocking
+//--------------------------------------------------------------------------------------------------
+static void test_stats_non_blocking(void)
+{
+    mtb_block_storage_stats_t stats;
+    cy_rslt_t result;
+    uint32_t polls = 0;
+
+    //The operation is recorded once, when the poll reports its completion
+    test_stats_init();
+    TEST_ASSERT(test_bsd.program_nb(test_bsd.context, 0u, 16u, test_data) == CY_RSLT_SUCCESS);
+    do
+    {
+        mtb_block_storage_stats_get(&test_stats_obj, &stats);
+        TEST_ASSERT(stats.ops[MTB_BLOCK_STORAGE_STATS_PROGRAM_NB].count == 0u);
+        result = test_bsd.poll(test_bsd.context);
+        polls++;
+    } while ((result == MTB_BLOCK_STORAGE_BUSY) && (polls < 100u));
+    TEST_ASSERT(result == CY_RSLT_SUCCESS);
+    TEST_ASSERT(polls == 4u);
+
+    mtb_block_storage_stats_get(&test_stats_obj, &stats);
+    TEST_ASSERT(stats.ops[MTB_BLOCK_STORAGE_STATS_PROGRAM_NB].count == 1u);
+    TEST_ASSERT(stats.ops[MTB_BLOCK_STORAGE_STATS_PROGRAM_NB].errors == 0u);
+    TEST_ASSERT(stats.ops[MTB_BLOCK_STORAGE_STATS_PROGRAM_NB].bytes == 16u);
+    TEST_ASSERT(stats.ops[MTB_BLOCK_STORAGE_STATS_PROGRAM_NB].max_ticks >= TEST_TICKS);
+    TEST_ASSERT(stats.ops[MTB_BLOCK_STORAGE_STATS_PROGRAM].count == 0u);
+    TEST_ASSERT(0 == memcmp(test_memory, test_data, 16u));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_stats_erase_required_unknown
+//--------------------------------------------------------------------------------------------------
+static void test_stats_erase_required_unknown(void)
+{
+    mtb_block_storage_stats_config_t config;
+
+    //An inner device without is_erase_required is reported as needing an erase
+    test_stats_init();
+    test_ram.is_erase_required = NULL;
+    (void)memset(&config, 0, sizeof(config));
+    config.bsd = &test_ram;
+    config.clock = test_clock;
+    TEST_ASSERT(mtb_block_storage_create_stats(&test_bsd, &test_stats_obj, &config) ==
+                CY_RSLT_SUCCESS);
+    TEST_ASSERT(test_bsd.is_erase_required(test_bsd.context, 0u, TEST_UNIT_SIZE));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// main
+//--------------------------------------------------------------------------------------------------
+int main(void)
+{
+    TEST_RUN(test_stats_counts);
+    TEST_RUN(test_stats_non_blocking);
+    TEST_RUN(test_stats_erase_required_unknown);
+    return TEST_RESULT();
+}
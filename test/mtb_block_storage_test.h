@@ -0,0 +1,57 @@
+/***********************************************************************************************//**
+ * \file mtb_block_storage_test.h
+ *
+ * \brief
+ * Minimal assertion helpers shared by the host tests of the test folder. Each test file is a
+ * program of its own, built as described in its header, that returns a non zero exit status
+ * when a check fails.
+ *
+ ***************************************************************************************************
+ * \copyright
+ * Copyright 2024 Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **************************************************************************************************/
+#pragma once
+
+#include <stdio.h>
+
+//Number of checks that failed so far
+static unsigned int test_failures = 0;
+
+/** Reports and counts a failed check, the test goes on */
+#define TEST_ASSERT(condition)                                                  \
+    do                                                                          \
+    {                                                                           \
+        if (!(condition))                                                       \
+        {                                                                       \
+            printf("%s:%d: %s failed\n", __FILE__, __LINE__, #condition);       \
+            test_failures++;                                                    \
+        }                                                                       \
+    } while (0)
+
+/** Runs a test function and prints its name */
+#define TEST_RUN(test)                                                          \
+    do                                                                          \
+    {                                                                           \
+        printf("%s\n", #test);                                                  \
+        test();                                                                 \
+    } while (0)
+
+/** Prints the summary, evaluates to the exit status of the test program */
+#define TEST_RESULT()                                                           \
+    ((0u == test_failures) ? (printf("passed\n"), 0) :                          \
+     (printf("%u checks failed\n", test_failures), 1))
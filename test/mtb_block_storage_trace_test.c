@@ -0,0 +1,200 @@
+/***********************************************************************************************//**
+ * \file mtb_block_storage_trace_test.c
+ *
+ * \brief
+ * Host test of the I/O trace: records of a RAM device, wrap of the record numbering and end of a
+ * call whose record is reused meanwhile.
+ *
+ * Build and run on host, with the core-lib include folder providing cy_result.h and cy_utils.h:
+ *
+ *     gcc -std=c99 -DMTB_BLOCK_STORAGE_TRACE_ENABLED=1 -Iinclude -I<core-lib>/include \
+ *         test/mtb_block_storage_trace_test.c source/mtb_block_storage_trace.c \
+ *         source/mtb_block_storage_ram.c -o mtb_block_storage_trace_test
+ *     ./mtb_block_storage_trace_test
+ *
+ * Adding -DCOMPONENT_CAT2 -Itest/hal builds the trace with the critical section used on the
+ * cores without atomic instructions instead.
+ *
+ ***************************************************************************************************
+ * \copyright
+ * Copyright 2024 Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ **************************************************************************************************/
+#include "mtb_block_storage.h"
+#include "mtb_block_storage_trace.h"
+#include "mtb_block_storage_test.h"
+
+#include <string.h>
+
+#define TEST_MEMORY_SIZE        (4096u)
+#define TEST_RECORD_COUNT       (4u)
+
+static const mtb_block_storage_ram_region_t test_regions[] =
+{
+    { 0x00000000u, TEST_MEMORY_SIZE, 4u, 512u, 0xFFu, false, 0u, 0u, 0u, 0u },
+};
+
+static uint8_t test_memory[TEST_MEMORY_SIZE];
+static uint32_t test_buffer[(sizeof(mtb_block_storage_trace_header_t) +
+                             (TEST_RECORD_COUNT * sizeof(mtb_block_storage_trace_record_t))) /
+                            sizeof(uint32_t)];
+static mtb_block_storage_trace_header_t* const test_header =
+    (mtb_block_storage_trace_header_t*)test_buffer;
+static const mtb_block_storage_trace_record_t* const test_records =
+    (const mtb_block_storage_trace_record_t*)(test_buffer +
+                                              (sizeof(mtb_block_storage_trace_header_t) /
+                                               sizeof(uint32_t)));
+static uint32_t test_clock_value;
+//Number of calls started by the clock when it is read next, to wrap the ring
+static uint32_t test_clock_calls;
+
+
+#if defined(COMPONENT_CAT2)
+#include "cy_syslib.h"
+
+//--------------------------------------------------------------------------------------------------
+// Cy_SysLib_EnterCriticalSection
+//--------------------------------------------------------------------------------------------------
+uint32_t Cy_SysLib_EnterCriticalSection(void)
+{
+    return 0u;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// Cy_SysLib_ExitCriticalSection
+//--------------------------------------------------------------------------------------------------
+void Cy_SysLib_ExitCriticalSection(uint32_t savedIntrStatus)
+{
+    (void)savedIntrStatus;
+}
+
+
+#endif // defined(COMPONENT_CAT2)
+//--------------------------------------------------------------------------------------------------
+// test_clock
+//--------------------------------------------------------------------------------------------------
+static uint32_t test_clock(void)
+{
+    //The calls started here stand for interrupts preempting the call being traced
+    uint32_t calls = test_clock_calls;
+    test_clock_calls = 0u;
+    for (uint32_t i = 0; i < calls; i++)
+    {
+        mtb_block_storage_trace_end(mtb_block_storage_trace_begin(MTB_BLOCK_STORAGE_TRACE_ERASE,
+                                                                  NULL, i, 1u), CY_RSLT_SUCCESS);
+    }
+    return ++test_clock_value;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_trace_ram
+//--------------------------------------------------------------------------------------------------
+static void test_trace_ram(void)
+{
+    mtb_block_storage_t bsd;
+    mtb_block_storage_ram_t obj;
+    mtb_block_storage_ram_config_t config;
+    uint8_t data[16];
+
+    (void)memset(&config, 0, sizeof(config));
+    config.regions = test_regions;
+    config.region_count = 1u;
+    config.memory = test_memory;
+    config.initialize = true;
+    TEST_ASSERT(mtb_block_storage_create_ram(&bsd, &obj, &config) == CY_RSLT_SUCCESS);
+
+    //No record is written while the trace is stopped
+    TEST_ASSERT(mtb_block_storage_trace_begin(MTB_BLOCK_STORAGE_TRACE_READ, NULL, 0u, 1u) ==
+                MTB_BLOCK_STORAGE_TRACE_NO_RECORD);
+    TEST_ASSERT(mtb_block_storage_trace_start(test_buffer, sizeof(test_buffer), test_clock,
+                                              1000u) == CY_RSLT_SUCCESS);
+    TEST_ASSERT(test_header->record_count == TEST_RECORD_COUNT);
+    TEST_ASSERT(bsd.read(bsd.context, 512u, sizeof(data), data) == CY_RSLT_SUCCESS);
+    TEST_ASSERT(bsd.program(bsd.context, 516u, 2u, data) == MTB_BLOCK_STORAGE_INVALID_SIZE_ERROR);
+    TEST_ASSERT(test_header->next == 2u);
+    TEST_ASSERT((test_records[0].sequence == 1u) &&
+                (test_records[0].op == MTB_BLOCK_STORAGE_TRACE_READ) &&
+                (test_records[0].addr == 512u) && (test_records[0].length == sizeof(data)) &&
+                (test_records[0].end > test_records[0].start) &&
+                (test_records[0].result == CY_RSLT_SUCCESS));
+    TEST_ASSERT((test_records[1].sequence == 2u) &&
+                (test_records[1].op == MTB_BLOCK_STORAGE_TRACE_PROGRAM) &&
+                (test_records[1].result == MTB_BLOCK_STORAGE_INVALID_SIZE_ERROR));
+    mtb_block_storage_trace_stop();
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_trace_numbering_wrap
+//--------------------------------------------------------------------------------------------------
+static void test_trace_numbering_wrap(void)
+{
+    uint32_t record;
+
+    //The number of no record is skipped, the record after the last one is 0 with sequence 1
+    TEST_ASSERT(mtb_block_storage_trace_start(test_buffer, sizeof(test_buffer), NULL, 0u) ==
+                CY_RSLT_SUCCESS);
+    test_header->next = MTB_BLOCK_STORAGE_TRACE_NO_RECORD - 1u;
+    record = mtb_block_storage_trace_begin(MTB_BLOCK_STORAGE_TRACE_READ, NULL, 0u, 1u);
+    TEST_ASSERT(record == (MTB_BLOCK_STORAGE_TRACE_NO_RECORD - 1u));
+    mtb_block_storage_trace_end(record, CY_RSLT_SUCCESS);
+    record = mtb_block_storage_trace_begin(MTB_BLOCK_STORAGE_TRACE_READ, NULL, 0u, 1u);
+    TEST_ASSERT(record == 0u);
+    mtb_block_storage_trace_end(record, CY_RSLT_SUCCESS);
+    TEST_ASSERT((test_records[0].sequence == 1u) && (test_records[0].result == CY_RSLT_SUCCESS));
+    TEST_ASSERT(mtb_block_storage_trace_begin(MTB_BLOCK_STORAGE_TRACE_READ, NULL, 0u, 1u) == 1u);
+    mtb_block_storage_trace_stop();
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// test_trace_end_reused
+//--------------------------------------------------------------------------------------------------
+static void test_trace_end_reused(void)
+{
+    uint32_t record;
+
+    TEST_ASSERT(mtb_block_storage_trace_start(test_buffer, sizeof(test_buffer), test_clock,
+                                              1000u) == CY_RSLT_SUCCESS);
+    record = mtb_block_storage_trace_begin(MTB_BLOCK_STORAGE_TRACE_PROGRAM, NULL, 0u, 4u);
+    TEST_ASSERT(record == 0u);
+
+    //Calls wrapping the ring while the end is written reuse the record, which is then dropped
+    //rather than holding the operation of one call and the result of another
+    test_clock_calls = TEST_RECORD_COUNT;
+    mtb_block_storage_trace_end(record, MTB_BLOCK_STORAGE_NOT_ERASED_ERROR);
+    TEST_ASSERT(test_header->next == (TEST_RECORD_COUNT + 1u));
+    TEST_ASSERT(test_records[0].sequence == 0u);
+    TEST_ASSERT((test_records[1].sequence == 2u) &&
+                (test_records[1].op == MTB_BLOCK_STORAGE_TRACE_ERASE) &&
+                (test_records[1].result == CY_RSLT_SUCCESS));
+    mtb_block_storage_trace_stop();
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// main
+//--------------------------------------------------------------------------------------------------
+int main(void)
+{
+    TEST_RUN(test_trace_ram);
+    TEST_RUN(test_trace_numbering_wrap);
+    TEST_RUN(test_trace_end_reused);
+    return TEST_RESULT();
+}
@@ -0,0 +1,128 @@
+#!/usr/bin/env python3
+"""Decodes a dump of a block storage trace buffer into a timeline.
+
+The dump is the raw content of the buffer given to mtb_block_storage_trace_start, e.g. saved by
+the debugger with "dump binary memory trace.bin &buffer (&buffer + 1)". The byte order is
+detected from the magic of the header.
+
+Copyright 2024 Cypress Semiconductor Corporation (an Infineon company) or
+an affiliate of Cypress Semiconductor Corporation
+
+SPDX-License-Identifier: Apache-2.0
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+
+import argparse
+import struct
+import sys
+
+TRACE_MAGIC = 0x52545342
+TRACE_VERSION = 1
+TRACE_IN_PROGRESS = 0xFFFFFFFF
+HEADER_FORMAT = "8I"
+RECORD_FORMAT = "8I"
+OPS = {1: "read", 2: "program", 3: "erase"}
+
+
+def parse(data):
+    """Returns the header fields and the valid records of a dump, oldest first."""
+    header_size = struct.calcsize(HEADER_FORMAT)
+    if len(data) < header_size:
+        raise ValueError("dump shorter than the trace header")
+    for order in ("<", ">"):
+        header = struct.unpack_from(order + HEADER_FORMAT, data, 0)
+        if header[0] == TRACE_MAGIC:
+            break
+    else:
+        raise ValueError("no trace header, magic not found")
+    _, version, record_size, record_count, clock_hz, next_record, _, _ = header
+    if version != TRACE_VERSION:
+        raise ValueError("unsupported trace version %u" % version)
+    if record_size < struct.calcsize(RECORD_FORMAT):
+        raise ValueError("unexpected record size %u" % record_size)
+    available = (len(data) - header_size) // record_size
+    if available < record_count:
+        print("warning: dump holds %u of %u records" % (available, record_count),
+              file=sys.stderr)
+        record_count = available
+
+    records = []
+    for index in range(record_count):
+        fields = struct.unpack_from(order + RECORD_FORMAT, data,
+                                    header_size + (index * record_size))
+        sequence = fields[0]
+        # 0 for the slots never used and for a record interrupted while it was written
+        if sequence != 0:
+            records.append(fields)
+    records.sort(key=lambda record: record[0])
+    info = {"clock_hz": clock_hz, "next": next_record, "record_count": record_count}
+    return info, records
+
+
+def describe_result(result):
+    """Returns a readable form of a cy_rslt_t."""
+    if result == TRACE_IN_PROGRESS:
+        return "IN PROGRESS"
+    if result == 0:
+        return "ok"
+    # Layout of CY_RSLT_CREATE: module in bits 18-31, type in bits 16-17, code in bits 0-15
+    return "0x%08X (module 0x%03X, code %u)" % (result, (result >> 18) & 0x3FFF, result & 0xFFFF)
+
+
+def format_ticks(ticks, clock_hz):
+    """Returns a duration in microseconds if the frequency is known, in ticks otherwise."""
+    if clock_hz == 0:
+        return "%u ticks" % ticks
+    return "%.3f us" % (ticks * 1000000.0 / clock_hz)
+
+
+def main():
+    """Prints the timeline of a trace dump."""
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("dump", help="binary dump of the trace buffer")
+    args = parser.parse_args()
+
+    with open(args.dump, "rb") as dump:
+        data = dump.read()
+    try:
+        info, records = parse(data)
+    except ValueError as error:
+        print("error: %s" % error, file=sys.stderr)
+        return 1
+
+    clock_hz = info["clock_hz"]
+    dropped = info["next"] - len(records)
+    print("%u records, %u older ones overwritten, clock %s" %
+          (len(records), max(dropped, 0), ("%u Hz" % clock_hz) if clock_hz else "unknown"))
+    if not records:
+        return 0
+
+    # The clock is a wrapping 32 bits counter, times are relative to the oldest record
+    origin = records[0][5]
+    print("%10s %16s %16s %-8s %-10s %-10s %-10s %s" %
+          ("seq", "start", "duration", "op", "context", "addr", "length", "result"))
+    for sequence, op, context, addr, length, start, end, result in records:
+        relative = (start - origin) & 0xFFFFFFFF
+        if result == TRACE_IN_PROGRESS:
+            duration = "-"
+        else:
+            duration = format_ticks((end - start) & 0xFFFFFFFF, clock_hz)
+        print("%10u %16s %16s %-8s 0x%08X 0x%08X 0x%08X %s" %
+              (sequence - 1, format_ticks(relative, clock_hz), duration,
+               OPS.get(op, "op %u" % op), context, addr, length, describe_result(result)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())